@@ -0,0 +1,178 @@
+// Host benchmark: legacy if/else CAN dispatch versus the shared dispatch table,
+// frame by frame and in coalesced batches.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++17 -Iinclude bench/dispatch_bench.cpp src/CAN_Dispatch.cpp src/BMW_CAN.cpp
+//       src/Kawasaki_CAN.cpp src/Vehicle_State.cpp -o dispatch_bench && ./dispatch_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "BMW_CAN.h"
+#include "Kawasaki_CAN.h"
+#include "CAN_Dispatch.h"
+#include "Vehicle_State.h"
+
+#define BENCH_FRAME_COUNT 4096
+#define BENCH_ROUNDS 2000
+
+#define BENCH_BATCH_SIZE 32
+
+typedef CAN_Frame_t BenchFrame_t;
+
+// === LEGACY DISPATCH (as it was before the dispatch table) ===
+// Decoded data as it was laid out before the vehicle state store
+typedef struct {
+    bool ignition;
+    bool cranking;
+    bool tcs;
+    int torque;
+    int rpm;
+    int torqueLoss;
+} Legacy_DME1_t;
+
+typedef struct {
+    int coolantTemp;
+    int manifoldPressure;
+} Legacy_DME2_t;
+
+typedef struct {
+    bool mil;
+    bool cruise;
+    bool eml;
+} Legacy_DME4_t;
+
+typedef struct {
+    Legacy_DME1_t* dme1;
+    Legacy_DME2_t* dme2;
+    Legacy_DME4_t* dme4;
+} Legacy_BMW_Context_t;
+
+typedef struct {
+    int rpm;
+    int coolantTemp;
+    int tps;
+    int iap;
+    int ect;
+} Legacy_Kawasaki_Data_t;
+
+static void Legacy_parseBMW(uint32_t rxId, uint8_t len, const uint8_t* buf, Legacy_BMW_Context_t* ctx, uint32_t* changed) {
+    if (rxId == 0x316 && len >= 8) {
+        ctx->dme1->ignition = (buf[0] & 0x01) > 0;
+        ctx->dme1->cranking = (buf[0] & 0x02) > 0;
+        ctx->dme1->tcs = (buf[0] & 0x04) > 0;
+        ctx->dme1->torque = buf[1];
+        ctx->dme1->rpm = (buf[3] << 8) | buf[2];
+        ctx->dme1->torqueLoss = buf[5];
+        *changed |= 1;
+    } else if (rxId == 0x329 && len >= 3) {
+        ctx->dme2->coolantTemp = (int)((float)buf[1] * 0.75 - 48);
+        ctx->dme2->manifoldPressure = buf[2] == 0xFF ? -999 : (int)(buf[2] * 2 + 598);
+        *changed |= 1;
+    } else if (rxId == 0x545 && len >= 1) {
+        ctx->dme4->mil = (buf[0] & 0x02) > 0;
+        ctx->dme4->cruise = (buf[0] & 0x08) > 0;
+        ctx->dme4->eml = (buf[0] & 0x10) > 0;
+        *changed |= 1;
+    }
+}
+
+static void Legacy_parseKawasaki(uint32_t rxId, uint8_t len, const uint8_t* buf, Legacy_Kawasaki_Data_t* data, uint32_t* changed) {
+    if (rxId == 0x620 && len >= 8) {
+        data->rpm = (buf[0] << 8) | buf[1];
+        data->tps = buf[2];
+        data->iap = buf[3];
+        data->ect = buf[4];
+        data->coolantTemp = buf[4];
+        *changed |= 1;
+    }
+}
+
+// === FRAME STREAM ===
+static void buildFrameStream(BenchFrame_t* frames, int count) {
+    // Roughly the E46 PT-CAN mix: DME1 dominates, plus IDs nobody decodes
+    static const uint32_t ids[] = {0x316, 0x316, 0x316, 0x329, 0x545, 0x620, 0x153, 0x1F0, 0x1F3, 0x43F, 0x613, 0x615};
+    const int idCount = sizeof(ids) / sizeof(ids[0]);
+    srand(46);
+    for (int i = 0; i < count; i++) {
+        frames[i].id = ids[rand() % idCount];
+        frames[i].len = 8;
+        frames[i].flags = 0;
+        frames[i].timestamp = (uint64_t)i * 250;
+        for (int b = 0; b < 8; b++) {
+            frames[i].buf[b] = (uint8_t)rand();
+        }
+    }
+}
+
+typedef void (*BenchRun_t)(const BenchFrame_t* frames, int count, uint32_t* changed);
+
+// Legacy decode targets
+Legacy_DME1_t dme1;
+Legacy_DME2_t dme2;
+Legacy_DME4_t dme4;
+static Legacy_BMW_Context_t legacy_ctx = {&dme1, &dme2, &dme4};
+Legacy_Kawasaki_Data_t kawasaki_data;
+
+// Dispatch table targets
+static Vehicle_State_t state;
+static BMW_Kombi_t kombi;
+static BMW_CAN_Context_t bmw_ctx = {&state, &kombi};
+static CAN_Dispatch_Table_t dispatch;
+
+static void runLegacy(const BenchFrame_t* frames, int count, uint32_t* changed) {
+    // VEHICLE_UNKNOWN mode: both chains run on every frame
+    for (int i = 0; i < count; i++) {
+        Legacy_parseBMW(frames[i].id, frames[i].len, frames[i].buf, &legacy_ctx, changed);
+        Legacy_parseKawasaki(frames[i].id, frames[i].len, frames[i].buf, &kawasaki_data, changed);
+    }
+}
+
+static void runTable(const BenchFrame_t* frames, int count, uint32_t* changed) {
+    for (int i = 0; i < count; i++) {
+        CAN_Dispatch_process(&dispatch, frames[i].id, frames[i].len, frames[i].buf, changed);
+    }
+}
+
+static void runBatch(const BenchFrame_t* frames, int count, uint32_t* changed) {
+    // What CAN_Reader_readMessages does with the frames it pops from the ring
+    for (int i = 0; i < count; i += BENCH_BATCH_SIZE) {
+        int n = count - i < BENCH_BATCH_SIZE ? count - i : BENCH_BATCH_SIZE;
+        CAN_Dispatch_processBatch(&dispatch, &frames[i], n, changed);
+    }
+}
+
+static double measure(const char* name, BenchRun_t run, const BenchFrame_t* frames, int count) {
+    uint32_t changed = 0;
+    run(frames, count, &changed); // warm up
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        run(frames, count, &changed);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double frames_s = (double)count * BENCH_ROUNDS / seconds;
+    printf("%-8s %8.2f ns/frame  %8.2f Mframes/s  (rpm=%d/%d coolant=%d/%d)\n",
+           name, seconds * 1e9 / ((double)count * BENCH_ROUNDS), frames_s / 1e6, dme1.rpm, state.value[BMW_SIGNAL_RPM],
+           dme2.coolantTemp, state.value[BMW_SIGNAL_COOLANT_TEMP]);
+    return frames_s;
+}
+
+int main() {
+    static BenchFrame_t frames[BENCH_FRAME_COUNT];
+    buildFrameStream(frames, BENCH_FRAME_COUNT);
+
+    CAN_Dispatch_clear(&dispatch);
+    Vehicle_State_clear(&state);
+    BMW_registerDecoders(&dispatch, &bmw_ctx, VEHICLE_STATE_BMW_BASE);
+    Kawasaki_registerDecoders(&dispatch, &state, VEHICLE_STATE_KAWASAKI_BASE);
+
+    printf("Replaying %d mixed-ID frames x %d rounds\n", BENCH_FRAME_COUNT, BENCH_ROUNDS);
+    double legacy = measure("legacy", runLegacy, frames, BENCH_FRAME_COUNT);
+    double table = measure("table", runTable, frames, BENCH_FRAME_COUNT);
+    double batch = measure("batch", runBatch, frames, BENCH_FRAME_COUNT);
+    printf("speedup  table %.2fx  batch %.2fx\n", table / legacy, batch / legacy);
+    return 0;
+}
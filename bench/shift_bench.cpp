@@ -0,0 +1,245 @@
+// Host benchmark: RPM meter bars lit from the last decoded RPM versus the RPM trend
+// extrapolated to the moment the frame reaches the panel. DME1 samples come from seeded
+// Engine_Sim drives (full-throttle pulls through the gears), or from a candump log of a real
+// car given on the command line. The UI is modelled as one frame per frame-rate cap interval
+// that sees the samples received before it and reaches the panel a fixed latency later; the
+// truth is the logged RPM interpolated at that time.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=gnu++17 -Iinclude -Ilib/ArduinoHost/src bench/shift_bench.cpp src/RPM_Trend.cpp
+//       src/Engine_Sim.cpp src/BMW_CAN.cpp src/Kawasaki_CAN.cpp src/CAN_Dispatch.cpp src/Vehicle_State.cpp
+//       src/CAN_Replay.cpp src/CAN_Filter.cpp lib/ArduinoHost/src/ArduinoHost.cpp -o shift_bench
+//   ./shift_bench [candump.log]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "BMW_CAN.h"
+#include "CAN_Replay.h"
+#include "Engine_Sim.h"
+#include "RPM_Trend.h"
+
+#define BENCH_SEEDS 8
+#define BENCH_DRIVE_US 300000000ull     // Per seed
+#define BENCH_RX_DELAY_US 2000          // Reception to the CAN task publishing the sample
+#define BENCH_PULL_SLOPE 1500           // rpm/s, frames above count as a pull
+#define BENCH_FRAME_MS 40               // DISPLAY_RENDERER_MIN_FRAME_MS, the renderer's frame-rate cap
+
+// Same bars as the RPM meter screen
+static const int BENCH_THRESHOLDS[] = {5250, 5500, 5750, 6000, 6250, 6500};
+static const size_t BENCH_THRESHOLD_COUNT = sizeof(BENCH_THRESHOLDS) / sizeof(BENCH_THRESHOLDS[0]);
+
+// Draw plus flush, from a partial update to a full 1 KB frame over 400 kHz I2C
+static const uint32_t BENCH_LATENCIES_US[] = {5000, 15000, 25000, 40000};
+
+typedef struct {
+    uint64_t timeUs;
+    int16_t rpm;
+} BenchSample_t;
+
+typedef struct {
+    std::vector<int> errors;        // Shown minus true RPM at the panel, every frame
+    std::vector<int> pullErrors;    // Frames during a pull only
+    double lateMsSum;               // Bar lit after the engine crossed its threshold, negative when ahead of it
+    uint32_t crossings;
+    uint32_t missed;                // Crossings no frame showed before the engine fell back
+    uint32_t earlyFrames;           // Bar lit while the engine was still below its threshold
+} BenchResult_t;
+
+// === SAMPLE SOURCES ===
+static void collectSim(std::vector<BenchSample_t>* samples, uint32_t seed, uint64_t offsetUs) {
+    Engine_Sim_t sim;
+    Engine_Sim_init(&sim, seed);
+    Engine_Sim_setVehicles(&sim, true, false);
+    CAN_Frame_t frame;
+    do {
+        Engine_Sim_next(&sim, &frame);
+        int16_t rpm;
+        if (BMW_decodeRPM(&frame, &rpm)) {
+            samples->push_back({offsetUs + frame.timestamp, rpm});
+        }
+    } while (frame.timestamp < BENCH_DRIVE_US);
+}
+
+static bool collectLog(std::vector<BenchSample_t>* samples, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char line[CAN_REPLAY_LINE_SIZE];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        line[strcspn(line, "\r\n")] = '\0';
+        uint64_t timeUs;
+        bool hasTime;
+        CAN_Frame_t frame = {};
+        int16_t rpm;
+        if (CAN_Replay_parseCandump(line, &timeUs, &hasTime, &frame) && hasTime && BMW_decodeRPM(&frame, &rpm)) {
+            samples->push_back({timeUs, rpm});
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// === MODEL ===
+static int trueRpm(const std::vector<BenchSample_t>& samples, size_t* cursor, uint64_t atUs) {
+    // Samples are sorted, the cursor only moves forward
+    while (*cursor + 1 < samples.size() && samples[*cursor + 1].timeUs <= atUs) {
+        (*cursor)++;
+    }
+    const BenchSample_t& a = samples[*cursor];
+    if (*cursor + 1 >= samples.size() || atUs <= a.timeUs) {
+        return a.rpm;
+    }
+    const BenchSample_t& b = samples[*cursor + 1];
+    if (b.timeUs - a.timeUs > RPM_TREND_MAX_GAP_US) {
+        return a.rpm;
+    }
+    return a.rpm + (int)((int64_t)(b.rpm - a.rpm) * (int64_t)(atUs - a.timeUs) / (int64_t)(b.timeUs - a.timeUs));
+}
+
+static int litBars(int rpm) {
+    int bars = 0;
+    while (bars < (int)BENCH_THRESHOLD_COUNT && rpm >= BENCH_THRESHOLDS[bars]) {
+        bars++;
+    }
+    return bars;
+}
+
+static void run(const std::vector<BenchSample_t>& samples, uint32_t latencyUs, bool predict, BenchResult_t* result) {
+    RPM_Trend_t trend;
+    RPM_Trend_reset(&trend);
+    size_t fed = 0;
+    size_t truthCursor = 0;
+    size_t crossCursor = 0;
+    int lastShown = 0;
+    int shownBars = 0;
+    int trueBars = 0;
+    uint64_t crossedUs[BENCH_THRESHOLD_COUNT] = {};
+    uint64_t litUs[BENCH_THRESHOLD_COUNT] = {};     // Photon time the shown bar came on
+    bool pending[BENCH_THRESHOLD_COUNT] = {};
+
+    const uint64_t frameUs = BENCH_FRAME_MS * 1000ull;
+    uint64_t endUs = samples.back().timeUs - latencyUs;
+    for (uint64_t drawUs = samples.front().timeUs + frameUs; drawUs < endUs; drawUs += frameUs) {
+        while (fed < samples.size() && samples[fed].timeUs + BENCH_RX_DELAY_US <= drawUs) {
+            RPM_Trend_sample(&trend, samples[fed].timeUs, samples[fed].rpm);
+            lastShown = samples[fed].rpm;
+            fed++;
+        }
+        uint64_t photonUs = drawUs + latencyUs;
+        int shown = predict ? RPM_Trend_predict(&trend, photonUs) : lastShown;
+        int truth = trueRpm(samples, &truthCursor, photonUs);
+
+        // Threshold crossings of the engine up to this photon time, at sample resolution
+        while (crossCursor < samples.size() && samples[crossCursor].timeUs <= photonUs) {
+            int bars = litBars(samples[crossCursor].rpm);
+            for (int i = trueBars; i < bars; i++) {
+                result->crossings++;
+                if (i < shownBars) {
+                    // Already lit by the prediction
+                    result->lateMsSum -= (double)(int64_t)(samples[crossCursor].timeUs - litUs[i]) / 1000.0;
+                } else {
+                    pending[i] = true;
+                    crossedUs[i] = samples[crossCursor].timeUs;
+                }
+            }
+            for (int i = bars; i < trueBars; i++) {
+                if (pending[i]) {
+                    result->missed++;
+                    pending[i] = false;
+                }
+            }
+            trueBars = bars;
+            crossCursor++;
+        }
+
+        int bars = litBars(shown);
+        for (int i = shownBars; i < bars; i++) {
+            litUs[i] = photonUs;
+            if (pending[i]) {
+                result->lateMsSum += (double)(int64_t)(photonUs - crossedUs[i]) / 1000.0;
+                pending[i] = false;
+            }
+        }
+        if (bars > litBars(truth)) {
+            result->earlyFrames++;
+        }
+        shownBars = bars;
+
+        int error = shown - truth;
+        result->errors.push_back(error);
+        if (trend.slope > BENCH_PULL_SLOPE) {
+            result->pullErrors.push_back(error);
+        }
+    }
+}
+
+// === REPORT ===
+static void absStats(std::vector<int>* errors, double* mean, int* p95, int* worst) {
+    *mean = 0;
+    *p95 = 0;
+    *worst = 0;
+    if (errors->empty()) {
+        return;
+    }
+    for (int& e : *errors) {
+        e = abs(e);
+        *mean += e;
+    }
+    *mean /= errors->size();
+    std::sort(errors->begin(), errors->end());
+    *p95 = (*errors)[errors->size() * 95 / 100];
+    *worst = errors->back();
+}
+
+static void report(const char* name, BenchResult_t* result) {
+    double mean;
+    double pullMean;
+    int p95;
+    int worst;
+    int pullP95;
+    int pullWorst;
+    absStats(&result->errors, &mean, &p95, &worst);
+    absStats(&result->pullErrors, &pullMean, &pullP95, &pullWorst);
+    uint32_t lit = result->crossings - result->missed;
+    printf("  %-10s %7.0f %5d %6d   %7.0f %5d %6d   %7.1f %6lu %6lu\n", name, mean, p95, worst,
+           pullMean, pullP95, pullWorst, lit ? result->lateMsSum / lit : 0.0,
+           (unsigned long)result->missed, (unsigned long)result->earlyFrames);
+}
+
+int main(int argc, char** argv) {
+    std::vector<BenchSample_t> samples;
+    if (argc > 1) {
+        if (!collectLog(&samples, argv[1])) {
+            printf("Cannot read %s\n", argv[1]);
+            return 1;
+        }
+        printf("Log %s: %zu DME1 samples\n", argv[1], samples.size());
+    } else {
+        // Drives back to back, each seed its own pulls and shift points
+        for (uint32_t seed = 1; seed <= BENCH_SEEDS; seed++) {
+            uint64_t offsetUs = samples.empty() ? 0 : samples.back().timeUs + RPM_TREND_MAX_GAP_US * 2;
+            collectSim(&samples, seed, offsetUs);
+        }
+        printf("Engine_Sim seeds 1-%d: %zu DME1 samples, %.0f s\n", BENCH_SEEDS, samples.size(),
+               (samples.back().timeUs - samples.front().timeUs) / 1e6);
+    }
+    if (samples.size() < 2) {
+        printf("Not enough DME1 samples\n");
+        return 1;
+    }
+
+    for (uint32_t latencyUs : BENCH_LATENCIES_US) {
+        printf("\nPanel latency %lu ms, a frame every %d ms\n", (unsigned long)(latencyUs / 1000), BENCH_FRAME_MS);
+        printf("  RPM error   all: mean  p95  worst   pulls: mean  p95  worst   late ms missed  early\n");
+        BenchResult_t last = {};
+        BenchResult_t predicted = {};
+        run(samples, latencyUs, false, &last);
+        run(samples, latencyUs, true, &predicted);
+        report("last", &last);
+        report("predicted", &predicted);
+    }
+    return 0;
+}
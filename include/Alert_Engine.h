@@ -0,0 +1,88 @@
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <FS.h>
+#include "Vehicle_State.h"
+
+// Alert configuration
+#define ALERT_MAX_RULES 16
+#define ALERT_NAME_SIZE 16
+#define ALERT_LINE_SIZE 96
+#define ALERT_RULES_PATH "/alerts.cfg"
+#define ALERT_NO_SCREEN -1
+
+typedef enum {
+    ALERT_ABOVE,        // >
+    ALERT_AT_LEAST,     // >=
+    ALERT_BELOW,        // <
+    ALERT_AT_MOST       // <=
+} Alert_Comparator_t;
+
+// What the screens draw while a rule is active, several rules may share one
+typedef enum {
+    ALERT_INDICATOR_NONE,
+    ALERT_INDICATOR_SHIFT,      // RPM screen: blinking bar and warning triangle
+    ALERT_INDICATOR_REDLINE,    // RPM meter: blinking bars
+    ALERT_INDICATOR_COOLANT,    // RPM screen: thermometer
+    ALERT_INDICATOR_OVERHEAT,   // Detailed temperature screen: blinking thermometer
+    ALERT_INDICATOR_COUNT
+} Alert_Indicator_t;
+
+// One line of the rules file:
+//   <name> <signal> <op> <threshold> [hyst=<n>] [debounce=<ms>] [prio=<n>] [show=<indicator>] [screen=<n>]
+// The alert raises when "signal op threshold" held for debounce ms, and clears once the value
+// is back past threshold -/+ hysteresis for as long. A missing or stale reading clears it at once.
+typedef struct {
+    char name[ALERT_NAME_SIZE];
+    uint8_t signal;             // Vehicle_State slot
+    Alert_Comparator_t comparator;
+    int16_t threshold;
+    int16_t hysteresis;
+    uint16_t debounceMs;
+    uint8_t priority;           // The highest active priority picks the override screen
+    Alert_Indicator_t indicator;
+    int8_t screen;              // Shown instead of the selected screen while active, or ALERT_NO_SCREEN
+} Alert_Rule_t;
+
+typedef struct {
+    bool active;
+    bool pending;               // Condition differs from active, waiting for the debounce
+    bool fresh;                 // The signal had a fresh reading at the last evaluation
+    uint32_t pendingSinceMs;
+    uint32_t activeSinceMs;
+    uint16_t activations;
+} Alert_State_t;
+
+// Rule engine owned by the UI task, fed from the render view. A rule is evaluated when its signal
+// changed; only rules that are active, debouncing or without a fresh reading are looked at on
+// every update, since time alone can change their state.
+typedef struct {
+    Alert_Rule_t rules[ALERT_MAX_RULES];
+    Alert_State_t states[ALERT_MAX_RULES];
+    uint8_t ruleCount;
+
+    uint32_t generation;        // Vehicle_State generation of the last update
+    uint32_t indicators;        // Bit per Alert_Indicator_t of the active rules
+    int8_t overrideScreen;
+    uint32_t changes;           // Advanced on every raise or clear, part of the screen keys
+    uint32_t evaluations;
+} Alert_Engine_t;
+
+// Function prototypes
+void Alert_Engine_init(Alert_Engine_t* engine);
+void Alert_Engine_loadDefaults(Alert_Engine_t* engine);
+int Alert_Engine_load(Alert_Engine_t* engine, File file);
+bool Alert_Engine_save(const Alert_Engine_t* engine, File file);
+int Alert_Engine_findIndicator(const char* name);
+bool Alert_Engine_parseRule(const char* line, Alert_Rule_t* rule);
+void Alert_Engine_formatRule(const Alert_Rule_t* rule, char* buf, size_t size);
+bool Alert_Engine_setRule(Alert_Engine_t* engine, const Alert_Rule_t* rule);
+bool Alert_Engine_removeRule(Alert_Engine_t* engine, const char* name);
+bool Alert_Engine_update(Alert_Engine_t* engine, const Vehicle_State_t* state, uint32_t nowMs);
+bool Alert_Engine_indicator(const Alert_Engine_t* engine, Alert_Indicator_t indicator);
+int Alert_Engine_overrideScreen(const Alert_Engine_t* engine);
+void Alert_Engine_printStatus(const Alert_Engine_t* engine, uint32_t nowMs);
+
+#endif // ALERT_ENGINE_H
@@ -0,0 +1,59 @@
+#ifndef ANIM_PLAYER_H
+#define ANIM_PLAYER_H
+
+#include <stdint.h>
+#include <FS.h>
+#include <U8g2lib.h>
+#include "Display_Renderer.h"
+
+// Player configuration
+#define ANIM_PLAYER_FRAME_BYTES DISPLAY_RENDERER_BUFFER_SIZE
+#define ANIM_PLAYER_CHUNK_SIZE 256
+
+// .anim format, written by tools/anim_convert.py (see there for the full layout)
+#define ANIM_PLAYER_MAGIC "ANIM"
+#define ANIM_PLAYER_VERSION 1
+#define ANIM_PLAYER_HEADER_SIZE 14
+#define ANIM_PLAYER_FRAME_KEY 0
+#define ANIM_PLAYER_FRAME_DELTA 1
+#define ANIM_PLAYER_RLE_MIN_RUN 3
+
+typedef enum {
+    ANIM_PLAYER_IDLE,
+    ANIM_PLAYER_PLAYING,
+    ANIM_PLAYER_DONE
+} Anim_Player_State_t;
+
+// Non-blocking player: each step either shows the prefetched frame (when due) or decodes the next one
+typedef struct {
+    Anim_Player_State_t state;
+    File file;
+    U8G2* display;
+
+    uint16_t frameCount;
+    uint16_t frameMs;
+    uint16_t framesDecoded;
+    uint16_t framesShown;
+    unsigned long nextFrameAt;
+
+    // Double buffer in U8g2 page layout: front is on the panel, back holds the next frame
+    uint8_t frames[2][ANIM_PLAYER_FRAME_BYTES];
+    uint8_t front;
+    bool backReady;
+
+    // File read buffer
+    uint8_t chunk[ANIM_PLAYER_CHUNK_SIZE];
+    uint16_t chunkLen;
+    uint16_t chunkPos;
+
+    uint16_t framesLate;    // Frame was decoded after its slot had passed
+} Anim_Player_t;
+
+// Function prototypes
+void Anim_Player_init(Anim_Player_t* player);
+bool Anim_Player_start(Anim_Player_t* player, File file, U8G2* display);
+bool Anim_Player_step(Anim_Player_t* player, Display_Renderer_Context_t* renderer);
+void Anim_Player_stop(Anim_Player_t* player);
+bool Anim_Player_isPlaying(const Anim_Player_t* player);
+
+#endif // ANIM_PLAYER_H
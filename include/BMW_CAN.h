@@ -2,60 +2,93 @@
 #define BMW_CAN_H
 
 #include <stdint.h>
+#include "CAN_Dispatch.h"
+#include "CAN_Frame.h"
+#include "Bus_Fingerprint.h"
 
-// BMW DME1 (0x316) - Engine Status and Performance
-typedef struct {
-    bool ignition;
-    bool cranking;
-    bool tcs;
-    int torque;
-    int rpm;
-    int torqueLoss;
-} BMW_DME1_t;
-
-// BMW DME2 (0x329) - Engine Temperatures and Pressure
-typedef struct {
-    int coolantTemp;
-    int manifoldPressure;
-} BMW_DME2_t;
-
-// BMW DME4 (0x545) - Warning Lights
-typedef struct {
-    bool mil;
-    bool cruise;
-    bool eml;
-} BMW_DME4_t;
-
-// MS42 Temperatures
-typedef struct {
-    int intakeTemp;
-    int oilTemp;
-    int outletTemp;
-} BMW_MS42_Temp_t;
-
-// MS42 Status
-typedef struct {
-    int fuelPressure;
-    int lambda;
-    int maf;
-} BMW_MS42_Status_t;
+// Decoded values live in the vehicle state store (Vehicle_State.h)
+typedef struct Vehicle_State Vehicle_State_t;
 
 // Instrument Cluster Data
+#define BMW_VIN_LENGTH 17
 typedef struct {
-    char vin[8];
+    char vin[BMW_VIN_LENGTH + 1];
     bool vinReceived;
 } BMW_Kombi_t;
 
+// Diagnostic CAN: ISO-TP with extended addressing, the first byte of every frame is the target address.
+// ECUs answer on 0x600 + their address.
+#define BMW_DIAG_REQUEST_ID 0x6F1           // Tester requests to every ECU
+#define BMW_DIAG_DME_RESPONSE_ID 0x612
+#define BMW_DIAG_KOMBI_RESPONSE_ID 0x660
+#define BMW_DIAG_DME_ADDRESS 0x12
+#define BMW_DIAG_KOMBI_ADDRESS 0x60
+#define BMW_DIAG_TESTER_ADDRESS 0xF1
+
+// KWP2000 services used on the diagnostic CAN
+#define DIAG_KWP_READ_ECU_ID 0x1A
+#define DIAG_KWP_READ_LOCAL_ID 0x21
+#define DIAG_KWP_POSITIVE_RESPONSE(sid) ((sid) + 0x40)
+#define DIAG_KWP_NEGATIVE_RESPONSE 0x7F
+#define DIAG_KWP_ECU_ID_VIN 0x90
+
+// Consumer of the diagnostic response IDs (the ISO-TP layer), returns the changed signals
+typedef uint32_t (*BMW_DiagFrameHandler_t)(void* diagCtx, uint32_t id, uint8_t len, const uint8_t* buf);
+
 // Parsing function
 typedef struct {
-    BMW_DME1_t* dme1;
-    BMW_DME2_t* dme2;
-    BMW_DME4_t* dme4;
-    BMW_MS42_Temp_t* ms42_temp;
-    BMW_MS42_Status_t* ms42_status;
+    Vehicle_State_t* state;     // BMW_Signal_t slots from VEHICLE_STATE_BMW_BASE on
     BMW_Kombi_t* kombi;
+
+    // Optional, diagnostic responses are ignored without it
+    BMW_DiagFrameHandler_t diagFrame;
+    void* diagCtx;
 } BMW_CAN_Context_t;
 
-void BMW_parseCANMessage(uint32_t rxId, uint8_t len, const uint8_t* buf, BMW_CAN_Context_t* ctx, bool* displayUpdated);
+// Vehicle state slots, also the changed-signal bits returned by the decoders
+typedef enum {
+    // DME1 (0x316) - Engine Status and Performance
+    BMW_SIGNAL_IGNITION,
+    BMW_SIGNAL_CRANKING,
+    BMW_SIGNAL_TCS,
+    BMW_SIGNAL_TORQUE,
+    BMW_SIGNAL_RPM,
+    BMW_SIGNAL_TORQUE_LOSS,
+    // DME2 (0x329) - Engine Temperatures and Pressure
+    BMW_SIGNAL_COOLANT_TEMP,
+    BMW_SIGNAL_MANIFOLD_PRESSURE,
+    // DME4 (0x545) - Warning Lights
+    BMW_SIGNAL_MIL,
+    BMW_SIGNAL_CRUISE,
+    BMW_SIGNAL_EML,
+    // MS42 temperatures and status
+    BMW_SIGNAL_OIL_TEMP,
+    BMW_SIGNAL_INTAKE_TEMP,
+    BMW_SIGNAL_OUTLET_TEMP,
+    BMW_SIGNAL_FUEL_PRESSURE,
+    BMW_SIGNAL_LAMBDA,
+    BMW_SIGNAL_MAF,
+    BMW_SIGNAL_VIN,            // Not in a signal table, 1 once the cluster answered a VIN request
+    BMW_SIGNAL_COUNT
+} BMW_Signal_t;
+
+// MS42 measurement blocks returned by the DME on request (not broadcast on PT-CAN)
+typedef enum {
+    BMW_MS42_BLOCK_TEMP,      // Intake and radiator outlet temperature
+    BMW_MS42_BLOCK_FUEL,      // Fuel pressure and lambda
+    BMW_MS42_BLOCK_AIR        // Air mass
+} BMW_MS42_Block_t;
+
+const CAN_Dispatch_Entry_t* BMW_getDispatchEntries(size_t* count);
+const Bus_Fingerprint_Id_t* BMW_getFingerprint(size_t* count);
+bool BMW_registerDecoders(CAN_Dispatch_Table_t* table, BMW_CAN_Context_t* ctx, uint8_t maskShift);
+bool BMW_decodeMS42Block(BMW_MS42_Block_t block, uint8_t len, const uint8_t* buf, BMW_CAN_Context_t* ctx, uint32_t* changed);
+uint32_t BMW_decodeBatch(const CAN_Frame_t* frames, size_t count, BMW_CAN_Context_t* ctx);
+bool BMW_decodeRPM(const CAN_Frame_t* frame, int16_t* rpm);
+
+// Encoders from BMW_Signal_t slots, the inverse of the decoders. Return the payload length,
+// 0 for an ID or block without a signal table.
+uint8_t BMW_encodeFrame(uint32_t id, const int16_t* values, uint8_t* buf);
+uint8_t BMW_encodeMS42Block(BMW_MS42_Block_t block, const int16_t* values, uint8_t* buf);
 
 #endif // BMW_CAN_H 
\ No newline at end of file
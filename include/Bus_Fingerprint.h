@@ -0,0 +1,66 @@
+#ifndef BUS_FINGERPRINT_H
+#define BUS_FINGERPRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "CAN_Frame.h"
+
+// Detection configuration
+#define BUS_FINGERPRINT_MAX_PROFILES 4
+#define BUS_FINGERPRINT_MAX_IDS 8           // Per profile
+#define BUS_FINGERPRINT_WINDOW_US 1000000   // Traffic collected before every decision
+#define BUS_FINGERPRINT_LOCK_PERCENT 70     // Confidence needed to lock onto a profile
+#define BUS_FINGERPRINT_MARGIN_PERCENT 20   // Lead over the runner-up needed to lock
+#define BUS_FINGERPRINT_BREAK_PERCENT 30    // Below this the locked profile no longer fits
+#define BUS_FINGERPRINT_BREAK_WINDOWS 2     // Consecutive weak windows before re-detecting
+#define BUS_FINGERPRINT_NONE 0xFF
+
+// Periodic frame that identifies a vehicle, vehicle modules keep these in constexpr arrays
+typedef struct {
+    uint16_t id;
+    uint16_t periodMs;
+} Bus_Fingerprint_Id_t;
+
+typedef struct {
+    const char* name;
+    uint8_t vehicle;                        // Caller's vehicle tag, returned on a lock
+    const Bus_Fingerprint_Id_t* ids;
+    uint8_t idCount;
+} Bus_Fingerprint_Profile_t;
+
+// Matches the IDs and rates seen on the bus against the registered profiles, one window at a time.
+// A profile's confidence is how well its IDs keep their periods, scaled by the share of the
+// profile frames on the bus that belong to it. Windows without any profile frame (ignition off)
+// are no evidence either way.
+typedef struct {
+    Bus_Fingerprint_Profile_t profiles[BUS_FINGERPRINT_MAX_PROFILES];
+    uint8_t profileCount;
+
+    // Current window
+    uint64_t windowStartUs;
+    bool windowOpen;
+    uint16_t counts[BUS_FINGERPRINT_MAX_PROFILES][BUS_FINGERPRINT_MAX_IDS];
+    uint32_t matchedFrames;                 // Frames of any profile ID
+
+    // Decision
+    uint8_t score[BUS_FINGERPRINT_MAX_PROFILES];   // Confidence in percent, last window
+    uint8_t locked;                         // Profile index, BUS_FINGERPRINT_NONE while detecting
+    uint8_t weakWindows;
+    uint64_t detectStartUs;
+    uint64_t lockedAtUs;
+    uint32_t lockAfterMs;                   // Time from the first frame to the lock
+
+    uint32_t windows;
+    uint32_t locks;
+    uint32_t breaks;
+} Bus_Fingerprint_t;
+
+// Function prototypes
+void Bus_Fingerprint_init(Bus_Fingerprint_t* fp);
+bool Bus_Fingerprint_addProfile(Bus_Fingerprint_t* fp, const char* name, uint8_t vehicle, const Bus_Fingerprint_Id_t* ids, size_t count);
+bool Bus_Fingerprint_frame(Bus_Fingerprint_t* fp, const CAN_Frame_t* frame);
+const Bus_Fingerprint_Profile_t* Bus_Fingerprint_lockedProfile(const Bus_Fingerprint_t* fp);
+uint8_t Bus_Fingerprint_confidence(const Bus_Fingerprint_t* fp);
+void Bus_Fingerprint_printStatus(const Bus_Fingerprint_t* fp);
+
+#endif // BUS_FINGERPRINT_H
@@ -0,0 +1,60 @@
+#ifndef CAN_DISPATCH_H
+#define CAN_DISPATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "CAN_Frame.h"
+
+// Dispatch table configuration
+#define CAN_DISPATCH_MAX_ENTRIES 16
+#define CAN_DISPATCH_STD_ID_COUNT 0x800   // 11-bit identifiers are indexed directly
+#define CAN_DISPATCH_NO_SLOT 0xFF
+
+// CAN_Dispatch_Entry_t.flags
+#define CAN_DISPATCH_EVERY_FRAME 0x01     // Never coalesced in a batch, e.g. request/response traffic
+
+// Decoder for a single CAN ID, target is the context given at registration.
+// Returns a bitmask of the signals whose value changed (vehicle specific bit numbering).
+typedef uint32_t (*CAN_Decoder_t)(uint8_t len, const uint8_t* buf, void* target);
+
+// Decoder entry, vehicle modules keep these in sorted constexpr arrays
+typedef struct {
+    uint32_t id;
+    uint8_t minLen;
+    CAN_Decoder_t decode;
+    uint8_t flags;
+} CAN_Dispatch_Entry_t;
+
+// Registered decoder with its target context
+typedef struct {
+    const CAN_Dispatch_Entry_t* entry;
+    void* target;
+    uint8_t maskShift;      // Where this vehicle's signal bits start in the combined changed mask
+} CAN_Dispatch_Slot_t;
+
+// Shared lookup table: one array access per frame, unknown IDs are skipped immediately
+typedef struct {
+    uint8_t slotForId[CAN_DISPATCH_STD_ID_COUNT];
+    CAN_Dispatch_Slot_t slots[CAN_DISPATCH_MAX_ENTRIES];
+    uint8_t count;
+} CAN_Dispatch_Table_t;
+
+// Compile-time check that an entry array is strictly sorted by ID
+constexpr bool CAN_Dispatch_isSorted(const CAN_Dispatch_Entry_t* entries, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (entries[i - 1].id >= entries[i].id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function prototypes
+void CAN_Dispatch_clear(CAN_Dispatch_Table_t* table);
+bool CAN_Dispatch_register(CAN_Dispatch_Table_t* table, const CAN_Dispatch_Entry_t* entries, size_t count, void* target, uint8_t maskShift);
+bool CAN_Dispatch_process(const CAN_Dispatch_Table_t* table, uint32_t rxId, uint8_t len, const uint8_t* buf, uint32_t* changed);
+size_t CAN_Dispatch_processBatch(const CAN_Dispatch_Table_t* table, const CAN_Frame_t* frames, size_t count, uint32_t* changed);
+uint32_t CAN_Dispatch_decodeBatch(const CAN_Dispatch_Entry_t* entries, size_t entryCount, const CAN_Frame_t* frames, size_t count, void* target);
+const CAN_Dispatch_Entry_t* CAN_Dispatch_findEntry(const CAN_Dispatch_Entry_t* entries, size_t count, uint32_t rxId);
+
+#endif // CAN_DISPATCH_H
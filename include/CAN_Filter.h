@@ -0,0 +1,25 @@
+#ifndef CAN_FILTER_H
+#define CAN_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// MCP2515 acceptance filter layout: RXB0 has mask 0 with filters 0-1, RXB1 has mask 1 with filters 2-5
+#define CAN_FILTER_MASK_COUNT 2
+#define CAN_FILTER_SLOT_COUNT 6
+#define CAN_FILTER_RXB0_SLOTS 2
+#define CAN_FILTER_STD_ID_MASK 0x7FF
+
+typedef struct {
+    uint16_t masks[CAN_FILTER_MASK_COUNT];
+    uint16_t filters[CAN_FILTER_SLOT_COUNT];
+    bool exact;           // Every accepted ID is a decoded ID
+    bool acceptAll;       // No IDs given, masks are open
+} CAN_Filter_Config_t;
+
+// Function prototypes
+void CAN_Filter_compute(const uint32_t* ids, size_t count, CAN_Filter_Config_t* config);
+uint32_t CAN_Filter_acceptedIdCount(const CAN_Filter_Config_t* config);
+bool CAN_Filter_accepts(const CAN_Filter_Config_t* config, uint32_t id);
+
+#endif // CAN_FILTER_H
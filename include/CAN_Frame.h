@@ -0,0 +1,29 @@
+#ifndef CAN_FRAME_H
+#define CAN_FRAME_H
+
+#include <stdint.h>
+
+// Identifier flag bits as returned by CAN_Interface_t.read (mcp_can convention)
+#define CAN_ID_EXTENDED_BIT 0x80000000u
+#define CAN_ID_RTR_BIT 0x40000000u
+#define CAN_ID_MASK 0x1FFFFFFFu
+
+// CAN_Frame_t.flags
+#define CAN_FRAME_FLAG_EXTENDED 0x01
+#define CAN_FRAME_FLAG_RTR 0x02
+
+// Bits a data frame occupies on the bus: SOF to CRC (34 or 54 + 8 * len bits) with worst-case
+// stuffing of one bit per four after the first, then CRC delimiter, ACK, EOF and interframe space
+#define CAN_FRAME_BUS_BITS(len) (34 + 8 * (len) + (33 + 8 * (len)) / 4 + 13)
+#define CAN_FRAME_BUS_BITS_EXTENDED(len) (54 + 8 * (len) + (53 + 8 * (len)) / 4 + 13)
+
+// Received CAN frame: the record passed through the ring, the batch decoders, the trace and the logger
+typedef struct {
+    uint64_t timestamp;     // Receive time in microseconds since boot
+    uint32_t id;            // Without the flag bits
+    uint8_t len;            // DLC, at most 8
+    uint8_t flags;
+    uint8_t buf[8];
+} CAN_Frame_t;
+
+#endif // CAN_FRAME_H
@@ -0,0 +1,16 @@
+#ifndef CAN_INTERFACE_H
+#define CAN_INTERFACE_H
+
+#include <stdint.h>
+#include "CAN_Filter.h"
+
+// CAN controller abstraction, implemented by the MCP2515 driver on the ESP32 and by the mock on the host
+typedef struct {
+    void* impl;
+    bool (*available)(void* impl);
+    bool (*read)(void* impl, uint32_t* id, uint8_t* len, uint8_t* buf);
+    bool (*send)(void* impl, uint32_t id, uint8_t len, const uint8_t* buf);
+    bool (*setAcceptance)(void* impl, const CAN_Filter_Config_t* config);
+} CAN_Interface_t;
+
+#endif // CAN_INTERFACE_H
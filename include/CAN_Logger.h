@@ -0,0 +1,90 @@
+#ifndef CAN_LOGGER_H
+#define CAN_LOGGER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <FS.h>
+#include "CAN_RingBuffer.h"
+
+// Logger configuration
+#define CAN_LOGGER_BLOCK_SIZE 2048          // One flash write, two of these are the logger's whole RAM buffer
+#define CAN_LOGGER_FLUSH_MS 1000            // Seal a partly filled block after this long
+#define CAN_LOGGER_MAX_FILE_SIZE (64u * 1024u)
+#define CAN_LOGGER_MAX_FILES 100
+#define CAN_LOGGER_FREE_RESERVE (16u * 1024u) // Oldest logs are deleted to keep this much of the partition free
+#define CAN_LOGGER_PATH_FORMAT "/canlog_%03u.bin"
+#define CAN_LOGGER_PATH_SIZE 24
+
+// File format, all integers little endian:
+//   file header   "CANL", version, 3 reserved bytes
+//   block header  "BK", uint16 payloadLen, uint16 frameCount, uint16 sequence, uint32 baseTimeUs, uint32 crc32(payload)
+//   frame         varint timestamp delta (us, the first frame of a block is relative to baseTimeUs)
+//                 tag: dictionary index, or 0xFF followed by uint16 id + uint8 len to add a new entry
+//                 len payload bytes, the length is implied by the dictionary entry
+#define CAN_LOGGER_FILE_MAGIC "CANL"
+#define CAN_LOGGER_FILE_VERSION 1
+#define CAN_LOGGER_FILE_HEADER_SIZE 8
+#define CAN_LOGGER_BLOCK_MAGIC "BK"
+#define CAN_LOGGER_BLOCK_HEADER_SIZE 16
+#define CAN_LOGGER_NEW_ENTRY 0xFF
+#define CAN_LOGGER_DICT_SIZE 255
+#define CAN_LOGGER_MAX_FRAME_BYTES (5 + 1 + 3 + 8)
+
+typedef struct {
+    uint8_t data[CAN_LOGGER_BLOCK_SIZE];
+    uint16_t len;                   // Bytes used including the header
+    uint16_t frameCount;
+    uint32_t baseTimeUs;
+    uint32_t lastTimeUs;
+    unsigned long openedMs;
+    uint16_t dictCount;
+    uint16_t dictIds[CAN_LOGGER_DICT_SIZE];
+    uint8_t dictLens[CAN_LOGGER_DICT_SIZE];
+    std::atomic<bool> sealed;       // Owned by the writer until it clears this
+} CAN_Logger_Block_t;
+
+typedef struct {
+    // Encoder side (CAN task)
+    CAN_Logger_Block_t blocks[2];
+    uint8_t active;
+    uint16_t sequence;
+    std::atomic<bool> recording;    // Cleared after closeRequested is set, see CAN_Logger_isIdle()
+
+    // Requests from the console, handled by the CAN task in CAN_Logger_service()
+    std::atomic<bool> startRequested;
+    std::atomic<bool> stopRequested;
+
+    // Writer side
+    File file;
+    uint16_t fileIndex;
+    bool fileIndexValid;            // Set once the newest existing log was found
+    uint32_t fileSize;
+    std::atomic<bool> closeRequested;
+    void* writerTask;
+
+    // Statistics
+    std::atomic<uint32_t> framesLogged;
+    std::atomic<uint32_t> framesDropped;    // Both blocks were waiting for the writer
+    std::atomic<uint32_t> blocksWritten;
+    std::atomic<uint32_t> bytesWritten;
+    std::atomic<uint32_t> writeErrors;
+    std::atomic<uint32_t> filesRotated;
+} CAN_Logger_t;
+
+// Function prototypes
+void CAN_Logger_init(CAN_Logger_t* logger);
+bool CAN_Logger_startWriter(CAN_Logger_t* logger);
+void CAN_Logger_start(CAN_Logger_t* logger);
+void CAN_Logger_stop(CAN_Logger_t* logger);
+bool CAN_Logger_isRecording(const CAN_Logger_t* logger);
+bool CAN_Logger_isIdle(const CAN_Logger_t* logger);
+void CAN_Logger_record(CAN_Logger_t* logger, const CAN_Frame_t* frame);
+void CAN_Logger_service(CAN_Logger_t* logger);
+void CAN_Logger_writePending(CAN_Logger_t* logger);
+void CAN_Logger_printStatus(const CAN_Logger_t* logger);
+void CAN_Logger_list(void);
+bool CAN_Logger_dump(uint16_t index);
+void CAN_Logger_clear(CAN_Logger_t* logger);
+uint32_t CAN_Logger_crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+#endif // CAN_LOGGER_H
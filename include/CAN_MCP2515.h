@@ -0,0 +1,10 @@
+#ifndef CAN_MCP2515_H
+#define CAN_MCP2515_H
+
+#include <mcp_can.h>
+#include "CAN_Interface.h"
+
+// Function prototypes
+void CAN_MCP2515_init(CAN_Interface_t* iface, MCP_CAN* mcp);
+
+#endif // CAN_MCP2515_H
@@ -0,0 +1,66 @@
+#ifndef CAN_MOCK_H
+#define CAN_MOCK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "CAN_Interface.h"
+#include "CAN_Filter.h"
+#include "CAN_RingBuffer.h"
+
+// Mock configuration
+#define CAN_MOCK_LINE_SIZE 160
+#define CAN_MOCK_INJECT_QUEUE_SIZE 16
+#define CAN_MOCK_FRAMES_PER_STEP 64     // Keeps max speed replay below the receive ring size
+#define CAN_MOCK_MAX_SEND_HOOKS 4
+
+// Called for every frame the application sends, e.g. to let a simulated ECU answer via CAN_Mock_inject()
+typedef void (*CAN_Mock_SendHook_t)(void* hookCtx, uint32_t id, uint8_t len, const uint8_t* buf);
+
+// Mock CAN controller fed from a candump style frame file (see CAN_Replay_parseCandump)
+typedef struct {
+    FILE* file;
+    bool loop;
+    bool realTime;              // Deliver frames according to their timestamps
+    unsigned long startMicros;
+
+    // Next frame read from the file
+    bool pendingValid;
+    CAN_Frame_t pending;
+    uint64_t pendingTimeUs;     // Relative to the first frame in the file
+    bool haveFirstTime;
+    uint64_t firstTimeUs;
+    bool endOfFile;
+    uint16_t stepBudget;        // Frames left until the next CAN_Mock_beginStep()
+
+    // Frames injected by the host (simulated ECUs), delivered before file frames
+    CAN_Frame_t injected[CAN_MOCK_INJECT_QUEUE_SIZE];
+    uint8_t injectHead;
+    uint8_t injectCount;
+
+    // Emulated MCP2515 acceptance filter
+    CAN_Filter_Config_t acceptance;
+    bool acceptanceSet;
+
+    // Simulated ECUs listening to sent frames
+    struct {
+        CAN_Mock_SendHook_t hook;
+        void* ctx;
+    } sendHooks[CAN_MOCK_MAX_SEND_HOOKS];
+    uint8_t sendHookCount;
+
+    uint32_t framesRead;
+    uint32_t framesRejected;    // Dropped by the emulated hardware filter
+    uint32_t framesSent;
+} CAN_Mock_t;
+
+// Function prototypes
+void CAN_Mock_init(CAN_Mock_t* mock);
+bool CAN_Mock_open(CAN_Mock_t* mock, const char* path, bool loop, bool realTime);
+void CAN_Mock_close(CAN_Mock_t* mock);
+bool CAN_Mock_inject(CAN_Mock_t* mock, uint32_t id, uint8_t len, const uint8_t* buf);
+bool CAN_Mock_addSendHook(CAN_Mock_t* mock, CAN_Mock_SendHook_t hook, void* hookCtx);
+void CAN_Mock_beginStep(CAN_Mock_t* mock);
+bool CAN_Mock_isDrained(const CAN_Mock_t* mock);
+void CAN_Mock_initInterface(CAN_Interface_t* iface, CAN_Mock_t* mock);
+
+#endif // CAN_MOCK_H
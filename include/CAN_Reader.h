@@ -2,24 +2,97 @@
 #define CAN_READER_H
 
 #include <stdint.h>
-#include <mcp_can.h>
+#include <atomic>
+#include "CAN_RingBuffer.h"
+#include "CAN_Dispatch.h"
+#include "CAN_Filter.h"
+#include "CAN_Interface.h"
+#include "CAN_Trace.h"
+#include "CAN_Stats.h"
+#include "Bus_Fingerprint.h"
+#include "Perf_Trace.h"
+#include "BMW_CAN.h"
+#include "Kawasaki_CAN.h"
+#include "Vehicle_State.h"
+
+// Receive task configuration (overridable from build_flags)
+#ifndef CAN_RX_TASK_STACK_SIZE
+#define CAN_RX_TASK_STACK_SIZE 4096
+#endif
+#ifndef CAN_RX_TASK_PRIORITY
+#define CAN_RX_TASK_PRIORITY 5
+#endif
+#ifndef CAN_RX_TASK_CORE
+#define CAN_RX_TASK_CORE 0             // Arduino loop() runs on core 1
+#endif
+#define CAN_RX_POLL_TIMEOUT_MS 10      // Fallback drain in case an interrupt edge is missed
+#define CAN_READER_BATCH_SIZE 32       // Frames popped from the ring and decoded together
+#define CAN_READER_NO_REQUEST -1       // CAN_Reader_Context_t.requestedVehicle without a pending switch
+
+// Layout of the changed-signal mask returned by CAN_Reader_readMessages
+#define CAN_READER_BMW_SIGNAL_SHIFT VEHICLE_STATE_BMW_BASE
+#define CAN_READER_KAWASAKI_SIGNAL_SHIFT VEHICLE_STATE_KAWASAKI_BASE
+
+// Called for every received frame before it is decoded, e.g. by the flash logger
+typedef void (*CAN_Reader_FrameTap_t)(void* tapCtx, const CAN_Frame_t* frame);
 
 // Vehicle type enumeration
 typedef enum {
     VEHICLE_BMW,
     VEHICLE_KAWASAKI,
-    VEHICLE_UNKNOWN
+    VEHICLE_UNKNOWN         // Auto-detected from the bus fingerprint, no decoder runs until it locks
 } VehicleType_t;
 
 // CAN Reader context structure
 typedef struct {
-    VehicleType_t vehicleType;
-    MCP_CAN* canInterface;
-    bool* displayUpdated;
+    VehicleType_t vehicleType;  // Owned by the consumer (CAN task) once it runs
+    CAN_Interface_t* canInterface;
+    bool* displayUpdated;   // Set whenever a decoder ran, timestamps moved even if no value changed
+
+    // Vehicle switch from another task, applied by the consumer before its next batch
+    std::atomic<int> requestedVehicle;          // VehicleType_t or CAN_READER_NO_REQUEST
+    std::atomic<uint8_t> activeVehicle;         // Published by the consumer, see CAN_Reader_activeVehicle()
+
+    // Decoders of the active vehicle, rebuilt lazily after a vehicle switch
+    CAN_Dispatch_Table_t dispatch;
+    bool dispatchValid;
+
+    // VEHICLE_UNKNOWN: profiles of every vehicle matched against the received traffic,
+    // reset lazily by the consumer like the dispatch table
+    Bus_Fingerprint_t fingerprint;
+    bool fingerprintValid;
+
+    // MCP2515 acceptance filters derived from the decoded IDs
+    CAN_Filter_Config_t filterConfig;
+    uint32_t rxUnmatched;   // Frames that passed the hardware filter but have no decoder
+
+    // Interrupt driven receive path
+    CAN_RingBuffer_t rxRing;
+    void* rxTask;           // FreeRTOS task handle, null until CAN_Reader_start()
+    void* busMutex;         // Serialises SPI access between the receive task and reconfiguration
+    void* consumerTask;     // Optional task notified whenever frames were queued
+    uint8_t intPin;
+    uint32_t rxCount;       // Frames read from the controller (producer side)
+    CAN_Trace_t* trace;     // Optional frame trace, drained to Serial by the UI task
+    CAN_Stats_t* stats;     // Optional per-ID statistics, updated by the producer so ring overflows are counted too
+#if PERF_TRACE
+    Perf_Trace_t* perf;     // Optional, stamps every decoded frame
+#endif
+    CAN_Reader_FrameTap_t frameTap;
+    void* frameTapCtx;
 } CAN_Reader_Context_t;
 
 // Function prototypes
-void CAN_Reader_init(CAN_Reader_Context_t* ctx, VehicleType_t vehicleType, MCP_CAN* canInterface, bool* displayUpdated);
-void CAN_Reader_readMessages(CAN_Reader_Context_t* ctx, void* bmw_ctx, void* kawasaki_data);
+void CAN_Reader_init(CAN_Reader_Context_t* ctx, VehicleType_t vehicleType, CAN_Interface_t* canInterface, bool* displayUpdated);
+bool CAN_Reader_start(CAN_Reader_Context_t* ctx, uint8_t intPin);
+void CAN_Reader_requestVehicle(CAN_Reader_Context_t* ctx, VehicleType_t vehicleType);
+void CAN_Reader_setInterface(CAN_Reader_Context_t* ctx, CAN_Interface_t* canInterface);
+bool CAN_Reader_send(CAN_Reader_Context_t* ctx, uint32_t id, uint8_t len, const uint8_t* buf);
+void CAN_Reader_poll(CAN_Reader_Context_t* ctx);
+uint32_t CAN_Reader_readMessages(CAN_Reader_Context_t* ctx, void* bmw_ctx, Vehicle_State_t* state);
+uint32_t CAN_Reader_getOverflowCount(const CAN_Reader_Context_t* ctx);
+VehicleType_t CAN_Reader_activeVehicle(const CAN_Reader_Context_t* ctx);
+void CAN_Reader_resetStats(CAN_Reader_Context_t* ctx);
+uint64_t CAN_Reader_timestampUs(void);
 
 #endif // CAN_READER_H
@@ -0,0 +1,78 @@
+#ifndef CAN_REPLAY_H
+#define CAN_REPLAY_H
+
+#include <stdint.h>
+#include <FS.h>
+#include "CAN_Interface.h"
+#include "CAN_Filter.h"
+#include "CAN_RingBuffer.h"
+
+// Replay configuration
+#define CAN_REPLAY_CHUNK_SIZE 256       // File read granularity, the whole log is never loaded
+#define CAN_REPLAY_LINE_SIZE 160
+#define CAN_REPLAY_MAX_BURST 64         // Frames per receive poll, stays below the receive ring size
+#define CAN_REPLAY_SPEED_MAX 0.0f       // As fast as the consumer drains
+
+// Compact binary log: "CANB" + version byte + 3 reserved bytes, then records of
+//   uint32 timeUs (little endian, relative to the first frame), uint16 id, uint8 len, len data bytes
+// timeUs wraps every 2^32 us (71.6 min) and is unwrapped on reading, so times never decrease and
+// consecutive records are less than 2^32 us apart
+#define CAN_REPLAY_BIN_MAGIC "CANB"
+#define CAN_REPLAY_BIN_VERSION 1
+#define CAN_REPLAY_BIN_HEADER_SIZE 8
+#define CAN_REPLAY_BIN_RECORD_HEADER 7
+
+typedef enum {
+    CAN_REPLAY_FORMAT_CANDUMP,  // (1436509052.249713) can0 316#0510F60F00001D00
+    CAN_REPLAY_FORMAT_ASC,      // Vector ASCII:  0.012345 1  316  Rx   d 8 05 10 F6 0F 00 00 1D 00
+    CAN_REPLAY_FORMAT_BINARY
+} CAN_Replay_Format_t;
+
+// Streaming log source that plugs into CAN_Reader like a controller
+typedef struct {
+    File file;
+    CAN_Replay_Format_t format;
+    float speed;                // 1.0 real time, N accelerated, CAN_REPLAY_SPEED_MAX unthrottled
+    bool active;
+    bool finished;
+
+    // Read buffer
+    uint8_t chunk[CAN_REPLAY_CHUNK_SIZE];
+    uint16_t chunkLen;
+    uint16_t chunkPos;
+
+    // Playback clock, accumulated so micros() wrap and speed changes are harmless
+    unsigned long lastMicros;
+    uint64_t playUs;
+
+    // Next frame
+    bool pendingValid;
+    CAN_Frame_t pending;
+    uint64_t pendingTimeUs;
+    uint64_t positionUs;        // Log time of the last delivered frame
+    bool haveFirstTime;
+    uint64_t firstTimeUs;
+    bool ascDecimalIds;         // ASC "base dec"
+    uint64_t binaryTimeUs;      // Unwrapped time of the last binary record
+
+    CAN_Filter_Config_t acceptance;
+    bool acceptanceSet;
+    uint16_t burst;
+
+    uint32_t framesRead;
+    uint32_t framesRejected;    // Dropped by the emulated acceptance filter
+    uint32_t parseErrors;
+} CAN_Replay_t;
+
+// Function prototypes
+void CAN_Replay_init(CAN_Replay_t* replay);
+bool CAN_Replay_open(CAN_Replay_t* replay, File file, float speed);
+void CAN_Replay_close(CAN_Replay_t* replay);
+void CAN_Replay_setSpeed(CAN_Replay_t* replay, float speed);
+uint32_t CAN_Replay_positionMs(const CAN_Replay_t* replay);
+void CAN_Replay_initInterface(CAN_Interface_t* iface, CAN_Replay_t* replay);
+const char* CAN_Replay_formatName(CAN_Replay_Format_t format);
+bool CAN_Replay_parseCandump(const char* line, uint64_t* timeUs, bool* hasTime, CAN_Frame_t* frame);
+bool CAN_Replay_parseAsc(const char* line, bool decimalIds, uint64_t* timeUs, CAN_Frame_t* frame);
+
+#endif // CAN_REPLAY_H
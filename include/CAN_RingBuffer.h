@@ -0,0 +1,26 @@
+#ifndef CAN_RING_BUFFER_H
+#define CAN_RING_BUFFER_H
+
+#include <stdint.h>
+#include <atomic>
+#include "CAN_Frame.h"
+
+// Ring capacity in frames (must be a power of two)
+#define CAN_RING_BUFFER_SIZE 256
+
+// Single-producer/single-consumer frame ring.
+// The producer only writes head, the consumer only writes tail, so no lock is needed.
+typedef struct {
+    CAN_Frame_t frames[CAN_RING_BUFFER_SIZE];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    uint32_t overflowCount; // Frames dropped because the ring was full (producer side)
+} CAN_RingBuffer_t;
+
+// Function prototypes
+void CAN_RingBuffer_init(CAN_RingBuffer_t* rb);
+bool CAN_RingBuffer_push(CAN_RingBuffer_t* rb, const CAN_Frame_t* frame);
+bool CAN_RingBuffer_pop(CAN_RingBuffer_t* rb, CAN_Frame_t* frame);
+uint32_t CAN_RingBuffer_count(const CAN_RingBuffer_t* rb);
+
+#endif // CAN_RING_BUFFER_H
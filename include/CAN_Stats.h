@@ -0,0 +1,66 @@
+#ifndef CAN_STATS_H
+#define CAN_STATS_H
+
+#include <stdint.h>
+#include "CAN_Frame.h"
+
+// Statistics configuration (overridable from build_flags)
+#ifndef CAN_STATS_MAX_IDS
+#define CAN_STATS_MAX_IDS 64            // Distinct IDs tracked, later ones only count as untracked
+#endif
+#ifndef CAN_STATS_BITRATE
+#define CAN_STATS_BITRATE 500000        // PT-CAN, must match the controller setup
+#endif
+#define CAN_STATS_NO_SLOT 0xFF
+#define CAN_STATS_EWMA_SHIFT 3          // Averages move 1/8 of the way to each new gap
+#define CAN_STATS_LOAD_WINDOW_US 1000000
+#define CAN_STATS_LATE_FACTOR 2         // A gap this many times the average means a period went missing
+#define CAN_STATS_TOP_N 10
+
+static_assert(CAN_STATS_MAX_IDS < CAN_STATS_NO_SLOT, "Slot indices are stored in a byte");
+
+// Per-ID receive statistics, gaps in microseconds of frame receive time
+typedef struct {
+    uint16_t id;
+    uint8_t len;                // DLC of the latest frame
+    uint32_t count;
+    uint32_t dlcChanges;
+    uint32_t late;              // Gaps over CAN_STATS_LATE_FACTOR times the average
+    uint32_t lastUs;            // Low word of the latest timestamp, gaps stay correct across the wrap
+    uint32_t minGapUs;
+    uint32_t maxGapUs;
+    uint32_t avgGapUs;          // EWMA of the inter-arrival time
+    uint32_t jitterUs;          // EWMA of the deviation from avgGapUs
+} CAN_Stats_Id_t;
+
+// Fixed memory statistics of every frame read from the controller. Updated by the receive task
+// under the bus lock, one table lookup and a few integer operations per frame. The console reads
+// the counters without the lock, so a printed line can mix two updates.
+typedef struct {
+    uint8_t slotOf[0x800];      // Standard ID -> index into ids, CAN_STATS_NO_SLOT until first seen
+    CAN_Stats_Id_t ids[CAN_STATS_MAX_IDS];
+    uint8_t idCount;
+
+    uint32_t frames;
+    uint32_t untracked;         // Extended IDs, and new IDs once the table is full
+    uint64_t busBits;           // Estimated bus bits of every frame, see CAN_FRAME_BUS_BITS
+    uint64_t startUs;           // First frame since the last reset
+
+    // Bus utilization over the last complete window. Only frames that passed the acceptance
+    // filter are seen, so with filtering on this is the load of the decoded traffic.
+    uint64_t windowStartUs;
+    uint32_t windowBits;
+    uint16_t loadPermille;
+    uint16_t peakLoadPermille;
+} CAN_Stats_t;
+
+// Function prototypes
+void CAN_Stats_reset(CAN_Stats_t* stats);
+void CAN_Stats_frame(CAN_Stats_t* stats, const CAN_Frame_t* frame);
+const CAN_Stats_Id_t* CAN_Stats_find(const CAN_Stats_t* stats, uint32_t id);
+uint32_t CAN_Stats_rateMilliHz(const CAN_Stats_Id_t* entry);
+uint16_t CAN_Stats_loadPermille(const CAN_Stats_t* stats, uint64_t nowUs);
+void CAN_Stats_print(const CAN_Stats_t* stats, uint64_t nowUs, uint8_t top);
+bool CAN_Stats_printId(const CAN_Stats_t* stats, uint32_t id, uint64_t nowUs);
+
+#endif // CAN_STATS_H
@@ -0,0 +1,54 @@
+#ifndef CAN_TRACE_H
+#define CAN_TRACE_H
+
+#include <stdint.h>
+#include <atomic>
+#include "CAN_RingBuffer.h"
+
+// Trace configuration
+#define CAN_TRACE_QUEUE_SIZE 2048       // TX queue bytes (must be a power of two)
+#define CAN_TRACE_LINE_SIZE 64          // "ID: 0x7FF  LEN: 8  DATA: 00 11 22 33 44 55 66 77\r\n" fits
+#define CAN_TRACE_DEFAULT_SAMPLE 100
+#ifndef CAN_TRACE_DEFAULT_LEVEL
+#define CAN_TRACE_DEFAULT_LEVEL CAN_TRACE_FULL
+#endif
+
+typedef enum {
+    CAN_TRACE_OFF,
+    CAN_TRACE_SAMPLED,      // Every Nth frame
+    CAN_TRACE_FILTERED,     // Only IDs in the filter set
+    CAN_TRACE_FULL
+} CAN_Trace_Level_t;
+
+// Frame trace: formatted on the CAN task, written to Serial by the UI task.
+// A full queue drops the line and counts it, the receive path never waits for the UART.
+typedef struct {
+    CAN_Trace_Level_t level;
+    uint16_t sampleEvery;
+    uint16_t sampleCounter;
+    uint8_t idFilter[0x800 / 8];    // One bit per standard ID
+
+    // SPSC byte queue, the CAN task only writes head and the UI task only writes tail
+    char queue[CAN_TRACE_QUEUE_SIZE];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+
+    uint32_t framesSeen;
+    uint32_t linesQueued;
+    std::atomic<uint32_t> linesDropped;
+    uint32_t bytesSent;
+} CAN_Trace_t;
+
+// Function prototypes
+void CAN_Trace_init(CAN_Trace_t* trace);
+void CAN_Trace_setLevel(CAN_Trace_t* trace, CAN_Trace_Level_t level);
+void CAN_Trace_setSample(CAN_Trace_t* trace, uint16_t every);
+void CAN_Trace_addId(CAN_Trace_t* trace, uint32_t id);
+void CAN_Trace_clearIds(CAN_Trace_t* trace);
+bool CAN_Trace_hasId(const CAN_Trace_t* trace, uint32_t id);
+void CAN_Trace_frame(CAN_Trace_t* trace, const CAN_Frame_t* frame);
+uint32_t CAN_Trace_drain(CAN_Trace_t* trace);
+void CAN_Trace_printStatus(const CAN_Trace_t* trace);
+const char* CAN_Trace_levelName(CAN_Trace_Level_t level);
+
+#endif // CAN_TRACE_H
@@ -0,0 +1,40 @@
+#ifndef DME_SIM_H
+#define DME_SIM_H
+
+#ifndef ARDUINO_ARCH_ESP32
+
+#include <stdint.h>
+#include "CAN_Mock.h"
+
+// Simulator configuration
+#define DME_SIM_QUEUE_SIZE 8
+
+// Host stand-in for the MS42 DME: answers Diag_Poller requests sent through the mock
+// controller after a configurable latency, one request at a time like the real ECU
+typedef struct {
+    CAN_Mock_t* mock;
+    uint16_t latencyMs;
+    uint16_t jitterMs;
+    uint8_t dropPercent;        // Requests silently ignored
+
+    // Responses waiting for their due time
+    struct {
+        unsigned long dueMs;
+        uint8_t len;
+        uint8_t buf[8];
+    } queue[DME_SIM_QUEUE_SIZE];
+    uint8_t queueCount;
+    unsigned long busyUntilMs;
+
+    uint32_t requests;
+    uint32_t responses;
+    uint32_t dropped;
+} DME_Sim_t;
+
+// Function prototypes
+void DME_Sim_init(DME_Sim_t* sim, CAN_Mock_t* mock, uint16_t latencyMs, uint16_t jitterMs, uint8_t dropPercent);
+void DME_Sim_step(DME_Sim_t* sim);
+
+#endif // ARDUINO_ARCH_ESP32
+
+#endif // DME_SIM_H
@@ -0,0 +1,63 @@
+#ifndef DIAG_POLLER_H
+#define DIAG_POLLER_H
+
+#include <stdint.h>
+#include <atomic>
+#include "BMW_CAN.h"
+#include "ISOTP.h"
+
+// Poller configuration
+#define DIAG_POLLER_MAX_IN_FLIGHT 2            // Requests awaiting a response at the same time
+#define DIAG_POLLER_VISIBLE_PERIOD_MS 100      // Values on the current screen
+#define DIAG_POLLER_BACKGROUND_PERIOD_MS 2000  // Everything else
+#define DIAG_POLLER_MIN_GAP_MS 5               // Between two requests on the bus
+#define DIAG_POLLER_TIMEOUT_FACTOR 4           // Timeout in multiples of the average latency
+#define DIAG_POLLER_MIN_TIMEOUT_MS 50
+#define DIAG_POLLER_MAX_TIMEOUT_MS 500
+#define DIAG_POLLER_MAX_BACKOFF 4              // Period doubles per failed request, up to 16x
+#define DIAG_POLLER_RESPONSE_SIZE 32           // Reassembly buffer for multi-frame blocks
+
+// One polled measurement block
+typedef struct {
+    BMW_MS42_Block_t block;
+    uint8_t localId;
+    uint32_t signals;           // BMW_Signal_t bits the block fills
+
+    bool inFlight;
+    unsigned long sentUs;
+    unsigned long nextDueMs;
+    uint16_t periodMs;          // Current poll period after latency adaption and backoff
+    uint8_t backoff;
+    uint32_t latencyAvgUs;      // Moving average of the response time, 0 until the first response
+
+    uint32_t requests;
+    uint32_t responses;
+    uint32_t timeouts;
+    uint32_t negatives;
+} Diag_Poller_Item_t;
+
+#define DIAG_POLLER_ITEM_COUNT 3
+
+// Request/response scheduler for DME values that are not broadcast, runs on the CAN task
+typedef struct {
+    Diag_Poller_Item_t items[DIAG_POLLER_ITEM_COUNT];
+    ISOTP_t* isotp;
+    ISOTP_Session_t* session;   // Tester <-> DME
+    BMW_CAN_Context_t* bmw;
+    uint8_t response[DIAG_POLLER_RESPONSE_SIZE];
+    std::atomic<bool> enabled;
+    std::atomic<uint32_t> visibleSignals;   // Set from the UI task when the screen changes
+    uint8_t inFlight;
+    unsigned long lastRequestMs;
+    uint32_t sendErrors;
+    uint32_t unexpected;        // Responses nobody asked for (late or foreign)
+} Diag_Poller_t;
+
+// Function prototypes
+bool Diag_Poller_init(Diag_Poller_t* poller, ISOTP_t* isotp, BMW_CAN_Context_t* bmw_ctx);
+void Diag_Poller_setEnabled(Diag_Poller_t* poller, bool enabled);
+void Diag_Poller_setVisibleSignals(Diag_Poller_t* poller, uint32_t signals);
+void Diag_Poller_step(Diag_Poller_t* poller);
+void Diag_Poller_printStatus(const Diag_Poller_t* poller);
+
+#endif // DIAG_POLLER_H
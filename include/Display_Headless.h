@@ -0,0 +1,19 @@
+#ifndef DISPLAY_HEADLESS_H
+#define DISPLAY_HEADLESS_H
+
+#ifndef ARDUINO_ARCH_ESP32
+
+#include <U8g2lib.h>
+
+// SH1106 128x64 full frame buffer without a bus, used by the native build
+class U8G2_SH1106_128X64_HEADLESS_F : public U8G2 {
+public:
+    U8G2_SH1106_128X64_HEADLESS_F(const u8g2_cb_t* rotation);
+};
+
+// Function prototypes
+bool Display_Headless_writePNM(U8G2* display, const char* path);
+
+#endif // ARDUINO_ARCH_ESP32
+
+#endif // DISPLAY_HEADLESS_H
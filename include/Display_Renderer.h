@@ -0,0 +1,56 @@
+#ifndef DISPLAY_RENDERER_H
+#define DISPLAY_RENDERER_H
+
+#include <stdint.h>
+#include <U8g2lib.h>
+
+// Renderer configuration
+#define DISPLAY_RENDERER_MAX_SCREENS 8
+#define DISPLAY_RENDERER_MIN_FRAME_MS 40      // Frame-rate cap (25 fps)
+#define DISPLAY_RENDERER_BUFFER_SIZE 1024     // 128x64 monochrome, one bit per pixel
+#define DISPLAY_RENDERER_TILE_BYTES 8         // A tile is 8x8 pixels, one byte per column
+#define DISPLAY_RENDERER_LATENCY_SHIFT 3      // Latency average weight, 1/8 per frame
+
+// Updates the frame buffer to the screen. It still holds the previous frame of the same screen
+// unless full is set, then the screen is drawn from a cleared buffer.
+typedef void (*Display_DrawFunction_t)(bool full);
+
+// Per-screen render statistics
+typedef struct {
+    uint32_t framesRendered;
+    uint32_t framesSkipped;     // Bound state unchanged, nothing drawn
+    uint32_t framesDeferred;    // State changed but the frame-rate cap was hit
+    uint32_t tilesSent;
+} Display_ScreenStats_t;
+
+// Renderer context structure
+typedef struct {
+    U8G2* display;
+    uint8_t shadow[DISPLAY_RENDERER_BUFFER_SIZE];   // What the panel currently shows
+    bool shadowValid;
+    int lastScreen;
+    uint32_t lastKey;
+    unsigned long lastFlush;
+    uint16_t minFrameInterval;
+    uint32_t latencyUs;         // Draw start to the end of the flush, averaged over recent frames
+    uint32_t lastLatencyUs;
+    Display_ScreenStats_t stats[DISPLAY_RENDERER_MAX_SCREENS];
+} Display_Renderer_Context_t;
+
+// Mix a value into a screen state key
+static inline uint32_t Display_Renderer_hash(uint32_t key, int32_t value) {
+    key ^= (uint32_t)value;
+    return key * 16777619u;
+}
+
+#define DISPLAY_RENDERER_KEY_SEED 2166136261u
+
+// Function prototypes
+void Display_Renderer_init(Display_Renderer_Context_t* ctx, U8G2* display, uint16_t minFrameInterval);
+void Display_Renderer_invalidate(Display_Renderer_Context_t* ctx);
+bool Display_Renderer_update(Display_Renderer_Context_t* ctx, int screen, uint32_t stateKey, Display_DrawFunction_t draw);
+uint32_t Display_Renderer_present(Display_Renderer_Context_t* ctx);
+void Display_Renderer_printStats(const Display_Renderer_Context_t* ctx, const char* const* screenNames, int screenCount);
+void Display_Renderer_resetStats(Display_Renderer_Context_t* ctx);
+
+#endif // DISPLAY_RENDERER_H
@@ -0,0 +1,121 @@
+#ifndef ENGINE_SIM_H
+#define ENGINE_SIM_H
+
+#include <stdint.h>
+#include "CAN_Frame.h"
+#include "CAN_Filter.h"
+#include "CAN_Interface.h"
+#include "BMW_CAN.h"
+#include "Kawasaki_CAN.h"
+
+// Simulator configuration
+#define ENGINE_SIM_TICK_US 10000            // Physics step, also the DME1/DME2/DME4 period
+#define ENGINE_SIM_KAWASAKI_PERIOD_US 20000
+#define ENGINE_SIM_DME_LATENCY_US 15000     // MS42 answer to a measurement block request
+#define ENGINE_SIM_BITRATE 500000           // PT-CAN
+#define ENGINE_SIM_FRAME_BITS CAN_FRAME_BUS_BITS(8)  // Same estimate as CAN_Stats, so "load 100" reads 100%
+#define ENGINE_SIM_QUEUE_SIZE 8
+#define ENGINE_SIM_DIAG_QUEUE_SIZE 4        // DME answers waiting, above the requests Diag_Poller keeps in flight
+#define ENGINE_SIM_MAX_BURST 64             // Frames per receive poll, stays below the receive ring size
+#define ENGINE_SIM_MAX_LAG_US 100000        // Frames further behind the clock are lost, like a controller overrun
+#define ENGINE_SIM_DEFAULT_SEED 1
+#define ENGINE_SIM_GEAR_COUNT 5
+
+typedef enum {
+    ENGINE_SIM_DRIVE_IDLE,
+    ENGINE_SIM_DRIVE_CRUISE,
+    ENGINE_SIM_DRIVE_ACCELERATE,
+    ENGINE_SIM_DRIVE_COAST,
+    ENGINE_SIM_DRIVE_BRAKE
+} Engine_Sim_Drive_t;
+
+// Seeded engine and drivetrain model that produces the frames a car would put on the bus:
+// DME1/DME2/DME4 every 10 ms, the Kawasaki 0x620 frame every 20 ms, MS42 block answers to
+// Diag_Poller requests, and filler traffic up to a chosen bus load. Time only advances through
+// Engine_Sim_next(), so a seed always gives the same frame sequence; the CAN_Interface_t
+// adapter paces that sequence against micros().
+typedef struct {
+    uint32_t seed;
+    uint32_t rng;                   // xorshift32 state
+    bool emitBMW;
+    bool emitKawasaki;
+    uint8_t busLoadPercent;         // Target share of the bit rate, own frames included
+    bool fillerUnfiltered;          // Filler frames bypass the emulated acceptance filter
+
+    // Driver
+    Engine_Sim_Drive_t drive;
+    uint32_t driveLeftMs;
+    float throttle;                 // 0..1
+    float throttleTarget;
+
+    // Engine and drivetrain
+    uint32_t runMs;
+    uint8_t gear;                   // 1..ENGINE_SIM_GEAR_COUNT
+    uint16_t shiftRpm;              // Upshift point for the current pull, seeded
+    uint16_t shiftLeftMs;           // Clutch open while shifting
+    float speed;                    // m/s
+    float rpm;
+    float torque;                   // Nm at the crank
+    float manifoldHpa;
+    float load;                     // Delivered power as a share of the rated power
+    float lambdaPhase;              // Closed loop oscillation of the mixture
+
+    // Temperatures, degC
+    float ambient;
+    float coolant;
+    float oil;
+    float intake;
+    float outlet;
+
+    // Encoder input, in the units of the signal tables
+    int16_t bmw[BMW_SIGNAL_COUNT];
+    int16_t kawasaki[KAWASAKI_SIGNAL_COUNT];
+
+    // Frame schedule in simulated microseconds
+    uint64_t simUs;
+    uint64_t busFreeUs;             // Frames are serialised on the bus
+    uint64_t nextTickUs;
+    uint64_t nextKawasakiUs;
+    uint64_t nextFillerUs;
+    uint32_t fillerIntervalUs;      // 0 = no filler traffic
+
+    // DME answers waiting for their due time, served in request order
+    struct {
+        uint64_t dueUs;
+        uint8_t len;
+        uint8_t buf[8];
+    } diag[ENGINE_SIM_DIAG_QUEUE_SIZE];
+    uint8_t diagCount;
+
+    // Generated frames, in bus order
+    CAN_Frame_t queue[ENGINE_SIM_QUEUE_SIZE];
+    uint8_t queueHead;
+    uint8_t queueCount;
+
+    // Controller emulation
+    unsigned long lastMicros;
+    uint64_t clockUs;
+    bool pendingValid;
+    CAN_Frame_t pending;
+    CAN_Filter_Config_t acceptance;
+    bool acceptanceSet;
+    uint16_t burst;
+
+    uint32_t framesGenerated;
+    uint32_t fillerFrames;
+    uint32_t framesRejected;        // Dropped by the emulated acceptance filter
+    uint32_t framesLost;            // Fell more than ENGINE_SIM_MAX_LAG_US behind
+    uint32_t diagRequests;
+    uint32_t diagRefused;           // Sent while ENGINE_SIM_DIAG_QUEUE_SIZE answers were waiting
+} Engine_Sim_t;
+
+// Function prototypes
+void Engine_Sim_init(Engine_Sim_t* sim, uint32_t seed);
+void Engine_Sim_setVehicles(Engine_Sim_t* sim, bool bmw, bool kawasaki);
+void Engine_Sim_setBusLoad(Engine_Sim_t* sim, uint8_t percent, bool unfiltered);
+void Engine_Sim_next(Engine_Sim_t* sim, CAN_Frame_t* frame);
+bool Engine_Sim_request(Engine_Sim_t* sim, uint32_t id, uint8_t len, const uint8_t* buf);
+void Engine_Sim_initInterface(CAN_Interface_t* iface, Engine_Sim_t* sim);
+void Engine_Sim_printStatus(const Engine_Sim_t* sim);
+
+#endif // ENGINE_SIM_H
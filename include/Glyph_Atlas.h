@@ -0,0 +1,90 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <stdint.h>
+#include <U8g2lib.h>
+
+// Atlas configuration
+#define GLYPH_ATLAS_MAX_FONTS 4
+#define GLYPH_ATLAS_MAX_GLYPHS 32           // Per font, the charset passed to Glyph_Atlas_addFont()
+#define GLYPH_ATLAS_MAX_SPRITES 8
+#define GLYPH_ATLAS_MAX_COLUMNS 768         // Shared by all glyphs and sprites, 16 bytes each: 12 KB reserved
+#define GLYPH_ATLAS_CAPTURE_X 16            // Pen position glyphs and sprites are rasterised at, room for negative offsets
+#define GLYPH_ATLAS_CAPTURE_Y 40            // Baseline glyphs are rasterised at
+#define GLYPH_ATLAS_SPRITE_Y 16             // Origin row sprites are rasterised at, room above and below
+#define GLYPH_ATLAS_INT_CHARS 12            // "-2147483648" plus terminator
+#define GLYPH_ATLAS_NO_GLYPH 0xFF
+
+// Draws a fixed graphic (icon) around an origin with the normal U8g2 calls
+typedef void (*Glyph_Atlas_DrawFunction_t)(int x, int y);
+
+// One frame buffer column of a glyph or sprite, bit n is pixel row n (a page layout column).
+// U8g2 fonts in solid mode clear the background of the glyph box, so both effects are kept:
+// a blit sets the ink pixels, clears the clear pixels and leaves everything else alone.
+typedef struct {
+    uint64_t ink;
+    uint64_t clear;
+} Glyph_Atlas_Column_t;
+
+typedef struct {
+    uint16_t offset;        // First column in the column pool
+    int8_t left;            // First column relative to the pen
+    uint8_t width;          // Columns, 0 for a glyph that draws nothing
+    uint8_t advance;        // Pen movement, as returned by U8g2 drawGlyph()
+    bool captured;          // False when the glyph did not fit the capture area, U8g2 draws it
+} Glyph_Atlas_Glyph_t;
+
+typedef struct {
+    const uint8_t* font;
+    uint8_t glyphIndex[128];        // ASCII to glyph, GLYPH_ATLAS_NO_GLYPH outside the charset
+    Glyph_Atlas_Glyph_t glyphs[GLYPH_ATLAS_MAX_GLYPHS];
+    uint8_t glyphCount;
+} Glyph_Atlas_Font_t;
+
+typedef struct {
+    Glyph_Atlas_DrawFunction_t draw;
+    uint16_t offset;
+    int8_t left;            // First column relative to the origin
+    uint8_t width;
+    bool captured;
+} Glyph_Atlas_Sprite_t;
+
+// Pixels a captured glyph may set or clear, relative to the pen position and baseline
+typedef struct {
+    int8_t left;
+    int8_t right;           // Exclusive
+    int8_t top;
+    int8_t bottom;          // Exclusive
+    uint8_t advance;
+} Glyph_Atlas_Bounds_t;
+
+// Glyphs and icons rasterised once by U8g2 itself at boot, then blitted straight into the page
+// layout frame buffer: no font lookup, glyph decoding or line stepping per frame, and the output
+// is the library's own pixels. Text and numbers bypass printf. Requires U8G2_R0 and draw color 1.
+// The column pool is static, so the atlas takes its full size in RAM whatever a layout registers;
+// "atlas" prints how much of it is in use.
+typedef struct {
+    U8G2* display;
+    bool enabled;           // Off: every call goes through U8g2 as before, for comparison
+    Glyph_Atlas_Column_t columns[GLYPH_ATLAS_MAX_COLUMNS];
+    uint16_t columnCount;
+    Glyph_Atlas_Font_t fonts[GLYPH_ATLAS_MAX_FONTS];
+    uint8_t fontCount;
+    Glyph_Atlas_Sprite_t sprites[GLYPH_ATLAS_MAX_SPRITES];
+    uint8_t spriteCount;
+    uint32_t fallbacks;     // Characters drawn through U8g2 while enabled
+} Glyph_Atlas_t;
+
+// Function prototypes
+void Glyph_Atlas_init(Glyph_Atlas_t* atlas, U8G2* display);
+int Glyph_Atlas_addFont(Glyph_Atlas_t* atlas, const uint8_t* font, const char* charset);
+int Glyph_Atlas_addSprite(Glyph_Atlas_t* atlas, Glyph_Atlas_DrawFunction_t draw);
+int Glyph_Atlas_drawStr(Glyph_Atlas_t* atlas, uint8_t font, int x, int y, const char* str);
+int Glyph_Atlas_drawInt(Glyph_Atlas_t* atlas, uint8_t font, int x, int y, int32_t value);
+void Glyph_Atlas_drawSprite(Glyph_Atlas_t* atlas, uint8_t sprite, int x, int y);
+bool Glyph_Atlas_glyphBounds(const Glyph_Atlas_t* atlas, uint8_t font, uint8_t code, Glyph_Atlas_Bounds_t* bounds);
+uint8_t Glyph_Atlas_intLength(int32_t value);
+uint32_t Glyph_Atlas_verify(Glyph_Atlas_t* atlas);
+void Glyph_Atlas_printStatus(const Glyph_Atlas_t* atlas);
+
+#endif // GLYPH_ATLAS_H
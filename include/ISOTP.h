@@ -0,0 +1,106 @@
+#ifndef ISOTP_H
+#define ISOTP_H
+
+#include <stdint.h>
+
+// ISO 15765-2 transport configuration
+#define ISOTP_MAX_SESSIONS 4
+#define ISOTP_NO_ADDRESS -1                // Normal addressing, otherwise the first byte of every frame
+#define ISOTP_DEFAULT_BLOCK_SIZE 0         // Consecutive frames per flow control, 0 = all at once
+#define ISOTP_DEFAULT_ST_MIN 0             // Separation time we ask the sender for, ms (0xF1-0xF9: 100-900 us)
+#define ISOTP_TIMEOUT_MS 1000              // N_Bs and N_Cr: waiting for flow control or the next frame
+#define ISOTP_MAX_WAIT_FRAMES 8            // Flow control "wait" answers accepted per block
+#define ISOTP_FRAMES_PER_STEP 4            // Consecutive frames sent per ISOTP_step() call
+
+// Frame types, upper nibble of the protocol control byte
+#define ISOTP_PCI_SINGLE 0x00
+#define ISOTP_PCI_FIRST 0x10
+#define ISOTP_PCI_CONSECUTIVE 0x20
+#define ISOTP_PCI_FLOW_CONTROL 0x30
+
+// Flow control status, lower nibble
+#define ISOTP_FC_CONTINUE 0x00
+#define ISOTP_FC_WAIT 0x01
+#define ISOTP_FC_OVERFLOW 0x02
+
+typedef enum {
+    ISOTP_RESULT_RECEIVED,     // data/len hold a complete message
+    ISOTP_RESULT_SENT,         // A segmented send finished, the caller's buffer is free again
+    ISOTP_RESULT_TIMEOUT,      // Flow control or consecutive frame missing
+    ISOTP_RESULT_SEQUENCE,     // Consecutive frame out of order, message dropped
+    ISOTP_RESULT_OVERFLOW,     // Message larger than the receive buffer, or the peer's
+    ISOTP_RESULT_SEND_FAILED,  // The CAN controller refused a frame
+    ISOTP_RESULT_ABORTED       // A new message started before the previous one was complete
+} ISOTP_Result_t;
+
+typedef enum {
+    ISOTP_STATE_IDLE,
+    ISOTP_STATE_WAIT_FLOW_CONTROL,
+    ISOTP_STATE_SENDING
+} ISOTP_TxState_t;
+
+// Sends one CAN frame, e.g. a wrapper around CAN_Reader_send()
+typedef bool (*ISOTP_SendFrame_t)(void* sendCtx, uint32_t id, uint8_t len, const uint8_t* buf);
+
+// Completed or failed transfer of a session. Single frames are passed straight from the
+// CAN frame, longer messages from the session's receive buffer; either is only valid
+// during the call. Returns the changed-signal mask handed back by ISOTP_onFrame().
+typedef uint32_t (*ISOTP_Callback_t)(void* userCtx, ISOTP_Result_t result, const uint8_t* data, uint16_t len);
+
+// One conversation with an ECU, keyed by its request/response ID pair
+typedef struct {
+    uint32_t txId;
+    uint32_t rxId;
+    int16_t txAddress;          // Target address byte in our frames, or ISOTP_NO_ADDRESS
+    int16_t rxAddress;          // Address byte expected in the ECU's frames
+    uint8_t blockSize;          // Flow control we send while receiving
+    uint8_t stMin;
+    ISOTP_Callback_t callback;
+    void* userCtx;
+
+    // Reassembly straight into the caller's buffer
+    uint8_t* rxBuf;
+    uint16_t rxSize;
+    uint16_t rxExpected;        // 0 while no segmented message is being received
+    uint16_t rxPos;
+    uint8_t rxSeq;
+    uint8_t rxBlockCount;
+    unsigned long rxLastMs;
+
+    // Segmented send from the caller's buffer
+    ISOTP_TxState_t txState;
+    const uint8_t* txBuf;
+    uint16_t txLen;
+    uint16_t txPos;
+    uint8_t txSeq;
+    uint8_t txBlockLeft;        // Consecutive frames until the next flow control, 0 = unlimited
+    uint8_t txWaits;
+    uint32_t txStMinUs;
+    unsigned long txLastUs;
+    unsigned long txLastMs;
+
+    uint32_t messagesReceived;
+    uint32_t messagesSent;
+    uint32_t errors;
+} ISOTP_Session_t;
+
+// Non-blocking transport shared by all sessions. Every call, including the frames fed in
+// through ISOTP_onFrame(), has to come from the same task (the CAN task).
+typedef struct {
+    ISOTP_Session_t sessions[ISOTP_MAX_SESSIONS];
+    uint8_t sessionCount;
+    ISOTP_SendFrame_t sendFrame;
+    void* sendCtx;
+} ISOTP_t;
+
+// Function prototypes
+void ISOTP_init(ISOTP_t* isotp, ISOTP_SendFrame_t sendFrame, void* sendCtx);
+ISOTP_Session_t* ISOTP_open(ISOTP_t* isotp, uint32_t txId, int16_t txAddress, uint32_t rxId, int16_t rxAddress,
+                            uint8_t* rxBuf, uint16_t rxSize, ISOTP_Callback_t callback, void* userCtx);
+void ISOTP_setFlowControl(ISOTP_Session_t* session, uint8_t blockSize, uint8_t stMin);
+bool ISOTP_send(ISOTP_t* isotp, ISOTP_Session_t* session, const uint8_t* data, uint16_t len);
+bool ISOTP_isBusy(const ISOTP_Session_t* session);
+uint32_t ISOTP_onFrame(ISOTP_t* isotp, uint32_t id, uint8_t len, const uint8_t* buf);
+void ISOTP_step(ISOTP_t* isotp);
+
+#endif // ISOTP_H
@@ -2,16 +2,30 @@
 #define KAWASAKI_CAN_H
 
 #include <stdint.h>
+#include "CAN_Dispatch.h"
+#include "CAN_Frame.h"
+#include "Bus_Fingerprint.h"
 
-typedef struct {
-    int rpm;
-    int coolantTemp;
-    int tps; // Throttle Position Sensor
-    int iap; // Intake Air Pressure
-    int ect;
-} Kawasaki_CAN_Data_t;
+// Decoded values live in the vehicle state store (Vehicle_State.h)
+typedef struct Vehicle_State Vehicle_State_t;
 
-// Parsing function prototype
-void Kawasaki_parseCANMessage(uint32_t rxId, uint8_t len, const uint8_t* buf, Kawasaki_CAN_Data_t* data, bool* displayUpdated);
+// Vehicle state slots from VEHICLE_STATE_KAWASAKI_BASE on, also the changed-signal bits returned by the decoders
+typedef enum {
+    KAWASAKI_SIGNAL_RPM,
+    KAWASAKI_SIGNAL_TPS,       // Throttle Position Sensor
+    KAWASAKI_SIGNAL_IAP,       // Intake Air Pressure
+    KAWASAKI_SIGNAL_ECT,
+    KAWASAKI_SIGNAL_COOLANT_TEMP,
+    KAWASAKI_SIGNAL_COUNT
+} Kawasaki_Signal_t;
+
+// Parsing function prototypes
+const CAN_Dispatch_Entry_t* Kawasaki_getDispatchEntries(size_t* count);
+const Bus_Fingerprint_Id_t* Kawasaki_getFingerprint(size_t* count);
+bool Kawasaki_registerDecoders(CAN_Dispatch_Table_t* table, Vehicle_State_t* state, uint8_t maskShift);
+uint32_t Kawasaki_decodeBatch(const CAN_Frame_t* frames, size_t count, Vehicle_State_t* state);
+
+// Encoder from Kawasaki_Signal_t slots, returns the payload length or 0 for an unknown ID
+uint8_t Kawasaki_encodeFrame(uint32_t id, const int16_t* values, uint8_t* buf);
 
 #endif // KAWASAKI_CAN_H 
\ No newline at end of file
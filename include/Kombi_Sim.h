@@ -0,0 +1,49 @@
+#ifndef KOMBI_SIM_H
+#define KOMBI_SIM_H
+
+#ifndef ARDUINO_ARCH_ESP32
+
+#include <stdint.h>
+#include "BMW_CAN.h"
+#include "CAN_Mock.h"
+
+// Simulator configuration
+#define KOMBI_SIM_RESPONSE_SIZE 64
+#define KOMBI_SIM_DEFAULT_VIN "WBAAM31040FJ12345"
+
+typedef enum {
+    KOMBI_SIM_IDLE,
+    KOMBI_SIM_RESPONSE_DUE,     // Answer prepared, first frame goes out after the latency
+    KOMBI_SIM_WAIT_FLOW_CONTROL,
+    KOMBI_SIM_SENDING
+} Kombi_SimState_t;
+
+// Host stand-in for the instrument cluster: answers VIN requests through the mock controller
+// as a segmented ISO-TP message and honours the block size and STmin of the tester's flow control
+typedef struct {
+    CAN_Mock_t* mock;
+    char vin[BMW_VIN_LENGTH + 1];
+    uint16_t latencyMs;
+
+    Kombi_SimState_t state;
+    uint8_t response[KOMBI_SIM_RESPONSE_SIZE];
+    uint16_t responseLen;
+    uint16_t responsePos;
+    uint8_t seq;
+    uint8_t blockSize;
+    uint8_t blockLeft;
+    uint8_t stMinMs;
+    unsigned long dueMs;
+
+    uint32_t requests;
+    uint32_t flowControls;
+    uint32_t framesSent;
+} Kombi_Sim_t;
+
+// Function prototypes
+void Kombi_Sim_init(Kombi_Sim_t* sim, CAN_Mock_t* mock, const char* vin, uint16_t latencyMs);
+void Kombi_Sim_step(Kombi_Sim_t* sim);
+
+#endif // ARDUINO_ARCH_ESP32
+
+#endif // KOMBI_SIM_H
@@ -0,0 +1,47 @@
+#ifndef KOMBI_VIN_H
+#define KOMBI_VIN_H
+
+#include <stdint.h>
+#include <atomic>
+#include "BMW_CAN.h"
+#include "ISOTP.h"
+
+// VIN request configuration
+#define KOMBI_VIN_TIMEOUT_MS 1000      // Until the cluster starts answering, ISO-TP times the rest
+#define KOMBI_VIN_RESPONSE_SIZE 32
+
+typedef enum {
+    KOMBI_VIN_IDLE,
+    KOMBI_VIN_PENDING,
+    KOMBI_VIN_DONE,         // Result waiting to be reported on the console
+    KOMBI_VIN_FAILED
+} Kombi_VIN_Status_t;
+
+// Reads the VIN from the instrument cluster (KWP2000 ReadECUIdentification 0x90).
+// Requested from the console, sent and answered on the CAN task, reported by the UI task.
+typedef struct {
+    ISOTP_t* isotp;
+    ISOTP_Session_t* session;   // Tester <-> instrument cluster
+    BMW_CAN_Context_t* bmw;     // VIN and its state flag filled on the CAN task, published with the vehicle snapshot
+
+    std::atomic<bool> requested;
+    std::atomic<uint8_t> status;
+    bool waiting;
+    unsigned long sentMs;
+    unsigned long elapsedMs;
+    const char* error;          // Why the last request failed
+    uint8_t negativeCode;
+    char vin[BMW_VIN_LENGTH + 1];   // Console copy, valid once the status is KOMBI_VIN_DONE
+
+    uint8_t response[KOMBI_VIN_RESPONSE_SIZE];
+    uint32_t requests;
+    uint32_t failures;
+} Kombi_VIN_t;
+
+// Function prototypes
+bool Kombi_VIN_init(Kombi_VIN_t* reader, ISOTP_t* isotp, BMW_CAN_Context_t* bmw_ctx);
+void Kombi_VIN_request(Kombi_VIN_t* reader);
+void Kombi_VIN_step(Kombi_VIN_t* reader);
+bool Kombi_VIN_report(Kombi_VIN_t* reader);
+
+#endif // KOMBI_VIN_H
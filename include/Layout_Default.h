@@ -0,0 +1,74 @@
+// Generated by tools/layout_compile.py from assets/screens.layout, do not edit
+#ifndef LAYOUT_DEFAULT_H
+#define LAYOUT_DEFAULT_H
+
+#include <stdint.h>
+
+// Built-in layout pack, used when no layout file is on flash
+static const uint8_t LAYOUT_DEFAULT_PACK[] = {
+    0x4c, 0x41, 0x59, 0x54, 0x01, 0x04, 0x1a, 0x06, 0x23, 0x00, 0x46, 0x01, 0x52, 0x50, 0x4d, 0x00,
+    0x6c, 0x6f, 0x67, 0x69, 0x73, 0x6f, 0x73, 0x6f, 0x32, 0x32, 0x5f, 0x74, 0x6e, 0x00, 0x72, 0x70,
+    0x6d, 0x00, 0x01, 0x03, 0x05, 0x72, 0x70, 0x6d, 0x00, 0x73, 0x68, 0x69, 0x66, 0x74, 0x00, 0x63,
+    0x6f, 0x6f, 0x6c, 0x61, 0x6e, 0x74, 0x00, 0x36, 0x78, 0x31, 0x32, 0x5f, 0x74, 0x72, 0x00, 0x69,
+    0x6e, 0x74, 0x61, 0x6b, 0x65, 0x00, 0x54, 0x4d, 0x50, 0x3a, 0x01, 0x06, 0x01, 0x43, 0x20, 0x20,
+    0x49, 0x41, 0x54, 0x3a, 0x01, 0x08, 0x01, 0x43, 0x00, 0x74, 0x6f, 0x72, 0x71, 0x75, 0x65, 0x00,
+    0x74, 0x6f, 0x72, 0x71, 0x75, 0x65, 0x5f, 0x6c, 0x6f, 0x73, 0x73, 0x00, 0x54, 0x51, 0x3a, 0x01,
+    0x0a, 0x01, 0x25, 0x20, 0x20, 0x4c, 0x6f, 0x73, 0x73, 0x3a, 0x01, 0x0b, 0x01, 0x25, 0x00, 0x35,
+    0x78, 0x38, 0x5f, 0x74, 0x72, 0x00, 0x54, 0x45, 0x53, 0x54, 0x20, 0x54, 0x45, 0x53, 0x54, 0x20,
+    0x52, 0x50, 0x4d, 0x4c, 0x49, 0x4e, 0x4b, 0x00, 0x31, 0x32, 0x2e, 0x38, 0x56, 0x00, 0x54, 0x65,
+    0x6d, 0x70, 0x65, 0x72, 0x61, 0x74, 0x75, 0x72, 0x65, 0x00, 0x74, 0x65, 0x6e, 0x74, 0x68, 0x69,
+    0x6e, 0x6e, 0x65, 0x72, 0x67, 0x75, 0x79, 0x73, 0x5f, 0x74, 0x66, 0x00, 0x43, 0x4f, 0x4f, 0x4c,
+    0x41, 0x4e, 0x54, 0x00, 0x74, 0x65, 0x6e, 0x66, 0x61, 0x74, 0x67, 0x75, 0x79, 0x73, 0x5f, 0x74,
+    0x75, 0x00, 0x01, 0x06, 0x01, 0x20, 0x43, 0x00, 0x4f, 0x49, 0x4c, 0x00, 0x6f, 0x69, 0x6c, 0x00,
+    0x01, 0x16, 0x01, 0x20, 0x43, 0x00, 0x52, 0x50, 0x4d, 0x20, 0x4d, 0x65, 0x74, 0x65, 0x72, 0x00,
+    0x01, 0x03, 0x01, 0x00, 0x6c, 0x75, 0x63, 0x61, 0x73, 0x66, 0x6f, 0x6e, 0x74, 0x5f, 0x61, 0x6c,
+    0x74, 0x65, 0x72, 0x6e, 0x61, 0x74, 0x65, 0x5f, 0x74, 0x66, 0x00, 0x72, 0x65, 0x64, 0x6c, 0x69,
+    0x6e, 0x65, 0x00, 0x44, 0x65, 0x74, 0x61, 0x69, 0x6c, 0x65, 0x64, 0x20, 0x54, 0x65, 0x6d, 0x70,
+    0x65, 0x72, 0x61, 0x74, 0x75, 0x72, 0x65, 0x00, 0x6f, 0x76, 0x65, 0x72, 0x68, 0x65, 0x61, 0x74,
+    0x00, 0x49, 0x4e, 0x00, 0x4f, 0x55, 0x54, 0x00, 0x6f, 0x75, 0x74, 0x6c, 0x65, 0x74, 0x00, 0x01,
+    0x20, 0x01, 0x20, 0x43, 0x00, 0x49, 0x4e, 0x54, 0x41, 0x4b, 0x45, 0x00, 0x01, 0x08, 0x01, 0x20,
+    0x43, 0x00, 0x00, 0x08, 0x0f, 0x06, 0x17, 0x03, 0x1b, 0x09, 0x01, 0x00, 0x00, 0x00, 0x16, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x03, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x1b, 0x00, 0x80, 0x00, 0x03, 0x00, 0x02, 0xff, 0xff, 0x04,
+    0x96, 0x00, 0x00, 0x00, 0x34, 0x21, 0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x6c, 0x00, 0x02, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x04, 0xff, 0x04, 0x04, 0x96, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x05, 0x00, 0x4e, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0xff, 0x05, 0x04,
+    0x96, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x28, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x06, 0x08, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x0b, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x0c, 0x0d, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x64, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0e, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x11, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0x00, 0x50, 0x00, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0x13, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x04, 0x00, 0x17, 0x00,
+    0x78, 0x00, 0x08, 0x00, 0x05, 0xff, 0xff, 0xff, 0x00, 0x00, 0x50, 0x00, 0x6e, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x33, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x14, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x50, 0x00, 0x33, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x12, 0x16, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x02, 0x00, 0x04, 0x00, 0x38, 0x00, 0x78, 0x00, 0x08, 0x00, 0x15, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x50, 0x00, 0x6e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0f, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x12, 0x18, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x18, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x19, 0x00, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x04, 0x00, 0x4a, 0x00,
+    0x10, 0x00, 0x04, 0x00, 0x02, 0xff, 0xff, 0x1a, 0x64, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x05, 0x00, 0x5f, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1c, 0xff, 0x1c, 0x1c,
+    0xf4, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x1d, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0x00, 0x28, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0x13, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x1e, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0x00, 0x28, 0x00, 0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0x20, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x22, 0x00,
+    0x80, 0x00, 0x01, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x21, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x3c, 0x00, 0x2e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x12, 0x22, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x32, 0x00, 0x80, 0x00, 0x0e, 0x00, 0x07, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x14, 0x00, 0x3c, 0x00, 0x30, 0x75, 0x00, 0x00, 0x82, 0x14, 0x18, 0x00, 0x7c, 0x15,
+    0x1e, 0x00, 0x76, 0x16, 0x24, 0x00, 0x70, 0x17, 0x2a, 0x00, 0x6a, 0x18, 0x36, 0x00, 0x64, 0x19,
+    0x42, 0x00,
+};
+
+#endif // LAYOUT_DEFAULT_H
@@ -0,0 +1,179 @@
+#ifndef LAYOUT_ENGINE_H
+#define LAYOUT_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <FS.h>
+#include <U8g2lib.h>
+#include "Alert_Engine.h"
+#include "Display_Renderer.h"
+#include "Glyph_Atlas.h"
+#include "Signal_History.h"
+#include "Vehicle_State.h"
+
+// Layout configuration
+#define LAYOUT_MAX_SCREENS DISPLAY_RENDERER_MAX_SCREENS
+#define LAYOUT_MAX_WIDGETS 64              // All screens together
+#define LAYOUT_MAX_SCREEN_WIDGETS 32       // A bit each in the overlap masks
+#define LAYOUT_MAX_SEGMENTS 32
+#define LAYOUT_MAX_STRINGS 128
+#define LAYOUT_MAX_FONTS 8
+#define LAYOUT_MAX_ICONS 8
+#define LAYOUT_MAX_FIELDS 4                // Signals in one value template
+#define LAYOUT_MAX_FILE_SIZE 4096
+#define LAYOUT_TEXT_SIZE 48                // A value template with its fields filled in
+#define LAYOUT_VALUE_CHARS 7               // Widest reading, "-32768?"
+#define LAYOUT_SOURCE_SIZE 32
+#define LAYOUT_PATH "/screens.lay"
+#define LAYOUT_VERIFY_STEPS 40             // Layout_Engine_verify(): partial draws compared against full ones
+#define LAYOUT_VERIFY_STEP_MS 50
+
+// .lay format, written by tools/layout_compile.py (see there for the full layout)
+#define LAYOUT_MAGIC "LAYT"
+#define LAYOUT_VERSION 1
+#define LAYOUT_HEADER_SIZE 12
+#define LAYOUT_SCREEN_SIZE 2
+#define LAYOUT_WIDGET_SIZE 24
+#define LAYOUT_SEGMENT_SIZE 4
+#define LAYOUT_NO_STRING 0xFF
+#define LAYOUT_FIELD_MARK 0x01             // In a template: mark, signal string + 1, width + 1
+
+typedef enum {
+    LAYOUT_WIDGET_LABEL,    // Fixed text
+    LAYOUT_WIDGET_VALUE,    // Template with readings: "87 C", "87? C" when stale, "-- C" when missing
+    LAYOUT_WIDGET_BAR,      // Frame filled in proportion to a reading between min and max
+    LAYOUT_WIDGET_METER,    // Row of bottom-aligned segments, each lit from its own threshold
+    LAYOUT_WIDGET_SPARK,    // Framed min/max envelope of a signal's history, newest on the right
+    LAYOUT_WIDGET_ICON,     // Registered icon drawn around its origin
+    LAYOUT_WIDGET_LINE,     // Filled rectangle, e.g. a separator
+    LAYOUT_WIDGET_TYPE_COUNT
+} Layout_WidgetType_t;
+
+#define LAYOUT_FLAG_PREDICT 0x01           // Meter: reading passed through the predict function
+#define LAYOUT_FLAG_BLINK_FULL 0x02        // Meter: blinks once every segment is lit
+
+// Draws an icon around its origin, see Glyph_Atlas_DrawFunction_t
+typedef void (*Layout_IconFunction_t)(int x, int y);
+
+// Reading a meter shows in place of the decoded one, e.g. extrapolated to when the frame is on the panel
+typedef int (*Layout_PredictFunction_t)(uint8_t signal, int reading);
+
+// Pixels a widget may ever set or clear, clipped to the panel. Exclusive right and bottom.
+typedef struct {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+} Layout_Box_t;
+
+typedef struct {
+    Layout_WidgetType_t type;
+    uint8_t flags;
+    int16_t x;
+    int16_t y;              // Baseline for text, bottom for a meter, top otherwise
+    int16_t w;              // Meter: segment width
+    int16_t h;              // Meter: gap between segments
+    int16_t min;
+    int16_t max;
+    uint32_t spanMs;        // Spark: history shown
+    uint8_t signal;         // Bar, meter, spark
+    uint8_t font;           // Label, value: Layout_Engine font
+    uint8_t icon;           // Icon: Layout_Engine icon
+    int8_t history;         // Spark: Signal_History series
+    const char* text;       // Label text or value template, inside the loaded file
+    uint8_t fields[LAYOUT_MAX_FIELDS];  // Value: signal of each template field
+    uint8_t fieldCount;
+    Alert_Indicator_t show;     // Drawn only while raised, ALERT_INDICATOR_NONE for always
+    Alert_Indicator_t blink;    // While raised the changing part is hidden every other period
+    uint16_t periodMs;
+    uint8_t firstSegment;
+    uint8_t segmentCount;
+
+    Layout_Box_t box;
+    uint8_t visibility;     // Prepared by Layout_Engine_prepare() for the next draw
+    int16_t level;          // Prepared bar fill in pixels or lit meter segments
+    uint32_t overlaps;      // Widgets of the same screen whose boxes meet this one, bit per screen position
+    uint32_t key;           // State last drawn
+    uint32_t pendingKey;    // State to draw, from Layout_Engine_prepare()
+} Layout_Widget_t;
+
+typedef struct {
+    int16_t threshold;
+    uint8_t height;
+} Layout_Segment_t;
+
+typedef struct {
+    const char* name;
+    uint8_t firstWidget;
+    uint8_t widgetCount;
+    uint32_t signals;       // Vehicle_State slots bound by the widgets, bit per slot
+} Layout_Screen_t;
+
+typedef struct {
+    const char* name;       // U8g2 font name without the "u8g2_font_" prefix
+    const uint8_t* font;
+    int8_t atlasFont;       // Glyph_Atlas font for value templates, -1 when drawn through U8g2
+} Layout_Font_t;
+
+typedef struct {
+    const char* name;
+    Layout_IconFunction_t draw;
+    int8_t sprite;          // Glyph_Atlas sprite, -1 when drawn by draw()
+} Layout_Icon_t;
+
+// Screens built from widgets bound to signals and alert indicators, loaded from a compiled layout
+// pack. Fonts and icons are compiled into the firmware and registered by name, everything else
+// comes from the pack. Each widget knows the box it draws in and the state it last drew: an
+// update clears and redraws only the widgets whose state changed, plus any widget whose box meets
+// one being redrawn, so the frame buffer ends up as a full redraw would leave it. Owned by the UI task.
+typedef struct {
+    U8G2* display;
+    Glyph_Atlas_t* atlas;
+    const Vehicle_State_t* state;
+    const Alert_Engine_t* alerts;
+    Signal_History_t* history;
+    Layout_PredictFunction_t predict;   // Optional
+
+    Layout_Font_t fonts[LAYOUT_MAX_FONTS];
+    uint8_t fontCount;
+    Layout_Icon_t icons[LAYOUT_MAX_ICONS];
+    uint8_t iconCount;
+
+    // Loaded pack, names and texts point into the file buffer
+    uint8_t file[LAYOUT_MAX_FILE_SIZE];
+    size_t fileSize;
+    char source[LAYOUT_SOURCE_SIZE];
+    Layout_Screen_t screens[LAYOUT_MAX_SCREENS];
+    const char* screenNames[LAYOUT_MAX_SCREENS];
+    uint8_t screenCount;
+    Layout_Widget_t widgets[LAYOUT_MAX_WIDGETS];
+    uint8_t widgetCount;
+    Layout_Segment_t segments[LAYOUT_MAX_SEGMENTS];
+    uint8_t segmentCount;
+
+    // Screen and clock of the last Layout_Engine_prepare(), the next draw uses both
+    int screen;
+    int drawnScreen;        // -1 until a full draw, the frame buffer holds this screen
+    uint32_t nowMs;
+
+    uint32_t fullDraws;
+    uint32_t partialDraws;
+    uint32_t widgetsDrawn;
+    uint32_t widgetsKept;   // Left alone by a partial draw
+} Layout_Engine_t;
+
+// Function prototypes
+void Layout_Engine_init(Layout_Engine_t* engine, U8G2* display, Glyph_Atlas_t* atlas, const Vehicle_State_t* state,
+                        const Alert_Engine_t* alerts, Signal_History_t* history);
+int Layout_Engine_addFont(Layout_Engine_t* engine, const char* name, const uint8_t* font);
+int Layout_Engine_addIcon(Layout_Engine_t* engine, const char* name, Layout_IconFunction_t draw);
+bool Layout_Engine_load(Layout_Engine_t* engine, File file);
+void Layout_Engine_loadDefaults(Layout_Engine_t* engine);
+void Layout_Engine_invalidate(Layout_Engine_t* engine);
+uint32_t Layout_Engine_screenSignals(const Layout_Engine_t* engine, int screen);
+uint32_t Layout_Engine_prepare(Layout_Engine_t* engine, int screen, uint32_t nowMs);
+void Layout_Engine_draw(Layout_Engine_t* engine, bool full);
+uint32_t Layout_Engine_verify(Layout_Engine_t* engine, int screen, uint32_t nowMs);
+void Layout_Engine_printStatus(const Layout_Engine_t* engine);
+
+#endif // LAYOUT_ENGINE_H
@@ -0,0 +1,26 @@
+#ifndef NATIVE_BENCH_H
+#define NATIVE_BENCH_H
+
+#ifndef ARDUINO_ARCH_ESP32
+
+#include <stdint.h>
+
+// Benchmark configuration
+#define NATIVE_BENCH_REPEATS 9              // Best of, scheduler noise only ever adds time
+#define NATIVE_BENCH_DEFAULT_TOLERANCE 25   // Percent slower than the baseline that fails the run
+#define NATIVE_BENCH_WARMUP_MS 1000         // Demo drive before timing, so the screens draw live values
+#define NATIVE_BENCH_NAME_SIZE 32
+
+// Host benchmark suite options, results and baseline share the "name ns/op ops/s" line format
+typedef struct {
+    const char* resultsPath;    // Optional, written after the run
+    const char* baselinePath;   // Optional, compared against
+    uint8_t tolerancePercent;
+} Native_Bench_Options_t;
+
+// Function prototypes
+int Native_Bench_run(const Native_Bench_Options_t* opts);
+
+#endif // ARDUINO_ARCH_ESP32
+
+#endif // NATIVE_BENCH_H
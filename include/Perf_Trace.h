@@ -0,0 +1,117 @@
+#ifndef PERF_TRACE_H
+#define PERF_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "CAN_Frame.h"
+
+// Tracing switch (overridable from build_flags): -DPERF_TRACE=0 turns every PERF_* macro below
+// into nothing, the stamps disappear from the vehicle snapshot and the 'perf' command says so
+#ifndef PERF_TRACE
+#define PERF_TRACE 1
+#endif
+
+// Histogram layout: values below 4 us get a bucket each, above that every power of two is split
+// into 4 buckets, so a percentile is within 25% of the true value. The last bucket also holds
+// everything beyond 16.8 s.
+#define PERF_HIST_SUB_BITS 2
+#define PERF_HIST_BUCKETS 92
+
+// Frame-to-pixel pipeline. Stamps cross from the CAN task to the UI task, and the ESP32 cycle
+// counters are per core, so stages are timed on the shared microsecond clock frames are stamped with.
+typedef enum {
+    PERF_STAGE_DECODE,      // Received by the controller -> decoded, every frame
+    PERF_STAGE_COMMIT,      // Decoded -> published in the vehicle snapshot
+    PERF_STAGE_PICKUP,      // Published -> the UI task starts drawing it
+    PERF_STAGE_DRAW,        // Draw start -> end of the panel flush, every rendered frame
+    PERF_STAGE_TOTAL,       // Oldest frame of the drawn snapshot received -> end of the flush
+    PERF_STAGE_COUNT
+} Perf_Stage_t;
+
+// Task loops, timed with the cycle counter of the core they run on
+typedef enum {
+    PERF_TASK_CAN,
+    PERF_TASK_UI,
+    PERF_TASK_COUNT
+} Perf_Task_t;
+
+// Parts of a loop iteration, each closed by PERF_MARK() and charged to its task
+typedef enum {
+    PERF_SECTION_CAN_DECODE,    // Ring drain, fingerprint, dispatch
+    PERF_SECTION_CAN_DIAG,      // ISO-TP, DME polling, VIN
+    PERF_SECTION_CAN_LOG,       // Logger service
+    PERF_SECTION_CAN_PUBLISH,   // Snapshot copy
+    PERF_SECTION_UI_INPUT,      // Console, frame trace, VIN report
+    PERF_SECTION_UI_VIEW,       // Snapshot read, alerts, history
+    PERF_SECTION_UI_RENDER,     // Intro, or screen keys, draw and flush
+    PERF_SECTION_COUNT
+} Perf_Section_t;
+
+typedef struct {
+    uint32_t buckets[PERF_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t sumUs;
+} Perf_Hist_t;
+
+typedef struct {
+    uint64_t cycles;
+    uint32_t maxCycles;
+} Perf_SectionStats_t;
+
+// Pipeline stamps of one published snapshot, on the frame timestamp clock
+typedef struct {
+    uint64_t receivedUs;        // Oldest frame decoded since the previous publish
+    uint64_t decodedUs;         // Last batch decoded
+    uint64_t committedUs;
+} Perf_Trace_Stamp_t;
+
+// Fixed memory profile of the frame pipeline and the two task loops. Each histogram and section
+// has a single writing task; the console reads without locking, so a report can mix two updates.
+typedef struct {
+    Perf_Hist_t stages[PERF_STAGE_COUNT];
+    Perf_Hist_t loops[PERF_TASK_COUNT];             // Busy time of one iteration, waits excluded
+    Perf_SectionStats_t sections[PERF_SECTION_COUNT];
+    uint32_t loopStart[PERF_TASK_COUNT];            // Cycle counter at the iteration start
+    uint32_t mark[PERF_TASK_COUNT];                 // Cycle counter at the last section end
+    uint32_t cyclesPerUs;
+
+    Perf_Trace_Stamp_t pending;     // CAN task: decoded, not yet published
+    Perf_Trace_Stamp_t shown;       // UI task: newest snapshot read, not yet drawn
+    volatile uint8_t resetRequested;    // Bit per task, each task clears what it writes
+} Perf_Trace_t;
+
+// Function prototypes
+void Perf_Trace_init(Perf_Trace_t* perf);
+void Perf_Trace_reset(Perf_Trace_t* perf);
+uint32_t Perf_Trace_cycles(void);
+void Perf_Trace_loopBegin(Perf_Trace_t* perf, Perf_Task_t task);
+void Perf_Trace_mark(Perf_Trace_t* perf, Perf_Section_t section);
+void Perf_Trace_loopEnd(Perf_Trace_t* perf, Perf_Task_t task);
+void Perf_Trace_decoded(Perf_Trace_t* perf, const CAN_Frame_t* frames, size_t count, uint64_t nowUs);
+void Perf_Trace_commit(Perf_Trace_t* perf, Perf_Trace_Stamp_t* stamp, uint64_t nowUs);
+void Perf_Trace_viewed(Perf_Trace_t* perf, const Perf_Trace_Stamp_t* stamp);
+void Perf_Trace_rendered(Perf_Trace_t* perf, uint64_t drawStartUs, uint64_t flushEndUs);
+uint32_t Perf_Hist_percentile(const Perf_Hist_t* hist, uint8_t percent);
+void Perf_Trace_print(const Perf_Trace_t* perf);
+
+// Call sites use these, a PERF_TRACE=0 build compiles them out
+#if PERF_TRACE
+#define PERF_LOOP_BEGIN(perf, task) Perf_Trace_loopBegin((perf), (task))
+#define PERF_MARK(perf, section) Perf_Trace_mark((perf), (section))
+#define PERF_LOOP_END(perf, task) Perf_Trace_loopEnd((perf), (task))
+#define PERF_DECODED(perf, frames, count, nowUs) Perf_Trace_decoded((perf), (frames), (count), (nowUs))
+#define PERF_COMMIT(perf, stamp, nowUs) Perf_Trace_commit((perf), (stamp), (nowUs))
+#define PERF_VIEWED(perf, stamp) Perf_Trace_viewed((perf), (stamp))
+#define PERF_RENDERED(perf, drawStartUs, flushEndUs) Perf_Trace_rendered((perf), (drawStartUs), (flushEndUs))
+#else
+#define PERF_LOOP_BEGIN(perf, task) ((void)0)
+#define PERF_MARK(perf, section) ((void)0)
+#define PERF_LOOP_END(perf, task) ((void)0)
+#define PERF_DECODED(perf, frames, count, nowUs) ((void)0)
+#define PERF_COMMIT(perf, stamp, nowUs) ((void)0)
+#define PERF_VIEWED(perf, stamp) ((void)0)
+#define PERF_RENDERED(perf, drawStartUs, flushEndUs) ((void)0)
+#endif
+
+#endif // PERF_TRACE_H
@@ -0,0 +1,37 @@
+#ifndef RPM_TREND_H
+#define RPM_TREND_H
+
+#include <stdint.h>
+
+// Trend configuration
+#define RPM_TREND_FIT_SAMPLES 5             // DME1 frames in the slope fit, 40 ms at 100 Hz
+#define RPM_TREND_MAX_GAP_US 50000          // A longer gap (lost frames, shift, replay seek) restarts the fit
+#define RPM_TREND_MAX_LEAD_US 150000        // Never extrapolate further than this past the newest sample
+#define RPM_TREND_MAX_SLOPE 20000           // rpm/s, beyond any real engine, a bad sample cannot fling the estimate
+#define RPM_TREND_MAX_STEP 250              // rpm off the fitted line that counts as a step (shift, clutch), restarts the fit
+
+// Engine speed slope from timestamped samples, fitted by least squares over the last few frames.
+// Fed by the CAN task with every DME1 frame (not just the newest of a batch) and published with
+// the vehicle state, so the UI task can extrapolate to the time its frame reaches the panel.
+typedef struct {
+    // Ring of the newest samples
+    uint64_t timeUs[RPM_TREND_FIT_SAMPLES];
+    int16_t rpm[RPM_TREND_FIT_SAMPLES];
+    uint8_t head;                   // Next slot to write
+    uint8_t count;
+
+    // Fit at the newest sample
+    uint64_t anchorUs;
+    int32_t anchorRpm;
+    int32_t slope;                  // rpm/s
+
+    uint32_t samples;
+    uint32_t restarts;              // Gaps and steps
+} RPM_Trend_t;
+
+// Function prototypes
+void RPM_Trend_reset(RPM_Trend_t* trend);
+void RPM_Trend_sample(RPM_Trend_t* trend, uint64_t timeUs, int16_t rpm);
+int RPM_Trend_predict(const RPM_Trend_t* trend, uint64_t atUs);
+
+#endif // RPM_TREND_H
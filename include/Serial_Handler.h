@@ -2,11 +2,10 @@
 #define SERIAL_HANDLER_H
 
 #include <stdint.h>
-#include <mcp_can.h>
 #include "CAN_Reader.h"
 
 // Serial buffer configuration
-#define SERIAL_BUFFER_SIZE 32
+#define SERIAL_BUFFER_SIZE 128    // Fits "alerts rule" with a full rules file line
 
 // Callback function types for different commands
 typedef void (*ScreenChangeCallback_t)(int screen);
@@ -15,6 +14,19 @@ typedef void (*IntroCallback_t)(void);
 typedef void (*VINRequestCallback_t)(void);
 typedef void (*VehicleTypeChangeCallback_t)(VehicleType_t vehicleType);
 typedef void (*VehicleStatusCallback_t)(VehicleType_t vehicleType);
+typedef void (*DisplayStatsCallback_t)(void);
+typedef void (*TaskStatsCallback_t)(void);
+typedef void (*ReplayStartCallback_t)(const char* path, float speed);
+typedef void (*ReplayStopCallback_t)(void);
+typedef void (*ReplayStatusCallback_t)(void);
+typedef void (*LogCommandCallback_t)(const char* args);
+typedef void (*DiagCommandCallback_t)(const char* args);
+typedef void (*SimCommandCallback_t)(const char* args);
+typedef void (*AlertCommandCallback_t)(const char* args);
+typedef void (*ShiftCommandCallback_t)(const char* args);
+typedef void (*PerfCommandCallback_t)(const char* args);
+typedef void (*AtlasCommandCallback_t)(const char* args);
+typedef void (*LayoutCommandCallback_t)(const char* args);
 
 // Serial Handler context structure
 typedef struct {
@@ -28,13 +40,26 @@ typedef struct {
     VINRequestCallback_t vinRequestCallback;
     VehicleTypeChangeCallback_t vehicleTypeChangeCallback;
     VehicleStatusCallback_t vehicleStatusCallback;
+    DisplayStatsCallback_t displayStatsCallback;
+    TaskStatsCallback_t taskStatsCallback;
+    ReplayStartCallback_t replayStartCallback;
+    ReplayStopCallback_t replayStopCallback;
+    ReplayStatusCallback_t replayStatusCallback;
+    LogCommandCallback_t logCommandCallback;
+    DiagCommandCallback_t diagCommandCallback;
+    SimCommandCallback_t simCommandCallback;
+    AlertCommandCallback_t alertCommandCallback;
+    ShiftCommandCallback_t shiftCommandCallback;
+    PerfCommandCallback_t perfCommandCallback;
+    AtlasCommandCallback_t atlasCommandCallback;
+    LayoutCommandCallback_t layoutCommandCallback;
     
     // State variables (pointers to main variables)
     int* currentScreen;
     bool* devMode;
     VehicleType_t* vehicleType;
     CAN_Reader_Context_t* canReaderCtx;
-    MCP_CAN* canInterface;
+    CAN_Interface_t* canInterface;
     bool* displayUpdated;
 } Serial_Handler_Context_t;
 
@@ -44,7 +69,7 @@ void Serial_Handler_init(Serial_Handler_Context_t* ctx,
                         bool* devMode, 
                         VehicleType_t* vehicleType,
                         CAN_Reader_Context_t* canReaderCtx,
-                        MCP_CAN* canInterface,
+                        CAN_Interface_t* canInterface,
                         bool* displayUpdated,
                         ScreenChangeCallback_t screenChangeCallback,
                         ModeChangeCallback_t modeChangeCallback,
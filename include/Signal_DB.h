@@ -0,0 +1,255 @@
+#ifndef SIGNAL_DB_H
+#define SIGNAL_DB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <utility>
+
+// DBC-like signal description. Vehicle modules keep one constexpr table per frame, each
+// entry names the slot of a value array it is stored in. Signal_decode<TABLE>() is
+// instantiated per table so every shift, mask and scale below is a compile-time
+// constant: the generated decoder is integer only. Signal_encode<TABLE>() is its
+// inverse, used to build frames from values (Engine_Sim).
+//
+// Bit numbering follows DBC: bit n is bit (n % 8) of byte (n / 8).
+//   SIGNAL_LITTLE_ENDIAN (Intel):    startBit is the least significant bit
+//   SIGNAL_BIG_ENDIAN    (Motorola): startBit is the most significant bit
+// Physical value = raw * factorNum / factorDen + offset, truncated toward zero. When the
+// signal's range does not fit int16_t, a value outside it is stored as SIGNAL_NO_VALUE
+// rather than clamped, so it reads as missing instead of as a plausible limit.
+
+typedef enum {
+    SIGNAL_LITTLE_ENDIAN,
+    SIGNAL_BIG_ENDIAN
+} Signal_ByteOrder_t;
+
+#define SIGNAL_NO_SENTINEL 0xFFFFFFFFu   // Signal has no "not available" raw value
+#define SIGNAL_NO_VALUE INT16_MIN         // Stored when the sender flags a value as not available
+
+typedef struct {
+    const char* name;
+    uint8_t startBit;
+    uint8_t length;              // 1..32 bits
+    Signal_ByteOrder_t byteOrder;
+    bool isSigned;
+    int32_t factorNum;
+    int32_t factorDen;
+    int32_t offset;
+    uint32_t invalidRaw;         // Raw value meaning "not available", stored as SIGNAL_NO_VALUE
+    uint8_t slot;                // Index into the value array, also the bit reported on change
+} Signal_Def_t;
+
+// Table entry helpers, slot is the vehicle's signal enum (flags are stored as 0 or 1)
+#define SIGNAL_INT(slot, start, len, order, num, den, ofs) \
+    {#slot, start, len, order, false, num, den, ofs, SIGNAL_NO_SENTINEL, (uint8_t)(slot)}
+#define SIGNAL_INT_SENTINEL(slot, start, len, order, num, den, ofs, invalidRaw) \
+    {#slot, start, len, order, false, num, den, ofs, invalidRaw, (uint8_t)(slot)}
+#define SIGNAL_FLAG(slot, bit) \
+    {#slot, bit, 1, SIGNAL_LITTLE_ENDIAN, false, 1, 1, 0, SIGNAL_NO_SENTINEL, (uint8_t)(slot)}
+
+// === COMPILE-TIME LAYOUT ===
+constexpr uint8_t Signal_firstByte(const Signal_Def_t& s) {
+    return (uint8_t)(s.startBit / 8);
+}
+
+constexpr uint8_t Signal_byteCount(const Signal_Def_t& s) {
+    if (s.byteOrder == SIGNAL_LITTLE_ENDIAN) {
+        return (uint8_t)((s.startBit + s.length - 1) / 8 - s.startBit / 8 + 1);
+    }
+    // Motorola: the first byte holds the top (startBit % 8) + 1 bits, the rest continue in the following bytes
+    int firstBits = s.startBit % 8 + 1;
+    return (uint8_t)(s.length <= firstBits ? 1 : 1 + (s.length - firstBits + 7) / 8);
+}
+
+// Payload length a frame needs for every signal in the table to be present
+constexpr uint8_t Signal_minLen(const Signal_Def_t* signals, size_t count) {
+    uint8_t len = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t end = (uint8_t)(Signal_firstByte(signals[i]) + Signal_byteCount(signals[i]));
+        len = end > len ? end : len;
+    }
+    return len;
+}
+
+// Compile-time check of a table, used in static_assert next to it
+constexpr bool Signal_isValid(const Signal_Def_t* signals, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const Signal_Def_t& s = signals[i];
+        if (s.length == 0 || s.length > 32 || s.factorDen == 0 || Signal_byteCount(s) > 5 ||
+            Signal_firstByte(s) + Signal_byteCount(s) > 8) {
+            return false;
+        }
+        if (s.slot >= 32) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Slots written by a table, as a changed-signal mask
+constexpr uint32_t Signal_slotMask(const Signal_Def_t* signals, size_t count) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < count; i++) {
+        mask |= 1u << signals[i].slot;
+    }
+    return mask;
+}
+
+// Physical value of a raw value, evaluated at compile time for the range check below
+constexpr int64_t Signal_physical(const Signal_Def_t& s, int64_t raw) {
+    return (raw * s.factorNum + (int64_t)s.offset * s.factorDen) / s.factorDen;
+}
+
+// True when every physical value fits int16_t without the SIGNAL_NO_VALUE marker
+constexpr bool Signal_fitsInt16(const Signal_Def_t& s) {
+    uint32_t mask = s.length < 32 ? (1u << (s.length % 32)) - 1u : 0xFFFFFFFFu;
+    int64_t rawMin = s.isSigned ? -(int64_t)(mask / 2) - 1 : 0;
+    int64_t rawMax = s.isSigned ? (int64_t)(mask / 2) : (int64_t)mask;
+    int64_t a = Signal_physical(s, rawMin);
+    int64_t b = Signal_physical(s, rawMax);
+    int64_t lo = a < b ? a : b;
+    int64_t hi = a < b ? b : a;
+    return lo > INT16_MIN && hi <= INT16_MAX;
+}
+
+// === DECODING ===
+// Instantiated once per signal: every field of s is a constant, so only the byte loads,
+// one shift, one mask and the scaling remain in the generated code
+template <const Signal_Def_t* SIGNALS, size_t I>
+static inline int32_t Signal_extract(const uint8_t* buf) {
+    constexpr Signal_Def_t s = SIGNALS[I];
+    constexpr uint8_t first = Signal_firstByte(s);
+    constexpr uint8_t count = Signal_byteCount(s);
+    constexpr uint32_t mask = s.length < 32 ? (1u << (s.length % 32)) - 1u : 0xFFFFFFFFu;
+
+    uint64_t bits = 0;
+    uint32_t raw;
+    if constexpr (s.byteOrder == SIGNAL_LITTLE_ENDIAN) {
+        for (int i = count - 1; i >= 0; i--) {
+            bits = (bits << 8) | buf[first + i];
+        }
+        raw = (uint32_t)(bits >> (s.startBit % 8)) & mask;
+    } else {
+        for (int i = 0; i < count; i++) {
+            bits = (bits << 8) | buf[first + i];
+        }
+        raw = (uint32_t)(bits >> (8 * count - (7 - s.startBit % 8) - s.length)) & mask;
+    }
+
+    if constexpr (s.invalidRaw != SIGNAL_NO_SENTINEL) {
+        if (raw == s.invalidRaw) {
+            return SIGNAL_NO_VALUE;
+        }
+    }
+    int32_t value = (int32_t)raw;
+    if constexpr (s.isSigned && s.length < 32) {
+        if (raw & (1u << (s.length - 1))) {
+            value = (int32_t)(raw | ~mask);
+        }
+    }
+    if constexpr (s.factorDen == 1) {
+        return value * s.factorNum + s.offset;
+    } else {
+        // Offset folded into the numerator so truncation matches (int)(raw * factor + offset)
+        return (value * s.factorNum + s.offset * s.factorDen) / s.factorDen;
+    }
+}
+
+// Stores one signal and returns its slot bit when the value changed
+template <const Signal_Def_t* SIGNALS, size_t I>
+static inline uint32_t Signal_store(const uint8_t* buf, int16_t* values) {
+    constexpr Signal_Def_t s = SIGNALS[I];
+    int32_t physical = Signal_extract<SIGNALS, I>(buf);
+    if constexpr (!Signal_fitsInt16(s)) {
+        if (physical > INT16_MAX || physical < INT16_MIN) {
+            physical = SIGNAL_NO_VALUE;
+        }
+    }
+    int16_t value = (int16_t)physical;
+    uint32_t changed = (uint32_t)(values[s.slot] != value) << s.slot;
+    values[s.slot] = value;
+    return changed;
+}
+
+template <const Signal_Def_t* SIGNALS, size_t... I>
+static inline uint32_t Signal_decodeAll(const uint8_t* buf, int16_t* values, std::index_sequence<I...>) {
+    return (0u | ... | Signal_store<SIGNALS, I>(buf, values));
+}
+
+// Decode every signal of a table into its slot of values, the payload must hold
+// Signal_minLen() bytes. Returns a mask with the slot bit set for every changed value.
+template <const Signal_Def_t* SIGNALS, size_t COUNT>
+static inline uint32_t Signal_decode(const uint8_t* buf, int16_t* values) {
+    static_assert(COUNT <= 32, "A signal table reports changes in a 32-bit mask");
+    return Signal_decodeAll<SIGNALS>(buf, values, std::make_index_sequence<COUNT>{});
+}
+
+// === ENCODING ===
+// Inverse of Signal_extract(): the smallest raw value whose physical value is not below
+// value, so every value the signal can represent survives an encode/decode round trip.
+// Bits outside the signal are preserved, flags and fields may share a byte.
+template <const Signal_Def_t* SIGNALS, size_t I>
+static inline void Signal_insert(int16_t value, uint8_t* buf) {
+    constexpr Signal_Def_t s = SIGNALS[I];
+    constexpr uint8_t first = Signal_firstByte(s);
+    constexpr uint8_t count = Signal_byteCount(s);
+    constexpr uint32_t mask = s.length < 32 ? (1u << (s.length % 32)) - 1u : 0xFFFFFFFFu;
+    constexpr int64_t rawMin = s.isSigned ? -(int64_t)(mask / 2) - 1 : 0;
+    constexpr int64_t rawMax = s.isSigned ? (int64_t)(mask / 2) : (int64_t)mask;
+    static_assert(s.factorNum > 0 && s.factorDen > 0, "Encoding needs a positive factor");
+
+    int64_t raw;
+    if (s.invalidRaw != SIGNAL_NO_SENTINEL && value == SIGNAL_NO_VALUE) {
+        raw = s.invalidRaw;
+    } else {
+        // Floor division, then one step up when that raw value decodes below the target
+        int64_t scaled = ((int64_t)value - s.offset) * s.factorDen;
+        raw = scaled / s.factorNum;
+        if (scaled % s.factorNum != 0 && scaled < 0) {
+            raw--;
+        }
+        if (Signal_physical(s, raw) < value) {
+            raw++;
+        }
+        raw = raw < rawMin ? rawMin : (raw > rawMax ? rawMax : raw);
+        if (s.invalidRaw != SIGNAL_NO_SENTINEL && (uint32_t)raw == s.invalidRaw) {
+            raw += raw > rawMin ? -1 : 1;
+        }
+    }
+
+    uint64_t field = (uint64_t)((uint32_t)raw & mask);
+    uint64_t fieldMask = (uint64_t)mask;
+    if constexpr (s.byteOrder == SIGNAL_LITTLE_ENDIAN) {
+        field <<= s.startBit % 8;
+        fieldMask <<= s.startBit % 8;
+        for (int i = 0; i < count; i++) {
+            uint8_t bits = (uint8_t)(fieldMask >> (8 * i));
+            buf[first + i] = (uint8_t)((buf[first + i] & ~bits) | (uint8_t)(field >> (8 * i)));
+        }
+    } else {
+        constexpr int shift = 8 * count - (7 - s.startBit % 8) - s.length;
+        field <<= shift;
+        fieldMask <<= shift;
+        for (int i = 0; i < count; i++) {
+            int byteShift = 8 * (count - 1 - i);
+            uint8_t bits = (uint8_t)(fieldMask >> byteShift);
+            buf[first + i] = (uint8_t)((buf[first + i] & ~bits) | (uint8_t)(field >> byteShift));
+        }
+    }
+}
+
+template <const Signal_Def_t* SIGNALS, size_t... I>
+static inline void Signal_encodeAll(const int16_t* values, uint8_t* buf, std::index_sequence<I...>) {
+    (Signal_insert<SIGNALS, I>(values[SIGNALS[I].slot], buf), ...);
+}
+
+// Encode every signal of a table from its slot of values into buf, which must hold
+// Signal_minLen() bytes. Signals sharing bits are written in table order, the last one wins.
+template <const Signal_Def_t* SIGNALS, size_t COUNT>
+static inline void Signal_encode(const int16_t* values, uint8_t* buf) {
+    Signal_encodeAll<SIGNALS>(values, buf, std::make_index_sequence<COUNT>{});
+}
+
+#define SIGNAL_COUNT(table) (sizeof(table) / sizeof(table[0]))
+
+#endif // SIGNAL_DB_H
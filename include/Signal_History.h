@@ -0,0 +1,74 @@
+#ifndef SIGNAL_HISTORY_H
+#define SIGNAL_HISTORY_H
+
+#include <stdint.h>
+#include "Vehicle_State.h"
+
+// History configuration (overridable from build_flags)
+#ifndef SIGNAL_HISTORY_MAX_SIGNALS
+#define SIGNAL_HISTORY_MAX_SIGNALS 4
+#endif
+#ifndef SIGNAL_HISTORY_LENGTH
+#define SIGNAL_HISTORY_LENGTH 300          // Points per tier: 30 s, 5 min and 50 min
+#endif
+#ifndef SIGNAL_HISTORY_RAM_BUDGET
+#define SIGNAL_HISTORY_RAM_BUDGET 20480    // Bytes, checked at compile time
+#endif
+#define SIGNAL_HISTORY_TIER_COUNT 3
+#define SIGNAL_HISTORY_BASE_PERIOD_MS 100  // Tier 0 sample clock
+#define SIGNAL_HISTORY_DECIMATION 10       // Points of tier n folded into one point of tier n + 1
+#define SIGNAL_HISTORY_MAX_CATCH_UP 50     // Missed samples filled in after a stall, then the clock resyncs
+#define SIGNAL_HISTORY_NO_DATA INT16_MIN   // Gap: signal missing, stale or not sampled yet
+
+// Decimated point, tier 0 points have min == max == mean
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t mean;
+} Signal_History_Point_t;
+
+// Running min/max/mean of the points that will form the next point of a coarser tier
+typedef struct {
+    int32_t sum;
+    int16_t min;
+    int16_t max;
+    uint8_t valid;      // Points that were not gaps
+} Signal_History_Accumulator_t;
+
+// One recorded signal. Tier 0 keeps plain samples, coarser tiers min/max/mean points.
+typedef struct {
+    const char* name;
+    uint8_t signal;             // Vehicle state slot read on every sample tick
+    int16_t samples[SIGNAL_HISTORY_LENGTH];
+    Signal_History_Point_t points[SIGNAL_HISTORY_TIER_COUNT - 1][SIGNAL_HISTORY_LENGTH];
+    Signal_History_Accumulator_t pending[SIGNAL_HISTORY_TIER_COUNT - 1];
+} Signal_History_Series_t;
+
+// Fixed-clock sampler for every registered signal. All series are sampled together,
+// so they share the ring positions. Owned by the UI task.
+typedef struct {
+    const Vehicle_State_t* state;
+    Signal_History_Series_t series[SIGNAL_HISTORY_MAX_SIGNALS];
+    uint8_t count;
+    uint16_t head[SIGNAL_HISTORY_TIER_COUNT];     // Next write position
+    uint16_t filled[SIGNAL_HISTORY_TIER_COUNT];
+    uint8_t phase[SIGNAL_HISTORY_TIER_COUNT - 1]; // Points folded into the pending accumulators
+    uint32_t sampleCount;       // Tier 0 ticks so far, e.g. for screen state keys
+    unsigned long nextSampleMs;
+    bool started;
+} Signal_History_t;
+
+static_assert(sizeof(Signal_History_t) <= SIGNAL_HISTORY_RAM_BUDGET, "Signal history exceeds its RAM budget");
+
+// Function prototypes
+void Signal_History_init(Signal_History_t* history, const Vehicle_State_t* state);
+int Signal_History_register(Signal_History_t* history, const char* name, uint8_t signal);
+int Signal_History_find(const Signal_History_t* history, uint8_t signal);
+bool Signal_History_sample(Signal_History_t* history, unsigned long nowMs);
+uint32_t Signal_History_tierPeriodMs(int tier);
+int Signal_History_tierFor(uint32_t spanMs);
+uint16_t Signal_History_available(const Signal_History_t* history, int tier);
+Signal_History_Point_t Signal_History_get(const Signal_History_t* history, int signal, int tier, uint16_t age);
+Signal_History_Point_t Signal_History_range(const Signal_History_t* history, int signal, int tier, uint16_t age, uint16_t count);
+
+#endif // SIGNAL_HISTORY_H
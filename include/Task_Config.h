@@ -0,0 +1,46 @@
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+// FreeRTOS task layout. Every value can be overridden with -D in platformio.ini build_flags.
+// Core 0 runs CAN receive and decode, core 1 (the Arduino core) runs rendering and the serial console.
+
+// CAN decode task: consumes the receive ring and publishes vehicle snapshots
+#ifndef CAN_TASK_CORE
+#define CAN_TASK_CORE 0
+#endif
+#ifndef CAN_TASK_PRIORITY
+#define CAN_TASK_PRIORITY 4
+#endif
+#ifndef CAN_TASK_STACK_SIZE
+#define CAN_TASK_STACK_SIZE 4096
+#endif
+#ifndef CAN_TASK_TIMEOUT_MS
+#define CAN_TASK_TIMEOUT_MS 20      // Wake up without frames, e.g. for demo data
+#endif
+
+// UI task: serial console and display rendering
+#ifndef UI_TASK_CORE
+#define UI_TASK_CORE 1
+#endif
+#ifndef UI_TASK_PRIORITY
+#define UI_TASK_PRIORITY 2
+#endif
+#ifndef UI_TASK_STACK_SIZE
+#define UI_TASK_STACK_SIZE 8192
+#endif
+#ifndef UI_TASK_PERIOD_MS
+#define UI_TASK_PERIOD_MS 5
+#endif
+
+// CAN log writer: flushes sealed log blocks to SPIFFS, below the UI so flash stalls never delay rendering
+#ifndef LOG_TASK_CORE
+#define LOG_TASK_CORE 1
+#endif
+#ifndef LOG_TASK_PRIORITY
+#define LOG_TASK_PRIORITY 1
+#endif
+#ifndef LOG_TASK_STACK_SIZE
+#define LOG_TASK_STACK_SIZE 4096
+#endif
+
+#endif // TASK_CONFIG_H
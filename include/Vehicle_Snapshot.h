@@ -0,0 +1,34 @@
+#ifndef VEHICLE_SNAPSHOT_H
+#define VEHICLE_SNAPSHOT_H
+
+#include <stdint.h>
+#include <atomic>
+#include "BMW_CAN.h"
+#include "Vehicle_State.h"
+#include "RPM_Trend.h"
+#include "Perf_Trace.h"
+
+// Everything the decoders produce
+typedef struct {
+    Vehicle_State_t state;
+    BMW_Kombi_t kombi;
+    RPM_Trend_t rpmTrend;       // Every DME1 sample, the shift light extrapolates from it
+#if PERF_TRACE
+    Perf_Trace_Stamp_t perf;    // When the newest data of this snapshot was received, decoded and published
+#endif
+} Vehicle_Data_t;
+
+// Seqlock protected copy of the vehicle data.
+// One writer (the CAN task) publishes, readers retry until they see an unchanged, even sequence.
+typedef struct {
+    std::atomic<uint32_t> sequence;
+    Vehicle_Data_t data;
+} Vehicle_Snapshot_t;
+
+// Function prototypes
+void Vehicle_Snapshot_init(Vehicle_Snapshot_t* snapshot);
+void Vehicle_Snapshot_publish(Vehicle_Snapshot_t* snapshot, const Vehicle_Data_t* data);
+uint32_t Vehicle_Snapshot_read(const Vehicle_Snapshot_t* snapshot, Vehicle_Data_t* data);
+uint32_t Vehicle_Snapshot_sequence(const Vehicle_Snapshot_t* snapshot);
+
+#endif // VEHICLE_SNAPSHOT_H
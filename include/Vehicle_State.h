@@ -0,0 +1,82 @@
+#ifndef VEHICLE_STATE_H
+#define VEHICLE_STATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "BMW_CAN.h"
+#include "Kawasaki_CAN.h"
+#include "Signal_DB.h"
+
+// Signal slots: BMW signals first, then Kawasaki, the same layout as the CAN_Reader changed mask
+#define VEHICLE_STATE_BMW_BASE 0
+#define VEHICLE_STATE_KAWASAKI_BASE BMW_SIGNAL_COUNT
+#define VEHICLE_STATE_SIGNAL_COUNT (BMW_SIGNAL_COUNT + KAWASAKI_SIGNAL_COUNT)
+#define VEHICLE_STATE_NEVER_STALE 0
+
+static_assert(VEHICLE_STATE_SIGNAL_COUNT <= 32, "Every signal needs a bit in the changed mask");
+
+// Display convention: a missing value is drawn as "--", a stale one keeps its last value
+// with a trailing '?'. Bars, graphs and warnings treat both as "no reading".
+typedef enum {
+    VEHICLE_VALUE_MISSING,     // Never received since the last clear, or flagged unavailable by the sender
+    VEHICLE_VALUE_STALE,       // Not updated within the signal's stale threshold
+    VEHICLE_VALUE_FRESH
+} Vehicle_ValueStatus_t;
+
+// Latest value of every decoded signal, one array per attribute so decoding a frame touches
+// a few adjacent words. Written by the CAN task only, the UI task reads its snapshot copy.
+struct Vehicle_State {
+    int16_t value[VEHICLE_STATE_SIGNAL_COUNT];               // Flags are 0 or 1, SIGNAL_NO_VALUE when unavailable
+    uint16_t updates[VEHICLE_STATE_SIGNAL_COUNT];            // Frames that carried the signal, wraps
+    uint32_t updatedMs[VEHICLE_STATE_SIGNAL_COUNT];          // Clock of the last update
+    uint32_t changedGeneration[VEHICLE_STATE_SIGNAL_COUNT];  // Generation of the last value change
+    uint32_t received;          // Signals updated at least once since the last clear
+    uint32_t generation;        // Advanced by Vehicle_State_begin() and Vehicle_State_clear()
+    uint32_t nowMs;             // Clock stamped into the updates of this generation
+};
+
+// Function prototypes
+void Vehicle_State_clear(Vehicle_State_t* state);
+void Vehicle_State_begin(Vehicle_State_t* state, uint32_t nowMs);
+void Vehicle_State_touch(Vehicle_State_t* state, uint32_t updated, uint32_t changed);
+uint32_t Vehicle_State_set(Vehicle_State_t* state, uint8_t signal, int32_t value);
+uint32_t Vehicle_State_staleAfterMs(uint8_t signal);
+const char* Vehicle_State_signalName(uint8_t signal);
+int Vehicle_State_findSignal(const char* name);
+Vehicle_ValueStatus_t Vehicle_State_status(const Vehicle_State_t* state, uint8_t signal, uint32_t nowMs);
+uint32_t Vehicle_State_staleMask(const Vehicle_State_t* state, uint32_t signals, uint32_t nowMs);
+bool Vehicle_State_changedSince(const Vehicle_State_t* state, uint32_t signals, uint32_t generation);
+uint32_t Vehicle_State_lastChange(const Vehicle_State_t* state, uint32_t signals);
+int Vehicle_State_reading(const Vehicle_State_t* state, uint8_t signal, uint32_t nowMs, int fallback);
+void Vehicle_State_format(const Vehicle_State_t* state, uint8_t signal, uint32_t nowMs, char* buf, size_t size);
+
+// Stamps one slot of a table, the slot is a constant after inlining
+template <const Signal_Def_t* SIGNALS, size_t I>
+static inline void Vehicle_State_stamp(Vehicle_State_t* state, uint8_t base, uint32_t changed) {
+    constexpr uint8_t slot = SIGNALS[I].slot;
+    state->updatedMs[base + slot] = state->nowMs;
+    state->updates[base + slot]++;
+    if (changed & (1u << slot)) {
+        state->changedGeneration[base + slot] = state->generation;
+    }
+}
+
+template <const Signal_Def_t* SIGNALS, size_t... I>
+static inline void Vehicle_State_stampAll(Vehicle_State_t* state, uint8_t base, uint32_t changed, std::index_sequence<I...>) {
+    (Vehicle_State_stamp<SIGNALS, I>(state, base, changed), ...);
+}
+
+// Decodes a signal table into the slots from base on and stamps every slot the table
+// carries, changed or not. Returns the changed mask relative to base.
+template <const Signal_Def_t* SIGNALS, size_t COUNT>
+static inline uint32_t Vehicle_State_decode(Vehicle_State_t* state, uint8_t base, const uint8_t* buf) {
+    constexpr uint32_t carried = Signal_slotMask(SIGNALS, COUNT);
+    uint32_t changed = Signal_decode<SIGNALS, COUNT>(buf, &state->value[base]);
+    // A first reading changes what is drawn even when it equals the cleared value
+    uint32_t stamped = changed | (carried & ~(state->received >> base));
+    state->received |= carried << base;
+    Vehicle_State_stampAll<SIGNALS>(state, base, stamped, std::make_index_sequence<COUNT>{});
+    return changed;
+}
+
+#endif // VEHICLE_STATE_H
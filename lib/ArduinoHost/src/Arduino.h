@@ -0,0 +1,76 @@
+#ifndef ARDUINO_HOST_H
+#define ARDUINO_HOST_H
+
+// Host stand-in for the parts of the Arduino core this firmware and U8g2 use.
+// ARDUINO is deliberately left undefined so libraries skip their hardware backends.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "Print.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define FALLING 2
+#define RISING 1
+#define MSBFIRST 1
+#define LSBFIRST 0
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Serial console on stdin/stdout, plus injected input for scripted runs
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    int availableForWrite() override;
+    void flush() override;
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// Host-only helpers
+void ArduinoHost_injectSerial(const char* text);
+void ArduinoHost_setStdinEnabled(bool enabled);
+void ArduinoHost_setStdoutEnabled(bool enabled);
+
+#endif // ARDUINO_HOST_H
@@ -0,0 +1,391 @@
+#include "Arduino.h"
+#include "SPI.h"
+#include "Wire.h"
+#include "SPIFFS.h"
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <thread>
+#include <stdarg.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+HardwareSerial Serial;
+SPIClass SPI;
+TwoWire Wire;
+fs::SPIFFSFS SPIFFS;
+
+// === TIME ===
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long millis(void) {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros(void) {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield(void) {
+    std::this_thread::yield();
+}
+
+// === MATH ===
+static std::mt19937 randomEngine(1);
+
+long random(long howBig) {
+    if (howBig <= 0) {
+        return 0;
+    }
+    return (long)(randomEngine() % (unsigned long)howBig);
+}
+
+long random(long howSmall, long howBig) {
+    if (howSmall >= howBig) {
+        return howSmall;
+    }
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+    randomEngine.seed((uint32_t)seed);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// === GPIO ===
+static uint8_t pinLevels[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < sizeof(pinLevels)) {
+        pinLevels[pin] = value;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+// === PRINT ===
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size-- > 0) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char* str) {
+    return str != nullptr ? write((const uint8_t*)str, strlen(str)) : 0;
+}
+
+size_t Print::print(const char* str) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(int value, int base) { return print((long)value, base); }
+size_t Print::print(unsigned int value, int base) { return print((unsigned long)value, base); }
+
+size_t Print::print(long value, int base) {
+    if (base == DEC) {
+        return printf("%ld", value);
+    }
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return printf(base == HEX ? "%lX" : "%lu", value);
+}
+
+size_t Print::print(double value, int digits) {
+    return printf("%.*f", digits, value);
+}
+
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const char* str) { return print(str) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(int value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned int value, int base) { return print(value, base) + println(); }
+size_t Print::println(long value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned long value, int base) { return print(value, base) + println(); }
+size_t Print::println(double value, int digits) { return print(value, digits) + println(); }
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    if ((size_t)len < sizeof(buffer)) {
+        return write((const uint8_t*)buffer, (size_t)len);
+    }
+
+    // Long output, format again into a heap buffer
+    char* big = (char*)malloc((size_t)len + 1);
+    if (big == nullptr) {
+        return 0;
+    }
+    va_start(args, format);
+    vsnprintf(big, (size_t)len + 1, format, args);
+    va_end(args);
+    size_t n = write((const uint8_t*)big, (size_t)len);
+    free(big);
+    return n;
+}
+
+// === SERIAL ===
+static std::deque<uint8_t> serialInput;
+static bool stdinEnabled = true;
+static bool stdoutEnabled = true;
+
+static void HardwareSerial_pollStdin(void) {
+    if (!stdinEnabled) {
+        return;
+    }
+    struct pollfd pfd;
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+    while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+        uint8_t buffer[64];
+        ssize_t n = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (n <= 0) {
+            stdinEnabled = false;   // EOF, stop polling
+            return;
+        }
+        serialInput.insert(serialInput.end(), buffer, buffer + n);
+    }
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+    (void)baud;
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    // The firmware prints CRLF line endings, keep host output plain
+    if (c != '\r' && stdoutEnabled) {
+        fputc(c, stdout);
+    }
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+    return size;
+}
+
+int HardwareSerial::available() {
+    HardwareSerial_pollStdin();
+    return (int)serialInput.size();
+}
+
+int HardwareSerial::read() {
+    if (available() == 0) {
+        return -1;
+    }
+    uint8_t c = serialInput.front();
+    serialInput.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek() {
+    return available() > 0 ? serialInput.front() : -1;
+}
+
+int HardwareSerial::availableForWrite() {
+    return 4096;
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+void ArduinoHost_injectSerial(const char* text) {
+    while (*text != '\0') {
+        serialInput.push_back((uint8_t)*text++);
+    }
+}
+
+void ArduinoHost_setStdinEnabled(bool enabled) {
+    stdinEnabled = enabled;
+}
+
+void ArduinoHost_setStdoutEnabled(bool enabled) {
+    // Serial output only, printf() from the host tools still reaches stdout
+    stdoutEnabled = enabled;
+}
+
+// === FILESYSTEM ===
+namespace fs {
+
+File::File(FILE* file, const std::string& path)
+    : _file(file, fclose), _path(path) {
+}
+
+size_t File::write(uint8_t c) {
+    return _file ? fwrite(&c, 1, 1, _file.get()) : 0;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    return _file ? fwrite(buffer, 1, size, _file.get()) : 0;
+}
+
+int File::available() {
+    if (!_file) {
+        return 0;
+    }
+    size_t pos = position();
+    size_t total = size();
+    return pos < total ? (int)(total - pos) : 0;
+}
+
+int File::read() {
+    return _file ? fgetc(_file.get()) : -1;
+}
+
+int File::peek() {
+    if (!_file) {
+        return -1;
+    }
+    int c = fgetc(_file.get());
+    if (c != EOF) {
+        ungetc(c, _file.get());
+    }
+    return c;
+}
+
+void File::flush() {
+    if (_file) {
+        fflush(_file.get());
+    }
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    return _file ? fread(buffer, 1, size, _file.get()) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return _file && fseek(_file.get(), (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+    if (!_file) {
+        return 0;
+    }
+    long pos = ftell(_file.get());
+    return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+    if (!_file) {
+        return 0;
+    }
+    fflush(_file.get());
+    struct stat st;
+    return fstat(fileno(_file.get()), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+    _file.reset();
+}
+
+const char* File::name() const {
+    size_t slash = _path.find_last_of('/');
+    return slash == std::string::npos ? _path.c_str() : _path.c_str() + slash + 1;
+}
+
+const char* File::path() const {
+    return _path.c_str();
+}
+
+std::string FS::hostPath(const char* path) const {
+    std::string full = _root;
+    if (path[0] != '/') {
+        full += '/';
+    }
+    return full + path;
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    (void)create;
+    // Binary mode so logs and assets round-trip byte for byte
+    std::string hostMode = std::string(mode) + "b";
+    if (hostMode == "rb") {
+        struct stat st;
+        if (stat(hostPath(path).c_str(), &st) != 0 || S_ISDIR(st.st_mode)) {
+            return File();
+        }
+    }
+    FILE* file = fopen(hostPath(path).c_str(), hostMode.c_str());
+    return file != nullptr ? File(file, path) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    struct stat st;
+    if (stat(_root.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    return formatOnFail && mkdir(_root.c_str(), 0755) == 0;
+}
+
+size_t SPIFFSFS::totalBytes() {
+    return ARDUINO_HOST_SPIFFS_TOTAL_BYTES;
+}
+
+size_t SPIFFSFS::usedBytes() {
+    size_t used = 0;
+    DIR* dir = opendir(_root.c_str());
+    if (dir == nullptr) {
+        return 0;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        struct stat st;
+        std::string path = _root + "/" + entry->d_name;
+        if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+            used += (size_t)st.st_size;
+        }
+    }
+    closedir(dir);
+    return used;
+}
+
+} // namespace fs
@@ -0,0 +1,66 @@
+#ifndef ARDUINO_HOST_FS_H
+#define ARDUINO_HOST_FS_H
+
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+// File handle backed by stdio, copies share the underlying FILE like on the ESP32
+class File : public Stream {
+public:
+    File() {}
+    File(FILE* file, const std::string& path);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+
+    size_t read(uint8_t* buffer, size_t size);
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    const char* name() const;
+    const char* path() const;
+    operator bool() const { return _file != nullptr; }
+
+private:
+    std::shared_ptr<FILE> _file;
+    std::string _path;
+};
+
+// Filesystem rooted at a host directory
+class FS {
+public:
+    explicit FS(const char* root) : _root(root) {}
+    void setRoot(const char* root) { _root = root; }
+    const char* root() const { return _root.c_str(); }
+
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+
+protected:
+    std::string hostPath(const char* path) const;
+    std::string _root;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // ARDUINO_HOST_FS_H
@@ -0,0 +1,24 @@
+#ifndef ARDUINO_HOST_SPIFFS_H
+#define ARDUINO_HOST_SPIFFS_H
+
+#include "FS.h"
+
+#define ARDUINO_HOST_SPIFFS_TOTAL_BYTES (1024u * 1024u)
+
+namespace fs {
+
+// SPIFFS mapped onto a host directory (the project's data/ folder by default)
+class SPIFFSFS : public FS {
+public:
+    SPIFFSFS() : FS("data") {}
+    bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10, const char* partitionLabel = nullptr);
+    void end() {}
+    size_t totalBytes();
+    size_t usedBytes();
+};
+
+} // namespace fs
+
+extern fs::SPIFFSFS SPIFFS;
+
+#endif // ARDUINO_HOST_SPIFFS_H
@@ -0,0 +1,17 @@
+#ifndef ARDUINO_HOST_WIRE_H
+#define ARDUINO_HOST_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+    void begin() {}
+    void setClock(uint32_t clock) { (void)clock; }
+    void beginTransmission(uint8_t address) { (void)address; }
+    size_t write(uint8_t data) { (void)data; return 1; }
+    uint8_t endTransmission(bool stop = true) { (void)stop; return 0; }
+};
+
+extern TwoWire Wire;
+
+#endif // ARDUINO_HOST_WIRE_H
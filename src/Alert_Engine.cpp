@@ -0,0 +1,322 @@
+#include "Alert_Engine.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// === DEFAULT RULES ===
+// The warnings the screens used to hard-code, used when no rules file is on flash
+static const Alert_Rule_t ALERT_DEFAULT_RULES[] = {
+    {"shift", BMW_SIGNAL_RPM, ALERT_AT_LEAST, 6000, 100, 0, 2, ALERT_INDICATOR_SHIFT, ALERT_NO_SCREEN},
+    {"redline", BMW_SIGNAL_RPM, ALERT_AT_LEAST, 6500, 100, 0, 3, ALERT_INDICATOR_REDLINE, ALERT_NO_SCREEN},
+    {"coolant", BMW_SIGNAL_COOLANT_TEMP, ALERT_ABOVE, 90, 2, 1000, 1, ALERT_INDICATOR_COOLANT, ALERT_NO_SCREEN},
+    {"coolant_hot", BMW_SIGNAL_COOLANT_TEMP, ALERT_AT_LEAST, 100, 3, 2000, 5, ALERT_INDICATOR_OVERHEAT, 3},
+    {"outlet_hot", BMW_SIGNAL_OUTLET_TEMP, ALERT_AT_LEAST, 100, 3, 2000, 4, ALERT_INDICATOR_OVERHEAT, 3},
+};
+static_assert(sizeof(ALERT_DEFAULT_RULES) / sizeof(ALERT_DEFAULT_RULES[0]) <= ALERT_MAX_RULES, "Too many default rules");
+
+static const char* const ALERT_COMPARATOR_NAMES[] = {">", ">=", "<", "<="};
+static const char* const ALERT_INDICATOR_NAMES[ALERT_INDICATOR_COUNT] = {"none", "shift", "redline", "coolant", "overheat"};
+
+void Alert_Engine_init(Alert_Engine_t* engine) {
+    memset(engine, 0, sizeof(*engine));
+    engine->overrideScreen = ALERT_NO_SCREEN;
+}
+
+void Alert_Engine_loadDefaults(Alert_Engine_t* engine) {
+    Alert_Engine_init(engine);
+    for (size_t i = 0; i < sizeof(ALERT_DEFAULT_RULES) / sizeof(ALERT_DEFAULT_RULES[0]); i++) {
+        Alert_Engine_setRule(engine, &ALERT_DEFAULT_RULES[i]);
+    }
+}
+
+// === RULES FILE ===
+static int Alert_Engine_lookup(const char* const* names, int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool Alert_Engine_parseNumber(const char* text, long min, long max, long* value) {
+    char* end;
+    *value = strtol(text, &end, 10);
+    return end != text && *end == '\0' && *value >= min && *value <= max;
+}
+
+int Alert_Engine_findIndicator(const char* name) {
+    return Alert_Engine_lookup(ALERT_INDICATOR_NAMES, ALERT_INDICATOR_COUNT, name);
+}
+
+bool Alert_Engine_parseRule(const char* line, Alert_Rule_t* rule) {
+    char copy[ALERT_LINE_SIZE];
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char* save;
+    const char* name = strtok_r(copy, " \t\r\n", &save);
+    const char* signal = strtok_r(nullptr, " \t\r\n", &save);
+    const char* op = strtok_r(nullptr, " \t\r\n", &save);
+    const char* threshold = strtok_r(nullptr, " \t\r\n", &save);
+    if (threshold == nullptr || strlen(name) >= ALERT_NAME_SIZE) {
+        return false;
+    }
+
+    memset(rule, 0, sizeof(*rule));
+    strcpy(rule->name, name);
+    rule->screen = ALERT_NO_SCREEN;
+    int slot = Vehicle_State_findSignal(signal);
+    int comparator = Alert_Engine_lookup(ALERT_COMPARATOR_NAMES, 4, op);
+    long value;
+    if (slot < 0 || comparator < 0 || !Alert_Engine_parseNumber(threshold, INT16_MIN, INT16_MAX, &value)) {
+        return false;
+    }
+    rule->signal = (uint8_t)slot;
+    rule->comparator = (Alert_Comparator_t)comparator;
+    rule->threshold = (int16_t)value;
+
+    // Optional key=value settings in any order
+    for (char* option = strtok_r(nullptr, " \t\r\n", &save); option != nullptr; option = strtok_r(nullptr, " \t\r\n", &save)) {
+        char* text = strchr(option, '=');
+        if (text == nullptr) {
+            return false;
+        }
+        *text++ = '\0';
+        if (strcmp(option, "show") == 0) {
+            int indicator = Alert_Engine_lookup(ALERT_INDICATOR_NAMES, ALERT_INDICATOR_COUNT, text);
+            if (indicator < 0) {
+                return false;
+            }
+            rule->indicator = (Alert_Indicator_t)indicator;
+        } else if (strcmp(option, "hyst") == 0 && Alert_Engine_parseNumber(text, 0, INT16_MAX, &value)) {
+            rule->hysteresis = (int16_t)value;
+        } else if (strcmp(option, "debounce") == 0 && Alert_Engine_parseNumber(text, 0, UINT16_MAX, &value)) {
+            rule->debounceMs = (uint16_t)value;
+        } else if (strcmp(option, "prio") == 0 && Alert_Engine_parseNumber(text, 0, UINT8_MAX, &value)) {
+            rule->priority = (uint8_t)value;
+        } else if (strcmp(option, "screen") == 0 && Alert_Engine_parseNumber(text, ALERT_NO_SCREEN, INT8_MAX, &value)) {
+            rule->screen = (int8_t)value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Alert_Engine_formatRule(const Alert_Rule_t* rule, char* buf, size_t size) {
+    int len = snprintf(buf, size, "%s %s %s %d hyst=%d debounce=%u prio=%u show=%s",
+                       rule->name, Vehicle_State_signalName(rule->signal), ALERT_COMPARATOR_NAMES[rule->comparator],
+                       rule->threshold, rule->hysteresis, (unsigned)rule->debounceMs, (unsigned)rule->priority,
+                       ALERT_INDICATOR_NAMES[rule->indicator]);
+    if (rule->screen != ALERT_NO_SCREEN && len > 0 && (size_t)len < size) {
+        snprintf(buf + len, size - len, " screen=%d", rule->screen);
+    }
+}
+
+int Alert_Engine_load(Alert_Engine_t* engine, File file) {
+    // Replaces every rule, returns the number loaded or -1 without a file. Bad lines are reported and skipped.
+    if (!file) {
+        return -1;
+    }
+    Alert_Engine_init(engine);
+
+    char line[ALERT_LINE_SIZE];
+    int lineNumber = 0;
+    bool more = true;
+    while (more) {
+        size_t len = 0;
+        int c;
+        while ((c = file.read()) >= 0 && c != '\n') {
+            if (c != '\r' && len < sizeof(line) - 1) {
+                line[len++] = (char)c;
+            }
+        }
+        line[len] = '\0';
+        more = c >= 0;
+        lineNumber++;
+
+        const char* p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        Alert_Rule_t rule;
+        if (!Alert_Engine_parseRule(p, &rule)) {
+            Serial.printf("Alert rules line %d ignored: %s\n", lineNumber, p);
+        } else if (!Alert_Engine_setRule(engine, &rule)) {
+            Serial.printf("Alert rules line %d ignored, table full\n", lineNumber);
+        }
+    }
+    file.close();
+    return engine->ruleCount;
+}
+
+bool Alert_Engine_save(const Alert_Engine_t* engine, File file) {
+    if (!file) {
+        return false;
+    }
+    char line[ALERT_LINE_SIZE];
+    file.print("# name signal op threshold [hyst=] [debounce=ms] [prio=] [show=none|shift|redline|coolant|overheat] [screen=]\n");
+    for (uint8_t i = 0; i < engine->ruleCount; i++) {
+        Alert_Engine_formatRule(&engine->rules[i], line, sizeof(line));
+        file.print(line);
+        file.print("\n");
+    }
+    file.close();
+    return true;
+}
+
+static void Alert_Engine_refresh(Alert_Engine_t* engine) {
+    // Shared by every screen: the indicators to draw and the screen of the most urgent alert
+    uint32_t indicators = 0;
+    int8_t screen = ALERT_NO_SCREEN;
+    int priority = -1;
+    for (uint8_t i = 0; i < engine->ruleCount; i++) {
+        if (!engine->states[i].active) {
+            continue;
+        }
+        indicators |= 1u << engine->rules[i].indicator;
+        if (engine->rules[i].screen != ALERT_NO_SCREEN && engine->rules[i].priority > priority) {
+            priority = engine->rules[i].priority;
+            screen = engine->rules[i].screen;
+        }
+    }
+    engine->indicators = indicators;
+    engine->overrideScreen = screen;
+    engine->changes++;
+}
+
+bool Alert_Engine_setRule(Alert_Engine_t* engine, const Alert_Rule_t* rule) {
+    // Replaces the rule of the same name, its state starts over
+    uint8_t index = 0;
+    while (index < engine->ruleCount && strcmp(engine->rules[index].name, rule->name) != 0) {
+        index++;
+    }
+    if (index == ALERT_MAX_RULES || rule->signal >= VEHICLE_STATE_SIGNAL_COUNT) {
+        return false;
+    }
+    if (index == engine->ruleCount) {
+        engine->ruleCount++;
+    }
+    engine->rules[index] = *rule;
+    memset(&engine->states[index], 0, sizeof(engine->states[index]));
+    Alert_Engine_refresh(engine);
+    return true;
+}
+
+bool Alert_Engine_removeRule(Alert_Engine_t* engine, const char* name) {
+    for (uint8_t i = 0; i < engine->ruleCount; i++) {
+        if (strcmp(engine->rules[i].name, name) == 0) {
+            engine->ruleCount--;
+            memmove(&engine->rules[i], &engine->rules[i + 1], (engine->ruleCount - i) * sizeof(engine->rules[0]));
+            memmove(&engine->states[i], &engine->states[i + 1], (engine->ruleCount - i) * sizeof(engine->states[0]));
+            Alert_Engine_refresh(engine);
+            return true;
+        }
+    }
+    return false;
+}
+
+// === EVALUATION ===
+static bool Alert_Engine_holds(Alert_Comparator_t comparator, int32_t value, int32_t threshold) {
+    switch (comparator) {
+        case ALERT_ABOVE: return value > threshold;
+        case ALERT_AT_LEAST: return value >= threshold;
+        case ALERT_BELOW: return value < threshold;
+        case ALERT_AT_MOST: return value <= threshold;
+    }
+    return false;
+}
+
+static bool Alert_Engine_evaluate(const Alert_Rule_t* rule, Alert_State_t* alert, const Vehicle_State_t* state, uint32_t nowMs) {
+    // Returns true when the alert raised or cleared
+    alert->fresh = Vehicle_State_status(state, rule->signal, nowMs) == VEHICLE_VALUE_FRESH;
+    if (!alert->fresh) {
+        alert->pending = false;
+        if (alert->active) {
+            alert->active = false;
+            return true;
+        }
+        return false;
+    }
+
+    // An active alert holds until the value is past the threshold by the hysteresis
+    int32_t threshold = rule->threshold;
+    if (alert->active) {
+        bool upward = rule->comparator == ALERT_ABOVE || rule->comparator == ALERT_AT_LEAST;
+        threshold += upward ? -rule->hysteresis : rule->hysteresis;
+    }
+    bool condition = Alert_Engine_holds(rule->comparator, state->value[rule->signal], threshold);
+    if (condition == alert->active) {
+        alert->pending = false;
+        return false;
+    }
+    if (!alert->pending) {
+        alert->pending = true;
+        alert->pendingSinceMs = nowMs;
+    }
+    if (nowMs - alert->pendingSinceMs < rule->debounceMs) {
+        return false;
+    }
+    alert->pending = false;
+    alert->active = condition;
+    if (condition) {
+        alert->activeSinceMs = nowMs;
+        alert->activations++;
+    }
+    return true;
+}
+
+bool Alert_Engine_update(Alert_Engine_t* engine, const Vehicle_State_t* state, uint32_t nowMs) {
+    // Returns true when any alert raised or cleared
+    bool newData = state->generation != engine->generation;
+    bool changed = false;
+    for (uint8_t i = 0; i < engine->ruleCount; i++) {
+        const Alert_Rule_t* rule = &engine->rules[i];
+        Alert_State_t* alert = &engine->states[i];
+        bool idle = !alert->active && !alert->pending && alert->fresh;
+        if (idle && !(newData && Vehicle_State_changedSince(state, 1u << rule->signal, engine->generation))) {
+            continue;
+        }
+        engine->evaluations++;
+        changed |= Alert_Engine_evaluate(rule, alert, state, nowMs);
+    }
+    engine->generation = state->generation;
+    if (changed) {
+        Alert_Engine_refresh(engine);
+    }
+    return changed;
+}
+
+bool Alert_Engine_indicator(const Alert_Engine_t* engine, Alert_Indicator_t indicator) {
+    return indicator != ALERT_INDICATOR_NONE && (engine->indicators & (1u << indicator)) != 0;
+}
+
+int Alert_Engine_overrideScreen(const Alert_Engine_t* engine) {
+    return engine->overrideScreen;
+}
+
+void Alert_Engine_printStatus(const Alert_Engine_t* engine, uint32_t nowMs) {
+    char line[ALERT_LINE_SIZE];
+    Serial.printf("Alert rules: %u, evaluations: %lu", (unsigned)engine->ruleCount, (unsigned long)engine->evaluations);
+    if (engine->overrideScreen != ALERT_NO_SCREEN) {
+        Serial.printf(", showing screen %d", engine->overrideScreen);
+    }
+    Serial.println();
+    for (uint8_t i = 0; i < engine->ruleCount; i++) {
+        const Alert_State_t* alert = &engine->states[i];
+        Alert_Engine_formatRule(&engine->rules[i], line, sizeof(line));
+        if (alert->active) {
+            Serial.printf("  ACTIVE %lus  ", (unsigned long)((nowMs - alert->activeSinceMs) / 1000));
+        } else if (alert->pending) {
+            Serial.print("  pending    ");
+        } else {
+            Serial.print(alert->fresh ? "  ok         " : "  no reading ");
+        }
+        Serial.printf("%s (raised %u times)\n", line, (unsigned)alert->activations);
+    }
+}
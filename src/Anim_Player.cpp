@@ -0,0 +1,182 @@
+#include "Anim_Player.h"
+#include <Arduino.h>
+#include <string.h>
+
+void Anim_Player_init(Anim_Player_t* player) {
+    player->state = ANIM_PLAYER_IDLE;
+    player->file = File();
+    player->display = nullptr;
+    player->frameCount = 0;
+    player->frameMs = 0;
+    player->framesDecoded = 0;
+    player->framesShown = 0;
+    player->nextFrameAt = 0;
+    player->front = 0;
+    player->backReady = false;
+    player->chunkLen = 0;
+    player->chunkPos = 0;
+    player->framesLate = 0;
+}
+
+static bool Anim_Player_readByte(Anim_Player_t* player, uint8_t* value) {
+    if (player->chunkPos >= player->chunkLen) {
+        player->chunkPos = 0;
+        player->chunkLen = (uint16_t)player->file.read(player->chunk, sizeof(player->chunk));
+        if (player->chunkLen == 0) {
+            return false;
+        }
+    }
+    *value = player->chunk[player->chunkPos++];
+    return true;
+}
+
+static bool Anim_Player_readBytes(Anim_Player_t* player, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (!Anim_Player_readByte(player, &dst[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Anim_Player_start(Anim_Player_t* player, File file, U8G2* display) {
+    Anim_Player_stop(player);
+    Anim_Player_init(player);
+    if (!file) {
+        return false;
+    }
+    player->file = file;
+    player->display = display;
+
+    uint8_t header[ANIM_PLAYER_HEADER_SIZE];
+    if (!Anim_Player_readBytes(player, header, sizeof(header)) ||
+        memcmp(header, ANIM_PLAYER_MAGIC, 4) != 0 || header[4] != ANIM_PLAYER_VERSION) {
+        player->file.close();
+        return false;
+    }
+
+    // Frames are stored in the panel's page layout, so the geometry must match exactly
+    uint16_t width = (uint16_t)(header[6] | (header[7] << 8));
+    uint16_t height = (uint16_t)(header[8] | (header[9] << 8));
+    if (width != display->getBufferTileWidth() * 8 || height != display->getBufferTileHeight() * 8 ||
+        (uint32_t)width * height / 8 != ANIM_PLAYER_FRAME_BYTES) {
+        player->file.close();
+        return false;
+    }
+    player->frameCount = (uint16_t)(header[10] | (header[11] << 8));
+    player->frameMs = (uint16_t)(header[12] | (header[13] << 8));
+
+    // Delta frames start from a blank panel
+    memset(player->frames[player->front], 0, ANIM_PLAYER_FRAME_BYTES);
+    player->nextFrameAt = millis();
+    player->state = ANIM_PLAYER_PLAYING;
+    return true;
+}
+
+static bool Anim_Player_decodeNext(Anim_Player_t* player) {
+    uint8_t frameHeader[3];
+    if (!Anim_Player_readBytes(player, frameHeader, sizeof(frameHeader))) {
+        return false;
+    }
+    uint8_t type = frameHeader[0];
+    uint16_t payloadLen = (uint16_t)(frameHeader[1] | (frameHeader[2] << 8));
+    if (type != ANIM_PLAYER_FRAME_KEY && type != ANIM_PLAYER_FRAME_DELTA) {
+        return false;
+    }
+
+    const uint8_t* prev = player->frames[player->front];
+    uint8_t* out = player->frames[player->front ^ 1];
+    bool delta = (type == ANIM_PLAYER_FRAME_DELTA);
+    uint16_t pos = 0;
+    uint16_t consumed = 0;
+
+    // Literal and repeat runs, XORed onto the previous frame for delta frames
+    while (pos < ANIM_PLAYER_FRAME_BYTES && consumed < payloadLen) {
+        uint8_t control;
+        uint8_t value = 0;
+        if (!Anim_Player_readByte(player, &control)) {
+            return false;
+        }
+        consumed++;
+        if (control < 0x80) {
+            uint16_t count = (uint16_t)(control + 1);
+            if (pos + count > ANIM_PLAYER_FRAME_BYTES) {
+                return false;
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                if (!Anim_Player_readByte(player, &value)) {
+                    return false;
+                }
+                out[pos] = delta ? (uint8_t)(prev[pos] ^ value) : value;
+                pos++;
+            }
+            consumed += count;
+        } else {
+            uint16_t count = (uint16_t)(control - 0x80 + ANIM_PLAYER_RLE_MIN_RUN);
+            if (pos + count > ANIM_PLAYER_FRAME_BYTES || !Anim_Player_readByte(player, &value)) {
+                return false;
+            }
+            consumed++;
+            if (delta) {
+                for (uint16_t i = 0; i < count; i++, pos++) {
+                    out[pos] = prev[pos] ^ value;
+                }
+            } else {
+                memset(&out[pos], value, count);
+                pos += count;
+            }
+        }
+    }
+    return pos == ANIM_PLAYER_FRAME_BYTES && consumed == payloadLen;
+}
+
+bool Anim_Player_step(Anim_Player_t* player, Display_Renderer_Context_t* renderer) {
+    if (player->state != ANIM_PLAYER_PLAYING) {
+        return false;
+    }
+
+    // Prefetch: decode the next frame while the current one is on screen
+    if (!player->backReady) {
+        if (player->framesDecoded >= player->frameCount || !Anim_Player_decodeNext(player)) {
+            Anim_Player_stop(player);
+            return false;
+        }
+        player->framesDecoded++;
+        player->backReady = true;
+        if ((long)(millis() - player->nextFrameAt) > (long)player->frameMs) {
+            player->framesLate++;
+        }
+        return true;
+    }
+
+    unsigned long now = millis();
+    if ((long)(now - player->nextFrameAt) < 0) {
+        return true;
+    }
+
+    // Show the prefetched frame, the renderer only sends tiles that changed since the last one
+    player->front ^= 1;
+    player->backReady = false;
+    memcpy(player->display->getBufferPtr(), player->frames[player->front], ANIM_PLAYER_FRAME_BYTES);
+    Display_Renderer_present(renderer);
+    player->framesShown++;
+    player->nextFrameAt += player->frameMs;
+    if ((long)(now - player->nextFrameAt) > (long)player->frameMs) {
+        player->nextFrameAt = now + player->frameMs;   // Fell behind, do not try to catch up
+    }
+    return true;
+}
+
+void Anim_Player_stop(Anim_Player_t* player) {
+    if (player->file) {
+        player->file.close();
+    }
+    if (player->state == ANIM_PLAYER_PLAYING) {
+        player->state = ANIM_PLAYER_DONE;
+    }
+    player->backReady = false;
+}
+
+bool Anim_Player_isPlaying(const Anim_Player_t* player) {
+    return player->state == ANIM_PLAYER_PLAYING;
+}
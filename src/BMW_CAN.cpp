@@ -1,24 +1,199 @@
 #include "BMW_CAN.h"
+#include "Signal_DB.h"
+#include "Vehicle_State.h"
 #include <string.h>
 #include <stdio.h>
 
-void BMW_parseCANMessage(uint32_t rxId, uint8_t len, const uint8_t* buf, BMW_CAN_Context_t* ctx, bool* displayUpdated) {
-    if (rxId == 0x316 && len >= 8) {
-        ctx->dme1->ignition = (buf[0] & 0x01) > 0;
-        ctx->dme1->cranking = (buf[0] & 0x02) > 0;
-        ctx->dme1->tcs = (buf[0] & 0x04) > 0;
-        ctx->dme1->torque = buf[1];
-        ctx->dme1->rpm = (buf[3] << 8) | buf[2];
-        ctx->dme1->torqueLoss = buf[5];
-        *displayUpdated = true;
-    } else if (rxId == 0x329 && len >= 3) {
-        ctx->dme2->coolantTemp = (int)((float)buf[1] * 0.75 - 48);
-        ctx->dme2->manifoldPressure = buf[2] == 0xFF ? -999 : (int)(buf[2] * 2 + 598);
-        *displayUpdated = true;
-    } else if (rxId == 0x545 && len >= 1) {
-        ctx->dme4->mil = (buf[0] & 0x02) > 0;
-        ctx->dme4->cruise = (buf[0] & 0x08) > 0;
-        ctx->dme4->eml = (buf[0] & 0x10) > 0;
-        *displayUpdated = true;
+// === SIGNAL DATABASE ===
+// Adding a signal is a BMW_Signal_t slot plus a table entry, the decoders below are generated from these tables
+
+// DME1 (0x316) - Engine Status and Performance
+static constexpr Signal_Def_t BMW_DME1_SIGNALS[] = {
+    SIGNAL_FLAG(BMW_SIGNAL_IGNITION, 0),
+    SIGNAL_FLAG(BMW_SIGNAL_CRANKING, 1),
+    SIGNAL_FLAG(BMW_SIGNAL_TCS, 2),
+    SIGNAL_INT(BMW_SIGNAL_TORQUE, 8, 8, SIGNAL_LITTLE_ENDIAN, 1, 1, 0),
+    SIGNAL_INT(BMW_SIGNAL_RPM, 16, 16, SIGNAL_LITTLE_ENDIAN, 1, 1, 0),
+    SIGNAL_INT(BMW_SIGNAL_TORQUE_LOSS, 40, 8, SIGNAL_LITTLE_ENDIAN, 1, 1, 0),
+};
+
+// DME2 (0x329) - Engine Temperatures and Pressure
+static constexpr Signal_Def_t BMW_DME2_SIGNALS[] = {
+    SIGNAL_INT(BMW_SIGNAL_COOLANT_TEMP, 8, 8, SIGNAL_LITTLE_ENDIAN, 3, 4, -48),
+    SIGNAL_INT_SENTINEL(BMW_SIGNAL_MANIFOLD_PRESSURE, 16, 8, SIGNAL_LITTLE_ENDIAN, 2, 1, 598, 0xFF),
+};
+
+// DME4 (0x545) - Warning Lights, plus the MS42 oil temperature in byte 4
+static constexpr Signal_Def_t BMW_DME4_SIGNALS[] = {
+    SIGNAL_FLAG(BMW_SIGNAL_MIL, 1),
+    SIGNAL_FLAG(BMW_SIGNAL_CRUISE, 3),
+    SIGNAL_FLAG(BMW_SIGNAL_EML, 4),
+};
+static constexpr Signal_Def_t BMW_DME4_MS42_SIGNALS[] = {
+    SIGNAL_INT(BMW_SIGNAL_OIL_TEMP, 32, 8, SIGNAL_LITTLE_ENDIAN, 1, 1, -48),
+};
+
+// MS42 measurement blocks, not broadcast on PT-CAN but returned by the DME on request
+static constexpr Signal_Def_t BMW_MS42_TEMP_SIGNALS[] = {
+    SIGNAL_INT(BMW_SIGNAL_INTAKE_TEMP, 0, 8, SIGNAL_LITTLE_ENDIAN, 3, 4, -48),
+    SIGNAL_INT(BMW_SIGNAL_OUTLET_TEMP, 8, 8, SIGNAL_LITTLE_ENDIAN, 3, 4, -48),
+};
+static constexpr Signal_Def_t BMW_MS42_FUEL_SIGNALS[] = {
+    SIGNAL_INT(BMW_SIGNAL_FUEL_PRESSURE, 7, 16, SIGNAL_BIG_ENDIAN, 1, 10, 0),   // kPa
+    SIGNAL_INT(BMW_SIGNAL_LAMBDA, 23, 16, SIGNAL_BIG_ENDIAN, 1000, 32768, 0), // Lambda x 1000
+};
+static constexpr Signal_Def_t BMW_MS42_AIR_SIGNALS[] = {
+    SIGNAL_INT(BMW_SIGNAL_MAF, 7, 16, SIGNAL_BIG_ENDIAN, 1, 10, 0),           // kg/h
+};
+
+static_assert(Signal_isValid(BMW_DME1_SIGNALS, SIGNAL_COUNT(BMW_DME1_SIGNALS)), "Invalid DME1 signal table");
+static_assert(Signal_isValid(BMW_DME2_SIGNALS, SIGNAL_COUNT(BMW_DME2_SIGNALS)), "Invalid DME2 signal table");
+static_assert(Signal_isValid(BMW_DME4_SIGNALS, SIGNAL_COUNT(BMW_DME4_SIGNALS)), "Invalid DME4 signal table");
+static_assert(Signal_isValid(BMW_DME4_MS42_SIGNALS, SIGNAL_COUNT(BMW_DME4_MS42_SIGNALS)), "Invalid DME4 MS42 signal table");
+static_assert(Signal_isValid(BMW_MS42_TEMP_SIGNALS, SIGNAL_COUNT(BMW_MS42_TEMP_SIGNALS)), "Invalid MS42 temperature signal table");
+static_assert(Signal_isValid(BMW_MS42_FUEL_SIGNALS, SIGNAL_COUNT(BMW_MS42_FUEL_SIGNALS)), "Invalid MS42 fuel signal table");
+static_assert(Signal_isValid(BMW_MS42_AIR_SIGNALS, SIGNAL_COUNT(BMW_MS42_AIR_SIGNALS)), "Invalid MS42 air signal table");
+
+static constexpr uint8_t BMW_DME4_MS42_MIN_LEN = Signal_minLen(BMW_DME4_MS42_SIGNALS, SIGNAL_COUNT(BMW_DME4_MS42_SIGNALS));
+
+// === DECODERS ===
+static uint32_t BMW_decodeDME1(uint8_t len, const uint8_t* buf, void* target) {
+    BMW_CAN_Context_t* ctx = (BMW_CAN_Context_t*)target;
+    return Vehicle_State_decode<BMW_DME1_SIGNALS, SIGNAL_COUNT(BMW_DME1_SIGNALS)>(ctx->state, VEHICLE_STATE_BMW_BASE, buf);
+}
+
+static uint32_t BMW_decodeDME2(uint8_t len, const uint8_t* buf, void* target) {
+    BMW_CAN_Context_t* ctx = (BMW_CAN_Context_t*)target;
+    return Vehicle_State_decode<BMW_DME2_SIGNALS, SIGNAL_COUNT(BMW_DME2_SIGNALS)>(ctx->state, VEHICLE_STATE_BMW_BASE, buf);
+}
+
+static uint32_t BMW_decodeDME4(uint8_t len, const uint8_t* buf, void* target) {
+    BMW_CAN_Context_t* ctx = (BMW_CAN_Context_t*)target;
+    uint32_t changed = Vehicle_State_decode<BMW_DME4_SIGNALS, SIGNAL_COUNT(BMW_DME4_SIGNALS)>(ctx->state, VEHICLE_STATE_BMW_BASE, buf);
+    if (len >= BMW_DME4_MS42_MIN_LEN) {
+        changed |= Vehicle_State_decode<BMW_DME4_MS42_SIGNALS, SIGNAL_COUNT(BMW_DME4_MS42_SIGNALS)>(ctx->state, VEHICLE_STATE_BMW_BASE, buf);
+    }
+    return changed;
+}
+
+bool BMW_decodeMS42Block(BMW_MS42_Block_t block, uint8_t len, const uint8_t* buf, BMW_CAN_Context_t* ctx, uint32_t* changed) {
+    switch (block) {
+        case BMW_MS42_BLOCK_TEMP:
+            if (len < Signal_minLen(BMW_MS42_TEMP_SIGNALS, SIGNAL_COUNT(BMW_MS42_TEMP_SIGNALS))) {
+                return false;
+            }
+            *changed |= Vehicle_State_decode<BMW_MS42_TEMP_SIGNALS, SIGNAL_COUNT(BMW_MS42_TEMP_SIGNALS)>(ctx->state, VEHICLE_STATE_BMW_BASE, buf);
+            return true;
+        case BMW_MS42_BLOCK_FUEL:
+            if (len < Signal_minLen(BMW_MS42_FUEL_SIGNALS, SIGNAL_COUNT(BMW_MS42_FUEL_SIGNALS))) {
+                return false;
+            }
+            *changed |= Vehicle_State_decode<BMW_MS42_FUEL_SIGNALS, SIGNAL_COUNT(BMW_MS42_FUEL_SIGNALS)>(ctx->state, VEHICLE_STATE_BMW_BASE, buf);
+            return true;
+        case BMW_MS42_BLOCK_AIR:
+            if (len < Signal_minLen(BMW_MS42_AIR_SIGNALS, SIGNAL_COUNT(BMW_MS42_AIR_SIGNALS))) {
+                return false;
+            }
+            *changed |= Vehicle_State_decode<BMW_MS42_AIR_SIGNALS, SIGNAL_COUNT(BMW_MS42_AIR_SIGNALS)>(ctx->state, VEHICLE_STATE_BMW_BASE, buf);
+            return true;
+    }
+    return false;
+}
+
+// === ENCODERS ===
+// The decoders' tables run backwards, for the engine simulator
+uint8_t BMW_encodeFrame(uint32_t id, const int16_t* values, uint8_t* buf) {
+    memset(buf, 0, 8);
+    switch (id) {
+        case 0x316:
+            Signal_encode<BMW_DME1_SIGNALS, SIGNAL_COUNT(BMW_DME1_SIGNALS)>(values, buf);
+            return 8;
+        case 0x329:
+            Signal_encode<BMW_DME2_SIGNALS, SIGNAL_COUNT(BMW_DME2_SIGNALS)>(values, buf);
+            return 8;
+        case 0x545:
+            Signal_encode<BMW_DME4_SIGNALS, SIGNAL_COUNT(BMW_DME4_SIGNALS)>(values, buf);
+            Signal_encode<BMW_DME4_MS42_SIGNALS, SIGNAL_COUNT(BMW_DME4_MS42_SIGNALS)>(values, buf);
+            return 8;
     }
-} 
\ No newline at end of file
+    return 0;
+}
+
+uint8_t BMW_encodeMS42Block(BMW_MS42_Block_t block, const int16_t* values, uint8_t* buf) {
+    switch (block) {
+        case BMW_MS42_BLOCK_TEMP:
+            Signal_encode<BMW_MS42_TEMP_SIGNALS, SIGNAL_COUNT(BMW_MS42_TEMP_SIGNALS)>(values, buf);
+            return Signal_minLen(BMW_MS42_TEMP_SIGNALS, SIGNAL_COUNT(BMW_MS42_TEMP_SIGNALS));
+        case BMW_MS42_BLOCK_FUEL:
+            Signal_encode<BMW_MS42_FUEL_SIGNALS, SIGNAL_COUNT(BMW_MS42_FUEL_SIGNALS)>(values, buf);
+            return Signal_minLen(BMW_MS42_FUEL_SIGNALS, SIGNAL_COUNT(BMW_MS42_FUEL_SIGNALS));
+        case BMW_MS42_BLOCK_AIR:
+            Signal_encode<BMW_MS42_AIR_SIGNALS, SIGNAL_COUNT(BMW_MS42_AIR_SIGNALS)>(values, buf);
+            return Signal_minLen(BMW_MS42_AIR_SIGNALS, SIGNAL_COUNT(BMW_MS42_AIR_SIGNALS));
+    }
+    return 0;
+}
+
+// Diagnostic responses are reassembled by the ISO-TP layer, its sessions decode them
+static uint32_t BMW_decodeDMEResponse(uint8_t len, const uint8_t* buf, void* target) {
+    BMW_CAN_Context_t* ctx = (BMW_CAN_Context_t*)target;
+    return ctx->diagFrame != nullptr ? ctx->diagFrame(ctx->diagCtx, BMW_DIAG_DME_RESPONSE_ID, len, buf) : 0;
+}
+
+static uint32_t BMW_decodeKombiResponse(uint8_t len, const uint8_t* buf, void* target) {
+    BMW_CAN_Context_t* ctx = (BMW_CAN_Context_t*)target;
+    return ctx->diagFrame != nullptr ? ctx->diagFrame(ctx->diagCtx, BMW_DIAG_KOMBI_RESPONSE_ID, len, buf) : 0;
+}
+
+// Frames consumed by the BMW decoder, sorted by ID
+static constexpr CAN_Dispatch_Entry_t BMW_DISPATCH_ENTRIES[] = {
+    {0x316, 8, BMW_decodeDME1, 0},
+    {0x329, 3, BMW_decodeDME2, 0},
+    {0x545, 1, BMW_decodeDME4, 0},
+    {BMW_DIAG_DME_RESPONSE_ID, 2, BMW_decodeDMEResponse, CAN_DISPATCH_EVERY_FRAME},
+    {BMW_DIAG_KOMBI_RESPONSE_ID, 2, BMW_decodeKombiResponse, CAN_DISPATCH_EVERY_FRAME},
+};
+static constexpr size_t BMW_DISPATCH_COUNT = sizeof(BMW_DISPATCH_ENTRIES) / sizeof(BMW_DISPATCH_ENTRIES[0]);
+static_assert(CAN_Dispatch_isSorted(BMW_DISPATCH_ENTRIES, BMW_DISPATCH_COUNT), "BMW dispatch entries must be sorted by ID");
+static_assert(BMW_DISPATCH_ENTRIES[0].minLen >= Signal_minLen(BMW_DME1_SIGNALS, SIGNAL_COUNT(BMW_DME1_SIGNALS)) &&
+              BMW_DISPATCH_ENTRIES[1].minLen >= Signal_minLen(BMW_DME2_SIGNALS, SIGNAL_COUNT(BMW_DME2_SIGNALS)) &&
+              BMW_DISPATCH_ENTRIES[2].minLen >= Signal_minLen(BMW_DME4_SIGNALS, SIGNAL_COUNT(BMW_DME4_SIGNALS)),
+              "BMW dispatch minimum lengths must cover their signal tables");
+
+const CAN_Dispatch_Entry_t* BMW_getDispatchEntries(size_t* count) {
+    *count = BMW_DISPATCH_COUNT;
+    return BMW_DISPATCH_ENTRIES;
+}
+
+// Engine speed of a single DME1 frame. The dispatch table decodes only the newest frame of
+// each ID in a batch, the shift light needs every sample with its timestamp. False as well
+// when the frame's engine speed is out of range.
+bool BMW_decodeRPM(const CAN_Frame_t* frame, int16_t* rpm) {
+    if (frame->id != 0x316 || frame->len < BMW_DISPATCH_ENTRIES[0].minLen || (frame->flags & CAN_FRAME_FLAG_EXTENDED)) {
+        return false;
+    }
+    int16_t values[BMW_SIGNAL_COUNT] = {};
+    Signal_decode<BMW_DME1_SIGNALS, SIGNAL_COUNT(BMW_DME1_SIGNALS)>(frame->buf, values);
+    *rpm = values[BMW_SIGNAL_RPM];
+    return *rpm != SIGNAL_NO_VALUE;
+}
+
+// Broadcast frames that identify the bus for auto-detection, with their nominal periods
+static constexpr Bus_Fingerprint_Id_t BMW_FINGERPRINT[] = {
+    {0x316, 10},    // DME1
+    {0x329, 10},    // DME2
+    {0x545, 10},    // DME4
+};
+
+const Bus_Fingerprint_Id_t* BMW_getFingerprint(size_t* count) {
+    *count = sizeof(BMW_FINGERPRINT) / sizeof(BMW_FINGERPRINT[0]);
+    return BMW_FINGERPRINT;
+}
+
+bool BMW_registerDecoders(CAN_Dispatch_Table_t* table, BMW_CAN_Context_t* ctx, uint8_t maskShift) {
+    return CAN_Dispatch_register(table, BMW_DISPATCH_ENTRIES, BMW_DISPATCH_COUNT, ctx, maskShift);
+}
+
+uint32_t BMW_decodeBatch(const CAN_Frame_t* frames, size_t count, BMW_CAN_Context_t* ctx) {
+    return CAN_Dispatch_decodeBatch(BMW_DISPATCH_ENTRIES, BMW_DISPATCH_COUNT, frames, count, ctx);
+}
@@ -0,0 +1,164 @@
+#include "Bus_Fingerprint.h"
+#include <Arduino.h>
+#include <string.h>
+
+void Bus_Fingerprint_init(Bus_Fingerprint_t* fp) {
+    memset(fp, 0, sizeof(*fp));
+    fp->locked = BUS_FINGERPRINT_NONE;
+}
+
+bool Bus_Fingerprint_addProfile(Bus_Fingerprint_t* fp, const char* name, uint8_t vehicle, const Bus_Fingerprint_Id_t* ids, size_t count) {
+    if (fp->profileCount >= BUS_FINGERPRINT_MAX_PROFILES || count == 0 || count > BUS_FINGERPRINT_MAX_IDS) {
+        return false;
+    }
+    Bus_Fingerprint_Profile_t* profile = &fp->profiles[fp->profileCount++];
+    profile->name = name;
+    profile->vehicle = vehicle;
+    profile->ids = ids;
+    profile->idCount = (uint8_t)count;
+    return true;
+}
+
+static uint8_t Bus_Fingerprint_score(const Bus_Fingerprint_t* fp, uint8_t p, uint64_t elapsedUs) {
+    const Bus_Fingerprint_Profile_t* profile = &fp->profiles[p];
+    uint32_t profileFrames = 0;
+    uint32_t rateMatch = 0;     // Sum of per-ID percentages
+
+    for (uint8_t i = 0; i < profile->idCount; i++) {
+        uint32_t seen = fp->counts[p][i];
+        uint32_t expected = (uint32_t)(elapsedUs / ((uint32_t)profile->ids[i].periodMs * 1000));
+        if (expected == 0) {
+            expected = 1;
+        }
+        // Too few and too many frames both lower the match, a foreign ECU may reuse an ID at another rate
+        rateMatch += seen < expected ? seen * 100 / expected : expected * 100 / seen;
+        profileFrames += seen;
+    }
+    if (profileFrames == 0) {
+        return 0;
+    }
+    return (uint8_t)(rateMatch / profile->idCount * profileFrames / fp->matchedFrames);
+}
+
+static bool Bus_Fingerprint_tryLock(Bus_Fingerprint_t* fp, uint64_t nowUs) {
+    uint8_t best = BUS_FINGERPRINT_NONE;
+    uint8_t runnerUp = 0;
+    for (uint8_t p = 0; p < fp->profileCount; p++) {
+        if (best == BUS_FINGERPRINT_NONE || fp->score[p] > fp->score[best]) {
+            if (best != BUS_FINGERPRINT_NONE) {
+                runnerUp = fp->score[best];
+            }
+            best = p;
+        } else if (fp->score[p] > runnerUp) {
+            runnerUp = fp->score[p];
+        }
+    }
+    if (best == BUS_FINGERPRINT_NONE || fp->score[best] < BUS_FINGERPRINT_LOCK_PERCENT ||
+        fp->score[best] - runnerUp < BUS_FINGERPRINT_MARGIN_PERCENT) {
+        return false;
+    }
+    fp->locked = best;
+    fp->weakWindows = 0;
+    fp->lockedAtUs = nowUs;
+    fp->lockAfterMs = (uint32_t)((nowUs - fp->detectStartUs) / 1000);
+    fp->locks++;
+    return true;
+}
+
+static bool Bus_Fingerprint_closeWindow(Bus_Fingerprint_t* fp, uint64_t nowUs) {
+    uint64_t elapsedUs = nowUs - fp->windowStartUs;
+    // A window stretched over a silent bus says nothing about the rates
+    bool evidence = fp->matchedFrames > 0 && elapsedUs < 2 * BUS_FINGERPRINT_WINDOW_US;
+    bool changed = false;
+
+    if (evidence) {
+        fp->windows++;
+        for (uint8_t p = 0; p < fp->profileCount; p++) {
+            fp->score[p] = Bus_Fingerprint_score(fp, p, elapsedUs);
+        }
+
+        if (fp->locked != BUS_FINGERPRINT_NONE) {
+            fp->weakWindows = fp->score[fp->locked] < BUS_FINGERPRINT_BREAK_PERCENT ? fp->weakWindows + 1 : 0;
+            if (fp->weakWindows >= BUS_FINGERPRINT_BREAK_WINDOWS) {
+                // The fingerprint broke, e.g. another vehicle on the connector: start over
+                fp->locked = BUS_FINGERPRINT_NONE;
+                fp->weakWindows = 0;
+                fp->breaks++;
+                fp->detectStartUs = fp->windowStartUs;
+                changed = true;
+            }
+        }
+        // A window that broke the lock can already identify the new vehicle
+        if (fp->locked == BUS_FINGERPRINT_NONE && Bus_Fingerprint_tryLock(fp, nowUs)) {
+            changed = true;
+        }
+    }
+
+    memset(fp->counts, 0, sizeof(fp->counts));
+    fp->matchedFrames = 0;
+    fp->windowStartUs = nowUs;
+    return changed;
+}
+
+bool Bus_Fingerprint_frame(Bus_Fingerprint_t* fp, const CAN_Frame_t* frame) {
+    // Returns true when the locked profile changed
+    bool changed = false;
+    if (!fp->windowOpen) {
+        fp->windowOpen = true;
+        fp->windowStartUs = frame->timestamp;
+        fp->detectStartUs = frame->timestamp;
+    } else if (frame->timestamp - fp->windowStartUs >= BUS_FINGERPRINT_WINDOW_US) {
+        // Detection resumes from here after a silent bus
+        if (fp->locked == BUS_FINGERPRINT_NONE && fp->matchedFrames == 0) {
+            fp->detectStartUs = frame->timestamp;
+        }
+        changed = Bus_Fingerprint_closeWindow(fp, frame->timestamp);
+    }
+
+    if (frame->flags & CAN_FRAME_FLAG_EXTENDED) {
+        return changed;
+    }
+    bool matched = false;
+    for (uint8_t p = 0; p < fp->profileCount; p++) {
+        const Bus_Fingerprint_Profile_t* profile = &fp->profiles[p];
+        for (uint8_t i = 0; i < profile->idCount; i++) {
+            if (profile->ids[i].id == frame->id) {
+                if (fp->counts[p][i] < UINT16_MAX) {
+                    fp->counts[p][i]++;
+                }
+                matched = true;
+            }
+        }
+    }
+    if (matched) {
+        fp->matchedFrames++;
+    }
+    return changed;
+}
+
+const Bus_Fingerprint_Profile_t* Bus_Fingerprint_lockedProfile(const Bus_Fingerprint_t* fp) {
+    return fp->locked != BUS_FINGERPRINT_NONE ? &fp->profiles[fp->locked] : nullptr;
+}
+
+uint8_t Bus_Fingerprint_confidence(const Bus_Fingerprint_t* fp) {
+    return fp->locked != BUS_FINGERPRINT_NONE ? fp->score[fp->locked] : 0;
+}
+
+void Bus_Fingerprint_printStatus(const Bus_Fingerprint_t* fp) {
+    const Bus_Fingerprint_Profile_t* locked = Bus_Fingerprint_lockedProfile(fp);
+    if (locked != nullptr) {
+        Serial.printf("Auto-detect: %s, confidence %u%%, locked after %lu ms\n",
+                      locked->name, (unsigned)Bus_Fingerprint_confidence(fp), (unsigned long)fp->lockAfterMs);
+    } else if (!fp->windowOpen) {
+        Serial.println("Auto-detect: waiting for traffic");
+    } else {
+        Serial.println("Auto-detect: detecting, no decoder active");
+    }
+
+    Serial.print("Profiles:");
+    for (uint8_t p = 0; p < fp->profileCount; p++) {
+        Serial.printf(" %s %u%%", fp->profiles[p].name, (unsigned)fp->score[p]);
+    }
+    Serial.printf("\nWindows: %lu  locks: %lu  re-detections: %lu\n",
+                  (unsigned long)fp->windows, (unsigned long)fp->locks, (unsigned long)fp->breaks);
+}
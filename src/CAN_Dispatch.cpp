@@ -0,0 +1,156 @@
+#include "CAN_Dispatch.h"
+#include <string.h>
+
+void CAN_Dispatch_clear(CAN_Dispatch_Table_t* table) {
+    memset(table->slotForId, CAN_DISPATCH_NO_SLOT, sizeof(table->slotForId));
+    table->count = 0;
+}
+
+static_assert(CAN_DISPATCH_MAX_ENTRIES <= 32, "Batch coalescing tracks slots in a 32-bit mask");
+
+bool CAN_Dispatch_register(CAN_Dispatch_Table_t* table, const CAN_Dispatch_Entry_t* entries, size_t count, void* target, uint8_t maskShift) {
+    // All or nothing: every entry is checked before the table changes
+    if (count > (size_t)(CAN_DISPATCH_MAX_ENTRIES - table->count)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        // Only standard identifiers are dispatched, and the first registration of an ID wins
+        uint32_t id = entries[i].id;
+        if (id >= CAN_DISPATCH_STD_ID_COUNT || table->slotForId[id] != CAN_DISPATCH_NO_SLOT) {
+            return false;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (entries[j].id == id) {
+                return false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        table->slots[table->count].entry = &entries[i];
+        table->slots[table->count].target = target;
+        table->slots[table->count].maskShift = maskShift;
+        table->slotForId[entries[i].id] = table->count;
+        table->count++;
+    }
+    return true;
+}
+
+bool CAN_Dispatch_process(const CAN_Dispatch_Table_t* table, uint32_t rxId, uint8_t len, const uint8_t* buf, uint32_t* changed) {
+    if (rxId >= CAN_DISPATCH_STD_ID_COUNT) {
+        return false;
+    }
+
+    uint8_t slot = table->slotForId[rxId];
+    if (slot == CAN_DISPATCH_NO_SLOT) {
+        return false;
+    }
+
+    const CAN_Dispatch_Slot_t* s = &table->slots[slot];
+    if (len < s->entry->minLen) {
+        return false;
+    }
+    *changed |= s->entry->decode(len, buf, s->target) << s->maskShift;
+    return true;
+}
+
+size_t CAN_Dispatch_processBatch(const CAN_Dispatch_Table_t* table, const CAN_Frame_t* frames, size_t count, uint32_t* changed) {
+    // Newest frame first: once an ID was decoded, older copies in the batch are superseded
+    uint32_t decodedSlots = 0;
+    size_t matched = 0;
+    bool haveEveryFrame = false;
+    for (size_t i = count; i-- > 0;) {
+        const CAN_Frame_t* frame = &frames[i];
+        if (frame->id >= CAN_DISPATCH_STD_ID_COUNT || (frame->flags & CAN_FRAME_FLAG_EXTENDED)) {
+            continue;
+        }
+        uint8_t slot = table->slotForId[frame->id];
+        if (slot == CAN_DISPATCH_NO_SLOT) {
+            continue;
+        }
+        const CAN_Dispatch_Slot_t* s = &table->slots[slot];
+        if (frame->len < s->entry->minLen) {
+            continue;
+        }
+        matched++;
+        if (s->entry->flags & CAN_DISPATCH_EVERY_FRAME) {
+            haveEveryFrame = true;
+            continue;
+        }
+        if (decodedSlots & (1u << slot)) {
+            continue;
+        }
+        decodedSlots |= 1u << slot;
+        *changed |= s->entry->decode(frame->len, frame->buf, s->target) << s->maskShift;
+    }
+
+    // Request/response traffic is decoded in arrival order, e.g. ISO-TP consecutive frames
+    for (size_t i = 0; haveEveryFrame && i < count; i++) {
+        const CAN_Frame_t* frame = &frames[i];
+        if (frame->id >= CAN_DISPATCH_STD_ID_COUNT || (frame->flags & CAN_FRAME_FLAG_EXTENDED)) {
+            continue;
+        }
+        uint8_t slot = table->slotForId[frame->id];
+        if (slot == CAN_DISPATCH_NO_SLOT) {
+            continue;
+        }
+        const CAN_Dispatch_Slot_t* s = &table->slots[slot];
+        if ((s->entry->flags & CAN_DISPATCH_EVERY_FRAME) && frame->len >= s->entry->minLen) {
+            *changed |= s->entry->decode(frame->len, frame->buf, s->target) << s->maskShift;
+        }
+    }
+    return matched;
+}
+
+uint32_t CAN_Dispatch_decodeBatch(const CAN_Dispatch_Entry_t* entries, size_t entryCount, const CAN_Frame_t* frames, size_t count, void* target) {
+    // Same coalescing as CAN_Dispatch_processBatch, for a single vehicle without a table
+    uint32_t decodedEntries = 0;
+    uint32_t changed = 0;
+    bool haveEveryFrame = false;
+    for (size_t i = count; i-- > 0;) {
+        const CAN_Frame_t* frame = &frames[i];
+        if (frame->flags & CAN_FRAME_FLAG_EXTENDED) {
+            continue;
+        }
+        const CAN_Dispatch_Entry_t* entry = CAN_Dispatch_findEntry(entries, entryCount, frame->id);
+        if (entry == nullptr || frame->len < entry->minLen) {
+            continue;
+        }
+        if (entry->flags & CAN_DISPATCH_EVERY_FRAME) {
+            haveEveryFrame = true;
+            continue;
+        }
+        uint32_t bit = 1u << (entry - entries);
+        if (decodedEntries & bit) {
+            continue;
+        }
+        decodedEntries |= bit;
+        changed |= entry->decode(frame->len, frame->buf, target);
+    }
+    for (size_t i = 0; haveEveryFrame && i < count; i++) {
+        const CAN_Frame_t* frame = &frames[i];
+        if (frame->flags & CAN_FRAME_FLAG_EXTENDED) {
+            continue;
+        }
+        const CAN_Dispatch_Entry_t* entry = CAN_Dispatch_findEntry(entries, entryCount, frame->id);
+        if (entry != nullptr && (entry->flags & CAN_DISPATCH_EVERY_FRAME) && frame->len >= entry->minLen) {
+            changed |= entry->decode(frame->len, frame->buf, target);
+        }
+    }
+    return changed;
+}
+
+const CAN_Dispatch_Entry_t* CAN_Dispatch_findEntry(const CAN_Dispatch_Entry_t* entries, size_t count, uint32_t rxId) {
+    // Binary search over a sorted entry array
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (entries[mid].id < rxId) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < count && entries[lo].id == rxId) ? &entries[lo] : nullptr;
+}
@@ -0,0 +1,125 @@
+#include "CAN_Filter.h"
+
+static size_t CAN_Filter_distinct(const uint32_t* ids, size_t count, uint16_t mask, uint16_t* values, size_t maxValues) {
+    size_t distinct = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t value = (uint16_t)(ids[i] & mask);
+        bool seen = false;
+        for (size_t j = 0; j < distinct && j < maxValues; j++) {
+            if (values[j] == value) {
+                seen = true;
+                break;
+            }
+        }
+        if (!seen) {
+            if (distinct < maxValues) {
+                values[distinct] = value;
+            }
+            distinct++;
+        }
+    }
+    return distinct;
+}
+
+void CAN_Filter_compute(const uint32_t* ids, size_t count, CAN_Filter_Config_t* config) {
+    uint16_t values[CAN_FILTER_SLOT_COUNT];
+
+    if (count == 0) {
+        // Nothing decoded, keep the controller open rather than deaf
+        for (int i = 0; i < CAN_FILTER_MASK_COUNT; i++) {
+            config->masks[i] = 0;
+        }
+        for (int i = 0; i < CAN_FILTER_SLOT_COUNT; i++) {
+            config->filters[i] = 0;
+        }
+        config->exact = false;
+        config->acceptAll = true;
+        return;
+    }
+
+    // Clear mask bits one at a time until the masked IDs fit the filter slots,
+    // always dropping the bit that merges the most IDs
+    uint16_t mask = CAN_FILTER_STD_ID_MASK;
+    size_t distinct = CAN_Filter_distinct(ids, count, mask, values, CAN_FILTER_SLOT_COUNT);
+    while (distinct > CAN_FILTER_SLOT_COUNT) {
+        uint16_t bestMask = mask;
+        size_t bestDistinct = distinct;
+        for (int bit = 0; bit < 11; bit++) {
+            uint16_t candidate = mask & ~(1u << bit);
+            if (candidate == mask) {
+                continue;
+            }
+            size_t d = CAN_Filter_distinct(ids, count, candidate, values, CAN_FILTER_SLOT_COUNT);
+            if (d < bestDistinct) {
+                bestDistinct = d;
+                bestMask = candidate;
+            }
+        }
+        if (bestMask == mask) {
+            // No single bit helps, drop the lowest remaining one
+            bestMask = mask & (mask - 1);
+            bestDistinct = CAN_Filter_distinct(ids, count, bestMask, values, CAN_FILTER_SLOT_COUNT);
+        }
+        mask = bestMask;
+        distinct = bestDistinct;
+    }
+    CAN_Filter_distinct(ids, count, mask, values, CAN_FILTER_SLOT_COUNT);
+
+    // The first IDs (the busiest ones, by convention) go to RXB0 which rolls over into RXB1.
+    // Unused slots repeat an accepted value so they never open up ID 0x000.
+    config->masks[0] = mask;
+    config->masks[1] = mask;
+    for (int i = 0; i < CAN_FILTER_SLOT_COUNT; i++) {
+        size_t source;
+        if (i < CAN_FILTER_RXB0_SLOTS) {
+            source = (size_t)i < distinct ? (size_t)i : 0;
+        } else {
+            size_t rxb1Index = CAN_FILTER_RXB0_SLOTS + (size_t)(i - CAN_FILTER_RXB0_SLOTS);
+            source = rxb1Index < distinct ? rxb1Index : distinct - 1;
+        }
+        config->filters[i] = values[source];
+    }
+    config->exact = (mask == CAN_FILTER_STD_ID_MASK);
+    config->acceptAll = false;
+}
+
+uint32_t CAN_Filter_acceptedIdCount(const CAN_Filter_Config_t* config) {
+    if (config->acceptAll) {
+        return CAN_FILTER_STD_ID_MASK + 1;
+    }
+
+    // Each distinct filter value admits 2^(open mask bits) identifiers
+    uint32_t total = 0;
+    for (int m = 0; m < CAN_FILTER_MASK_COUNT; m++) {
+        int first = (m == 0) ? 0 : CAN_FILTER_RXB0_SLOTS;
+        int last = (m == 0) ? CAN_FILTER_RXB0_SLOTS : CAN_FILTER_SLOT_COUNT;
+        int openBits = 11 - __builtin_popcount(config->masks[m]);
+        for (int i = first; i < last; i++) {
+            bool duplicate = false;
+            for (int j = 0; j < i; j++) {
+                if ((config->filters[j] & config->masks[m]) == (config->filters[i] & config->masks[m])) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (!duplicate) {
+                total += 1u << openBits;
+            }
+        }
+    }
+    return total;
+}
+
+bool CAN_Filter_accepts(const CAN_Filter_Config_t* config, uint32_t id) {
+    // Same match the MCP2515 applies, for sources that emulate the controller
+    if (config->acceptAll) {
+        return true;
+    }
+    for (int i = 0; i < CAN_FILTER_SLOT_COUNT; i++) {
+        uint16_t mask = config->masks[i < CAN_FILTER_RXB0_SLOTS ? 0 : 1];
+        if ((id & mask) == (config->filters[i] & mask)) {
+            return true;
+        }
+    }
+    return false;
+}
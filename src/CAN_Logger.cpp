@@ -0,0 +1,424 @@
+#include "CAN_Logger.h"
+#include "Task_Config.h"
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <string.h>
+
+// === CRC ===
+uint32_t CAN_Logger_crc32(uint32_t crc, const uint8_t* data, size_t len) {
+    // Nibble table CRC-32 (IEEE), small enough for flash and fast enough per block
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static void CAN_Logger_put16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void CAN_Logger_put32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static void CAN_Logger_resetBlock(CAN_Logger_Block_t* block) {
+    block->len = CAN_LOGGER_BLOCK_HEADER_SIZE;
+    block->frameCount = 0;
+    block->dictCount = 0;
+}
+
+void CAN_Logger_init(CAN_Logger_t* logger) {
+    for (int i = 0; i < 2; i++) {
+        CAN_Logger_resetBlock(&logger->blocks[i]);
+        logger->blocks[i].sealed = false;
+    }
+    logger->active = 0;
+    logger->sequence = 0;
+    logger->recording = false;
+    logger->startRequested = false;
+    logger->stopRequested = false;
+    logger->file = File();
+    logger->fileIndex = 0;
+    logger->fileIndexValid = false;
+    logger->fileSize = 0;
+    logger->closeRequested = false;
+    logger->writerTask = nullptr;
+    logger->framesLogged = 0;
+    logger->framesDropped = 0;
+    logger->blocksWritten = 0;
+    logger->bytesWritten = 0;
+    logger->writeErrors = 0;
+    logger->filesRotated = 0;
+}
+
+// === WRITER ===
+static void CAN_Logger_notifyWriter(CAN_Logger_t* logger) {
+#ifdef ARDUINO_ARCH_ESP32
+    if (logger->writerTask != nullptr) {
+        xTaskNotifyGive((TaskHandle_t)logger->writerTask);
+        return;
+    }
+#endif
+    // No writer task (host build), write from the caller
+    CAN_Logger_writePending(logger);
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+static void CAN_Logger_writerTask(void* arg) {
+    CAN_Logger_t* logger = (CAN_Logger_t*)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        CAN_Logger_writePending(logger);
+    }
+}
+#endif
+
+bool CAN_Logger_startWriter(CAN_Logger_t* logger) {
+#ifdef ARDUINO_ARCH_ESP32
+    TaskHandle_t task = nullptr;
+    if (xTaskCreatePinnedToCore(CAN_Logger_writerTask, "can_log", LOG_TASK_STACK_SIZE, logger,
+                                LOG_TASK_PRIORITY, &task, LOG_TASK_CORE) != pdPASS) {
+        return false;
+    }
+    logger->writerTask = task;
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void CAN_Logger_path(char* path, uint16_t index) {
+    snprintf(path, CAN_LOGGER_PATH_SIZE, CAN_LOGGER_PATH_FORMAT, (unsigned)index);
+}
+
+static bool CAN_Logger_exists(uint16_t index) {
+    char path[CAN_LOGGER_PATH_SIZE];
+    CAN_Logger_path(path, index);
+    return SPIFFS.exists(path);
+}
+
+static bool CAN_Logger_removeOldest(CAN_Logger_t* logger) {
+    // Oldest is the first existing index after the current one, indices wrap at CAN_LOGGER_MAX_FILES
+    for (uint16_t i = 1; i < CAN_LOGGER_MAX_FILES; i++) {
+        uint16_t index = (uint16_t)((logger->fileIndex + i) % CAN_LOGGER_MAX_FILES);
+        if (CAN_Logger_exists(index)) {
+            char path[CAN_LOGGER_PATH_SIZE];
+            CAN_Logger_path(path, index);
+            SPIFFS.remove(path);
+            logger->filesRotated++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool CAN_Logger_ensureSpace(CAN_Logger_t* logger, size_t bytes) {
+    while (SPIFFS.usedBytes() + bytes + CAN_LOGGER_FREE_RESERVE > SPIFFS.totalBytes()) {
+        if (!CAN_Logger_removeOldest(logger)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool CAN_Logger_openNext(CAN_Logger_t* logger) {
+    // After boot continue behind the highest existing index, then simply count up
+    if (!logger->fileIndexValid) {
+        int newest = -1;
+        for (uint16_t i = 0; i < CAN_LOGGER_MAX_FILES; i++) {
+            if (CAN_Logger_exists(i)) {
+                newest = i;
+            }
+        }
+        logger->fileIndex = (uint16_t)((newest + CAN_LOGGER_MAX_FILES) % CAN_LOGGER_MAX_FILES);
+        logger->fileIndexValid = true;
+    }
+    logger->fileIndex = (uint16_t)((logger->fileIndex + 1) % CAN_LOGGER_MAX_FILES);
+
+    char path[CAN_LOGGER_PATH_SIZE];
+    CAN_Logger_path(path, logger->fileIndex);
+    if (SPIFFS.exists(path)) {
+        SPIFFS.remove(path);
+        logger->filesRotated++;
+    }
+    if (!CAN_Logger_ensureSpace(logger, CAN_LOGGER_FILE_HEADER_SIZE + CAN_LOGGER_BLOCK_SIZE)) {
+        return false;
+    }
+
+    logger->file = SPIFFS.open(path, FILE_WRITE);
+    if (!logger->file) {
+        return false;
+    }
+    uint8_t header[CAN_LOGGER_FILE_HEADER_SIZE] = {'C', 'A', 'N', 'L', CAN_LOGGER_FILE_VERSION, 0, 0, 0};
+    logger->fileSize = logger->file.write(header, sizeof(header));
+    return logger->fileSize == sizeof(header);
+}
+
+static bool CAN_Logger_writeBlock(CAN_Logger_t* logger, CAN_Logger_Block_t* block) {
+    if (logger->file && logger->fileSize + block->len > CAN_LOGGER_MAX_FILE_SIZE) {
+        logger->file.close();
+    }
+    if (!logger->file && !CAN_Logger_openNext(logger)) {
+        return false;
+    }
+    if (!CAN_Logger_ensureSpace(logger, block->len)) {
+        return false;
+    }
+    size_t written = logger->file.write(block->data, block->len);
+    logger->file.flush();
+    logger->fileSize += written;
+    logger->bytesWritten += written;
+    return written == block->len;
+}
+
+void CAN_Logger_writePending(CAN_Logger_t* logger) {
+    for (;;) {
+        // Write sealed blocks oldest first
+        CAN_Logger_Block_t* next = nullptr;
+        uint16_t nextSequence = 0;
+        for (int i = 0; i < 2; i++) {
+            CAN_Logger_Block_t* block = &logger->blocks[i];
+            if (!block->sealed.load(std::memory_order_acquire)) {
+                continue;
+            }
+            uint16_t sequence = (uint16_t)(block->data[6] | (block->data[7] << 8));
+            if (next == nullptr || (int16_t)(sequence - nextSequence) < 0) {
+                next = block;
+                nextSequence = sequence;
+            }
+        }
+        if (next == nullptr) {
+            break;
+        }
+
+        if (CAN_Logger_writeBlock(logger, next)) {
+            logger->blocksWritten++;
+        } else {
+            logger->writeErrors++;
+        }
+        CAN_Logger_resetBlock(next);
+        next->sealed.store(false, std::memory_order_release);
+    }
+
+    // Close only once the final block of the session is on flash. The request is cleared
+    // after the close, CAN_Logger_isIdle() relies on that
+    bool idle = !logger->blocks[0].sealed.load(std::memory_order_acquire) &&
+                !logger->blocks[1].sealed.load(std::memory_order_acquire);
+    if (idle && logger->closeRequested.load()) {
+        if (logger->file) {
+            logger->file.close();
+        }
+        logger->closeRequested = false;
+    }
+}
+
+// === ENCODER (CAN task) ===
+static void CAN_Logger_seal(CAN_Logger_t* logger) {
+    CAN_Logger_Block_t* block = &logger->blocks[logger->active];
+    uint16_t payloadLen = (uint16_t)(block->len - CAN_LOGGER_BLOCK_HEADER_SIZE);
+    uint8_t* header = block->data;
+    header[0] = 'B';
+    header[1] = 'K';
+    CAN_Logger_put16(&header[2], payloadLen);
+    CAN_Logger_put16(&header[4], block->frameCount);
+    CAN_Logger_put16(&header[6], logger->sequence++);
+    CAN_Logger_put32(&header[8], block->baseTimeUs);
+    CAN_Logger_put32(&header[12], CAN_Logger_crc32(0, &block->data[CAN_LOGGER_BLOCK_HEADER_SIZE], payloadLen));
+
+    block->sealed.store(true, std::memory_order_release);
+    logger->active ^= 1;
+    CAN_Logger_notifyWriter(logger);
+}
+
+static bool CAN_Logger_encode(CAN_Logger_Block_t* block, const CAN_Frame_t* frame) {
+    uint16_t id = (uint16_t)frame->id;
+    int index = -1;
+    for (int i = 0; i < block->dictCount; i++) {
+        if (block->dictIds[i] == id && block->dictLens[i] == frame->len) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0 && block->dictCount >= CAN_LOGGER_DICT_SIZE) {
+        return false;
+    }
+    if (block->len + CAN_LOGGER_MAX_FRAME_BYTES > CAN_LOGGER_BLOCK_SIZE) {
+        return false;
+    }
+
+    if (block->frameCount == 0) {
+        block->baseTimeUs = (uint32_t)frame->timestamp;   // The file format keeps 32-bit times
+        block->lastTimeUs = (uint32_t)frame->timestamp;
+        block->openedMs = millis();
+    }
+    uint8_t* p = &block->data[block->len];
+
+    // Timestamp delta as an unsigned LEB128 varint, usually one or two bytes on a busy bus
+    uint32_t delta = (uint32_t)frame->timestamp - block->lastTimeUs;
+    block->lastTimeUs = (uint32_t)frame->timestamp;
+    do {
+        uint8_t byte = delta & 0x7F;
+        delta >>= 7;
+        *p++ = byte | (delta ? 0x80 : 0);
+    } while (delta);
+
+    if (index >= 0) {
+        *p++ = (uint8_t)index;
+    } else {
+        *p++ = CAN_LOGGER_NEW_ENTRY;
+        CAN_Logger_put16(p, id);
+        p[2] = frame->len;
+        p += 3;
+        block->dictIds[block->dictCount] = id;
+        block->dictLens[block->dictCount] = frame->len;
+        block->dictCount++;
+    }
+    memcpy(p, frame->buf, frame->len);
+    p += frame->len;
+
+    block->len = (uint16_t)(p - block->data);
+    block->frameCount++;
+    return true;
+}
+
+void CAN_Logger_record(CAN_Logger_t* logger, const CAN_Frame_t* frame) {
+    if (!logger->recording) {
+        return;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        CAN_Logger_Block_t* block = &logger->blocks[logger->active];
+        if (block->sealed.load(std::memory_order_acquire)) {
+            break;  // Writer still owns both blocks
+        }
+        if (CAN_Logger_encode(block, frame)) {
+            logger->framesLogged++;
+            return;
+        }
+        CAN_Logger_seal(logger);
+    }
+    logger->framesDropped++;
+}
+
+void CAN_Logger_service(CAN_Logger_t* logger) {
+    CAN_Logger_Block_t* block = &logger->blocks[logger->active];
+    bool hasData = !block->sealed.load(std::memory_order_acquire) && block->frameCount > 0;
+
+    if (logger->startRequested.exchange(false)) {
+        logger->recording = true;
+    }
+    if (logger->stopRequested.exchange(false)) {
+        if (hasData) {
+            CAN_Logger_seal(logger);
+        }
+        // The close request first, so a stopped logger always shows its file as still open
+        logger->closeRequested = true;
+        logger->recording = false;
+        CAN_Logger_notifyWriter(logger);
+        return;
+    }
+
+    // A quiet bus must not leave frames in RAM indefinitely
+    if (hasData && millis() - block->openedMs >= CAN_LOGGER_FLUSH_MS) {
+        CAN_Logger_seal(logger);
+    }
+}
+
+// === CONSOLE (UI task) ===
+void CAN_Logger_start(CAN_Logger_t* logger) {
+    logger->startRequested = true;
+}
+
+void CAN_Logger_stop(CAN_Logger_t* logger) {
+    logger->stopRequested = true;
+}
+
+bool CAN_Logger_isRecording(const CAN_Logger_t* logger) {
+    return logger->recording;
+}
+
+bool CAN_Logger_isIdle(const CAN_Logger_t* logger) {
+    // Stopped, every sealed block written and the file closed: the writer leaves the files,
+    // fileIndex and fileSize alone until the console starts a new session
+    return !logger->recording && !logger->startRequested && !logger->stopRequested &&
+           !logger->closeRequested && !logger->blocks[0].sealed.load(std::memory_order_acquire) &&
+           !logger->blocks[1].sealed.load(std::memory_order_acquire);
+}
+
+void CAN_Logger_printStatus(const CAN_Logger_t* logger) {
+    char path[CAN_LOGGER_PATH_SIZE];
+    CAN_Logger_path(path, logger->fileIndex);
+    Serial.printf("Logger %s, file %s (%lu bytes)\n", logger->recording ? "recording" : "stopped",
+                  path, (unsigned long)logger->fileSize);
+    Serial.printf("Frames logged: %lu  dropped: %lu  blocks: %lu  bytes: %lu  write errors: %lu  rotated files: %lu\n",
+                  (unsigned long)logger->framesLogged, (unsigned long)logger->framesDropped,
+                  (unsigned long)logger->blocksWritten, (unsigned long)logger->bytesWritten,
+                  (unsigned long)logger->writeErrors, (unsigned long)logger->filesRotated);
+    Serial.printf("Flash: %lu of %lu bytes used\n", (unsigned long)SPIFFS.usedBytes(), (unsigned long)SPIFFS.totalBytes());
+}
+
+void CAN_Logger_list(void) {
+    int count = 0;
+    for (uint16_t i = 0; i < CAN_LOGGER_MAX_FILES; i++) {
+        char path[CAN_LOGGER_PATH_SIZE];
+        CAN_Logger_path(path, i);
+        if (!SPIFFS.exists(path)) {
+            continue;
+        }
+        File file = SPIFFS.open(path);
+        Serial.printf("%3u  %s  %lu bytes\n", (unsigned)i, path, (unsigned long)file.size());
+        file.close();
+        count++;
+    }
+    if (count == 0) {
+        Serial.println("No logs");
+    }
+}
+
+bool CAN_Logger_dump(uint16_t index) {
+    // Hex lines for tools/canlog_decode.py, which also accepts the raw file
+    char path[CAN_LOGGER_PATH_SIZE];
+    CAN_Logger_path(path, index);
+    File file = SPIFFS.open(path);
+    if (!file) {
+        return false;
+    }
+    Serial.printf("LOG BEGIN %s %lu\n", path, (unsigned long)file.size());
+    uint8_t chunk[32];
+    size_t n;
+    while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+        Serial.print(":");
+        for (size_t i = 0; i < n; i++) {
+            Serial.printf("%02X", chunk[i]);
+        }
+        Serial.println();
+    }
+    Serial.println("LOG END");
+    file.close();
+    return true;
+}
+
+void CAN_Logger_clear(CAN_Logger_t* logger) {
+    // Only while CAN_Logger_isIdle(), the next session starts again at file 0
+    for (uint16_t i = 0; i < CAN_LOGGER_MAX_FILES; i++) {
+        char path[CAN_LOGGER_PATH_SIZE];
+        CAN_Logger_path(path, i);
+        if (SPIFFS.exists(path)) {
+            SPIFFS.remove(path);
+        }
+    }
+    logger->fileIndex = 0;
+    logger->fileIndexValid = false;
+    logger->fileSize = 0;
+}
@@ -0,0 +1,44 @@
+#ifdef ARDUINO_ARCH_ESP32
+
+#include "CAN_MCP2515.h"
+
+static bool CAN_MCP2515_available(void* impl) {
+    return ((MCP_CAN*)impl)->checkReceive() == CAN_MSGAVAIL;
+}
+
+static bool CAN_MCP2515_read(void* impl, uint32_t* id, uint8_t* len, uint8_t* buf) {
+    unsigned long rxId;
+    if (((MCP_CAN*)impl)->readMsgBuf(&rxId, len, buf) != CAN_OK) {
+        return false;
+    }
+    *id = rxId;
+    return true;
+}
+
+static bool CAN_MCP2515_send(void* impl, uint32_t id, uint8_t len, const uint8_t* buf) {
+    return ((MCP_CAN*)impl)->sendMsgBuf(id, 0, len, (uint8_t*)buf) == CAN_OK;
+}
+
+static bool CAN_MCP2515_setAcceptance(void* impl, const CAN_Filter_Config_t* config) {
+    MCP_CAN* mcp = (MCP_CAN*)impl;
+    bool ok = true;
+
+    // Standard IDs live in the upper 16 bits, the lower half would match data bytes
+    for (int i = 0; i < CAN_FILTER_MASK_COUNT; i++) {
+        ok &= mcp->init_Mask(i, 0, (unsigned long)config->masks[i] << 16) == CAN_OK;
+    }
+    for (int i = 0; i < CAN_FILTER_SLOT_COUNT; i++) {
+        ok &= mcp->init_Filt(i, 0, (unsigned long)config->filters[i] << 16) == CAN_OK;
+    }
+    return ok;
+}
+
+void CAN_MCP2515_init(CAN_Interface_t* iface, MCP_CAN* mcp) {
+    iface->impl = mcp;
+    iface->available = CAN_MCP2515_available;
+    iface->read = CAN_MCP2515_read;
+    iface->send = CAN_MCP2515_send;
+    iface->setAcceptance = CAN_MCP2515_setAcceptance;
+}
+
+#endif // ARDUINO_ARCH_ESP32
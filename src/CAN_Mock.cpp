@@ -0,0 +1,172 @@
+#include "CAN_Mock.h"
+#include "CAN_Replay.h"
+#include <Arduino.h>
+#include <string.h>
+#include <stdlib.h>
+
+void CAN_Mock_init(CAN_Mock_t* mock) {
+    memset(mock, 0, sizeof(*mock));
+    mock->endOfFile = true;
+    mock->stepBudget = CAN_MOCK_FRAMES_PER_STEP;
+}
+
+bool CAN_Mock_open(CAN_Mock_t* mock, const char* path, bool loop, bool realTime) {
+    CAN_Mock_close(mock);
+    mock->file = fopen(path, "r");
+    if (mock->file == nullptr) {
+        return false;
+    }
+    mock->loop = loop;
+    mock->realTime = realTime;
+    mock->pendingValid = false;
+    mock->haveFirstTime = false;
+    mock->endOfFile = false;
+    mock->startMicros = micros();
+    return true;
+}
+
+void CAN_Mock_close(CAN_Mock_t* mock) {
+    if (mock->file != nullptr) {
+        fclose(mock->file);
+        mock->file = nullptr;
+    }
+    mock->pendingValid = false;
+    mock->endOfFile = true;
+}
+
+static bool CAN_Mock_readNext(CAN_Mock_t* mock) {
+    char line[CAN_MOCK_LINE_SIZE];
+    while (mock->file != nullptr) {
+        if (fgets(line, sizeof(line), mock->file) == nullptr) {
+            if (mock->loop) {
+                rewind(mock->file);
+                mock->haveFirstTime = false;
+                mock->startMicros = micros();
+                continue;
+            }
+            mock->endOfFile = true;
+            return false;
+        }
+
+        uint64_t timeUs = 0;
+        bool hasTime = false;
+        if (!CAN_Replay_parseCandump(line, &timeUs, &hasTime, &mock->pending)) {
+            continue;
+        }
+        if (hasTime) {
+            if (!mock->haveFirstTime) {
+                mock->firstTimeUs = timeUs;
+                mock->haveFirstTime = true;
+            }
+            mock->pendingTimeUs = timeUs - mock->firstTimeUs;
+        } else {
+            mock->pendingTimeUs = 0;
+        }
+        mock->pendingValid = true;
+        mock->framesRead++;
+        return true;
+    }
+    return false;
+}
+
+static bool CAN_Mock_available(void* impl) {
+    CAN_Mock_t* mock = (CAN_Mock_t*)impl;
+    if (mock->stepBudget == 0) {
+        return false;
+    }
+    if (mock->injectCount > 0) {
+        return true;
+    }
+
+    while (true) {
+        if (!mock->pendingValid && !CAN_Mock_readNext(mock)) {
+            return false;
+        }
+        if (mock->realTime && (uint64_t)(micros() - mock->startMicros) < mock->pendingTimeUs) {
+            return false;
+        }
+        if (!mock->acceptanceSet || CAN_Filter_accepts(&mock->acceptance, mock->pending.id)) {
+            return true;
+        }
+        mock->framesRejected++;
+        mock->pendingValid = false;
+    }
+}
+
+static bool CAN_Mock_read(void* impl, uint32_t* id, uint8_t* len, uint8_t* buf) {
+    CAN_Mock_t* mock = (CAN_Mock_t*)impl;
+    const CAN_Frame_t* frame;
+
+    if (mock->injectCount > 0) {
+        frame = &mock->injected[mock->injectHead];
+        mock->injectHead = (uint8_t)((mock->injectHead + 1) % CAN_MOCK_INJECT_QUEUE_SIZE);
+        mock->injectCount--;
+    } else if (mock->pendingValid) {
+        frame = &mock->pending;
+        mock->pendingValid = false;
+    } else {
+        return false;
+    }
+
+    if (mock->stepBudget > 0) {
+        mock->stepBudget--;
+    }
+    *id = frame->id;
+    *len = frame->len;
+    memcpy(buf, frame->buf, frame->len);
+    return true;
+}
+
+static bool CAN_Mock_send(void* impl, uint32_t id, uint8_t len, const uint8_t* buf) {
+    CAN_Mock_t* mock = (CAN_Mock_t*)impl;
+    mock->framesSent++;
+    for (int i = 0; i < mock->sendHookCount; i++) {
+        mock->sendHooks[i].hook(mock->sendHooks[i].ctx, id, len, buf);
+    }
+    return true;
+}
+
+static bool CAN_Mock_setAcceptance(void* impl, const CAN_Filter_Config_t* config) {
+    CAN_Mock_t* mock = (CAN_Mock_t*)impl;
+    mock->acceptance = *config;
+    mock->acceptanceSet = true;
+    return true;
+}
+
+bool CAN_Mock_inject(CAN_Mock_t* mock, uint32_t id, uint8_t len, const uint8_t* buf) {
+    if (mock->injectCount >= CAN_MOCK_INJECT_QUEUE_SIZE || len > 8) {
+        return false;
+    }
+    uint8_t tail = (uint8_t)((mock->injectHead + mock->injectCount) % CAN_MOCK_INJECT_QUEUE_SIZE);
+    mock->injected[tail].id = id;
+    mock->injected[tail].len = len;
+    memcpy(mock->injected[tail].buf, buf, len);
+    mock->injectCount++;
+    return true;
+}
+
+bool CAN_Mock_addSendHook(CAN_Mock_t* mock, CAN_Mock_SendHook_t hook, void* hookCtx) {
+    if (mock->sendHookCount >= CAN_MOCK_MAX_SEND_HOOKS) {
+        return false;
+    }
+    mock->sendHooks[mock->sendHookCount].hook = hook;
+    mock->sendHooks[mock->sendHookCount].ctx = hookCtx;
+    mock->sendHookCount++;
+    return true;
+}
+
+void CAN_Mock_beginStep(CAN_Mock_t* mock) {
+    mock->stepBudget = CAN_MOCK_FRAMES_PER_STEP;
+}
+
+bool CAN_Mock_isDrained(const CAN_Mock_t* mock) {
+    return mock->endOfFile && !mock->pendingValid && mock->injectCount == 0;
+}
+
+void CAN_Mock_initInterface(CAN_Interface_t* iface, CAN_Mock_t* mock) {
+    iface->impl = mock;
+    iface->available = CAN_Mock_available;
+    iface->read = CAN_Mock_read;
+    iface->send = CAN_Mock_send;
+    iface->setAcceptance = CAN_Mock_setAcceptance;
+}
@@ -1,50 +1,336 @@
 #include "CAN_Reader.h"
-#include "BMW_CAN.h"
-#include "Kawasaki_CAN.h"
+#include <Arduino.h>
+#ifdef ARDUINO_ARCH_ESP32
+#include <esp_timer.h>
+#endif
 
-void CAN_Reader_init(CAN_Reader_Context_t* ctx, VehicleType_t vehicleType, MCP_CAN* canInterface, bool* displayUpdated) {
+uint64_t CAN_Reader_timestampUs(void) {
+#ifdef ARDUINO_ARCH_ESP32
+    // 64-bit, micros() wraps after 71 minutes
+    return (uint64_t)esp_timer_get_time();
+#else
+    return micros();
+#endif
+}
+
+static void CAN_Reader_lock(CAN_Reader_Context_t* ctx) {
+#ifdef ARDUINO_ARCH_ESP32
+    if (ctx->busMutex != nullptr) {
+        xSemaphoreTake((SemaphoreHandle_t)ctx->busMutex, portMAX_DELAY);
+    }
+#endif
+}
+
+static void CAN_Reader_unlock(CAN_Reader_Context_t* ctx) {
+#ifdef ARDUINO_ARCH_ESP32
+    if (ctx->busMutex != nullptr) {
+        xSemaphoreGive((SemaphoreHandle_t)ctx->busMutex);
+    }
+#endif
+}
+
+static size_t CAN_Reader_appendIds(uint32_t* ids, size_t count, size_t maxIds, const CAN_Dispatch_Entry_t* entries, size_t entryCount) {
+    for (size_t i = 0; i < entryCount && count < maxIds; i++) {
+        ids[count++] = entries[i].id;
+    }
+    return count;
+}
+
+static void CAN_Reader_configureFilters(CAN_Reader_Context_t* ctx) {
+    uint32_t ids[CAN_DISPATCH_MAX_ENTRIES];
+    size_t count = 0;
+    size_t entryCount;
+    const CAN_Dispatch_Entry_t* entries;
+
+    // Auto-detection keeps admitting every vehicle, so a different one on the bus breaks the fingerprint
+    if (ctx->vehicleType == VEHICLE_BMW || ctx->vehicleType == VEHICLE_UNKNOWN) {
+        entries = BMW_getDispatchEntries(&entryCount);
+        count = CAN_Reader_appendIds(ids, count, CAN_DISPATCH_MAX_ENTRIES, entries, entryCount);
+    }
+    if (ctx->vehicleType == VEHICLE_KAWASAKI || ctx->vehicleType == VEHICLE_UNKNOWN) {
+        entries = Kawasaki_getDispatchEntries(&entryCount);
+        count = CAN_Reader_appendIds(ids, count, CAN_DISPATCH_MAX_ENTRIES, entries, entryCount);
+    }
+    CAN_Filter_Config_t config;
+    CAN_Filter_compute(ids, count, &config);
+
+    // CAN_Reader_setInterface() reads the configuration under the same lock
+    CAN_Reader_lock(ctx);
+    ctx->filterConfig = config;
+    ctx->canInterface->setAcceptance(ctx->canInterface->impl, &ctx->filterConfig);
+    CAN_Reader_unlock(ctx);
+}
+
+void CAN_Reader_init(CAN_Reader_Context_t* ctx, VehicleType_t vehicleType, CAN_Interface_t* canInterface, bool* displayUpdated) {
+    // Before the consumer runs, later switches go through CAN_Reader_requestVehicle()
     ctx->vehicleType = vehicleType;
     ctx->canInterface = canInterface;
     ctx->displayUpdated = displayUpdated;
+    ctx->requestedVehicle.store(CAN_READER_NO_REQUEST, std::memory_order_relaxed);
+    ctx->activeVehicle.store(vehicleType, std::memory_order_release);
+    ctx->dispatchValid = false;
+    ctx->fingerprintValid = false;
+    CAN_Reader_configureFilters(ctx);
+}
+
+void CAN_Reader_requestVehicle(CAN_Reader_Context_t* ctx, VehicleType_t vehicleType) {
+    // Any task: the decoders, the fingerprint and the filters belong to the consumer, which
+    // applies the newest request before its next batch. The receive path keeps running.
+    ctx->requestedVehicle.store(vehicleType, std::memory_order_release);
+}
+
+static void CAN_Reader_applyVehicle(CAN_Reader_Context_t* ctx, VehicleType_t vehicleType) {
+    ctx->vehicleType = vehicleType;
+    ctx->dispatchValid = false;
+    ctx->fingerprintValid = false;
+    CAN_Reader_configureFilters(ctx);
+}
+
+static void CAN_Reader_initFingerprint(CAN_Reader_Context_t* ctx) {
+    size_t count;
+    const Bus_Fingerprint_Id_t* ids;
+
+    Bus_Fingerprint_init(&ctx->fingerprint);
+    ids = BMW_getFingerprint(&count);
+    Bus_Fingerprint_addProfile(&ctx->fingerprint, "BMW", VEHICLE_BMW, ids, count);
+    ids = Kawasaki_getFingerprint(&count);
+    Bus_Fingerprint_addProfile(&ctx->fingerprint, "Kawasaki", VEHICLE_KAWASAKI, ids, count);
+    ctx->fingerprintValid = true;
+}
+
+static VehicleType_t CAN_Reader_decodedVehicle(const CAN_Reader_Context_t* ctx) {
+    // Consumer side: the configured vehicle, or the one auto-detection locked onto
+    if (ctx->vehicleType != VEHICLE_UNKNOWN) {
+        return ctx->vehicleType;
+    }
+    if (!ctx->fingerprintValid) {
+        return VEHICLE_UNKNOWN;
+    }
+    const Bus_Fingerprint_Profile_t* profile = Bus_Fingerprint_lockedProfile(&ctx->fingerprint);
+    return profile != nullptr ? (VehicleType_t)profile->vehicle : VEHICLE_UNKNOWN;
+}
+
+VehicleType_t CAN_Reader_activeVehicle(const CAN_Reader_Context_t* ctx) {
+    // The vehicle whose decoders run, VEHICLE_UNKNOWN while auto-detection has not locked.
+    // Safe from any task, a requested switch shows once the consumer applied it.
+    return (VehicleType_t)ctx->activeVehicle.load(std::memory_order_acquire);
+}
+
+static void CAN_Reader_buildDispatch(CAN_Reader_Context_t* ctx, void* bmw_ctx, Vehicle_State_t* state) {
+    CAN_Dispatch_clear(&ctx->dispatch);
+
+    // One vehicle's decoders at a time, an auto-detected bus gets none until the fingerprint locks
+    VehicleType_t vehicle = CAN_Reader_decodedVehicle(ctx);
+    bool useBMW = vehicle == VEHICLE_BMW;
+    bool useKawasaki = vehicle == VEHICLE_KAWASAKI;
+    if (useBMW && bmw_ctx != nullptr) {
+        BMW_registerDecoders(&ctx->dispatch, (BMW_CAN_Context_t*)bmw_ctx, CAN_READER_BMW_SIGNAL_SHIFT);
+    }
+    if (useKawasaki && state != nullptr) {
+        Kawasaki_registerDecoders(&ctx->dispatch, state, CAN_READER_KAWASAKI_SIGNAL_SHIFT);
+    }
+    ctx->dispatchValid = true;
+    ctx->activeVehicle.store(vehicle, std::memory_order_release);
+}
+
+void CAN_Reader_setInterface(CAN_Reader_Context_t* ctx, CAN_Interface_t* canInterface) {
+    // Swap the frame source (controller or log replay), the receive task only touches it under the lock
+    CAN_Reader_lock(ctx);
+    ctx->canInterface = canInterface;
+    canInterface->setAcceptance(canInterface->impl, &ctx->filterConfig);
+    CAN_Reader_unlock(ctx);
+}
+
+bool CAN_Reader_send(CAN_Reader_Context_t* ctx, uint32_t id, uint8_t len, const uint8_t* buf) {
+    // Shares the SPI bus with the receive task
+    CAN_Reader_lock(ctx);
+    bool ok = ctx->canInterface->send(ctx->canInterface->impl, id, len, buf);
+    CAN_Reader_unlock(ctx);
+    return ok;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+static void IRAM_ATTR CAN_Reader_onInterrupt(void* arg) {
+    CAN_Reader_Context_t* ctx = (CAN_Reader_Context_t*)arg;
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR((TaskHandle_t)ctx->rxTask, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void CAN_Reader_rxTask(void* arg) {
+    CAN_Reader_Context_t* ctx = (CAN_Reader_Context_t*)arg;
+    for (;;) {
+        // SPI cannot be used from the ISR, so it only wakes this task
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_RX_POLL_TIMEOUT_MS));
+        CAN_Reader_poll(ctx);
+    }
+}
+
+bool CAN_Reader_start(CAN_Reader_Context_t* ctx, uint8_t intPin) {
+    if (ctx->rxTask != nullptr) {
+        return true;
+    }
+
+    CAN_RingBuffer_init(&ctx->rxRing);
+    ctx->rxCount = 0;
+    ctx->rxUnmatched = 0;
+    ctx->trace = nullptr;
+    ctx->stats = nullptr;
+#if PERF_TRACE
+    ctx->perf = nullptr;
+#endif
+    ctx->frameTap = nullptr;
+    ctx->frameTapCtx = nullptr;
+    ctx->intPin = intPin;
+
+    ctx->busMutex = xSemaphoreCreateMutex();
+    if (ctx->busMutex == nullptr) {
+        return false;
+    }
+
+    TaskHandle_t task = nullptr;
+    if (xTaskCreatePinnedToCore(CAN_Reader_rxTask, "can_rx", CAN_RX_TASK_STACK_SIZE, ctx,
+                                CAN_RX_TASK_PRIORITY, &task, CAN_RX_TASK_CORE) != pdPASS) {
+        return false;
+    }
+    ctx->rxTask = task;
+
+    // MCP2515 INT is active low and stays low while a receive buffer is full
+    attachInterruptArg(digitalPinToInterrupt(intPin), CAN_Reader_onInterrupt, ctx, FALLING);
+    return true;
+}
+#else
+bool CAN_Reader_start(CAN_Reader_Context_t* ctx, uint8_t intPin) {
+    // No interrupts or tasks on the host, CAN_Reader_readMessages polls instead
+    CAN_RingBuffer_init(&ctx->rxRing);
+    ctx->rxCount = 0;
+    ctx->rxUnmatched = 0;
+    ctx->trace = nullptr;
+    ctx->stats = nullptr;
+#if PERF_TRACE
+    ctx->perf = nullptr;
+#endif
+    ctx->frameTap = nullptr;
+    ctx->frameTapCtx = nullptr;
+    ctx->intPin = intPin;
+    return false;
+}
+#endif
+
+void CAN_Reader_poll(CAN_Reader_Context_t* ctx) {
+    // Drain every pending frame so both MCP2515 receive buffers are free again
+    uint32_t queued = 0;
+    CAN_Reader_lock(ctx);
+    CAN_Interface_t* iface = ctx->canInterface;
+    while (iface->available(iface->impl)) {
+        CAN_Frame_t frame;
+        uint32_t rawId;
+        frame.len = 0;
+        if (!iface->read(iface->impl, &rawId, &frame.len, frame.buf)) {
+            break;
+        }
+        frame.timestamp = CAN_Reader_timestampUs();
+        frame.id = rawId & CAN_ID_MASK;
+        frame.flags = ((rawId & CAN_ID_EXTENDED_BIT) ? CAN_FRAME_FLAG_EXTENDED : 0) |
+                      ((rawId & CAN_ID_RTR_BIT) ? CAN_FRAME_FLAG_RTR : 0);
+        if (frame.len > 8) {
+            frame.len = 8;
+        }
+        ctx->rxCount++;
+        if (ctx->stats != nullptr) {
+            CAN_Stats_frame(ctx->stats, &frame);
+        }
+        if (CAN_RingBuffer_push(&ctx->rxRing, &frame)) {
+            queued++;
+        }
+    }
+    CAN_Reader_unlock(ctx);
+
+#ifdef ARDUINO_ARCH_ESP32
+    if (queued > 0 && ctx->consumerTask != nullptr) {
+        xTaskNotifyGive((TaskHandle_t)ctx->consumerTask);
+    }
+#endif
 }
 
-void CAN_Reader_readMessages(CAN_Reader_Context_t* ctx, void* bmw_ctx, void* kawasaki_data) {
-    if (ctx->canInterface->checkReceive() == CAN_MSGAVAIL) {
-        unsigned long rxId;
-        unsigned char len = 0;
-        unsigned char buf[8];
-        ctx->canInterface->readMsgBuf(&rxId, &len, buf);
-
-        Serial.printf("ID: 0x%03lX  LEN: %d  DATA:", rxId, len);
-        for (int i = 0; i < len; i++) {
-            Serial.printf(" %02X", buf[i]);
-        }
-        Serial.println();
-
-        // Parse CAN messages based on vehicle type
-        switch (ctx->vehicleType) {
-            case VEHICLE_BMW:
-                if (bmw_ctx != nullptr) {
-                    BMW_parseCANMessage(rxId, len, buf, (BMW_CAN_Context_t*)bmw_ctx, ctx->displayUpdated);
-                }
-                break;
-                
-            case VEHICLE_KAWASAKI:
-                if (kawasaki_data != nullptr) {
-                    Kawasaki_parseCANMessage(rxId, len, buf, (Kawasaki_CAN_Data_t*)kawasaki_data, ctx->displayUpdated);
-                }
-                break;
-                
-            case VEHICLE_UNKNOWN:
-            default:
-                // For unknown vehicle type, try both parsers
-                if (bmw_ctx != nullptr) {
-                    BMW_parseCANMessage(rxId, len, buf, (BMW_CAN_Context_t*)bmw_ctx, ctx->displayUpdated);
-                }
-                if (kawasaki_data != nullptr) {
-                    Kawasaki_parseCANMessage(rxId, len, buf, (Kawasaki_CAN_Data_t*)kawasaki_data, ctx->displayUpdated);
-                }
-                break;
+uint32_t CAN_Reader_readMessages(CAN_Reader_Context_t* ctx, void* bmw_ctx, Vehicle_State_t* state) {
+    // Without a receive task fall back to polling the controller from here
+    if (ctx->rxTask == nullptr) {
+        CAN_Reader_poll(ctx);
+    }
+
+    int requested = ctx->requestedVehicle.exchange(CAN_READER_NO_REQUEST, std::memory_order_acquire);
+    if (requested != CAN_READER_NO_REQUEST) {
+        CAN_Reader_applyVehicle(ctx, (VehicleType_t)requested);
+    }
+    if (!ctx->fingerprintValid) {
+        CAN_Reader_initFingerprint(ctx);
+    }
+    if (!ctx->dispatchValid) {
+        CAN_Reader_buildDispatch(ctx, bmw_ctx, state);
+    }
+    bool detecting = ctx->vehicleType == VEHICLE_UNKNOWN;
+
+    // Consume only what is queued now so a busy bus cannot starve the caller
+    uint32_t pending = CAN_RingBuffer_count(&ctx->rxRing);
+    uint32_t changed = 0;
+    size_t decoded = 0;
+    CAN_Frame_t batch[CAN_READER_BATCH_SIZE];
+    while (pending > 0) {
+        size_t count = 0;
+        while (count < CAN_READER_BATCH_SIZE && pending > 0 && CAN_RingBuffer_pop(&ctx->rxRing, &batch[count])) {
+            pending--;
+            count++;
         }
+        if (count == 0) {
+            break;
+        }
+
+        // Logger and trace see every frame, the decoders only the newest copy of each ID
+        for (size_t i = 0; i < count; i++) {
+            if (ctx->frameTap != nullptr) {
+                ctx->frameTap(ctx->frameTapCtx, &batch[i]);
+            }
+            if (ctx->trace != nullptr) {
+                CAN_Trace_frame(ctx->trace, &batch[i]);
+            }
+            if (detecting && Bus_Fingerprint_frame(&ctx->fingerprint, &batch[i])) {
+                ctx->dispatchValid = false;
+            }
+        }
+        // A lock or a broken fingerprint swaps the decoders, this batch already uses the new set
+        if (!ctx->dispatchValid) {
+            CAN_Reader_buildDispatch(ctx, bmw_ctx, state);
+        }
+        size_t matched = CAN_Dispatch_processBatch(&ctx->dispatch, batch, count, &changed);
+#if PERF_TRACE
+        if (ctx->perf != nullptr) {
+            PERF_DECODED(ctx->perf, batch, count, CAN_Reader_timestampUs());
+        }
+#endif
+        ctx->rxUnmatched += (uint32_t)(count - matched);
+        decoded += matched;
+    }
+
+    // Unchanged values were still refreshed, readers judge staleness by their timestamps
+    if (changed != 0 || decoded > 0) {
+        *ctx->displayUpdated = true;
+    }
+    return changed;
+}
+
+uint32_t CAN_Reader_getOverflowCount(const CAN_Reader_Context_t* ctx) {
+    return ctx->rxRing.overflowCount;
+}
+
+void CAN_Reader_resetStats(CAN_Reader_Context_t* ctx) {
+    // The receive task updates the table under the same lock
+    if (ctx->stats == nullptr) {
+        return;
     }
+    CAN_Reader_lock(ctx);
+    CAN_Stats_reset(ctx->stats);
+    CAN_Reader_unlock(ctx);
 }
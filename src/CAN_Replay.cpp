@@ -0,0 +1,384 @@
+#include "CAN_Replay.h"
+#include <Arduino.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+void CAN_Replay_init(CAN_Replay_t* replay) {
+    replay->file = File();
+    replay->format = CAN_REPLAY_FORMAT_CANDUMP;
+    replay->speed = 1.0f;
+    replay->active = false;
+    replay->finished = false;
+    replay->chunkLen = 0;
+    replay->chunkPos = 0;
+    replay->lastMicros = 0;
+    replay->playUs = 0;
+    replay->pendingValid = false;
+    replay->pendingTimeUs = 0;
+    replay->positionUs = 0;
+    replay->haveFirstTime = false;
+    replay->firstTimeUs = 0;
+    replay->ascDecimalIds = false;
+    replay->binaryTimeUs = 0;
+    replay->acceptanceSet = false;
+    replay->burst = 0;
+    replay->framesRead = 0;
+    replay->framesRejected = 0;
+    replay->parseErrors = 0;
+}
+
+// === STREAM READING ===
+static bool CAN_Replay_fill(CAN_Replay_t* replay) {
+    if (replay->chunkPos < replay->chunkLen) {
+        return true;
+    }
+    replay->chunkPos = 0;
+    replay->chunkLen = (uint16_t)replay->file.read(replay->chunk, sizeof(replay->chunk));
+    return replay->chunkLen > 0;
+}
+
+static bool CAN_Replay_readBytes(CAN_Replay_t* replay, uint8_t* dst, size_t count) {
+    while (count > 0) {
+        if (!CAN_Replay_fill(replay)) {
+            return false;
+        }
+        size_t n = replay->chunkLen - replay->chunkPos;
+        if (n > count) {
+            n = count;
+        }
+        memcpy(dst, &replay->chunk[replay->chunkPos], n);
+        replay->chunkPos += (uint16_t)n;
+        dst += n;
+        count -= n;
+    }
+    return true;
+}
+
+static bool CAN_Replay_readLine(CAN_Replay_t* replay, char* line, size_t size) {
+    size_t len = 0;
+    bool any = false;
+    while (CAN_Replay_fill(replay)) {
+        any = true;
+        char c = (char)replay->chunk[replay->chunkPos++];
+        if (c == '\n') {
+            break;
+        }
+        // Overlong lines are truncated, the parsers reject them
+        if (c != '\r' && len < size - 1) {
+            line[len++] = c;
+        }
+    }
+    line[len] = '\0';
+    return any;
+}
+
+bool CAN_Replay_open(CAN_Replay_t* replay, File file, float speed) {
+    CAN_Replay_close(replay);
+    CAN_Replay_init(replay);
+    if (!file) {
+        return false;
+    }
+    replay->file = file;
+    replay->speed = speed;
+
+    // Binary logs start with a magic, anything else is treated as text and sniffed per line
+    if (CAN_Replay_fill(replay) && replay->chunkLen >= CAN_REPLAY_BIN_HEADER_SIZE &&
+        memcmp(replay->chunk, CAN_REPLAY_BIN_MAGIC, 4) == 0) {
+        if (replay->chunk[4] != CAN_REPLAY_BIN_VERSION) {
+            replay->file.close();
+            return false;
+        }
+        replay->format = CAN_REPLAY_FORMAT_BINARY;
+        replay->chunkPos = CAN_REPLAY_BIN_HEADER_SIZE;
+    }
+
+    replay->lastMicros = micros();
+    replay->active = true;
+    return true;
+}
+
+void CAN_Replay_close(CAN_Replay_t* replay) {
+    if (replay->file) {
+        replay->file.close();
+    }
+    replay->active = false;
+    replay->pendingValid = false;
+}
+
+void CAN_Replay_setSpeed(CAN_Replay_t* replay, float speed) {
+    // Continue from the next frame instead of catching up on time spent unthrottled
+    replay->speed = speed;
+    replay->playUs = replay->pendingValid ? replay->pendingTimeUs : replay->positionUs;
+    replay->lastMicros = micros();
+}
+
+uint32_t CAN_Replay_positionMs(const CAN_Replay_t* replay) {
+    return (uint32_t)(replay->positionUs / 1000);
+}
+
+const char* CAN_Replay_formatName(CAN_Replay_Format_t format) {
+    switch (format) {
+        case CAN_REPLAY_FORMAT_CANDUMP: return "candump";
+        case CAN_REPLAY_FORMAT_ASC: return "asc";
+        case CAN_REPLAY_FORMAT_BINARY: return "binary";
+    }
+    return "?";
+}
+
+// === PARSERS ===
+static int CAN_Replay_hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static const char* CAN_Replay_skipSpaces(const char* p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+bool CAN_Replay_parseCandump(const char* line, uint64_t* timeUs, bool* hasTime, CAN_Frame_t* frame) {
+    const char* p = CAN_Replay_skipSpaces(line);
+    *hasTime = false;
+
+    if (*p == '\0' || *p == '\n' || *p == '#' || *p == ';') {
+        return false;
+    }
+
+    // Optional "(seconds.micros)" timestamp followed by an interface name
+    if (*p == '(') {
+        char* end;
+        unsigned long long seconds = strtoull(p + 1, &end, 10);
+        unsigned long long micro = 0;
+        if (*end == '.') {
+            const char* frac = end + 1;
+            int digits = 0;
+            while (*frac >= '0' && *frac <= '9' && digits < 6) {
+                micro = micro * 10 + (unsigned long long)(*frac - '0');
+                frac++;
+                digits++;
+            }
+            while (digits++ < 6) micro *= 10;
+        }
+        *timeUs = seconds * 1000000ULL + micro;
+        *hasTime = true;
+        p = strchr(p, ')');
+        if (p == nullptr) return false;
+        p = CAN_Replay_skipSpaces(p + 1);
+        const char* hash = strchr(p, '#');
+        const char* space = strchr(p, ' ');
+        if (space != nullptr && (hash == nullptr || space < hash)) {
+            p = CAN_Replay_skipSpaces(space + 1);
+        }
+    }
+
+    char* end;
+    unsigned long id = strtoul(p, &end, 16);
+    if (end == p || *end != '#') {
+        return false;
+    }
+    p = end + 1;
+
+    frame->id = (uint32_t)id;
+    frame->len = 0;
+    while (frame->len < 8) {
+        int hi = CAN_Replay_hexValue(p[0]);
+        int lo = hi < 0 ? -1 : CAN_Replay_hexValue(p[1]);
+        if (hi < 0 || lo < 0) {
+            break;
+        }
+        frame->buf[frame->len++] = (uint8_t)((hi << 4) | lo);
+        p += 2;
+    }
+    return true;
+}
+
+bool CAN_Replay_parseAsc(const char* line, bool decimalIds, uint64_t* timeUs, CAN_Frame_t* frame) {
+    // <time> <channel> <id>[x] Rx|Tx d <dlc> <bytes...>, other event lines are rejected
+    const char* p = CAN_Replay_skipSpaces(line);
+    char* end;
+    double seconds = strtod(p, &end);
+    if (end == p || seconds < 0.0) {
+        return false;
+    }
+    p = CAN_Replay_skipSpaces(end);
+    strtoul(p, &end, 10);
+    if (end == p) {
+        return false;
+    }
+    p = CAN_Replay_skipSpaces(end);
+    unsigned long id = strtoul(p, &end, decimalIds ? 10 : 16);
+    if (end == p) {
+        return false;
+    }
+    p = end;
+    if (*p == 'x' || *p == 'X') {
+        p++;
+    }
+    p = CAN_Replay_skipSpaces(p);
+    if (strncmp(p, "Rx", 2) != 0 && strncmp(p, "Tx", 2) != 0) {
+        return false;
+    }
+    p = CAN_Replay_skipSpaces(p + 2);
+    if (*p != 'd' && *p != 'D') {
+        return false;   // Remote frames carry no data
+    }
+    p = CAN_Replay_skipSpaces(p + 1);
+    unsigned long dlc = strtoul(p, &end, 16);
+    if (end == p || dlc > 8) {
+        return false;
+    }
+    p = end;
+
+    frame->id = (uint32_t)id;
+    frame->len = 0;
+    while (frame->len < dlc) {
+        p = CAN_Replay_skipSpaces(p);
+        int hi = CAN_Replay_hexValue(p[0]);
+        int lo = hi < 0 ? -1 : CAN_Replay_hexValue(p[1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        frame->buf[frame->len++] = (uint8_t)((hi << 4) | lo);
+        p += 2;
+    }
+    *timeUs = (uint64_t)(seconds * 1000000.0 + 0.5);
+    return true;
+}
+
+// === FRAME SOURCE ===
+static bool CAN_Replay_readBinary(CAN_Replay_t* replay, uint64_t* timeUs) {
+    uint8_t header[CAN_REPLAY_BIN_RECORD_HEADER];
+    if (!CAN_Replay_readBytes(replay, header, sizeof(header))) {
+        return false;
+    }
+    uint8_t len = header[6];
+    if (len > 8) {
+        replay->parseErrors++;
+        return false;   // Corrupt record, there is no way to resynchronise
+    }
+    // The stored time wraps, the step from the previous record never does
+    uint32_t wrapped = (uint32_t)header[0] | ((uint32_t)header[1] << 8) | ((uint32_t)header[2] << 16) | ((uint32_t)header[3] << 24);
+    replay->binaryTimeUs += (uint32_t)(wrapped - (uint32_t)replay->binaryTimeUs);
+    *timeUs = replay->binaryTimeUs;
+    replay->pending.id = (uint32_t)header[4] | ((uint32_t)header[5] << 8);
+    replay->pending.len = len;
+    return CAN_Replay_readBytes(replay, replay->pending.buf, len);
+}
+
+static bool CAN_Replay_readText(CAN_Replay_t* replay, uint64_t* timeUs) {
+    char line[CAN_REPLAY_LINE_SIZE];
+    while (CAN_Replay_readLine(replay, line, sizeof(line))) {
+        bool hasTime = false;
+        if (CAN_Replay_parseCandump(line, timeUs, &hasTime, &replay->pending)) {
+            replay->format = CAN_REPLAY_FORMAT_CANDUMP;
+            if (!hasTime) {
+                *timeUs = replay->haveFirstTime ? replay->firstTimeUs : 0;
+            }
+            return true;
+        }
+        if (CAN_Replay_parseAsc(line, replay->ascDecimalIds, timeUs, &replay->pending)) {
+            replay->format = CAN_REPLAY_FORMAT_ASC;
+            return true;
+        }
+
+        const char* p = CAN_Replay_skipSpaces(line);
+        if (strncmp(p, "base ", 5) == 0) {
+            replay->ascDecimalIds = strncmp(CAN_Replay_skipSpaces(p + 5), "dec", 3) == 0;
+        } else if (*p != '\0' && isdigit((unsigned char)*p)) {
+            replay->parseErrors++;   // Looked like a frame but did not parse (error frames, extended events)
+        }
+    }
+    return false;
+}
+
+static bool CAN_Replay_readNext(CAN_Replay_t* replay) {
+    uint64_t timeUs = 0;
+    bool ok = replay->format == CAN_REPLAY_FORMAT_BINARY ? CAN_Replay_readBinary(replay, &timeUs)
+                                                        : CAN_Replay_readText(replay, &timeUs);
+    if (!ok) {
+        replay->finished = true;
+        return false;
+    }
+
+    if (!replay->haveFirstTime) {
+        replay->firstTimeUs = timeUs;
+        replay->haveFirstTime = true;
+    }
+    replay->pendingTimeUs = timeUs >= replay->firstTimeUs ? timeUs - replay->firstTimeUs : 0;
+    replay->pendingValid = true;
+    replay->framesRead++;
+    return true;
+}
+
+static bool CAN_Replay_due(CAN_Replay_t* replay) {
+    if (replay->speed <= CAN_REPLAY_SPEED_MAX) {
+        return true;
+    }
+    unsigned long now = micros();
+    replay->playUs += (uint64_t)((float)(now - replay->lastMicros) * replay->speed);
+    replay->lastMicros = now;
+    return replay->playUs >= replay->pendingTimeUs;
+}
+
+static bool CAN_Replay_available(void* impl) {
+    CAN_Replay_t* replay = (CAN_Replay_t*)impl;
+
+    // Ending a burst makes the reader's drain loop return, the next poll starts a new one
+    if (!replay->active || replay->burst >= CAN_REPLAY_MAX_BURST) {
+        replay->burst = 0;
+        return false;
+    }
+
+    while (true) {
+        if (!replay->pendingValid && !CAN_Replay_readNext(replay)) {
+            replay->burst = 0;
+            return false;
+        }
+        if (!CAN_Replay_due(replay)) {
+            replay->burst = 0;
+            return false;
+        }
+        if (!replay->acceptanceSet || CAN_Filter_accepts(&replay->acceptance, replay->pending.id)) {
+            return true;
+        }
+        replay->framesRejected++;
+        replay->pendingValid = false;
+    }
+}
+
+static bool CAN_Replay_read(void* impl, uint32_t* id, uint8_t* len, uint8_t* buf) {
+    CAN_Replay_t* replay = (CAN_Replay_t*)impl;
+    if (!replay->pendingValid) {
+        return false;
+    }
+    replay->pendingValid = false;
+    replay->positionUs = replay->pendingTimeUs;
+    replay->burst++;
+    *id = replay->pending.id;
+    *len = replay->pending.len;
+    memcpy(buf, replay->pending.buf, replay->pending.len);
+    return true;
+}
+
+static bool CAN_Replay_send(void* impl, uint32_t id, uint8_t len, const uint8_t* buf) {
+    // A recording cannot answer requests
+    return false;
+}
+
+static bool CAN_Replay_setAcceptance(void* impl, const CAN_Filter_Config_t* config) {
+    CAN_Replay_t* replay = (CAN_Replay_t*)impl;
+    replay->acceptance = *config;
+    replay->acceptanceSet = true;
+    return true;
+}
+
+void CAN_Replay_initInterface(CAN_Interface_t* iface, CAN_Replay_t* replay) {
+    iface->impl = replay;
+    iface->available = CAN_Replay_available;
+    iface->read = CAN_Replay_read;
+    iface->send = CAN_Replay_send;
+    iface->setAcceptance = CAN_Replay_setAcceptance;
+}
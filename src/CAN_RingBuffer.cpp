@@ -0,0 +1,43 @@
+#include "CAN_RingBuffer.h"
+
+#define CAN_RING_BUFFER_MASK (CAN_RING_BUFFER_SIZE - 1)
+
+static_assert((CAN_RING_BUFFER_SIZE & CAN_RING_BUFFER_MASK) == 0, "CAN_RING_BUFFER_SIZE must be a power of two");
+
+void CAN_RingBuffer_init(CAN_RingBuffer_t* rb) {
+    rb->head.store(0, std::memory_order_relaxed);
+    rb->tail.store(0, std::memory_order_relaxed);
+    rb->overflowCount = 0;
+}
+
+bool CAN_RingBuffer_push(CAN_RingBuffer_t* rb, const CAN_Frame_t* frame) {
+    uint32_t head = rb->head.load(std::memory_order_relaxed);
+    uint32_t tail = rb->tail.load(std::memory_order_acquire);
+
+    // Full: drop the new frame and count it, never block the producer
+    if (head - tail >= CAN_RING_BUFFER_SIZE) {
+        rb->overflowCount++;
+        return false;
+    }
+
+    rb->frames[head & CAN_RING_BUFFER_MASK] = *frame;
+    rb->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool CAN_RingBuffer_pop(CAN_RingBuffer_t* rb, CAN_Frame_t* frame) {
+    uint32_t tail = rb->tail.load(std::memory_order_relaxed);
+    uint32_t head = rb->head.load(std::memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *frame = rb->frames[tail & CAN_RING_BUFFER_MASK];
+    rb->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t CAN_RingBuffer_count(const CAN_RingBuffer_t* rb) {
+    return rb->head.load(std::memory_order_acquire) - rb->tail.load(std::memory_order_acquire);
+}
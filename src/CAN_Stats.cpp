@@ -0,0 +1,205 @@
+#include "CAN_Stats.h"
+#include <Arduino.h>
+#include <string.h>
+
+// Bus bits in one load window
+static constexpr uint32_t CAN_STATS_WINDOW_BITS = (uint32_t)((uint64_t)CAN_STATS_BITRATE * CAN_STATS_LOAD_WINDOW_US / 1000000);
+
+void CAN_Stats_reset(CAN_Stats_t* stats) {
+    memset(stats->slotOf, CAN_STATS_NO_SLOT, sizeof(stats->slotOf));
+    stats->idCount = 0;
+    stats->frames = 0;
+    stats->untracked = 0;
+    stats->busBits = 0;
+    stats->startUs = 0;
+    stats->windowStartUs = 0;
+    stats->windowBits = 0;
+    stats->loadPermille = 0;
+    stats->peakLoadPermille = 0;
+}
+
+static inline uint32_t CAN_Stats_ewma(uint32_t average, uint32_t sample) {
+    // Unsigned both ways, a gap of minutes must not overflow
+    if (sample >= average) {
+        return average + ((sample - average) >> CAN_STATS_EWMA_SHIFT);
+    }
+    return average - ((average - sample) >> CAN_STATS_EWMA_SHIFT);
+}
+
+static void CAN_Stats_addLoad(CAN_Stats_t* stats, uint64_t nowUs, uint32_t bits) {
+    uint64_t elapsed = nowUs - stats->windowStartUs;
+    if (elapsed >= CAN_STATS_LOAD_WINDOW_US) {
+        // Windows that passed without a frame had no load, start over at this frame
+        bool adjacent = elapsed < 2 * CAN_STATS_LOAD_WINDOW_US;
+        stats->loadPermille = adjacent ? (uint16_t)((uint64_t)stats->windowBits * 1000 / CAN_STATS_WINDOW_BITS) : 0;
+        if (stats->loadPermille > stats->peakLoadPermille) {
+            stats->peakLoadPermille = stats->loadPermille;
+        }
+        stats->windowStartUs = adjacent ? stats->windowStartUs + CAN_STATS_LOAD_WINDOW_US : nowUs;
+        stats->windowBits = 0;
+    }
+    stats->windowBits += bits;
+}
+
+void CAN_Stats_frame(CAN_Stats_t* stats, const CAN_Frame_t* frame) {
+    uint64_t nowUs = frame->timestamp;
+    bool extended = (frame->flags & CAN_FRAME_FLAG_EXTENDED) != 0;
+    uint8_t dataLen = (frame->flags & CAN_FRAME_FLAG_RTR) ? 0 : frame->len;
+    uint32_t bits = extended ? CAN_FRAME_BUS_BITS_EXTENDED(dataLen) : CAN_FRAME_BUS_BITS(dataLen);
+
+    if (stats->frames == 0) {
+        stats->startUs = nowUs;
+        stats->windowStartUs = nowUs;
+    }
+    stats->frames++;
+    stats->busBits += bits;
+    CAN_Stats_addLoad(stats, nowUs, bits);
+
+    if (extended || frame->id >= 0x800) {
+        stats->untracked++;
+        return;
+    }
+
+    uint8_t slot = stats->slotOf[frame->id];
+    if (slot == CAN_STATS_NO_SLOT) {
+        if (stats->idCount >= CAN_STATS_MAX_IDS) {
+            stats->untracked++;
+            return;
+        }
+        slot = stats->idCount++;
+        stats->slotOf[frame->id] = slot;
+
+        CAN_Stats_Id_t* entry = &stats->ids[slot];
+        memset(entry, 0, sizeof(*entry));
+        entry->id = (uint16_t)frame->id;
+        entry->len = frame->len;
+        entry->count = 1;
+        entry->lastUs = (uint32_t)nowUs;
+        entry->minGapUs = UINT32_MAX;
+        return;
+    }
+
+    CAN_Stats_Id_t* entry = &stats->ids[slot];
+    uint32_t gap = (uint32_t)nowUs - entry->lastUs;
+    entry->lastUs = (uint32_t)nowUs;
+    if (frame->len != entry->len) {
+        entry->len = frame->len;
+        entry->dlcChanges++;
+    }
+    if (gap < entry->minGapUs) {
+        entry->minGapUs = gap;
+    }
+    if (gap > entry->maxGapUs) {
+        entry->maxGapUs = gap;
+    }
+
+    if (entry->count == 1) {
+        entry->avgGapUs = gap;
+    } else {
+        // The late check needs an average of at least two gaps
+        if (entry->count > 2 && gap / CAN_STATS_LATE_FACTOR > entry->avgGapUs) {
+            entry->late++;
+        }
+        uint32_t deviation = gap > entry->avgGapUs ? gap - entry->avgGapUs : entry->avgGapUs - gap;
+        entry->jitterUs = CAN_Stats_ewma(entry->jitterUs, deviation);
+        entry->avgGapUs = CAN_Stats_ewma(entry->avgGapUs, gap);
+    }
+    entry->count++;
+}
+
+const CAN_Stats_Id_t* CAN_Stats_find(const CAN_Stats_t* stats, uint32_t id) {
+    if (id >= 0x800 || stats->slotOf[id] == CAN_STATS_NO_SLOT) {
+        return nullptr;
+    }
+    return &stats->ids[stats->slotOf[id]];
+}
+
+uint32_t CAN_Stats_rateMilliHz(const CAN_Stats_Id_t* entry) {
+    // From the average gap, so the rate follows the recent traffic rather than the whole run
+    if (entry->count < 2 || entry->avgGapUs == 0) {
+        return 0;
+    }
+    return (uint32_t)(1000000000ull / entry->avgGapUs);
+}
+
+uint16_t CAN_Stats_loadPermille(const CAN_Stats_t* stats, uint64_t nowUs) {
+    // The window is only closed by the next frame, a silent bus has to be detected here
+    if (stats->frames == 0 || nowUs - stats->windowStartUs >= 2 * CAN_STATS_LOAD_WINDOW_US) {
+        return 0;
+    }
+    return stats->loadPermille;
+}
+
+static void CAN_Stats_printRow(const CAN_Stats_Id_t* entry) {
+    uint32_t rate = CAN_Stats_rateMilliHz(entry);
+    bool gaps = entry->count > 1;
+    Serial.printf("0x%03X %9lu %7lu.%lu %8.2f %8.2f %8.2f %7.2f %6lu %3u %5lu\n",
+                  (unsigned)entry->id, (unsigned long)entry->count,
+                  (unsigned long)(rate / 1000), (unsigned long)(rate % 1000 / 100),
+                  entry->avgGapUs / 1000.0f,
+                  gaps ? entry->minGapUs / 1000.0f : 0.0f,
+                  entry->maxGapUs / 1000.0f,
+                  entry->jitterUs / 1000.0f,
+                  (unsigned long)entry->late, (unsigned)entry->len,
+                  (unsigned long)entry->dlcChanges);
+}
+
+void CAN_Stats_print(const CAN_Stats_t* stats, uint64_t nowUs, uint8_t top) {
+    uint16_t load = CAN_Stats_loadPermille(stats, nowUs);
+    float seconds = stats->frames > 0 ? (nowUs - stats->startUs) / 1000000.0f : 0.0f;
+    Serial.printf("Frames: %lu in %.1f s, %u IDs, untracked: %lu\n",
+                  (unsigned long)stats->frames, seconds, (unsigned)stats->idCount,
+                  (unsigned long)stats->untracked);
+    Serial.printf("Bus load: %u.%u%% (peak %u.%u%%) of %lu kbit/s, worst-case stuffing, accepted frames only\n",
+                  load / 10, load % 10, stats->peakLoadPermille / 10, stats->peakLoadPermille % 10,
+                  (unsigned long)(CAN_STATS_BITRATE / 1000));
+    if (stats->idCount == 0) {
+        return;
+    }
+
+    // Busiest IDs first, the table is small enough for an insertion sort
+    uint8_t order[CAN_STATS_MAX_IDS];
+    uint8_t count = stats->idCount;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t j = i;
+        while (j > 0 && stats->ids[order[j - 1]].count < stats->ids[i].count) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    Serial.println("ID        count  rate/s   avg ms   min ms   max ms  jitter   late DLC  chg");
+    uint8_t shown = top < count ? top : count;
+    for (uint8_t i = 0; i < shown; i++) {
+        CAN_Stats_printRow(&stats->ids[order[i]]);
+    }
+    if (shown < count) {
+        Serial.printf("... %u more IDs, 'stats <id>' shows one\n", (unsigned)(count - shown));
+    }
+}
+
+bool CAN_Stats_printId(const CAN_Stats_t* stats, uint32_t id, uint64_t nowUs) {
+    const CAN_Stats_Id_t* entry = CAN_Stats_find(stats, id);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    uint32_t rate = CAN_Stats_rateMilliHz(entry);
+    uint32_t bits = CAN_FRAME_BUS_BITS(entry->len);
+    uint32_t share = (uint32_t)((uint64_t)rate * bits / CAN_STATS_BITRATE);  // Permille
+    Serial.printf("ID 0x%03X: %lu frames, %lu.%03lu/s, last %lu ms ago\n",
+                  (unsigned)entry->id, (unsigned long)entry->count,
+                  (unsigned long)(rate / 1000), (unsigned long)(rate % 1000),
+                  (unsigned long)(((uint32_t)nowUs - entry->lastUs) / 1000));
+    if (entry->count > 1) {
+        Serial.printf("Gap: avg %lu us, min %lu us, max %lu us, jitter %lu us, late %lu\n",
+                      (unsigned long)entry->avgGapUs, (unsigned long)entry->minGapUs,
+                      (unsigned long)entry->maxGapUs, (unsigned long)entry->jitterUs,
+                      (unsigned long)entry->late);
+    }
+    Serial.printf("DLC %u (%lu changes), %lu bits per frame, %lu.%lu%% of the bus\n",
+                  (unsigned)entry->len, (unsigned long)entry->dlcChanges, (unsigned long)bits,
+                  (unsigned long)(share / 10), (unsigned long)(share % 10));
+    return true;
+}
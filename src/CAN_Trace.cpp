@@ -0,0 +1,182 @@
+#include "CAN_Trace.h"
+#include <Arduino.h>
+#include <string.h>
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+void CAN_Trace_init(CAN_Trace_t* trace) {
+    trace->level = CAN_TRACE_DEFAULT_LEVEL;
+    trace->sampleEvery = CAN_TRACE_DEFAULT_SAMPLE;
+    trace->sampleCounter = 0;
+    memset(trace->idFilter, 0, sizeof(trace->idFilter));
+    trace->head.store(0, std::memory_order_relaxed);
+    trace->tail.store(0, std::memory_order_relaxed);
+    trace->framesSeen = 0;
+    trace->linesQueued = 0;
+    trace->linesDropped = 0;
+    trace->bytesSent = 0;
+}
+
+void CAN_Trace_setLevel(CAN_Trace_t* trace, CAN_Trace_Level_t level) {
+    trace->level = level;
+}
+
+void CAN_Trace_setSample(CAN_Trace_t* trace, uint16_t every) {
+    trace->sampleEvery = every > 0 ? every : 1;
+    trace->sampleCounter = 0;
+}
+
+void CAN_Trace_addId(CAN_Trace_t* trace, uint32_t id) {
+    if (id < 0x800) {
+        trace->idFilter[id >> 3] |= (uint8_t)(1u << (id & 7));
+    }
+}
+
+void CAN_Trace_clearIds(CAN_Trace_t* trace) {
+    memset(trace->idFilter, 0, sizeof(trace->idFilter));
+}
+
+bool CAN_Trace_hasId(const CAN_Trace_t* trace, uint32_t id) {
+    return id < 0x800 && (trace->idFilter[id >> 3] & (1u << (id & 7))) != 0;
+}
+
+static bool CAN_Trace_wanted(CAN_Trace_t* trace, uint32_t id) {
+    switch (trace->level) {
+        case CAN_TRACE_OFF:
+            return false;
+        case CAN_TRACE_SAMPLED:
+            if (++trace->sampleCounter < trace->sampleEvery) {
+                return false;
+            }
+            trace->sampleCounter = 0;
+            return true;
+        case CAN_TRACE_FILTERED:
+            return CAN_Trace_hasId(trace, id);
+        case CAN_TRACE_FULL:
+            return true;
+    }
+    return false;
+}
+
+static size_t CAN_Trace_format(char* line, const CAN_Frame_t* frame) {
+    // Same layout as the old Serial.printf dump, without the formatting engine
+    static const char PREFIX_ID[] = "ID: 0x";
+    static const char PREFIX_LEN[] = "  LEN: ";
+    static const char PREFIX_DATA[] = "  DATA:";
+    char* p = line;
+
+    memcpy(p, PREFIX_ID, sizeof(PREFIX_ID) - 1);
+    p += sizeof(PREFIX_ID) - 1;
+    *p++ = HEX_DIGITS[(frame->id >> 8) & 0x0F];
+    *p++ = HEX_DIGITS[(frame->id >> 4) & 0x0F];
+    *p++ = HEX_DIGITS[frame->id & 0x0F];
+
+    memcpy(p, PREFIX_LEN, sizeof(PREFIX_LEN) - 1);
+    p += sizeof(PREFIX_LEN) - 1;
+    *p++ = (char)('0' + (frame->len > 8 ? 8 : frame->len));
+
+    memcpy(p, PREFIX_DATA, sizeof(PREFIX_DATA) - 1);
+    p += sizeof(PREFIX_DATA) - 1;
+    for (uint8_t i = 0; i < frame->len && i < 8; i++) {
+        *p++ = ' ';
+        *p++ = HEX_DIGITS[frame->buf[i] >> 4];
+        *p++ = HEX_DIGITS[frame->buf[i] & 0x0F];
+    }
+    *p++ = '\r';
+    *p++ = '\n';
+    return (size_t)(p - line);
+}
+
+void CAN_Trace_frame(CAN_Trace_t* trace, const CAN_Frame_t* frame) {
+    trace->framesSeen++;
+    if (!CAN_Trace_wanted(trace, frame->id)) {
+        return;
+    }
+
+    char line[CAN_TRACE_LINE_SIZE];
+    size_t len = CAN_Trace_format(line, frame);
+
+    // Whole lines only, so a drop never leaves half a frame in the output
+    uint32_t head = trace->head.load(std::memory_order_relaxed);
+    uint32_t tail = trace->tail.load(std::memory_order_acquire);
+    if (CAN_TRACE_QUEUE_SIZE - (head - tail) < len) {
+        trace->linesDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        trace->queue[(head + i) & (CAN_TRACE_QUEUE_SIZE - 1)] = line[i];
+    }
+    trace->head.store(head + (uint32_t)len, std::memory_order_release);
+    trace->linesQueued++;
+}
+
+uint32_t CAN_Trace_drain(CAN_Trace_t* trace) {
+    uint32_t tail = trace->tail.load(std::memory_order_relaxed);
+    uint32_t head = trace->head.load(std::memory_order_acquire);
+    uint32_t pending = head - tail;
+    if (pending == 0) {
+        return 0;
+    }
+
+    // Only what the UART buffer takes without blocking, cut at a line end so console output stays readable
+    int room = Serial.availableForWrite();
+    if (room <= 0) {
+        return 0;
+    }
+    uint32_t count = pending < (uint32_t)room ? pending : (uint32_t)room;
+    while (count > 0 && trace->queue[(tail + count - 1) & (CAN_TRACE_QUEUE_SIZE - 1)] != '\n') {
+        count--;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // The ring may wrap once inside the span
+    uint32_t start = tail & (CAN_TRACE_QUEUE_SIZE - 1);
+    uint32_t first = CAN_TRACE_QUEUE_SIZE - start;
+    if (first > count) {
+        first = count;
+    }
+    Serial.write((const uint8_t*)&trace->queue[start], first);
+    if (count > first) {
+        Serial.write((const uint8_t*)trace->queue, count - first);
+    }
+
+    trace->tail.store(tail + count, std::memory_order_release);
+    trace->bytesSent += count;
+    return count;
+}
+
+const char* CAN_Trace_levelName(CAN_Trace_Level_t level) {
+    switch (level) {
+        case CAN_TRACE_OFF: return "off";
+        case CAN_TRACE_SAMPLED: return "sampled";
+        case CAN_TRACE_FILTERED: return "filtered";
+        case CAN_TRACE_FULL: return "full";
+    }
+    return "?";
+}
+
+void CAN_Trace_printStatus(const CAN_Trace_t* trace) {
+    Serial.printf("Trace level: %s", CAN_Trace_levelName(trace->level));
+    if (trace->level == CAN_TRACE_SAMPLED) {
+        Serial.printf(" (every %u frames)", (unsigned)trace->sampleEvery);
+    }
+    Serial.println();
+
+    Serial.print("Trace IDs:");
+    int ids = 0;
+    for (uint32_t id = 0; id < 0x800; id++) {
+        if (CAN_Trace_hasId(trace, id)) {
+            Serial.printf(" 0x%03lX", (unsigned long)id);
+            ids++;
+        }
+    }
+    Serial.println(ids == 0 ? " none" : "");
+
+    uint32_t queued = trace->head.load(std::memory_order_acquire) - trace->tail.load(std::memory_order_acquire);
+    Serial.printf("Frames seen: %lu  lines queued: %lu  dropped: %lu  bytes sent: %lu  pending: %lu\n",
+                  (unsigned long)trace->framesSeen, (unsigned long)trace->linesQueued,
+                  (unsigned long)trace->linesDropped.load(), (unsigned long)trace->bytesSent,
+                  (unsigned long)queued);
+}
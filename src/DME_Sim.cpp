@@ -0,0 +1,100 @@
+#ifndef ARDUINO_ARCH_ESP32
+
+#include "DME_Sim.h"
+#include "BMW_CAN.h"
+#include "Diag_Poller.h"
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+// Slowly varying engine values, raw in the encoding of the BMW_MS42_* signal tables
+static uint8_t DME_Sim_block(uint8_t localId, uint8_t* data) {
+    float t = millis() / 1000.0f;
+    float load = 0.5f + 0.5f * sinf(t * 0.7f);
+    uint16_t value;
+    switch (localId) {
+        case 0x01:  // Intake and outlet temperature, raw * 0.75 - 48
+            data[0] = (uint8_t)((35.0f + 8.0f * load + 48.0f) / 0.75f);
+            data[1] = (uint8_t)((82.0f + 4.0f * sinf(t * 0.05f) + 48.0f) / 0.75f);
+            return 2;
+        case 0x02:  // Fuel pressure in 0.1 kPa, lambda in 1/32768
+            value = (uint16_t)(3500 + 150 * load);
+            data[0] = (uint8_t)(value >> 8);
+            data[1] = (uint8_t)value;
+            value = (uint16_t)(32768.0f * (1.0f + 0.03f * sinf(t * 3.1f) - 0.1f * (load > 0.9f)));
+            data[2] = (uint8_t)(value >> 8);
+            data[3] = (uint8_t)value;
+            return 4;
+        case 0x03:  // Air mass in 0.1 kg/h
+            value = (uint16_t)(150 + 2500 * load);
+            data[0] = (uint8_t)(value >> 8);
+            data[1] = (uint8_t)value;
+            return 2;
+    }
+    return 0;
+}
+
+static void DME_Sim_onSend(void* hookCtx, uint32_t id, uint8_t len, const uint8_t* buf) {
+    DME_Sim_t* sim = (DME_Sim_t*)hookCtx;
+    if (id != BMW_DIAG_REQUEST_ID || len < 4 || buf[0] != BMW_DIAG_DME_ADDRESS) {
+        return;
+    }
+    sim->requests++;
+    if (sim->queueCount >= DME_SIM_QUEUE_SIZE || (int)random(100) < sim->dropPercent) {
+        sim->dropped++;
+        return;
+    }
+
+    uint8_t* response = sim->queue[sim->queueCount].buf;
+    response[0] = BMW_DIAG_TESTER_ADDRESS;
+    uint8_t dataLen = buf[2] == DIAG_KWP_READ_LOCAL_ID ? DME_Sim_block(buf[3], &response[4]) : 0;
+    if (dataLen > 0) {
+        response[1] = (uint8_t)(2 + dataLen);
+        response[2] = DIAG_KWP_POSITIVE_RESPONSE(DIAG_KWP_READ_LOCAL_ID);
+        response[3] = buf[3];
+    } else {
+        response[1] = 3;
+        response[2] = DIAG_KWP_NEGATIVE_RESPONSE;
+        response[3] = buf[2];
+        response[4] = 0x31;    // requestOutOfRange
+        dataLen = 1;
+    }
+    sim->queue[sim->queueCount].len = (uint8_t)(4 + dataLen);
+
+    // Requests are served in order, each one takes latency +- jitter
+    unsigned long now = millis();
+    unsigned long start = (long)(sim->busyUntilMs - now) > 0 ? sim->busyUntilMs : now;
+    long jitter = sim->jitterMs > 0 ? random(-(long)sim->jitterMs, (long)sim->jitterMs + 1) : 0;
+    long serviceMs = (long)sim->latencyMs + jitter;
+    sim->busyUntilMs = start + (serviceMs > 0 ? serviceMs : 0);
+    sim->queue[sim->queueCount].dueMs = sim->busyUntilMs;
+    sim->queueCount++;
+}
+
+void DME_Sim_init(DME_Sim_t* sim, CAN_Mock_t* mock, uint16_t latencyMs, uint16_t jitterMs, uint8_t dropPercent) {
+    sim->mock = mock;
+    sim->latencyMs = latencyMs;
+    sim->jitterMs = jitterMs;
+    sim->dropPercent = dropPercent;
+    sim->queueCount = 0;
+    sim->busyUntilMs = 0;
+    sim->requests = 0;
+    sim->responses = 0;
+    sim->dropped = 0;
+    CAN_Mock_addSendHook(mock, DME_Sim_onSend, sim);
+}
+
+void DME_Sim_step(DME_Sim_t* sim) {
+    // Due times are increasing, so only the head of the queue needs checking
+    unsigned long now = millis();
+    while (sim->queueCount > 0 && (long)(now - sim->queue[0].dueMs) >= 0) {
+        if (!CAN_Mock_inject(sim->mock, BMW_DIAG_DME_RESPONSE_ID, sim->queue[0].len, sim->queue[0].buf)) {
+            break;
+        }
+        sim->responses++;
+        sim->queueCount--;
+        memmove(&sim->queue[0], &sim->queue[1], sim->queueCount * sizeof(sim->queue[0]));
+    }
+}
+
+#endif // ARDUINO_ARCH_ESP32
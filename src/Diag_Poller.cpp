@@ -0,0 +1,236 @@
+#include "Diag_Poller.h"
+#include <Arduino.h>
+
+// Measurement blocks and the local identifiers the DME answers them under
+static const struct {
+    BMW_MS42_Block_t block;
+    uint8_t localId;
+    uint32_t signals;
+} DIAG_POLLER_BLOCKS[DIAG_POLLER_ITEM_COUNT] = {
+    {BMW_MS42_BLOCK_TEMP, 0x01, (1u << BMW_SIGNAL_INTAKE_TEMP) | (1u << BMW_SIGNAL_OUTLET_TEMP)},
+    {BMW_MS42_BLOCK_FUEL, 0x02, (1u << BMW_SIGNAL_FUEL_PRESSURE) | (1u << BMW_SIGNAL_LAMBDA)},
+    {BMW_MS42_BLOCK_AIR, 0x03, (1u << BMW_SIGNAL_MAF)},
+};
+
+static uint32_t Diag_Poller_onResponse(void* pollerCtx, ISOTP_Result_t result, const uint8_t* data, uint16_t len);
+
+bool Diag_Poller_init(Diag_Poller_t* poller, ISOTP_t* isotp, BMW_CAN_Context_t* bmw_ctx) {
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        Diag_Poller_Item_t* item = &poller->items[i];
+        item->block = DIAG_POLLER_BLOCKS[i].block;
+        item->localId = DIAG_POLLER_BLOCKS[i].localId;
+        item->signals = DIAG_POLLER_BLOCKS[i].signals;
+        item->inFlight = false;
+        item->sentUs = 0;
+        item->nextDueMs = 0;
+        item->periodMs = DIAG_POLLER_BACKGROUND_PERIOD_MS;
+        item->backoff = 0;
+        item->latencyAvgUs = 0;
+        item->requests = 0;
+        item->responses = 0;
+        item->timeouts = 0;
+        item->negatives = 0;
+    }
+    poller->isotp = isotp;
+    poller->bmw = bmw_ctx;
+    poller->enabled.store(true);
+    poller->visibleSignals.store(0);
+    poller->inFlight = 0;
+    poller->lastRequestMs = 0;
+    poller->sendErrors = 0;
+    poller->unexpected = 0;
+
+    poller->session = ISOTP_open(isotp, BMW_DIAG_REQUEST_ID, BMW_DIAG_DME_ADDRESS, BMW_DIAG_DME_RESPONSE_ID, BMW_DIAG_TESTER_ADDRESS,
+                                 poller->response, sizeof(poller->response), Diag_Poller_onResponse, poller);
+    return poller->session != nullptr;
+}
+
+void Diag_Poller_setEnabled(Diag_Poller_t* poller, bool enabled) {
+    poller->enabled.store(enabled);
+}
+
+void Diag_Poller_setVisibleSignals(Diag_Poller_t* poller, uint32_t signals) {
+    poller->visibleSignals.store(signals);
+}
+
+static bool Diag_Poller_isVisible(const Diag_Poller_t* poller, const Diag_Poller_Item_t* item) {
+    return (item->signals & poller->visibleSignals.load(std::memory_order_relaxed)) != 0;
+}
+
+static uint16_t Diag_Poller_period(const Diag_Poller_t* poller, const Diag_Poller_Item_t* item, uint8_t visibleCount) {
+    uint32_t period = Diag_Poller_isVisible(poller, item) ? DIAG_POLLER_VISIBLE_PERIOD_MS : DIAG_POLLER_BACKGROUND_PERIOD_MS;
+
+    // A slow DME answers at most MAX_IN_FLIGHT requests per latency, share that between the visible blocks
+    if (item->latencyAvgUs > 0) {
+        uint32_t floorMs = (item->latencyAvgUs * (visibleCount > 0 ? visibleCount : 1)) / (DIAG_POLLER_MAX_IN_FLIGHT * 1000u);
+        period = period > floorMs ? period : floorMs;
+    }
+    period <<= item->backoff;
+    return (uint16_t)(period < 0xFFFF ? period : 0xFFFF);
+}
+
+static unsigned long Diag_Poller_timeoutUs(const Diag_Poller_Item_t* item) {
+    // Until the first answer nothing is known about the DME, so wait as long as allowed
+    if (item->latencyAvgUs == 0) {
+        return DIAG_POLLER_MAX_TIMEOUT_MS * 1000ul;
+    }
+    unsigned long timeoutUs = (unsigned long)item->latencyAvgUs * DIAG_POLLER_TIMEOUT_FACTOR;
+    if (timeoutUs < DIAG_POLLER_MIN_TIMEOUT_MS * 1000ul) {
+        return DIAG_POLLER_MIN_TIMEOUT_MS * 1000ul;
+    }
+    return timeoutUs > DIAG_POLLER_MAX_TIMEOUT_MS * 1000ul ? DIAG_POLLER_MAX_TIMEOUT_MS * 1000ul : timeoutUs;
+}
+
+static void Diag_Poller_fail(Diag_Poller_t* poller, Diag_Poller_Item_t* item) {
+    item->inFlight = false;
+    poller->inFlight--;
+    if (item->backoff < DIAG_POLLER_MAX_BACKOFF) {
+        item->backoff++;
+    }
+}
+
+static bool Diag_Poller_send(Diag_Poller_t* poller, Diag_Poller_Item_t* item) {
+    uint8_t request[2] = {DIAG_KWP_READ_LOCAL_ID, item->localId};
+    return ISOTP_send(poller->isotp, poller->session, request, sizeof(request));
+}
+
+void Diag_Poller_step(Diag_Poller_t* poller) {
+    unsigned long nowUs = micros();
+    unsigned long nowMs = millis();
+
+    // Expire requests the DME did not answer
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        Diag_Poller_Item_t* item = &poller->items[i];
+        if (item->inFlight && nowUs - item->sentUs > Diag_Poller_timeoutUs(item)) {
+            item->timeouts++;
+            Diag_Poller_fail(poller, item);
+        }
+    }
+
+    if (poller->session == nullptr || !poller->enabled.load(std::memory_order_relaxed) || poller->inFlight >= DIAG_POLLER_MAX_IN_FLIGHT ||
+        nowMs - poller->lastRequestMs < DIAG_POLLER_MIN_GAP_MS) {
+        return;
+    }
+
+    // Most overdue block wins, blocks on the current screen always before background ones
+    uint8_t visibleCount = 0;
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        visibleCount += Diag_Poller_isVisible(poller, &poller->items[i]) ? 1 : 0;
+    }
+    Diag_Poller_Item_t* next = nullptr;
+    bool nextVisible = false;
+    long nextOverdue = 0;
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        Diag_Poller_Item_t* item = &poller->items[i];
+        item->periodMs = Diag_Poller_period(poller, item, visibleCount);
+        long overdue = (long)(nowMs - item->nextDueMs);
+        if (item->inFlight || overdue < 0) {
+            continue;
+        }
+        bool visible = Diag_Poller_isVisible(poller, item);
+        if (next == nullptr || (visible && !nextVisible) || (visible == nextVisible && overdue > nextOverdue)) {
+            next = item;
+            nextVisible = visible;
+            nextOverdue = overdue;
+        }
+    }
+    if (next == nullptr) {
+        return;
+    }
+
+    poller->lastRequestMs = nowMs;
+    next->nextDueMs = nowMs + next->periodMs;
+    if (!Diag_Poller_send(poller, next)) {
+        poller->sendErrors++;
+        if (next->backoff < DIAG_POLLER_MAX_BACKOFF) {
+            next->backoff++;
+        }
+        return;
+    }
+    next->requests++;
+    next->inFlight = true;
+    next->sentUs = nowUs;
+    poller->inFlight++;
+}
+
+static Diag_Poller_Item_t* Diag_Poller_findItem(Diag_Poller_t* poller, uint8_t localId) {
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        if (poller->items[i].localId == localId) {
+            return &poller->items[i];
+        }
+    }
+    return nullptr;
+}
+
+static Diag_Poller_Item_t* Diag_Poller_oldestInFlight(Diag_Poller_t* poller) {
+    Diag_Poller_Item_t* oldest = nullptr;
+    unsigned long nowUs = micros();
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        Diag_Poller_Item_t* item = &poller->items[i];
+        if (item->inFlight && (oldest == nullptr || nowUs - item->sentUs > nowUs - oldest->sentUs)) {
+            oldest = item;
+        }
+    }
+    return oldest;
+}
+
+static uint32_t Diag_Poller_onResponse(void* pollerCtx, ISOTP_Result_t result, const uint8_t* data, uint16_t len) {
+    // Transport errors surface as timeouts of the request
+    Diag_Poller_t* poller = (Diag_Poller_t*)pollerCtx;
+    if (result != ISOTP_RESULT_RECEIVED) {
+        return 0;
+    }
+    if (len < 2) {
+        poller->unexpected++;
+        return 0;
+    }
+
+    // Negative responses carry the service but not the local id, blame the oldest request
+    uint8_t sid = data[0];
+    if (sid == DIAG_KWP_NEGATIVE_RESPONSE) {
+        Diag_Poller_Item_t* item = Diag_Poller_oldestInFlight(poller);
+        if (item == nullptr) {
+            poller->unexpected++;
+            return 0;
+        }
+        item->negatives++;
+        Diag_Poller_fail(poller, item);
+        return 0;
+    }
+
+    Diag_Poller_Item_t* item = sid == DIAG_KWP_POSITIVE_RESPONSE(DIAG_KWP_READ_LOCAL_ID) ? Diag_Poller_findItem(poller, data[1]) : nullptr;
+    if (item == nullptr) {
+        poller->unexpected++;
+        return 0;
+    }
+    // Late answers still count towards the latency, so the timeout grows with a slow DME
+    uint32_t latencyUs = (uint32_t)(micros() - item->sentUs);
+    item->latencyAvgUs = item->latencyAvgUs == 0 ? latencyUs : item->latencyAvgUs - item->latencyAvgUs / 8 + latencyUs / 8;
+    if (item->inFlight) {
+        item->inFlight = false;
+        item->backoff = 0;
+        item->responses++;
+        poller->inFlight--;
+    } else {
+        poller->unexpected++;   // Answered after the timeout, the values are still good
+    }
+
+    uint32_t changed = 0;
+    BMW_decodeMS42Block(item->block, (uint8_t)(len - 2), &data[2], poller->bmw, &changed);
+    return changed;
+}
+
+void Diag_Poller_printStatus(const Diag_Poller_t* poller) {
+    static const char* const BLOCK_NAMES[] = {"temp", "fuel", "air"};
+    Serial.printf("Diagnostic polling: %s, %u in flight, %lu send errors, %lu unexpected responses\n",
+                  poller->enabled.load() ? "on" : "off", poller->inFlight,
+                  (unsigned long)poller->sendErrors, (unsigned long)poller->unexpected);
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        const Diag_Poller_Item_t* item = &poller->items[i];
+        Serial.printf("  %-5s LID 0x%02X %-10s every %5u ms  latency %5lu us  req %lu  resp %lu  timeout %lu  neg %lu\n",
+                      BLOCK_NAMES[item->block], item->localId,
+                      Diag_Poller_isVisible(poller, item) ? "visible" : "background", item->periodMs,
+                      (unsigned long)item->latencyAvgUs, (unsigned long)item->requests, (unsigned long)item->responses,
+                      (unsigned long)item->timeouts, (unsigned long)item->negatives);
+    }
+}
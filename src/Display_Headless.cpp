@@ -0,0 +1,38 @@
+#ifndef ARDUINO_ARCH_ESP32
+
+#include "Display_Headless.h"
+#include <stdio.h>
+
+U8G2_SH1106_128X64_HEADLESS_F::U8G2_SH1106_128X64_HEADLESS_F(const u8g2_cb_t* rotation) : U8G2() {
+    // Same controller and buffer layout as the device, bytes to the panel are discarded
+    u8g2_Setup_sh1106_128x64_noname_f(&u8g2, rotation, u8x8_byte_empty, u8x8_dummy_cb);
+}
+
+bool Display_Headless_writePNM(U8G2* display, const char* path) {
+    const uint8_t* buffer = display->getBufferPtr();
+    int width = display->getBufferTileWidth() * 8;
+    int height = display->getBufferTileHeight() * 8;
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    // P4 bitmap, lit OLED pixels are written white (0) on black (1)
+    fprintf(file, "P4\n%d %d\n", width, height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* tileRow = buffer + (y / 8) * width;
+        uint8_t out = 0;
+        for (int x = 0; x < width; x++) {
+            bool lit = (tileRow[x] >> (y & 7)) & 0x01;
+            out = (uint8_t)((out << 1) | (lit ? 0 : 1));
+            if ((x & 7) == 7) {
+                fputc(out, file);
+                out = 0;
+            }
+        }
+    }
+    return fclose(file) == 0;
+}
+
+#endif // ARDUINO_ARCH_ESP32
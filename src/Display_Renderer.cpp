@@ -0,0 +1,124 @@
+#include "Display_Renderer.h"
+#include <Arduino.h>
+
+void Display_Renderer_init(Display_Renderer_Context_t* ctx, U8G2* display, uint16_t minFrameInterval) {
+    ctx->display = display;
+    ctx->minFrameInterval = minFrameInterval;
+    ctx->lastFlush = 0;
+    Display_Renderer_invalidate(ctx);
+    Display_Renderer_resetStats(ctx);
+}
+
+void Display_Renderer_invalidate(Display_Renderer_Context_t* ctx) {
+    // Someone else drew on the panel (e.g. the intro), next frame is sent in full
+    ctx->shadowValid = false;
+    ctx->lastScreen = -1;
+}
+
+static uint32_t Display_Renderer_flushChanged(Display_Renderer_Context_t* ctx) {
+    U8G2* display = ctx->display;
+    uint8_t* buffer = display->getBufferPtr();
+    const uint8_t tileWidth = display->getBufferTileWidth();
+    const uint8_t tileHeight = display->getBufferTileHeight();
+    const uint32_t rowBytes = (uint32_t)tileWidth * DISPLAY_RENDERER_TILE_BYTES;
+
+    if (!ctx->shadowValid) {
+        display->sendBuffer();
+        memcpy(ctx->shadow, buffer, DISPLAY_RENDERER_BUFFER_SIZE);
+        ctx->shadowValid = true;
+        return (uint32_t)tileWidth * tileHeight;
+    }
+
+    // Send one span per tile row, from the first to the last changed tile
+    uint32_t tilesSent = 0;
+    for (uint8_t ty = 0; ty < tileHeight; ty++) {
+        const uint8_t* row = buffer + ty * rowBytes;
+        uint8_t* shadowRow = ctx->shadow + ty * rowBytes;
+        int first = -1;
+        int last = -1;
+        for (uint8_t tx = 0; tx < tileWidth; tx++) {
+            uint32_t offset = (uint32_t)tx * DISPLAY_RENDERER_TILE_BYTES;
+            if (memcmp(row + offset, shadowRow + offset, DISPLAY_RENDERER_TILE_BYTES) != 0) {
+                if (first < 0) {
+                    first = tx;
+                }
+                last = tx;
+            }
+        }
+        if (first >= 0) {
+            uint8_t span = (uint8_t)(last - first + 1);
+            display->updateDisplayArea((uint8_t)first, ty, span, 1);
+            memcpy(shadowRow + first * DISPLAY_RENDERER_TILE_BYTES, row + first * DISPLAY_RENDERER_TILE_BYTES,
+                   (size_t)span * DISPLAY_RENDERER_TILE_BYTES);
+            tilesSent += span;
+        }
+    }
+    return tilesSent;
+}
+
+uint32_t Display_Renderer_present(Display_Renderer_Context_t* ctx) {
+    // Push a frame buffer filled by someone else (e.g. the intro), screens are redrawn in full afterwards
+    uint32_t tilesSent = Display_Renderer_flushChanged(ctx);
+    ctx->lastScreen = -1;
+    ctx->lastFlush = millis();
+    return tilesSent;
+}
+
+bool Display_Renderer_update(Display_Renderer_Context_t* ctx, int screen, uint32_t stateKey, Display_DrawFunction_t draw) {
+    Display_ScreenStats_t* stats = (screen >= 0 && screen < DISPLAY_RENDERER_MAX_SCREENS) ? &ctx->stats[screen] : nullptr;
+    bool forced = (screen != ctx->lastScreen) || !ctx->shadowValid;
+
+    if (!forced && stateKey == ctx->lastKey) {
+        if (stats) stats->framesSkipped++;
+        return false;
+    }
+
+    // The key is only stored once drawn, so a deferred change is picked up next call
+    unsigned long now = millis();
+    if (!forced && now - ctx->lastFlush < ctx->minFrameInterval) {
+        if (stats) stats->framesDeferred++;
+        return false;
+    }
+
+    // What is drawn reaches the panel one draw and flush later, screens may compensate for it.
+    // The buffer is kept between frames of a screen, anything else drawn on the panel forces a full frame.
+    unsigned long start = micros();
+    draw(forced);
+    uint32_t tilesSent = Display_Renderer_flushChanged(ctx);
+    ctx->lastLatencyUs = (uint32_t)(micros() - start);
+    if (ctx->latencyUs == 0) {
+        ctx->latencyUs = ctx->lastLatencyUs;
+    } else if (ctx->lastLatencyUs >= ctx->latencyUs) {
+        ctx->latencyUs += (ctx->lastLatencyUs - ctx->latencyUs) >> DISPLAY_RENDERER_LATENCY_SHIFT;
+    } else {
+        ctx->latencyUs -= (ctx->latencyUs - ctx->lastLatencyUs) >> DISPLAY_RENDERER_LATENCY_SHIFT;
+    }
+
+    ctx->lastScreen = screen;
+    ctx->lastKey = stateKey;
+    ctx->lastFlush = now;
+    if (stats) {
+        stats->framesRendered++;
+        stats->tilesSent += tilesSent;
+    }
+    return true;
+}
+
+void Display_Renderer_printStats(const Display_Renderer_Context_t* ctx, const char* const* screenNames, int screenCount) {
+    Serial.println("Screen                    rendered   skipped  deferred  tiles  tiles/frame");
+    for (int i = 0; i < screenCount && i < DISPLAY_RENDERER_MAX_SCREENS; i++) {
+        const Display_ScreenStats_t* stats = &ctx->stats[i];
+        unsigned long perFrame = stats->framesRendered ? stats->tilesSent / stats->framesRendered : 0;
+        Serial.printf("%-24s %9lu %9lu %9lu %6lu %12lu\n", screenNames[i],
+                      (unsigned long)stats->framesRendered, (unsigned long)stats->framesSkipped,
+                      (unsigned long)stats->framesDeferred, (unsigned long)stats->tilesSent, perFrame);
+    }
+    Serial.printf("Draw and flush latency: %lu us average, %lu us last frame\n",
+                  (unsigned long)ctx->latencyUs, (unsigned long)ctx->lastLatencyUs);
+}
+
+void Display_Renderer_resetStats(Display_Renderer_Context_t* ctx) {
+    memset(ctx->stats, 0, sizeof(ctx->stats));
+    ctx->latencyUs = 0;
+    ctx->lastLatencyUs = 0;
+}
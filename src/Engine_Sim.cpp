@@ -0,0 +1,524 @@
+#include "Engine_Sim.h"
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include "Diag_Poller.h"
+
+static_assert(ENGINE_SIM_DIAG_QUEUE_SIZE >= DIAG_POLLER_MAX_IN_FLIGHT, "The simulated DME must hold every request in flight");
+
+// === MODEL CONSTANTS ===
+// Roughly an E46 328i (M52TU, 5-speed manual)
+static constexpr float ENGINE_SIM_GEAR_RATIOS[ENGINE_SIM_GEAR_COUNT] = {4.23f, 2.52f, 1.66f, 1.22f, 1.00f};
+static constexpr float ENGINE_SIM_FINAL_DRIVE = 3.46f;
+static constexpr float ENGINE_SIM_WHEEL_RADIUS = 0.31f;     // m
+static constexpr float ENGINE_SIM_MASS = 1450.0f;           // kg, with driver
+static constexpr float ENGINE_SIM_DRAG = 0.40f;             // 0.5 * air density * Cd * frontal area
+static constexpr float ENGINE_SIM_ROLLING = 210.0f;         // N
+static constexpr float ENGINE_SIM_BRAKE_FORCE = 5000.0f;    // N, a firm stop
+static constexpr float ENGINE_SIM_DRIVELINE_EFFICIENCY = 0.9f;
+static constexpr float ENGINE_SIM_INERTIA = 0.25f;          // kg m^2, engine and flywheel
+static constexpr float ENGINE_SIM_PEAK_TORQUE = 280.0f;     // Nm at 3500-4500 rpm
+static constexpr float ENGINE_SIM_DISPLACEMENT = 2.793e-3f; // m^3
+static constexpr float ENGINE_SIM_IDLE_RPM = 800.0f;
+static constexpr float ENGINE_SIM_LIMITER_RPM = 6800.0f;
+static constexpr float ENGINE_SIM_DOWNSHIFT_RPM = 1300.0f;
+static constexpr float ENGINE_SIM_THERMOSTAT = 88.0f;       // degC, fully open 8 degC above
+static constexpr uint16_t ENGINE_SIM_SHIFT_MS = 250;
+static constexpr uint16_t ENGINE_SIM_CRANK_MS = 800;
+
+// Filler traffic: PT-CAN frames of ABS/DSC, steering angle, gearbox and cluster that nothing decodes
+static constexpr uint16_t ENGINE_SIM_FILLER_IDS[] = {0x153, 0x1F0, 0x1F3, 0x1F5, 0x1F8, 0x43F, 0x613, 0x615};
+static constexpr size_t ENGINE_SIM_FILLER_COUNT = sizeof(ENGINE_SIM_FILLER_IDS) / sizeof(ENGINE_SIM_FILLER_IDS[0]);
+
+static constexpr uint32_t ENGINE_SIM_FRAME_US = (uint32_t)((uint64_t)ENGINE_SIM_FRAME_BITS * 1000000 / ENGINE_SIM_BITRATE);
+
+// === RANDOM NUMBERS ===
+static uint32_t Engine_Sim_random(Engine_Sim_t* sim) {
+    // xorshift32, the whole run follows from the seed
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+static float Engine_Sim_uniform(Engine_Sim_t* sim, float lo, float hi) {
+    return lo + (hi - lo) * (float)(Engine_Sim_random(sim) >> 8) / 16777216.0f;
+}
+
+static float Engine_Sim_approach(float value, float target, float dt, float tau) {
+    // First order lag with time constant tau
+    return value + (target - value) * (dt / (tau + dt));
+}
+
+static float Engine_Sim_clamp(float value, float lo, float hi) {
+    return value < lo ? lo : (value > hi ? hi : value);
+}
+
+void Engine_Sim_init(Engine_Sim_t* sim, uint32_t seed) {
+    memset(sim, 0, sizeof(*sim));
+    sim->seed = seed;
+    sim->rng = seed != 0 ? seed : 0x9E3779B9u;   // xorshift must not start at zero
+    sim->emitBMW = true;
+
+    // Cold start on a seeded day
+    sim->ambient = Engine_Sim_uniform(sim, 5.0f, 30.0f);
+    sim->coolant = sim->ambient;
+    sim->oil = sim->ambient;
+    sim->intake = sim->ambient;
+    sim->outlet = sim->ambient;
+    sim->gear = 1;
+    sim->rpm = ENGINE_SIM_IDLE_RPM;
+    sim->drive = ENGINE_SIM_DRIVE_IDLE;
+    sim->driveLeftMs = (uint32_t)Engine_Sim_uniform(sim, 2000.0f, 5000.0f);
+    sim->manifoldHpa = 1013.0f;
+
+    sim->nextTickUs = 0;
+    sim->nextKawasakiUs = 0;
+    sim->bmw[BMW_SIGNAL_IGNITION] = 1;
+}
+
+static void Engine_Sim_updateFiller(Engine_Sim_t* sim) {
+    // Filler makes up what the simulated ECUs leave of the target load
+    uint32_t targetFps = (uint32_t)sim->busLoadPercent * (ENGINE_SIM_BITRATE / ENGINE_SIM_FRAME_BITS) / 100;
+    uint32_t ownFps = (sim->emitBMW ? 3 * (1000000 / ENGINE_SIM_TICK_US) : 0) +
+                      (sim->emitKawasaki ? 1000000 / ENGINE_SIM_KAWASAKI_PERIOD_US : 0);
+    if (targetFps <= ownFps) {
+        sim->fillerIntervalUs = 0;
+        return;
+    }
+    uint32_t fillerFps = targetFps - ownFps;
+    sim->fillerIntervalUs = (1000000 + fillerFps - 1) / fillerFps;
+    sim->nextFillerUs = sim->simUs + sim->fillerIntervalUs;
+}
+
+void Engine_Sim_setVehicles(Engine_Sim_t* sim, bool bmw, bool kawasaki) {
+    // A frame switched back on starts from now instead of catching up
+    if (kawasaki && !sim->emitKawasaki && sim->nextKawasakiUs < sim->simUs) {
+        sim->nextKawasakiUs = sim->simUs;
+    }
+    sim->emitBMW = bmw;
+    sim->emitKawasaki = kawasaki;
+    Engine_Sim_updateFiller(sim);
+}
+
+void Engine_Sim_setBusLoad(Engine_Sim_t* sim, uint8_t percent, bool unfiltered) {
+    sim->busLoadPercent = percent > 100 ? 100 : percent;
+    sim->fillerUnfiltered = unfiltered;
+    Engine_Sim_updateFiller(sim);
+}
+
+// === DRIVER ===
+static void Engine_Sim_nextDrive(Engine_Sim_t* sim) {
+    uint32_t pick = Engine_Sim_random(sim) % 100;
+    if (sim->speed < 1.0f) {
+        // Standing: pull away most of the time
+        sim->drive = pick < 75 ? ENGINE_SIM_DRIVE_ACCELERATE : ENGINE_SIM_DRIVE_IDLE;
+    } else if (pick < 35) {
+        sim->drive = ENGINE_SIM_DRIVE_CRUISE;
+    } else if (pick < 60) {
+        sim->drive = ENGINE_SIM_DRIVE_ACCELERATE;
+    } else if (pick < 80) {
+        sim->drive = ENGINE_SIM_DRIVE_COAST;
+    } else {
+        sim->drive = ENGINE_SIM_DRIVE_BRAKE;
+    }
+
+    switch (sim->drive) {
+        case ENGINE_SIM_DRIVE_IDLE:
+            sim->throttleTarget = 0.0f;
+            sim->driveLeftMs = (uint32_t)Engine_Sim_uniform(sim, 2000.0f, 6000.0f);
+            break;
+        case ENGINE_SIM_DRIVE_CRUISE:
+            sim->throttleTarget = Engine_Sim_uniform(sim, 0.12f, 0.30f);
+            sim->shiftRpm = (uint16_t)Engine_Sim_uniform(sim, 2200.0f, 2800.0f);
+            sim->driveLeftMs = (uint32_t)Engine_Sim_uniform(sim, 3000.0f, 10000.0f);
+            break;
+        case ENGINE_SIM_DRIVE_ACCELERATE:
+            // Every third pull is flat out to the shift light
+            sim->throttleTarget = Engine_Sim_random(sim) % 3 == 0 ? 1.0f : Engine_Sim_uniform(sim, 0.45f, 0.9f);
+            sim->shiftRpm = (uint16_t)Engine_Sim_clamp(2000.0f + 4600.0f * sim->throttleTarget + Engine_Sim_uniform(sim, -200.0f, 200.0f),
+                                                       2200.0f, 6600.0f);
+            sim->driveLeftMs = (uint32_t)Engine_Sim_uniform(sim, 2000.0f, 8000.0f);
+            break;
+        case ENGINE_SIM_DRIVE_COAST:
+            sim->throttleTarget = 0.0f;
+            sim->driveLeftMs = (uint32_t)Engine_Sim_uniform(sim, 1500.0f, 5000.0f);
+            break;
+        case ENGINE_SIM_DRIVE_BRAKE:
+            sim->throttleTarget = 0.0f;
+            sim->driveLeftMs = (uint32_t)Engine_Sim_uniform(sim, 1000.0f, 6000.0f);
+            break;
+    }
+}
+
+// === PHYSICS ===
+static float Engine_Sim_wheelRpmFactor(uint8_t gear) {
+    // Engine rpm per m/s of road speed in a gear
+    return ENGINE_SIM_GEAR_RATIOS[gear - 1] * ENGINE_SIM_FINAL_DRIVE * 60.0f / (2.0f * (float)M_PI * ENGINE_SIM_WHEEL_RADIUS);
+}
+
+static float Engine_Sim_fullLoadTorque(float rpm) {
+    // Flat-topped curve peaking around 4000 rpm
+    float x = (rpm - 4000.0f) / 3500.0f;
+    return ENGINE_SIM_PEAK_TORQUE * Engine_Sim_clamp(1.0f - 0.35f * x * x, 0.4f, 1.0f);
+}
+
+static void Engine_Sim_step(Engine_Sim_t* sim) {
+    const float dt = ENGINE_SIM_TICK_US / 1e6f;
+    const uint32_t dtMs = ENGINE_SIM_TICK_US / 1000;
+    sim->runMs += dtMs;
+
+    // Driver script
+    if (sim->driveLeftMs <= dtMs || (sim->drive == ENGINE_SIM_DRIVE_BRAKE && sim->speed <= 0.0f)) {
+        Engine_Sim_nextDrive(sim);
+    } else {
+        sim->driveLeftMs -= dtMs;
+    }
+    float slew = (sim->throttleTarget > sim->throttle ? 3.0f : 6.0f) * dt;
+    sim->throttle = Engine_Sim_clamp(sim->throttleTarget, sim->throttle - slew, sim->throttle + slew);
+    if (sim->shiftLeftMs > 0) {
+        sim->throttle = 0.0f;   // Off the pedal while the clutch is down
+    }
+
+    // Crank torque: what the throttle asks for, less friction and pumping, cut at the limiter
+    float friction = 15.0f + sim->rpm * 0.004f;
+    float drive = sim->throttle * Engine_Sim_fullLoadTorque(sim->rpm);
+    if (sim->rpm >= ENGINE_SIM_LIMITER_RPM) {
+        drive = 0.0f;
+    }
+
+    // Clutch: open while shifting or standing off the throttle, slipping while pulling away in first
+    float coupledRpm = sim->speed * Engine_Sim_wheelRpmFactor(sim->gear);
+    bool standing = sim->speed < 2.0f && sim->throttle < 0.05f;
+    bool launching = sim->gear == 1 && coupledRpm < 1100.0f + 1800.0f * sim->throttle && sim->throttle >= 0.05f;
+    float wheelTorque = 0.0f;
+    if (standing || sim->shiftLeftMs > 0) {
+        // Idle air keeps the free engine at idle speed
+        float idle = sim->rpm < ENGINE_SIM_IDLE_RPM ? (ENGINE_SIM_IDLE_RPM - sim->rpm) * 0.2f + friction : 0.0f;
+        float net = drive + idle - friction;
+        sim->rpm += net / ENGINE_SIM_INERTIA * dt * 60.0f / (2.0f * (float)M_PI);
+        sim->rpm = Engine_Sim_clamp(sim->rpm, ENGINE_SIM_IDLE_RPM * 0.9f, ENGINE_SIM_LIMITER_RPM);
+        if (standing) {
+            sim->gear = 1;
+        }
+    } else if (launching) {
+        // The clutch passes the engine's torque while the revs stay at the launch speed
+        sim->rpm = Engine_Sim_approach(sim->rpm, 1100.0f + 1800.0f * sim->throttle, dt, 0.15f);
+        wheelTorque = drive - friction * 0.5f;
+    } else {
+        sim->rpm = coupledRpm > ENGINE_SIM_IDLE_RPM ? coupledRpm : ENGINE_SIM_IDLE_RPM;
+        wheelTorque = drive - friction;
+    }
+    sim->torque = drive;
+
+    // Road load
+    float force = wheelTorque * ENGINE_SIM_GEAR_RATIOS[sim->gear - 1] * ENGINE_SIM_FINAL_DRIVE *
+                  ENGINE_SIM_DRIVELINE_EFFICIENCY / ENGINE_SIM_WHEEL_RADIUS;
+    if (sim->speed > 0.0f) {
+        force -= ENGINE_SIM_ROLLING + ENGINE_SIM_DRAG * sim->speed * sim->speed;
+        if (sim->drive == ENGINE_SIM_DRIVE_BRAKE) {
+            force -= ENGINE_SIM_BRAKE_FORCE;
+        }
+    }
+    sim->speed += force / ENGINE_SIM_MASS * dt;
+    if (sim->speed < 0.0f) {
+        sim->speed = 0.0f;
+    }
+
+    // Gear changes at the seeded shift point, down when the revs drop
+    if (sim->shiftLeftMs > 0) {
+        sim->shiftLeftMs = sim->shiftLeftMs > dtMs ? (uint16_t)(sim->shiftLeftMs - dtMs) : 0;
+    } else if (!standing && !launching) {
+        if (sim->gear < ENGINE_SIM_GEAR_COUNT && sim->rpm >= sim->shiftRpm && sim->throttle > 0.05f) {
+            sim->gear++;
+            sim->shiftLeftMs = ENGINE_SIM_SHIFT_MS;
+        } else if (sim->gear > 1 && sim->rpm < ENGINE_SIM_DOWNSHIFT_RPM) {
+            sim->gear--;
+            sim->shiftLeftMs = ENGINE_SIM_SHIFT_MS;
+        }
+    }
+
+    // Intake manifold follows the throttle, with idle air when closed
+    float opening = sim->throttle > 0.04f ? sim->throttle : 0.04f;
+    sim->manifoldHpa = Engine_Sim_approach(sim->manifoldHpa, 250.0f + 760.0f * powf(opening, 0.6f), dt, 0.05f);
+    sim->load = drive * sim->rpm / (ENGINE_SIM_PEAK_TORQUE * 6500.0f);
+
+    // Cooling circuit: combustion heat, thermostat-controlled radiator, losses to the air
+    float open = Engine_Sim_clamp((sim->coolant - ENGINE_SIM_THERMOSTAT + 4.0f) / 8.0f, 0.0f, 1.0f);
+    float heat = 0.08f + 0.9f * sim->load;
+    float radiator = open * (sim->coolant - sim->ambient) * (0.02f + sim->speed * 0.0015f);
+    sim->coolant += (heat - radiator - 0.0015f * (sim->coolant - sim->ambient)) * dt;
+    sim->oil = Engine_Sim_approach(sim->oil, sim->coolant + 6.0f + 25.0f * sim->load, dt, 90.0f);
+    float soak = Engine_Sim_clamp(1.0f - sim->speed / 20.0f, 0.0f, 1.0f) * Engine_Sim_clamp((sim->coolant - sim->ambient) / 60.0f, 0.0f, 1.0f);
+    sim->intake = Engine_Sim_approach(sim->intake, sim->ambient + 3.0f + 20.0f * soak, dt, 30.0f);
+    float outletTarget = open > 0.0f ? sim->coolant - 4.0f - 6.0f * open - sim->speed * 0.05f
+                                     : sim->ambient + (sim->coolant - sim->ambient) * 0.3f;
+    sim->outlet = Engine_Sim_approach(sim->outlet, outletTarget, dt, 15.0f);
+    sim->lambdaPhase += 2.0f * (float)M_PI * 1.5f * dt;
+    if (sim->lambdaPhase > 2.0f * (float)M_PI) {
+        sim->lambdaPhase -= 2.0f * (float)M_PI;
+    }
+}
+
+static void Engine_Sim_updateSignals(Engine_Sim_t* sim) {
+    // Sensor readings in the units of the signal tables, with a little seeded noise
+    int16_t* bmw = sim->bmw;
+    int rpm = (int)sim->rpm + (int)(Engine_Sim_random(sim) % 11) - 5;
+    bmw[BMW_SIGNAL_IGNITION] = 1;
+    bmw[BMW_SIGNAL_CRANKING] = sim->runMs < ENGINE_SIM_CRANK_MS;
+    bmw[BMW_SIGNAL_TCS] = 0;
+    bmw[BMW_SIGNAL_TORQUE] = (int16_t)Engine_Sim_clamp(sim->torque / ENGINE_SIM_PEAK_TORQUE * 100.0f, 0.0f, 99.0f);
+    bmw[BMW_SIGNAL_RPM] = (int16_t)(rpm > 0 ? rpm : 0);
+    bmw[BMW_SIGNAL_TORQUE_LOSS] = (int16_t)((15.0f + sim->rpm * 0.004f) / ENGINE_SIM_PEAK_TORQUE * 100.0f);
+    bmw[BMW_SIGNAL_COOLANT_TEMP] = (int16_t)sim->coolant;
+    bmw[BMW_SIGNAL_MANIFOLD_PRESSURE] = (int16_t)sim->manifoldHpa;
+    bmw[BMW_SIGNAL_MIL] = 0;
+    bmw[BMW_SIGNAL_CRUISE] = sim->drive == ENGINE_SIM_DRIVE_CRUISE && sim->gear >= 4;
+    bmw[BMW_SIGNAL_EML] = 0;
+    bmw[BMW_SIGNAL_OIL_TEMP] = (int16_t)sim->oil;
+    bmw[BMW_SIGNAL_INTAKE_TEMP] = (int16_t)sim->intake;
+    bmw[BMW_SIGNAL_OUTLET_TEMP] = (int16_t)sim->outlet;
+    bmw[BMW_SIGNAL_FUEL_PRESSURE] = (int16_t)(350.0f + 10.0f * sim->load) + (int16_t)(Engine_Sim_random(sim) % 3) - 1;
+    // Closed loop around stoichiometric, rich at full load, fuel cut on the overrun
+    float lambda = 1.0f + 0.025f * sinf(sim->lambdaPhase);
+    if (sim->throttle > 0.85f) {
+        lambda = 0.87f;
+    } else if (sim->throttle == 0.0f && sim->rpm > 1200.0f && sim->shiftLeftMs == 0) {
+        lambda = 1.999f;
+    }
+    bmw[BMW_SIGNAL_LAMBDA] = (int16_t)(lambda * 1000.0f);
+    float airDensity = 1.2f * sim->manifoldHpa / 1013.0f;
+    bmw[BMW_SIGNAL_MAF] = (int16_t)(sim->rpm / 120.0f * ENGINE_SIM_DISPLACEMENT * airDensity * 0.9f * 3600.0f);
+
+    // The Kawasaki frame carries the same engine at a sport bike's rev range
+    int16_t* kawasaki = sim->kawasaki;
+    kawasaki[KAWASAKI_SIGNAL_RPM] = (int16_t)(1300 + (rpm - (int)ENGINE_SIM_IDLE_RPM) * 2);
+    kawasaki[KAWASAKI_SIGNAL_TPS] = (int16_t)(sim->throttle * 100.0f);
+    kawasaki[KAWASAKI_SIGNAL_IAP] = (int16_t)(sim->manifoldHpa / 10.0f);
+    kawasaki[KAWASAKI_SIGNAL_ECT] = (int16_t)sim->coolant;
+    kawasaki[KAWASAKI_SIGNAL_COOLANT_TEMP] = (int16_t)sim->coolant;
+}
+
+// === FRAME SCHEDULE ===
+static CAN_Frame_t* Engine_Sim_push(Engine_Sim_t* sim, uint32_t id) {
+    // One frame at a time on the wire: a frame due while another is sent waits for it
+    CAN_Frame_t* frame = &sim->queue[(sim->queueHead + sim->queueCount) % ENGINE_SIM_QUEUE_SIZE];
+    sim->queueCount++;
+    frame->timestamp = sim->simUs > sim->busFreeUs ? sim->simUs : sim->busFreeUs;
+    frame->id = id;
+    frame->flags = 0;
+    frame->len = 0;
+    sim->busFreeUs = frame->timestamp + ENGINE_SIM_FRAME_US;
+    return frame;
+}
+
+static void Engine_Sim_generate(Engine_Sim_t* sim) {
+    // Run the earliest due event, ties in the order below
+    enum { TICK, KAWASAKI, DIAG, FILLER } event = TICK;
+    uint64_t due = sim->nextTickUs;
+    if (sim->emitKawasaki && sim->nextKawasakiUs < due) {
+        event = KAWASAKI;
+        due = sim->nextKawasakiUs;
+    }
+    if (sim->diagCount > 0 && sim->diag[0].dueUs < due) {
+        event = DIAG;
+        due = sim->diag[0].dueUs;
+    }
+    if (sim->fillerIntervalUs > 0 && sim->nextFillerUs < due) {
+        event = FILLER;
+        due = sim->nextFillerUs;
+    }
+    sim->simUs = due;
+
+    CAN_Frame_t* frame;
+    switch (event) {
+        case TICK:
+            Engine_Sim_step(sim);
+            Engine_Sim_updateSignals(sim);
+            if (sim->emitBMW) {
+                static const uint16_t DME_IDS[] = {0x316, 0x329, 0x545};
+                for (uint16_t id : DME_IDS) {
+                    frame = Engine_Sim_push(sim, id);
+                    frame->len = BMW_encodeFrame(id, sim->bmw, frame->buf);
+                }
+            }
+            sim->nextTickUs += ENGINE_SIM_TICK_US;
+            break;
+        case KAWASAKI:
+            frame = Engine_Sim_push(sim, 0x620);
+            frame->len = Kawasaki_encodeFrame(0x620, sim->kawasaki, frame->buf);
+            sim->nextKawasakiUs += ENGINE_SIM_KAWASAKI_PERIOD_US;
+            break;
+        case DIAG:
+            frame = Engine_Sim_push(sim, BMW_DIAG_DME_RESPONSE_ID);
+            frame->len = sim->diag[0].len;
+            memcpy(frame->buf, sim->diag[0].buf, sim->diag[0].len);
+            sim->diagCount--;
+            memmove(&sim->diag[0], &sim->diag[1], sim->diagCount * sizeof(sim->diag[0]));
+            break;
+        case FILLER:
+            frame = Engine_Sim_push(sim, ENGINE_SIM_FILLER_IDS[Engine_Sim_random(sim) % ENGINE_SIM_FILLER_COUNT]);
+            frame->len = 8;
+            for (int i = 0; i < 8; i += 4) {
+                uint32_t bits = Engine_Sim_random(sim);
+                memcpy(&frame->buf[i], &bits, 4);
+            }
+            sim->fillerFrames++;
+            sim->nextFillerUs += sim->fillerIntervalUs;
+            break;
+    }
+}
+
+void Engine_Sim_next(Engine_Sim_t* sim, CAN_Frame_t* frame) {
+    // The next frame on the simulated bus, timestamp in simulated microseconds
+    while (sim->queueCount == 0) {
+        Engine_Sim_generate(sim);
+    }
+    *frame = sim->queue[sim->queueHead];
+    sim->queueHead = (uint8_t)((sim->queueHead + 1) % ENGINE_SIM_QUEUE_SIZE);
+    sim->queueCount--;
+    sim->framesGenerated++;
+}
+
+bool Engine_Sim_request(Engine_Sim_t* sim, uint32_t id, uint8_t len, const uint8_t* buf) {
+    // A frame sent by us: the DME answers MS42 block requests like the real one, one at a time
+    // and in order. Everything else is acknowledged on the bus and left unanswered.
+    if (id != BMW_DIAG_REQUEST_ID || len < 4 || buf[0] != BMW_DIAG_DME_ADDRESS || !sim->emitBMW) {
+        return true;
+    }
+    sim->diagRequests++;
+    if (sim->diagCount >= ENGINE_SIM_DIAG_QUEUE_SIZE) {
+        // Refused at the controller rather than lost, the transport sees the failed send
+        sim->diagRefused++;
+        return false;
+    }
+
+    uint8_t* response = sim->diag[sim->diagCount].buf;
+    uint8_t dataLen = 0;
+    if (buf[2] == DIAG_KWP_READ_LOCAL_ID && buf[3] >= 0x01 && buf[3] <= 0x03) {
+        static const BMW_MS42_Block_t BLOCKS[] = {BMW_MS42_BLOCK_TEMP, BMW_MS42_BLOCK_FUEL, BMW_MS42_BLOCK_AIR};
+        dataLen = BMW_encodeMS42Block(BLOCKS[buf[3] - 1], sim->bmw, &response[4]);
+    }
+    response[0] = BMW_DIAG_TESTER_ADDRESS;
+    if (dataLen > 0) {
+        response[1] = (uint8_t)(2 + dataLen);
+        response[2] = DIAG_KWP_POSITIVE_RESPONSE(DIAG_KWP_READ_LOCAL_ID);
+        response[3] = buf[3];
+    } else {
+        response[1] = 3;
+        response[2] = DIAG_KWP_NEGATIVE_RESPONSE;
+        response[3] = buf[2];
+        response[4] = 0x31;    // requestOutOfRange
+        dataLen = 1;
+    }
+    sim->diag[sim->diagCount].len = (uint8_t)(4 + dataLen);
+
+    // Each answer takes the latency after the previous one is out
+    uint64_t start = sim->simUs;
+    if (sim->diagCount > 0 && sim->diag[sim->diagCount - 1].dueUs > start) {
+        start = sim->diag[sim->diagCount - 1].dueUs;
+    }
+    sim->diag[sim->diagCount].dueUs = start + ENGINE_SIM_DME_LATENCY_US;
+    sim->diagCount++;
+    return true;
+}
+
+// === CONTROLLER EMULATION ===
+static bool Engine_Sim_isFiller(uint32_t id) {
+    for (size_t i = 0; i < ENGINE_SIM_FILLER_COUNT; i++) {
+        if (ENGINE_SIM_FILLER_IDS[i] == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool Engine_Sim_available(void* impl) {
+    Engine_Sim_t* sim = (Engine_Sim_t*)impl;
+
+    // Ending a burst makes the reader's drain loop return, the next poll starts a new one
+    if (sim->burst >= ENGINE_SIM_MAX_BURST) {
+        sim->burst = 0;
+        return false;
+    }
+    unsigned long now = micros();
+    sim->clockUs += now - sim->lastMicros;
+    sim->lastMicros = now;
+
+    while (true) {
+        if (!sim->pendingValid) {
+            Engine_Sim_next(sim, &sim->pending);
+            sim->pendingValid = true;
+        }
+        if (sim->pending.timestamp > sim->clockUs) {
+            sim->burst = 0;
+            return false;
+        }
+        sim->pendingValid = false;
+        if (sim->pending.timestamp + ENGINE_SIM_MAX_LAG_US < sim->clockUs) {
+            sim->framesLost++;
+            continue;
+        }
+        bool bypass = sim->fillerUnfiltered && Engine_Sim_isFiller(sim->pending.id);
+        if (!sim->acceptanceSet || bypass || CAN_Filter_accepts(&sim->acceptance, sim->pending.id)) {
+            sim->pendingValid = true;
+            return true;
+        }
+        sim->framesRejected++;
+    }
+}
+
+static bool Engine_Sim_read(void* impl, uint32_t* id, uint8_t* len, uint8_t* buf) {
+    Engine_Sim_t* sim = (Engine_Sim_t*)impl;
+    if (!sim->pendingValid) {
+        return false;
+    }
+    sim->pendingValid = false;
+    sim->burst++;
+    *id = sim->pending.id;
+    *len = sim->pending.len;
+    memcpy(buf, sim->pending.buf, sim->pending.len);
+    return true;
+}
+
+static bool Engine_Sim_send(void* impl, uint32_t id, uint8_t len, const uint8_t* buf) {
+    return Engine_Sim_request((Engine_Sim_t*)impl, id, len, buf);
+}
+
+static bool Engine_Sim_setAcceptance(void* impl, const CAN_Filter_Config_t* config) {
+    Engine_Sim_t* sim = (Engine_Sim_t*)impl;
+    sim->acceptance = *config;
+    sim->acceptanceSet = true;
+    return true;
+}
+
+void Engine_Sim_initInterface(CAN_Interface_t* iface, Engine_Sim_t* sim) {
+    // Simulated time resumes where it stopped, the time spent detached is not caught up
+    sim->clockUs = sim->simUs;
+    sim->lastMicros = micros();
+    sim->burst = 0;
+    iface->impl = sim;
+    iface->available = Engine_Sim_available;
+    iface->read = Engine_Sim_read;
+    iface->send = Engine_Sim_send;
+    iface->setAcceptance = Engine_Sim_setAcceptance;
+}
+
+void Engine_Sim_printStatus(const Engine_Sim_t* sim) {
+    static const char* const DRIVE_NAMES[] = {"idle", "cruise", "accelerate", "coast", "brake"};
+    Serial.printf("Engine simulator: seed %lu, %s%s%s, bus load %u%%%s, sim time %.1f s\n",
+                  (unsigned long)sim->seed,
+                  sim->emitBMW ? "BMW" : "", sim->emitBMW && sim->emitKawasaki ? " + " : "",
+                  sim->emitKawasaki ? "Kawasaki" : "",
+                  sim->busLoadPercent, sim->fillerUnfiltered ? " (filler unfiltered)" : "",
+                  sim->simUs / 1e6);
+    Serial.printf("  %s, gear %u, %.0f km/h, %.0f rpm, throttle %.0f%%, coolant %.1f C, oil %.1f C\n",
+                  DRIVE_NAMES[sim->drive], sim->gear, sim->speed * 3.6f, sim->rpm, sim->throttle * 100.0f,
+                  sim->coolant, sim->oil);
+    Serial.printf("  frames %lu (filler %lu), rejected by filter %lu, lost %lu, DME requests %lu (refused %lu)\n",
+                  (unsigned long)sim->framesGenerated, (unsigned long)sim->fillerFrames,
+                  (unsigned long)sim->framesRejected, (unsigned long)sim->framesLost,
+                  (unsigned long)sim->diagRequests, (unsigned long)sim->diagRefused);
+}
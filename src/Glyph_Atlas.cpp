@@ -0,0 +1,377 @@
+#include "Glyph_Atlas.h"
+#include <Arduino.h>
+#include <string.h>
+#include "Display_Renderer.h"
+
+// Pen positions Glyph_Atlas_verify() draws at, off the capture origins so blits shift both ways
+static const int8_t GLYPH_ATLAS_VERIFY_Y[] = {GLYPH_ATLAS_CAPTURE_Y - 3, GLYPH_ATLAS_CAPTURE_Y + 5};
+static const int8_t GLYPH_ATLAS_VERIFY_SPRITE_Y[] = {GLYPH_ATLAS_SPRITE_Y - 3, GLYPH_ATLAS_SPRITE_Y + 5};
+#define GLYPH_ATLAS_VERIFY_X 21
+
+void Glyph_Atlas_init(Glyph_Atlas_t* atlas, U8G2* display) {
+    memset(atlas, 0, sizeof(*atlas));
+    atlas->display = display;
+    atlas->enabled = true;
+}
+
+// === CAPTURE ===
+static uint64_t Glyph_Atlas_readColumn(const uint8_t* buffer, uint16_t width, uint8_t pages, int x) {
+    uint64_t column = 0;
+    for (uint8_t page = 0; page < pages; page++) {
+        column |= (uint64_t)buffer[page * width + x] << (page * 8);
+    }
+    return column;
+}
+
+static bool Glyph_Atlas_capture(Glyph_Atlas_t* atlas, void (*draw)(void* drawCtx), void* drawCtx,
+                                int* first, uint8_t* width, uint16_t* offset) {
+    // Rasterise twice, on a clear and on a filled buffer: pixels set on the first are ink,
+    // pixels cleared on the second are background the drawing wipes
+    U8G2* display = atlas->display;
+    uint8_t* buffer = display->getBufferPtr();
+    const uint16_t bufferWidth = (uint16_t)display->getBufferTileWidth() * 8;
+    const uint8_t pages = display->getBufferTileHeight();
+    const size_t size = (size_t)bufferWidth * pages;
+    static uint8_t ink[DISPLAY_RENDERER_BUFFER_SIZE];
+    if (pages > 8 || size > sizeof(ink)) {
+        return false;
+    }
+
+    memset(buffer, 0x00, size);
+    draw(drawCtx);
+    memcpy(ink, buffer, size);
+    memset(buffer, 0xFF, size);
+    draw(drawCtx);
+
+    const uint64_t rowMask = pages == 8 ? ~0ull : ((1ull << (pages * 8)) - 1);
+    int firstColumn = -1;
+    int lastColumn = -1;
+    for (int x = 0; x < bufferWidth; x++) {
+        uint64_t touched = Glyph_Atlas_readColumn(ink, bufferWidth, pages, x) |
+                           (~Glyph_Atlas_readColumn(buffer, bufferWidth, pages, x) & rowMask);
+        if (touched != 0) {
+            if (firstColumn < 0) {
+                firstColumn = x;
+            }
+            lastColumn = x;
+        }
+    }
+
+    *first = firstColumn;
+    *width = 0;
+    *offset = atlas->columnCount;
+    bool fits = true;
+    if (firstColumn >= 0) {
+        int columns = lastColumn - firstColumn + 1;
+        if (columns > 255 || atlas->columnCount + columns > GLYPH_ATLAS_MAX_COLUMNS) {
+            fits = false;
+        } else {
+            for (int x = firstColumn; x <= lastColumn; x++) {
+                Glyph_Atlas_Column_t* column = &atlas->columns[atlas->columnCount++];
+                column->ink = Glyph_Atlas_readColumn(ink, bufferWidth, pages, x);
+                column->clear = ~Glyph_Atlas_readColumn(buffer, bufferWidth, pages, x) & rowMask;
+            }
+            *width = (uint8_t)columns;
+        }
+    }
+    memset(buffer, 0x00, size);
+    return fits;
+}
+
+typedef struct {
+    U8G2* display;
+    uint16_t encoding;
+    uint8_t advance;
+} Glyph_Atlas_GlyphDraw_t;
+
+static void Glyph_Atlas_drawCaptureGlyph(void* drawCtx) {
+    Glyph_Atlas_GlyphDraw_t* glyph = (Glyph_Atlas_GlyphDraw_t*)drawCtx;
+    glyph->advance = (uint8_t)glyph->display->drawGlyph(GLYPH_ATLAS_CAPTURE_X, GLYPH_ATLAS_CAPTURE_Y, glyph->encoding);
+}
+
+static void Glyph_Atlas_drawCaptureSprite(void* drawCtx) {
+    ((Glyph_Atlas_DrawFunction_t)drawCtx)(GLYPH_ATLAS_CAPTURE_X, GLYPH_ATLAS_SPRITE_Y);
+}
+
+static bool Glyph_Atlas_clipped(const Glyph_Atlas_t* atlas, uint16_t offset, uint8_t width, int first) {
+    // Ink on the capture area border may have been cut off, such a glyph is left to U8g2
+    if (width == 0) {
+        return false;
+    }
+    const int bufferWidth = atlas->display->getBufferTileWidth() * 8;
+    const uint8_t pages = atlas->display->getBufferTileHeight();
+    const uint64_t edgeRows = 1ull | (1ull << (pages * 8 - 1));
+    if (first == 0 || first + width >= bufferWidth) {
+        return true;
+    }
+    for (uint8_t i = 0; i < width; i++) {
+        const Glyph_Atlas_Column_t* column = &atlas->columns[offset + i];
+        if ((column->ink | column->clear) & edgeRows) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int Glyph_Atlas_addFont(Glyph_Atlas_t* atlas, const uint8_t* font, const char* charset) {
+    // Rasterises every character of charset, returns the font handle or -1 when full
+    if (atlas->fontCount >= GLYPH_ATLAS_MAX_FONTS || strlen(charset) > GLYPH_ATLAS_MAX_GLYPHS) {
+        return -1;
+    }
+    Glyph_Atlas_Font_t* entry = &atlas->fonts[atlas->fontCount];
+    entry->font = font;
+    entry->glyphCount = 0;
+    memset(entry->glyphIndex, GLYPH_ATLAS_NO_GLYPH, sizeof(entry->glyphIndex));
+
+    atlas->display->setFont(font);
+    for (const char* c = charset; *c != '\0'; c++) {
+        uint8_t code = (uint8_t)*c;
+        if (code >= sizeof(entry->glyphIndex) || entry->glyphIndex[code] != GLYPH_ATLAS_NO_GLYPH) {
+            continue;
+        }
+        Glyph_Atlas_GlyphDraw_t draw = {atlas->display, code, 0};
+        Glyph_Atlas_Glyph_t* glyph = &entry->glyphs[entry->glyphCount];
+        uint16_t columnsBefore = atlas->columnCount;
+        int first;
+        bool fits = Glyph_Atlas_capture(atlas, Glyph_Atlas_drawCaptureGlyph, &draw, &first, &glyph->width, &glyph->offset);
+        glyph->left = (int8_t)(first - GLYPH_ATLAS_CAPTURE_X);
+        glyph->advance = draw.advance;
+        glyph->captured = fits && !Glyph_Atlas_clipped(atlas, glyph->offset, glyph->width, first);
+        if (!glyph->captured) {
+            atlas->columnCount = columnsBefore;
+            glyph->width = 0;
+        }
+        entry->glyphIndex[code] = entry->glyphCount++;
+    }
+    return atlas->fontCount++;
+}
+
+int Glyph_Atlas_addSprite(Glyph_Atlas_t* atlas, Glyph_Atlas_DrawFunction_t draw) {
+    // Rasterises draw() around the capture origin, returns the sprite handle or -1 when full.
+    // A sprite that does not fit the column pool or the capture area is still registered and drawn by draw().
+    if (atlas->spriteCount >= GLYPH_ATLAS_MAX_SPRITES) {
+        return -1;
+    }
+    Glyph_Atlas_Sprite_t* sprite = &atlas->sprites[atlas->spriteCount];
+    sprite->draw = draw;
+    uint16_t columnsBefore = atlas->columnCount;
+    int first;
+    bool fits = Glyph_Atlas_capture(atlas, Glyph_Atlas_drawCaptureSprite, (void*)draw, &first, &sprite->width, &sprite->offset);
+    sprite->left = (int8_t)(first - GLYPH_ATLAS_CAPTURE_X);
+    sprite->captured = fits && !Glyph_Atlas_clipped(atlas, sprite->offset, sprite->width, first);
+    if (!sprite->captured) {
+        atlas->columnCount = columnsBefore;
+        sprite->width = 0;
+    }
+    return atlas->spriteCount++;
+}
+
+// === BLIT ===
+static void Glyph_Atlas_blit(Glyph_Atlas_t* atlas, const Glyph_Atlas_Column_t* columns, uint8_t width, int x, int shift) {
+    // Columns hold the rows they were captured at, shift moves them to the target rows. Pixels
+    // shifted or placed off the buffer are dropped, as U8g2 clips them.
+    if (shift <= -64 || shift >= 64) {
+        return;
+    }
+    U8G2* display = atlas->display;
+    uint8_t* buffer = display->getBufferPtr();
+    const int bufferWidth = display->getBufferTileWidth() * 8;
+    const uint8_t pages = display->getBufferTileHeight();
+    for (uint8_t i = 0; i < width; i++) {
+        int column = x + i;
+        if (column < 0 || column >= bufferWidth) {
+            continue;
+        }
+        uint64_t ink = shift >= 0 ? columns[i].ink << shift : columns[i].ink >> -shift;
+        uint64_t clear = shift >= 0 ? columns[i].clear << shift : columns[i].clear >> -shift;
+        uint64_t touched = ink | clear;
+        uint8_t* pixel = buffer + column;
+        for (uint8_t page = 0; page < pages && touched != 0; page++, pixel += bufferWidth) {
+            if ((uint8_t)touched != 0) {
+                *pixel = (uint8_t)((*pixel & ~(uint8_t)clear) | (uint8_t)ink);
+            }
+            ink >>= 8;
+            clear >>= 8;
+            touched >>= 8;
+        }
+    }
+}
+
+static int Glyph_Atlas_drawChar(Glyph_Atlas_t* atlas, const Glyph_Atlas_Font_t* font, int x, int y, uint8_t code) {
+    uint8_t index = code < sizeof(font->glyphIndex) ? font->glyphIndex[code] : GLYPH_ATLAS_NO_GLYPH;
+    if (index == GLYPH_ATLAS_NO_GLYPH || !font->glyphs[index].captured) {
+        atlas->fallbacks++;
+        atlas->display->setFont(font->font);
+        return x + atlas->display->drawGlyph(x, y, code);
+    }
+    const Glyph_Atlas_Glyph_t* glyph = &font->glyphs[index];
+    Glyph_Atlas_blit(atlas, &atlas->columns[glyph->offset], glyph->width, x + glyph->left, y - GLYPH_ATLAS_CAPTURE_Y);
+    return x + glyph->advance;
+}
+
+int Glyph_Atlas_drawStr(Glyph_Atlas_t* atlas, uint8_t font, int x, int y, const char* str) {
+    // Same pixels and pen movement as setFont() + drawStr(), returns the pen position after str
+    const Glyph_Atlas_Font_t* entry = &atlas->fonts[font];
+    if (!atlas->enabled) {
+        atlas->display->setFont(entry->font);
+        return x + atlas->display->drawStr(x, y, str);
+    }
+    for (const char* c = str; *c != '\0'; c++) {
+        x = Glyph_Atlas_drawChar(atlas, entry, x, y, (uint8_t)*c);
+    }
+    return x;
+}
+
+uint8_t Glyph_Atlas_intLength(int32_t value) {
+    // Characters "%d" prints
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    uint8_t length = value < 0 ? 2 : 1;
+    while (magnitude >= 10) {
+        magnitude /= 10;
+        length++;
+    }
+    return length;
+}
+
+int Glyph_Atlas_drawInt(Glyph_Atlas_t* atlas, uint8_t font, int x, int y, int32_t value) {
+    // Like drawing "%d", without printf
+    char text[GLYPH_ATLAS_INT_CHARS];
+    char* c = text + sizeof(text) - 1;
+    *c = '\0';
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    do {
+        *--c = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        *--c = '-';
+    }
+    return Glyph_Atlas_drawStr(atlas, font, x, y, c);
+}
+
+void Glyph_Atlas_drawSprite(Glyph_Atlas_t* atlas, uint8_t sprite, int x, int y) {
+    const Glyph_Atlas_Sprite_t* entry = &atlas->sprites[sprite];
+    if (!atlas->enabled || !entry->captured) {
+        entry->draw(x, y);
+        return;
+    }
+    Glyph_Atlas_blit(atlas, &atlas->columns[entry->offset], entry->width, x + entry->left, y - GLYPH_ATLAS_SPRITE_Y);
+}
+
+bool Glyph_Atlas_glyphBounds(const Glyph_Atlas_t* atlas, uint8_t font, uint8_t code, Glyph_Atlas_Bounds_t* bounds) {
+    // Exact extent of a character, false when it is outside the charset or left to U8g2
+    if (font >= atlas->fontCount) {
+        return false;
+    }
+    const Glyph_Atlas_Font_t* entry = &atlas->fonts[font];
+    uint8_t index = code < sizeof(entry->glyphIndex) ? entry->glyphIndex[code] : GLYPH_ATLAS_NO_GLYPH;
+    if (index == GLYPH_ATLAS_NO_GLYPH || !entry->glyphs[index].captured) {
+        return false;
+    }
+    const Glyph_Atlas_Glyph_t* glyph = &entry->glyphs[index];
+    uint64_t rows = 0;
+    for (uint8_t i = 0; i < glyph->width; i++) {
+        rows |= atlas->columns[glyph->offset + i].ink | atlas->columns[glyph->offset + i].clear;
+    }
+    bounds->left = glyph->width ? glyph->left : 0;
+    bounds->right = glyph->width ? (int8_t)(glyph->left + glyph->width) : 0;
+    bounds->top = rows ? (int8_t)(__builtin_ctzll(rows) - GLYPH_ATLAS_CAPTURE_Y) : 0;
+    bounds->bottom = rows ? (int8_t)(64 - __builtin_clzll(rows) - GLYPH_ATLAS_CAPTURE_Y) : 0;
+    bounds->advance = glyph->advance;
+    return true;
+}
+
+// === VERIFICATION ===
+typedef struct {
+    Glyph_Atlas_t* atlas;
+    uint8_t font;
+    char text[2];
+    int y;
+    uint8_t sprite;
+} Glyph_Atlas_VerifyDraw_t;
+
+static void Glyph_Atlas_verifyGlyph(Glyph_Atlas_VerifyDraw_t* verify) {
+    Glyph_Atlas_drawStr(verify->atlas, verify->font, GLYPH_ATLAS_VERIFY_X, verify->y, verify->text);
+}
+
+static void Glyph_Atlas_verifySprite(Glyph_Atlas_VerifyDraw_t* verify) {
+    Glyph_Atlas_drawSprite(verify->atlas, verify->sprite, GLYPH_ATLAS_VERIFY_X, verify->y);
+}
+
+static uint32_t Glyph_Atlas_compare(Glyph_Atlas_VerifyDraw_t* verify, void (*draw)(Glyph_Atlas_VerifyDraw_t* verify)) {
+    // Pixels that differ between U8g2 and the atlas drawing over the same patterned background
+    Glyph_Atlas_t* atlas = verify->atlas;
+    uint8_t* buffer = atlas->display->getBufferPtr();
+    const size_t size = (size_t)atlas->display->getBufferTileWidth() * 8 * atlas->display->getBufferTileHeight();
+    static uint8_t reference[DISPLAY_RENDERER_BUFFER_SIZE];
+    if (size > sizeof(reference)) {
+        return 0;
+    }
+    bool enabled = atlas->enabled;
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = (uint8_t)(i * 37 + 0x5A);
+    }
+    atlas->enabled = false;
+    draw(verify);
+    memcpy(reference, buffer, size);
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = (uint8_t)(i * 37 + 0x5A);
+    }
+    atlas->enabled = true;
+    draw(verify);
+    atlas->enabled = enabled;
+
+    uint32_t differing = 0;
+    for (size_t i = 0; i < size; i++) {
+        differing += (uint32_t)__builtin_popcount((unsigned)(reference[i] ^ buffer[i]));
+    }
+    return differing;
+}
+
+uint32_t Glyph_Atlas_verify(Glyph_Atlas_t* atlas) {
+    // Every glyph and sprite at two positions, returns the differing pixels. Clears the buffer.
+    Glyph_Atlas_VerifyDraw_t verify = {};
+    verify.atlas = atlas;
+    uint32_t differing = 0;
+    for (uint8_t f = 0; f < atlas->fontCount; f++) {
+        verify.font = f;
+        for (uint8_t code = 0; code < sizeof(atlas->fonts[f].glyphIndex); code++) {
+            if (atlas->fonts[f].glyphIndex[code] == GLYPH_ATLAS_NO_GLYPH) {
+                continue;
+            }
+            verify.text[0] = (char)code;
+            for (int8_t y : GLYPH_ATLAS_VERIFY_Y) {
+                verify.y = y;
+                differing += Glyph_Atlas_compare(&verify, Glyph_Atlas_verifyGlyph);
+            }
+        }
+    }
+    for (uint8_t s = 0; s < atlas->spriteCount; s++) {
+        verify.sprite = s;
+        for (int8_t y : GLYPH_ATLAS_VERIFY_SPRITE_Y) {
+            verify.y = y;
+            differing += Glyph_Atlas_compare(&verify, Glyph_Atlas_verifySprite);
+        }
+    }
+    atlas->display->clearBuffer();
+    return differing;
+}
+
+void Glyph_Atlas_printStatus(const Glyph_Atlas_t* atlas) {
+    uint16_t glyphs = 0;
+    uint16_t missing = 0;
+    for (uint8_t f = 0; f < atlas->fontCount; f++) {
+        for (uint8_t g = 0; g < atlas->fonts[f].glyphCount; g++) {
+            glyphs++;
+            if (!atlas->fonts[f].glyphs[g].captured) {
+                missing++;
+            }
+        }
+    }
+    Serial.printf("Glyph atlas: %s, %u fonts, %u glyphs (%u left to U8g2), %u sprites\n",
+                  atlas->enabled ? "on" : "off", (unsigned)atlas->fontCount, (unsigned)glyphs,
+                  (unsigned)missing, (unsigned)atlas->spriteCount);
+    Serial.printf("Columns: %u of %u (%u of %u bytes), fallback characters drawn: %lu\n", (unsigned)atlas->columnCount,
+                  (unsigned)GLYPH_ATLAS_MAX_COLUMNS, (unsigned)(atlas->columnCount * sizeof(Glyph_Atlas_Column_t)),
+                  (unsigned)sizeof(atlas->columns), (unsigned long)atlas->fallbacks);
+}
@@ -0,0 +1,311 @@
+#include "ISOTP.h"
+#include <Arduino.h>
+#include <string.h>
+
+#define ISOTP_FRAME_SIZE 8
+#define ISOTP_MAX_MESSAGE 4095      // 12-bit length in the first frame
+#define ISOTP_PADDING 0x00
+
+void ISOTP_init(ISOTP_t* isotp, ISOTP_SendFrame_t sendFrame, void* sendCtx) {
+    memset(isotp, 0, sizeof(*isotp));
+    isotp->sendFrame = sendFrame;
+    isotp->sendCtx = sendCtx;
+}
+
+ISOTP_Session_t* ISOTP_open(ISOTP_t* isotp, uint32_t txId, int16_t txAddress, uint32_t rxId, int16_t rxAddress,
+                            uint8_t* rxBuf, uint16_t rxSize, ISOTP_Callback_t callback, void* userCtx) {
+    if (isotp->sessionCount >= ISOTP_MAX_SESSIONS) {
+        return nullptr;
+    }
+    ISOTP_Session_t* session = &isotp->sessions[isotp->sessionCount++];
+    memset(session, 0, sizeof(*session));
+    session->txId = txId;
+    session->txAddress = txAddress;
+    session->rxId = rxId;
+    session->rxAddress = rxAddress;
+    session->rxBuf = rxBuf;
+    session->rxSize = rxSize;
+    session->callback = callback;
+    session->userCtx = userCtx;
+    session->blockSize = ISOTP_DEFAULT_BLOCK_SIZE;
+    session->stMin = ISOTP_DEFAULT_ST_MIN;
+    session->txState = ISOTP_STATE_IDLE;
+    return session;
+}
+
+void ISOTP_setFlowControl(ISOTP_Session_t* session, uint8_t blockSize, uint8_t stMin) {
+    session->blockSize = blockSize;
+    session->stMin = stMin;
+}
+
+bool ISOTP_isBusy(const ISOTP_Session_t* session) {
+    return session->txState != ISOTP_STATE_IDLE;
+}
+
+// === FRAMES ===
+static uint8_t ISOTP_offset(int16_t address) {
+    return address == ISOTP_NO_ADDRESS ? 0 : 1;
+}
+
+static bool ISOTP_sendFrame(ISOTP_t* isotp, ISOTP_Session_t* session, const uint8_t* payload, uint8_t len) {
+    // Padded to a full frame, ECUs commonly ignore shorter ones
+    uint8_t frame[ISOTP_FRAME_SIZE];
+    uint8_t offset = ISOTP_offset(session->txAddress);
+    memset(frame, ISOTP_PADDING, sizeof(frame));
+    if (offset > 0) {
+        frame[0] = (uint8_t)session->txAddress;
+    }
+    memcpy(&frame[offset], payload, len);
+    return isotp->sendFrame(isotp->sendCtx, session->txId, ISOTP_FRAME_SIZE, frame);
+}
+
+static void ISOTP_sendFlowControl(ISOTP_t* isotp, ISOTP_Session_t* session, uint8_t status) {
+    uint8_t fc[3] = {(uint8_t)(ISOTP_PCI_FLOW_CONTROL | status), session->blockSize, session->stMin};
+    ISOTP_sendFrame(isotp, session, fc, sizeof(fc));
+}
+
+static uint32_t ISOTP_report(ISOTP_Session_t* session, ISOTP_Result_t result, const uint8_t* data, uint16_t len) {
+    if (result != ISOTP_RESULT_RECEIVED && result != ISOTP_RESULT_SENT) {
+        session->errors++;
+    }
+    return session->callback != nullptr ? session->callback(session->userCtx, result, data, len) : 0;
+}
+
+static uint32_t ISOTP_stMinUs(uint8_t stMin) {
+    if (stMin <= 0x7F) {
+        return stMin * 1000u;
+    }
+    if (stMin >= 0xF1 && stMin <= 0xF9) {
+        return (stMin - 0xF0) * 100u;
+    }
+    return 127000u;     // Reserved values mean the longest separation time
+}
+
+// === SENDING ===
+bool ISOTP_send(ISOTP_t* isotp, ISOTP_Session_t* session, const uint8_t* data, uint16_t len) {
+    if (session->txState != ISOTP_STATE_IDLE || len == 0 || len > ISOTP_MAX_MESSAGE) {
+        return false;
+    }
+    uint8_t offset = ISOTP_offset(session->txAddress);
+    uint8_t payload[ISOTP_FRAME_SIZE];
+
+    // Fits one frame: sent right away, data is not referenced afterwards
+    if (len <= ISOTP_FRAME_SIZE - 1 - offset) {
+        payload[0] = (uint8_t)(ISOTP_PCI_SINGLE | len);
+        memcpy(&payload[1], data, len);
+        if (!ISOTP_sendFrame(isotp, session, payload, (uint8_t)(len + 1))) {
+            session->errors++;
+            return false;
+        }
+        session->messagesSent++;
+        return true;
+    }
+
+    // Segmented: data stays with the caller until ISOTP_RESULT_SENT or an error is reported
+    uint8_t chunk = (uint8_t)(ISOTP_FRAME_SIZE - 2 - offset);
+    payload[0] = (uint8_t)(ISOTP_PCI_FIRST | (len >> 8));
+    payload[1] = (uint8_t)len;
+    memcpy(&payload[2], data, chunk);
+    if (!ISOTP_sendFrame(isotp, session, payload, (uint8_t)(chunk + 2))) {
+        session->errors++;
+        return false;
+    }
+    session->txBuf = data;
+    session->txLen = len;
+    session->txPos = chunk;
+    session->txSeq = 1;
+    session->txWaits = 0;
+    session->txLastMs = millis();
+    session->txState = ISOTP_STATE_WAIT_FLOW_CONTROL;
+    return true;
+}
+
+static void ISOTP_stepSend(ISOTP_t* isotp, ISOTP_Session_t* session) {
+    uint8_t offset = ISOTP_offset(session->txAddress);
+    uint8_t chunk = (uint8_t)(ISOTP_FRAME_SIZE - 1 - offset);
+    uint8_t payload[ISOTP_FRAME_SIZE];
+
+    for (int i = 0; i < ISOTP_FRAMES_PER_STEP; i++) {
+        if (micros() - session->txLastUs < session->txStMinUs) {
+            return;
+        }
+        uint16_t left = (uint16_t)(session->txLen - session->txPos);
+        uint8_t n = left < chunk ? (uint8_t)left : chunk;
+        payload[0] = (uint8_t)(ISOTP_PCI_CONSECUTIVE | session->txSeq);
+        memcpy(&payload[1], &session->txBuf[session->txPos], n);
+        if (!ISOTP_sendFrame(isotp, session, payload, (uint8_t)(n + 1))) {
+            session->txState = ISOTP_STATE_IDLE;
+            ISOTP_report(session, ISOTP_RESULT_SEND_FAILED, nullptr, 0);
+            return;
+        }
+        session->txLastUs = micros();
+        session->txPos += n;
+        session->txSeq = (uint8_t)((session->txSeq + 1) & 0x0F);
+
+        if (session->txPos >= session->txLen) {
+            session->txState = ISOTP_STATE_IDLE;
+            session->messagesSent++;
+            ISOTP_report(session, ISOTP_RESULT_SENT, nullptr, 0);
+            return;
+        }
+        if (session->txBlockLeft > 0 && --session->txBlockLeft == 0) {
+            session->txState = ISOTP_STATE_WAIT_FLOW_CONTROL;
+            session->txWaits = 0;
+            session->txLastMs = millis();
+            return;
+        }
+    }
+}
+
+static void ISOTP_onFlowControl(ISOTP_Session_t* session, uint8_t status, const uint8_t* params, uint8_t paramLen) {
+    if (session->txState != ISOTP_STATE_WAIT_FLOW_CONTROL) {
+        return;
+    }
+    switch (status) {
+        case ISOTP_FC_CONTINUE:
+            if (paramLen < 2) {
+                return;
+            }
+            session->txBlockLeft = params[0];
+            session->txStMinUs = ISOTP_stMinUs(params[1]);
+            session->txLastUs = micros() - session->txStMinUs;   // The first frame of a block goes out at once
+            session->txState = ISOTP_STATE_SENDING;
+            break;
+        case ISOTP_FC_WAIT:
+            if (++session->txWaits > ISOTP_MAX_WAIT_FRAMES) {
+                session->txState = ISOTP_STATE_IDLE;
+                ISOTP_report(session, ISOTP_RESULT_TIMEOUT, nullptr, 0);
+            } else {
+                session->txLastMs = millis();
+            }
+            break;
+        case ISOTP_FC_OVERFLOW:
+            session->txState = ISOTP_STATE_IDLE;
+            ISOTP_report(session, ISOTP_RESULT_OVERFLOW, nullptr, 0);
+            break;
+    }
+}
+
+// === RECEIVING ===
+static void ISOTP_abortReceive(ISOTP_Session_t* session) {
+    if (session->rxExpected != 0) {
+        session->rxExpected = 0;
+        ISOTP_report(session, ISOTP_RESULT_ABORTED, nullptr, 0);
+    }
+}
+
+static uint32_t ISOTP_onFirstFrame(ISOTP_t* isotp, ISOTP_Session_t* session, const uint8_t* payload, uint8_t payloadLen) {
+    uint16_t total = (uint16_t)(((payload[0] & 0x0F) << 8) | payload[1]);
+    if (payloadLen < ISOTP_FRAME_SIZE - ISOTP_offset(session->rxAddress) || total <= payloadLen - 1) {
+        return 0;   // First frames are always full, anything shorter would have been a single frame
+    }
+    ISOTP_abortReceive(session);
+    if (session->rxBuf == nullptr || total > session->rxSize) {
+        ISOTP_sendFlowControl(isotp, session, ISOTP_FC_OVERFLOW);
+        return ISOTP_report(session, ISOTP_RESULT_OVERFLOW, nullptr, total);
+    }
+
+    uint8_t chunk = (uint8_t)(payloadLen - 2);
+    memcpy(session->rxBuf, &payload[2], chunk);
+    session->rxPos = chunk;
+    session->rxExpected = total;
+    session->rxSeq = 1;
+    session->rxBlockCount = 0;
+    session->rxLastMs = millis();
+    ISOTP_sendFlowControl(isotp, session, ISOTP_FC_CONTINUE);
+    return 0;
+}
+
+static uint32_t ISOTP_onConsecutiveFrame(ISOTP_t* isotp, ISOTP_Session_t* session, const uint8_t* payload, uint8_t payloadLen) {
+    if (session->rxExpected == 0) {
+        return 0;
+    }
+    if ((payload[0] & 0x0F) != session->rxSeq) {
+        session->rxExpected = 0;
+        return ISOTP_report(session, ISOTP_RESULT_SEQUENCE, nullptr, 0);
+    }
+
+    uint16_t left = (uint16_t)(session->rxExpected - session->rxPos);
+    uint8_t n = (uint8_t)(payloadLen - 1);
+    n = left < n ? (uint8_t)left : n;
+    memcpy(&session->rxBuf[session->rxPos], &payload[1], n);
+    session->rxPos += n;
+    session->rxSeq = (uint8_t)((session->rxSeq + 1) & 0x0F);
+    session->rxLastMs = millis();
+
+    if (session->rxPos >= session->rxExpected) {
+        uint16_t len = session->rxExpected;
+        session->rxExpected = 0;
+        session->messagesReceived++;
+        return ISOTP_report(session, ISOTP_RESULT_RECEIVED, session->rxBuf, len);
+    }
+    if (session->blockSize > 0 && ++session->rxBlockCount >= session->blockSize) {
+        session->rxBlockCount = 0;
+        ISOTP_sendFlowControl(isotp, session, ISOTP_FC_CONTINUE);
+    }
+    return 0;
+}
+
+static ISOTP_Session_t* ISOTP_findSession(ISOTP_t* isotp, uint32_t id, uint8_t len, const uint8_t* buf) {
+    for (int i = 0; i < isotp->sessionCount; i++) {
+        ISOTP_Session_t* session = &isotp->sessions[i];
+        if (session->rxId != id) {
+            continue;
+        }
+        if (session->rxAddress == ISOTP_NO_ADDRESS || (len > 0 && buf[0] == (uint8_t)session->rxAddress)) {
+            return session;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t ISOTP_onFrame(ISOTP_t* isotp, uint32_t id, uint8_t len, const uint8_t* buf) {
+    ISOTP_Session_t* session = ISOTP_findSession(isotp, id, len, buf);
+    if (session == nullptr) {
+        return 0;
+    }
+    uint8_t offset = ISOTP_offset(session->rxAddress);
+    if (len < offset + 2) {
+        return 0;
+    }
+    const uint8_t* payload = &buf[offset];
+    uint8_t payloadLen = (uint8_t)(len - offset);
+
+    switch (payload[0] & 0xF0) {
+        case ISOTP_PCI_SINGLE: {
+            uint8_t n = payload[0] & 0x0F;
+            if (n == 0 || n > payloadLen - 1) {
+                return 0;
+            }
+            // Passed on straight from the CAN frame, no copy
+            ISOTP_abortReceive(session);
+            session->messagesReceived++;
+            return ISOTP_report(session, ISOTP_RESULT_RECEIVED, &payload[1], n);
+        }
+        case ISOTP_PCI_FIRST:
+            return ISOTP_onFirstFrame(isotp, session, payload, payloadLen);
+        case ISOTP_PCI_CONSECUTIVE:
+            return ISOTP_onConsecutiveFrame(isotp, session, payload, payloadLen);
+        case ISOTP_PCI_FLOW_CONTROL:
+            ISOTP_onFlowControl(session, payload[0] & 0x0F, &payload[1], (uint8_t)(payloadLen - 1));
+            return 0;
+    }
+    return 0;
+}
+
+void ISOTP_step(ISOTP_t* isotp) {
+    unsigned long nowMs = millis();
+    for (int i = 0; i < isotp->sessionCount; i++) {
+        ISOTP_Session_t* session = &isotp->sessions[i];
+        if (session->rxExpected != 0 && nowMs - session->rxLastMs > ISOTP_TIMEOUT_MS) {
+            session->rxExpected = 0;
+            ISOTP_report(session, ISOTP_RESULT_TIMEOUT, nullptr, 0);
+        }
+        if (session->txState == ISOTP_STATE_WAIT_FLOW_CONTROL && nowMs - session->txLastMs > ISOTP_TIMEOUT_MS) {
+            session->txState = ISOTP_STATE_IDLE;
+            ISOTP_report(session, ISOTP_RESULT_TIMEOUT, nullptr, 0);
+        } else if (session->txState == ISOTP_STATE_SENDING) {
+            ISOTP_stepSend(isotp, session);
+        }
+    }
+}
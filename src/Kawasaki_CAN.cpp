@@ -1,19 +1,64 @@
 #include "Kawasaki_CAN.h"
+#include "Signal_DB.h"
+#include "Vehicle_State.h"
 #include <stdio.h>
+#include <string.h>
 
-void Kawasaki_parseCANMessage(uint32_t rxId, uint8_t len, const uint8_t* buf, Kawasaki_CAN_Data_t* data, bool* displayUpdated) {
-    // Kawasaki FI Calibration Tool Main Diagnostic Frame: 0x620 (8 bytes)
-    // Byte 0-1: RPM (big endian)
-    // Byte 2: Throttle Position Sensor (TPS)
-    // Byte 3: Intake Air Pressure (IAP)
-    // Byte 4: Engine Coolant Temp (ECT)
-    // Byte 5-7: (other sensors, not implemented here)
-    if (rxId == 0x620 && len >= 8) {
-        data->rpm = (buf[0] << 8) | buf[1];
-        data->tps = buf[2];
-        data->iap = buf[3];
-        data->ect = buf[4];
-        data->coolantTemp = buf[4];
-        *displayUpdated = true;
+// === SIGNAL DATABASE ===
+// Kawasaki FI Calibration Tool Main Diagnostic Frame: 0x620 (8 bytes)
+// Bytes 5-7 carry other sensors that are not decoded yet
+static constexpr Signal_Def_t KAWASAKI_MAIN_SIGNALS[] = {
+    SIGNAL_INT(KAWASAKI_SIGNAL_RPM, 7, 16, SIGNAL_BIG_ENDIAN, 1, 1, 0),
+    SIGNAL_INT(KAWASAKI_SIGNAL_TPS, 16, 8, SIGNAL_LITTLE_ENDIAN, 1, 1, 0),
+    SIGNAL_INT(KAWASAKI_SIGNAL_IAP, 24, 8, SIGNAL_LITTLE_ENDIAN, 1, 1, 0),
+    SIGNAL_INT(KAWASAKI_SIGNAL_ECT, 32, 8, SIGNAL_LITTLE_ENDIAN, 1, 1, 0),
+    SIGNAL_INT(KAWASAKI_SIGNAL_COOLANT_TEMP, 32, 8, SIGNAL_LITTLE_ENDIAN, 1, 1, 0),
+};
+static_assert(Signal_isValid(KAWASAKI_MAIN_SIGNALS, SIGNAL_COUNT(KAWASAKI_MAIN_SIGNALS)), "Invalid Kawasaki signal table");
+
+static uint32_t Kawasaki_decodeMain(uint8_t len, const uint8_t* buf, void* target) {
+    Vehicle_State_t* state = (Vehicle_State_t*)target;
+    return Vehicle_State_decode<KAWASAKI_MAIN_SIGNALS, SIGNAL_COUNT(KAWASAKI_MAIN_SIGNALS)>(state, VEHICLE_STATE_KAWASAKI_BASE, buf);
+}
+
+// Inverse of the decoder, for the engine simulator
+uint8_t Kawasaki_encodeFrame(uint32_t id, const int16_t* values, uint8_t* buf) {
+    if (id != 0x620) {
+        return 0;
     }
-} 
\ No newline at end of file
+    memset(buf, 0, 8);
+    Signal_encode<KAWASAKI_MAIN_SIGNALS, SIGNAL_COUNT(KAWASAKI_MAIN_SIGNALS)>(values, buf);
+    return 8;
+}
+
+// Frames consumed by the Kawasaki decoder, sorted by ID
+static constexpr CAN_Dispatch_Entry_t KAWASAKI_DISPATCH_ENTRIES[] = {
+    {0x620, 8, Kawasaki_decodeMain, 0},
+};
+static constexpr size_t KAWASAKI_DISPATCH_COUNT = sizeof(KAWASAKI_DISPATCH_ENTRIES) / sizeof(KAWASAKI_DISPATCH_ENTRIES[0]);
+static_assert(CAN_Dispatch_isSorted(KAWASAKI_DISPATCH_ENTRIES, KAWASAKI_DISPATCH_COUNT), "Kawasaki dispatch entries must be sorted by ID");
+static_assert(KAWASAKI_DISPATCH_ENTRIES[0].minLen >= Signal_minLen(KAWASAKI_MAIN_SIGNALS, SIGNAL_COUNT(KAWASAKI_MAIN_SIGNALS)),
+              "Kawasaki dispatch minimum length must cover its signal table");
+
+const CAN_Dispatch_Entry_t* Kawasaki_getDispatchEntries(size_t* count) {
+    *count = KAWASAKI_DISPATCH_COUNT;
+    return KAWASAKI_DISPATCH_ENTRIES;
+}
+
+// Broadcast frames that identify the bus for auto-detection, with their nominal periods
+static constexpr Bus_Fingerprint_Id_t KAWASAKI_FINGERPRINT[] = {
+    {0x620, 20},
+};
+
+const Bus_Fingerprint_Id_t* Kawasaki_getFingerprint(size_t* count) {
+    *count = sizeof(KAWASAKI_FINGERPRINT) / sizeof(KAWASAKI_FINGERPRINT[0]);
+    return KAWASAKI_FINGERPRINT;
+}
+
+bool Kawasaki_registerDecoders(CAN_Dispatch_Table_t* table, Vehicle_State_t* state, uint8_t maskShift) {
+    return CAN_Dispatch_register(table, KAWASAKI_DISPATCH_ENTRIES, KAWASAKI_DISPATCH_COUNT, state, maskShift);
+}
+
+uint32_t Kawasaki_decodeBatch(const CAN_Frame_t* frames, size_t count, Vehicle_State_t* state) {
+    return CAN_Dispatch_decodeBatch(KAWASAKI_DISPATCH_ENTRIES, KAWASAKI_DISPATCH_COUNT, frames, count, state);
+}
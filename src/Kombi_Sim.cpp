@@ -0,0 +1,125 @@
+#ifndef ARDUINO_ARCH_ESP32
+
+#include "Kombi_Sim.h"
+#include "ISOTP.h"
+#include <Arduino.h>
+#include <string.h>
+
+static bool Kombi_Sim_sendFrame(Kombi_Sim_t* sim, const uint8_t* payload, uint8_t len) {
+    uint8_t frame[8];
+    memset(frame, 0x00, sizeof(frame));
+    frame[0] = BMW_DIAG_TESTER_ADDRESS;
+    memcpy(&frame[1], payload, len);
+    if (!CAN_Mock_inject(sim->mock, BMW_DIAG_KOMBI_RESPONSE_ID, sizeof(frame), frame)) {
+        return false;
+    }
+    sim->framesSent++;
+    return true;
+}
+
+static void Kombi_Sim_prepare(Kombi_Sim_t* sim, const uint8_t* request, uint8_t len) {
+    if (len >= 2 && request[0] == DIAG_KWP_READ_ECU_ID && request[1] == DIAG_KWP_ECU_ID_VIN) {
+        sim->response[0] = DIAG_KWP_POSITIVE_RESPONSE(DIAG_KWP_READ_ECU_ID);
+        sim->response[1] = DIAG_KWP_ECU_ID_VIN;
+        memcpy(&sim->response[2], sim->vin, BMW_VIN_LENGTH);
+        sim->responseLen = 2 + BMW_VIN_LENGTH;
+    } else {
+        sim->response[0] = DIAG_KWP_NEGATIVE_RESPONSE;
+        sim->response[1] = request[0];
+        sim->response[2] = 0x12;    // subFunctionNotSupported
+        sim->responseLen = 3;
+    }
+    sim->state = KOMBI_SIM_RESPONSE_DUE;
+    sim->dueMs = millis() + sim->latencyMs;
+}
+
+static void Kombi_Sim_onSend(void* hookCtx, uint32_t id, uint8_t len, const uint8_t* buf) {
+    Kombi_Sim_t* sim = (Kombi_Sim_t*)hookCtx;
+    if (id != BMW_DIAG_REQUEST_ID || len < 2 || buf[0] != BMW_DIAG_KOMBI_ADDRESS) {
+        return;
+    }
+    uint8_t pci = buf[1];
+    switch (pci & 0xF0) {
+        case ISOTP_PCI_SINGLE:
+            // The cluster handles one request at a time and drops requests while busy
+            if (sim->state == KOMBI_SIM_IDLE && (pci & 0x0F) > 0 && (pci & 0x0F) <= len - 2) {
+                sim->requests++;
+                Kombi_Sim_prepare(sim, &buf[2], pci & 0x0F);
+            }
+            break;
+        case ISOTP_PCI_FLOW_CONTROL:
+            if (sim->state != KOMBI_SIM_WAIT_FLOW_CONTROL || len < 4) {
+                break;
+            }
+            sim->flowControls++;
+            if ((pci & 0x0F) == ISOTP_FC_CONTINUE) {
+                sim->blockSize = buf[2];
+                sim->blockLeft = buf[2];
+                sim->stMinMs = buf[3] <= 0x7F ? buf[3] : 1;    // Sub-millisecond values round up
+                sim->dueMs = millis();
+                sim->state = KOMBI_SIM_SENDING;
+            } else if ((pci & 0x0F) == ISOTP_FC_OVERFLOW) {
+                sim->state = KOMBI_SIM_IDLE;
+            }
+            break;
+    }
+}
+
+void Kombi_Sim_init(Kombi_Sim_t* sim, CAN_Mock_t* mock, const char* vin, uint16_t latencyMs) {
+    memset(sim, 0, sizeof(*sim));
+    sim->mock = mock;
+    sim->latencyMs = latencyMs;
+    strncpy(sim->vin, vin, BMW_VIN_LENGTH);
+    for (size_t i = strlen(sim->vin); i < BMW_VIN_LENGTH; i++) {
+        sim->vin[i] = '0';
+    }
+    sim->state = KOMBI_SIM_IDLE;
+    CAN_Mock_addSendHook(mock, Kombi_Sim_onSend, sim);
+}
+
+void Kombi_Sim_step(Kombi_Sim_t* sim) {
+    unsigned long now = millis();
+    uint8_t payload[7];
+
+    if (sim->state == KOMBI_SIM_RESPONSE_DUE && (long)(now - sim->dueMs) >= 0) {
+        if (sim->responseLen <= 6) {
+            payload[0] = (uint8_t)(ISOTP_PCI_SINGLE | sim->responseLen);
+            memcpy(&payload[1], sim->response, sim->responseLen);
+            if (Kombi_Sim_sendFrame(sim, payload, (uint8_t)(sim->responseLen + 1))) {
+                sim->state = KOMBI_SIM_IDLE;
+            }
+            return;
+        }
+        // Extended addressing leaves 5 data bytes in the first frame
+        payload[0] = (uint8_t)(ISOTP_PCI_FIRST | (sim->responseLen >> 8));
+        payload[1] = (uint8_t)sim->responseLen;
+        memcpy(&payload[2], sim->response, 5);
+        if (Kombi_Sim_sendFrame(sim, payload, 7)) {
+            sim->responsePos = 5;
+            sim->seq = 1;
+            sim->state = KOMBI_SIM_WAIT_FLOW_CONTROL;
+        }
+        return;
+    }
+
+    while (sim->state == KOMBI_SIM_SENDING && (long)(now - sim->dueMs) >= 0) {
+        uint16_t left = (uint16_t)(sim->responseLen - sim->responsePos);
+        uint8_t n = left < 6 ? (uint8_t)left : 6;
+        payload[0] = (uint8_t)(ISOTP_PCI_CONSECUTIVE | sim->seq);
+        memcpy(&payload[1], &sim->response[sim->responsePos], n);
+        if (!Kombi_Sim_sendFrame(sim, payload, (uint8_t)(n + 1))) {
+            return;     // Inject queue full, retry next step
+        }
+        sim->responsePos += n;
+        sim->seq = (uint8_t)((sim->seq + 1) & 0x0F);
+        sim->dueMs = now + sim->stMinMs;
+
+        if (sim->responsePos >= sim->responseLen) {
+            sim->state = KOMBI_SIM_IDLE;
+        } else if (sim->blockSize > 0 && --sim->blockLeft == 0) {
+            sim->state = KOMBI_SIM_WAIT_FLOW_CONTROL;
+        }
+    }
+}
+
+#endif // ARDUINO_ARCH_ESP32
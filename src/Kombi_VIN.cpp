@@ -0,0 +1,115 @@
+#include "Kombi_VIN.h"
+#include "Vehicle_State.h"
+#include <Arduino.h>
+#include <string.h>
+
+static void Kombi_VIN_finish(Kombi_VIN_t* reader, const char* error) {
+    // The console reads error and vin only after seeing the new status
+    reader->waiting = false;
+    reader->elapsedMs = millis() - reader->sentMs;
+    reader->error = error;
+    if (error != nullptr) {
+        reader->failures++;
+    }
+    reader->status.store(error == nullptr ? KOMBI_VIN_DONE : KOMBI_VIN_FAILED);
+}
+
+static uint32_t Kombi_VIN_onResponse(void* readerCtx, ISOTP_Result_t result, const uint8_t* data, uint16_t len) {
+    Kombi_VIN_t* reader = (Kombi_VIN_t*)readerCtx;
+    if (!reader->waiting) {
+        return 0;
+    }
+    if (result != ISOTP_RESULT_RECEIVED) {
+        Kombi_VIN_finish(reader, "transport error");
+        return 0;
+    }
+    if (len >= 3 && data[0] == DIAG_KWP_NEGATIVE_RESPONSE && data[1] == DIAG_KWP_READ_ECU_ID) {
+        reader->negativeCode = data[2];
+        Kombi_VIN_finish(reader, "negative response");
+        return 0;
+    }
+    if (len < 2 + BMW_VIN_LENGTH || data[0] != DIAG_KWP_POSITIVE_RESPONSE(DIAG_KWP_READ_ECU_ID) ||
+        data[1] != DIAG_KWP_ECU_ID_VIN) {
+        Kombi_VIN_finish(reader, "invalid response");
+        return 0;
+    }
+    for (int i = 0; i < BMW_VIN_LENGTH; i++) {
+        if (data[2 + i] < 0x20 || data[2 + i] > 0x7E) {
+            Kombi_VIN_finish(reader, "invalid response");
+            return 0;
+        }
+    }
+
+    memcpy(reader->vin, &data[2], BMW_VIN_LENGTH);
+    reader->vin[BMW_VIN_LENGTH] = '\0';
+    BMW_Kombi_t* kombi = reader->bmw->kombi;
+    memcpy(kombi->vin, reader->vin, sizeof(kombi->vin));
+    kombi->vinReceived = true;
+    Vehicle_State_set(reader->bmw->state, VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_VIN, 1);
+    Kombi_VIN_finish(reader, nullptr);
+    return 1u << BMW_SIGNAL_VIN;
+}
+
+bool Kombi_VIN_init(Kombi_VIN_t* reader, ISOTP_t* isotp, BMW_CAN_Context_t* bmw_ctx) {
+    reader->isotp = isotp;
+    reader->bmw = bmw_ctx;
+    reader->requested.store(false);
+    reader->status.store(KOMBI_VIN_IDLE);
+    reader->waiting = false;
+    reader->sentMs = 0;
+    reader->elapsedMs = 0;
+    reader->error = nullptr;
+    reader->negativeCode = 0;
+    reader->vin[0] = '\0';
+    reader->requests = 0;
+    reader->failures = 0;
+    reader->session = ISOTP_open(isotp, BMW_DIAG_REQUEST_ID, BMW_DIAG_KOMBI_ADDRESS, BMW_DIAG_KOMBI_RESPONSE_ID, BMW_DIAG_TESTER_ADDRESS,
+                                 reader->response, sizeof(reader->response), Kombi_VIN_onResponse, reader);
+    return reader->session != nullptr;
+}
+
+void Kombi_VIN_request(Kombi_VIN_t* reader) {
+    // Safe from any task, picked up by the next Kombi_VIN_step()
+    reader->requested.store(true);
+}
+
+void Kombi_VIN_step(Kombi_VIN_t* reader) {
+    if (reader->session == nullptr) {
+        return;
+    }
+    if (reader->requested.exchange(false) && !reader->waiting) {
+        uint8_t request[2] = {DIAG_KWP_READ_ECU_ID, DIAG_KWP_ECU_ID_VIN};
+        reader->requests++;
+        reader->sentMs = millis();
+        reader->waiting = true;
+        reader->negativeCode = 0;
+        reader->status.store(KOMBI_VIN_PENDING);
+        if (!ISOTP_send(reader->isotp, reader->session, request, sizeof(request))) {
+            Kombi_VIN_finish(reader, "send failed");
+        }
+        return;
+    }
+
+    // Once the cluster is sending consecutive frames the ISO-TP timeouts apply
+    if (reader->waiting && reader->session->rxExpected == 0 && millis() - reader->sentMs > KOMBI_VIN_TIMEOUT_MS) {
+        Kombi_VIN_finish(reader, "no answer");
+    }
+}
+
+bool Kombi_VIN_report(Kombi_VIN_t* reader) {
+    // Prints the outcome of a finished request once, called from the console task
+    uint8_t status = reader->status.load();
+    if (status != KOMBI_VIN_DONE && status != KOMBI_VIN_FAILED) {
+        return false;
+    }
+    if (status == KOMBI_VIN_DONE) {
+        Serial.printf("VIN: %s (%lu ms)\n", reader->vin, reader->elapsedMs);
+    } else if (reader->negativeCode != 0) {
+        Serial.printf("VIN request failed: negative response 0x%02X\n", reader->negativeCode);
+    } else {
+        Serial.printf("VIN request failed: %s\n", reader->error);
+    }
+    // A new request may already be pending, leave its status alone
+    reader->status.compare_exchange_strong(status, KOMBI_VIN_IDLE);
+    return true;
+}
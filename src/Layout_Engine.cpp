@@ -0,0 +1,854 @@
+#include "Layout_Engine.h"
+#include <Arduino.h>
+#include <string.h>
+#include <limits.h>
+#include "Layout_Default.h"
+
+static_assert(sizeof(LAYOUT_DEFAULT_PACK) <= LAYOUT_MAX_FILE_SIZE, "Built-in layout exceeds the file buffer");
+static_assert(LAYOUT_MAX_SCREEN_WIDGETS <= 32, "Overlap masks hold a bit per widget of a screen");
+
+// Characters a value field may draw
+#define LAYOUT_VALUE_CHARSET " -?0123456789"
+
+// What a widget shows on the next draw
+enum {
+    LAYOUT_HIDDEN,          // Its show indicator is not raised
+    LAYOUT_BLINK_OFF,       // Off phase of a blink: a bar or meter keeps its frame
+    LAYOUT_SHOWN
+};
+
+static void Layout_Engine_drawWidget(Layout_Engine_t* engine, const Layout_Widget_t* widget);
+
+void Layout_Engine_init(Layout_Engine_t* engine, U8G2* display, Glyph_Atlas_t* atlas, const Vehicle_State_t* state,
+                        const Alert_Engine_t* alerts, Signal_History_t* history) {
+    memset(engine, 0, sizeof(*engine));
+    engine->display = display;
+    engine->atlas = atlas;
+    engine->state = state;
+    engine->alerts = alerts;
+    engine->history = history;
+    engine->drawnScreen = -1;
+}
+
+int Layout_Engine_addFont(Layout_Engine_t* engine, const char* name, const uint8_t* font) {
+    // Fonts a pack can name, returns the handle or -1 when full
+    if (engine->fontCount >= LAYOUT_MAX_FONTS) {
+        return -1;
+    }
+    Layout_Font_t* entry = &engine->fonts[engine->fontCount];
+    entry->name = name;
+    entry->font = font;
+    entry->atlasFont = -1;
+    return engine->fontCount++;
+}
+
+int Layout_Engine_addIcon(Layout_Engine_t* engine, const char* name, Layout_IconFunction_t draw) {
+    // Icons a pack can name, returns the handle or -1 when full
+    if (engine->iconCount >= LAYOUT_MAX_ICONS) {
+        return -1;
+    }
+    Layout_Icon_t* entry = &engine->icons[engine->iconCount];
+    entry->name = name;
+    entry->draw = draw;
+    entry->sprite = -1;
+    return engine->iconCount++;
+}
+
+// === LOADING ===
+static uint16_t Layout_Engine_read16(const uint8_t* data) {
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t Layout_Engine_read32(const uint8_t* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static bool Layout_Engine_reject(const Layout_Engine_t* engine, const char* reason, const char* name) {
+    Serial.printf("Layout %s rejected: %s%s%s\n", engine->source, reason, *name != '\0' ? " " : "", name);
+    return false;
+}
+
+static const char* Layout_Engine_string(const char* const* strings, uint8_t count, uint8_t index) {
+    return index < count ? strings[index] : nullptr;
+}
+
+static int Layout_Engine_findFont(const Layout_Engine_t* engine, const char* name) {
+    for (int i = 0; name != nullptr && i < engine->fontCount; i++) {
+        if (strcmp(engine->fonts[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int Layout_Engine_findIcon(const Layout_Engine_t* engine, const char* name) {
+    for (int i = 0; name != nullptr && i < engine->iconCount; i++) {
+        if (strcmp(engine->icons[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool Layout_Engine_parseTemplate(const Layout_Engine_t* engine, Layout_Widget_t* widget,
+                                        const char* const* strings, uint8_t stringCount) {
+    // Resolves the signal of every field and checks the filled-in text fits LAYOUT_TEXT_SIZE
+    size_t length = 0;
+    widget->fieldCount = 0;
+    for (const char* c = widget->text; *c != '\0'; c++) {
+        if (*c != LAYOUT_FIELD_MARK) {
+            length++;
+            continue;
+        }
+        if (c[1] == '\0' || c[2] == '\0') {
+            return Layout_Engine_reject(engine, "truncated template field", "");
+        }
+        const char* name = Layout_Engine_string(strings, stringCount, (uint8_t)c[1] - 1);
+        int signal = name != nullptr ? Vehicle_State_findSignal(name) : -1;
+        if (signal < 0) {
+            return Layout_Engine_reject(engine, "unknown signal", name != nullptr ? name : "");
+        }
+        if (widget->fieldCount >= LAYOUT_MAX_FIELDS) {
+            return Layout_Engine_reject(engine, "too many fields in", widget->text);
+        }
+        widget->fields[widget->fieldCount++] = (uint8_t)signal;
+        uint8_t width = (uint8_t)c[2] - 1;
+        length += width > LAYOUT_VALUE_CHARS ? width : LAYOUT_VALUE_CHARS;
+        c += 2;
+    }
+    if (length >= LAYOUT_TEXT_SIZE) {
+        return Layout_Engine_reject(engine, "template too long", "");
+    }
+    return true;
+}
+
+static bool Layout_Engine_parseWidget(Layout_Engine_t* engine, Layout_Widget_t* widget, const uint8_t* data,
+                                      const char* const* strings, uint8_t stringCount, uint8_t segmentCount) {
+    memset(widget, 0, sizeof(*widget));
+    if (data[0] >= LAYOUT_WIDGET_TYPE_COUNT) {
+        return Layout_Engine_reject(engine, "unknown widget type", "");
+    }
+    widget->type = (Layout_WidgetType_t)data[0];
+    widget->flags = data[1];
+    widget->x = (int16_t)Layout_Engine_read16(data + 2);
+    widget->y = (int16_t)Layout_Engine_read16(data + 4);
+    widget->w = (int16_t)Layout_Engine_read16(data + 6);
+    widget->h = (int16_t)Layout_Engine_read16(data + 8);
+    const char* ref = Layout_Engine_string(strings, stringCount, data[10]);
+    const char* text = Layout_Engine_string(strings, stringCount, data[11]);
+    const char* show = Layout_Engine_string(strings, stringCount, data[12]);
+    const char* blink = Layout_Engine_string(strings, stringCount, data[13]);
+    widget->periodMs = Layout_Engine_read16(data + 14);
+    widget->min = (int16_t)Layout_Engine_read16(data + 16);
+    widget->max = (int16_t)Layout_Engine_read16(data + 18);
+    widget->spanMs = Layout_Engine_read32(data + 20);
+    widget->history = -1;
+
+    switch (widget->type) {
+        case LAYOUT_WIDGET_LABEL:
+        case LAYOUT_WIDGET_VALUE: {
+            int font = Layout_Engine_findFont(engine, ref);
+            if (font < 0) {
+                return Layout_Engine_reject(engine, "unknown font", ref != nullptr ? ref : "");
+            }
+            if (text == nullptr) {
+                return Layout_Engine_reject(engine, "text missing", "");
+            }
+            widget->font = (uint8_t)font;
+            widget->text = text;
+            if (widget->type == LAYOUT_WIDGET_VALUE && !Layout_Engine_parseTemplate(engine, widget, strings, stringCount)) {
+                return false;
+            }
+            break;
+        }
+        case LAYOUT_WIDGET_BAR:
+        case LAYOUT_WIDGET_METER:
+        case LAYOUT_WIDGET_SPARK: {
+            int signal = ref != nullptr ? Vehicle_State_findSignal(ref) : -1;
+            if (signal < 0) {
+                return Layout_Engine_reject(engine, "unknown signal", ref != nullptr ? ref : "");
+            }
+            widget->signal = (uint8_t)signal;
+            if (widget->type == LAYOUT_WIDGET_METER) {
+                // min and max carry the segment range
+                if (widget->min < 0 || widget->max < 1 || widget->min + widget->max > segmentCount) {
+                    return Layout_Engine_reject(engine, "meter segments out of range", "");
+                }
+                widget->firstSegment = (uint8_t)widget->min;
+                widget->segmentCount = (uint8_t)widget->max;
+            } else if (widget->min >= widget->max) {
+                return Layout_Engine_reject(engine, "empty range for", ref);
+            }
+            if (widget->type == LAYOUT_WIDGET_SPARK) {
+                // Graphs share the series main records, a signal nobody records gets one if there is room
+                int series = Signal_History_find(engine->history, widget->signal);
+                if (series < 0) {
+                    series = Signal_History_register(engine->history, Vehicle_State_signalName(widget->signal), widget->signal);
+                }
+                if (series < 0 || widget->spanMs == 0) {
+                    return Layout_Engine_reject(engine, "no history series for", ref);
+                }
+                widget->history = (int8_t)series;
+            }
+            break;
+        }
+        case LAYOUT_WIDGET_ICON: {
+            int icon = Layout_Engine_findIcon(engine, ref);
+            if (icon < 0) {
+                return Layout_Engine_reject(engine, "unknown icon", ref != nullptr ? ref : "");
+            }
+            widget->icon = (uint8_t)icon;
+            break;
+        }
+        default:
+            break;
+    }
+
+    int showIndicator = show != nullptr ? Alert_Engine_findIndicator(show) : ALERT_INDICATOR_NONE;
+    int blinkIndicator = blink != nullptr ? Alert_Engine_findIndicator(blink) : ALERT_INDICATOR_NONE;
+    if (showIndicator < 0 || blinkIndicator < 0) {
+        return Layout_Engine_reject(engine, "unknown indicator", showIndicator < 0 ? show : blink);
+    }
+    widget->show = (Alert_Indicator_t)showIndicator;
+    widget->blink = (Alert_Indicator_t)blinkIndicator;
+    if ((widget->blink != ALERT_INDICATOR_NONE || (widget->flags & LAYOUT_FLAG_BLINK_FULL)) && widget->periodMs == 0) {
+        return Layout_Engine_reject(engine, "blinking without a period", "");
+    }
+    return true;
+}
+
+static bool Layout_Engine_addChar(char* charset, char c) {
+    if (strchr(charset, c) != nullptr) {
+        return true;
+    }
+    size_t length = strlen(charset);
+    if (length >= GLYPH_ATLAS_MAX_GLYPHS) {
+        return false;
+    }
+    charset[length] = c;
+    charset[length + 1] = '\0';
+    return true;
+}
+
+static void Layout_Engine_buildAtlas(Layout_Engine_t* engine) {
+    // Icons and the glyphs of the value templates, rasterised again for every pack. A font whose
+    // templates need more than GLYPH_ATLAS_MAX_GLYPHS characters stays with U8g2.
+    Glyph_Atlas_t* atlas = engine->atlas;
+    bool enabled = atlas->enabled;
+    Glyph_Atlas_init(atlas, engine->display);
+    atlas->enabled = enabled;
+    for (uint8_t i = 0; i < engine->iconCount; i++) {
+        engine->icons[i].sprite = (int8_t)Glyph_Atlas_addSprite(atlas, engine->icons[i].draw);
+    }
+    for (uint8_t f = 0; f < engine->fontCount; f++) {
+        char charset[GLYPH_ATLAS_MAX_GLYPHS + 1] = "";
+        bool used = false;
+        bool fits = true;
+        for (uint8_t w = 0; w < engine->widgetCount; w++) {
+            const Layout_Widget_t* widget = &engine->widgets[w];
+            if (widget->type != LAYOUT_WIDGET_VALUE || widget->font != f) {
+                continue;
+            }
+            used = true;
+            for (const char* c = widget->fieldCount > 0 ? LAYOUT_VALUE_CHARSET : ""; *c != '\0'; c++) {
+                fits = fits && Layout_Engine_addChar(charset, *c);
+            }
+            for (const char* c = widget->text; *c != '\0'; c++) {
+                if (*c == LAYOUT_FIELD_MARK) {
+                    c += 2;
+                } else {
+                    fits = fits && Layout_Engine_addChar(charset, *c);
+                }
+            }
+        }
+        engine->fonts[f].atlasFont = used && fits ? (int8_t)Glyph_Atlas_addFont(atlas, engine->fonts[f].font, charset) : -1;
+    }
+}
+
+// === BOXES ===
+static Layout_Box_t Layout_Engine_clip(const Layout_Engine_t* engine, int x0, int y0, int x1, int y1) {
+    const int width = engine->display->getBufferTileWidth() * 8;
+    const int height = engine->display->getBufferTileHeight() * 8;
+    Layout_Box_t box = {0, 0, 0, 0};
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 > width ? width : x1;
+    y1 = y1 > height ? height : y1;
+    if (x0 < x1 && y0 < y1) {
+        box = {(int16_t)x0, (int16_t)y0, (int16_t)x1, (int16_t)y1};
+    }
+    return box;
+}
+
+static Layout_Box_t Layout_Engine_measure(Layout_Engine_t* engine, const Layout_Widget_t* widget) {
+    // Pixels a fixed widget sets or clears: drawn on a clear and on a filled buffer
+    U8G2* display = engine->display;
+    uint8_t* buffer = display->getBufferPtr();
+    const int width = display->getBufferTileWidth() * 8;
+    const int pages = display->getBufferTileHeight();
+    const size_t size = (size_t)width * pages;
+    static uint8_t ink[DISPLAY_RENDERER_BUFFER_SIZE];
+    if (size > sizeof(ink)) {
+        return Layout_Engine_clip(engine, 0, 0, INT16_MAX, INT16_MAX);
+    }
+    Layout_Widget_t shown = *widget;
+    shown.visibility = LAYOUT_SHOWN;
+    memset(buffer, 0x00, size);
+    Layout_Engine_drawWidget(engine, &shown);
+    memcpy(ink, buffer, size);
+    memset(buffer, 0xFF, size);
+    Layout_Engine_drawWidget(engine, &shown);
+
+    int x0 = width, y0 = pages * 8, x1 = 0, y1 = 0;
+    for (int page = 0; page < pages; page++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t touched = (uint8_t)(ink[page * width + x] | ~buffer[page * width + x]);
+            if (touched == 0) {
+                continue;
+            }
+            x0 = x < x0 ? x : x0;
+            x1 = x + 1 > x1 ? x + 1 : x1;
+            int top = page * 8 + __builtin_ctz(touched);
+            int bottom = page * 8 + 32 - __builtin_clz(touched);
+            y0 = top < y0 ? top : y0;
+            y1 = bottom > y1 ? bottom : y1;
+        }
+    }
+    memset(buffer, 0x00, size);
+    return Layout_Engine_clip(engine, x0, y0, x1, y1);
+}
+
+static void Layout_Engine_include(int* box, int x0, int y0, int x1, int y1) {
+    box[0] = x0 < box[0] ? x0 : box[0];
+    box[1] = y0 < box[1] ? y0 : box[1];
+    box[2] = x1 > box[2] ? x1 : box[2];
+    box[3] = y1 > box[3] ? y1 : box[3];
+}
+
+static Layout_Box_t Layout_Engine_valueBox(Layout_Engine_t* engine, const Layout_Widget_t* widget) {
+    // Every glyph the template can draw, from the atlas bounds: a field holds max(width, 1) to
+    // max(width, LAYOUT_VALUE_CHARS) characters. Without bounds the widget may touch the whole panel.
+    const Layout_Box_t panel = Layout_Engine_clip(engine, 0, 0, INT16_MAX, INT16_MAX);
+    const int8_t font = engine->fonts[widget->font].atlasFont;
+    if (font < 0) {
+        return panel;
+    }
+
+    // Union of the field characters, relative to the pen
+    int field[4] = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    int minAdvance = INT_MAX, maxAdvance = 0;
+    Glyph_Atlas_Bounds_t bounds;
+    for (const char* c = widget->fieldCount > 0 ? LAYOUT_VALUE_CHARSET : ""; *c != '\0'; c++) {
+        if (!Glyph_Atlas_glyphBounds(engine->atlas, (uint8_t)font, (uint8_t)*c, &bounds)) {
+            return panel;
+        }
+        minAdvance = bounds.advance < minAdvance ? bounds.advance : minAdvance;
+        maxAdvance = bounds.advance > maxAdvance ? bounds.advance : maxAdvance;
+        if (bounds.right > bounds.left) {
+            Layout_Engine_include(field, bounds.left, bounds.top, bounds.right, bounds.bottom);
+        }
+    }
+
+    int box[4] = {INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+    int penMin = widget->x;
+    int penMax = widget->x;
+    for (const char* c = widget->text; *c != '\0'; c++) {
+        if (*c == LAYOUT_FIELD_MARK) {
+            int width = (uint8_t)c[2] - 1;
+            int minChars = width > 1 ? width : 1;
+            int maxChars = width > LAYOUT_VALUE_CHARS ? width : LAYOUT_VALUE_CHARS;
+            if (field[2] > field[0]) {
+                Layout_Engine_include(box, penMin + field[0], widget->y + field[1],
+                                      penMax + (maxChars - 1) * maxAdvance + field[2], widget->y + field[3]);
+            }
+            penMin += minChars * minAdvance;
+            penMax += maxChars * maxAdvance;
+            c += 2;
+            continue;
+        }
+        if (!Glyph_Atlas_glyphBounds(engine->atlas, (uint8_t)font, (uint8_t)*c, &bounds)) {
+            return panel;
+        }
+        if (bounds.right > bounds.left) {
+            Layout_Engine_include(box, penMin + bounds.left, widget->y + bounds.top,
+                                  penMax + bounds.right, widget->y + bounds.bottom);
+        }
+        penMin += bounds.advance;
+        penMax += bounds.advance;
+    }
+    return Layout_Engine_clip(engine, box[0], box[1], box[2], box[3]);
+}
+
+static Layout_Box_t Layout_Engine_widgetBox(Layout_Engine_t* engine, const Layout_Widget_t* widget) {
+    switch (widget->type) {
+        case LAYOUT_WIDGET_LABEL:
+        case LAYOUT_WIDGET_ICON:
+            return Layout_Engine_measure(engine, widget);
+        case LAYOUT_WIDGET_VALUE:
+            return Layout_Engine_valueBox(engine, widget);
+        case LAYOUT_WIDGET_METER: {
+            int tallest = 0;
+            for (uint8_t i = 0; i < widget->segmentCount; i++) {
+                int height = engine->segments[widget->firstSegment + i].height;
+                tallest = height > tallest ? height : tallest;
+            }
+            int width = widget->segmentCount * widget->w + (widget->segmentCount - 1) * widget->h;
+            return Layout_Engine_clip(engine, widget->x, widget->y - tallest, widget->x + width, widget->y);
+        }
+        default:
+            return Layout_Engine_clip(engine, widget->x, widget->y, widget->x + widget->w, widget->y + widget->h);
+    }
+}
+
+static bool Layout_Engine_overlap(const Layout_Box_t* a, const Layout_Box_t* b) {
+    return a->x0 < b->x1 && b->x0 < a->x1 && a->y0 < b->y1 && b->y0 < a->y1;
+}
+
+static bool Layout_Engine_parse(Layout_Engine_t* engine) {
+    // Checks the whole pack before any of it is used, names are resolved against the firmware
+    const uint8_t* file = engine->file;
+    if (engine->fileSize < LAYOUT_HEADER_SIZE || memcmp(file, LAYOUT_MAGIC, 4) != 0 || file[4] != LAYOUT_VERSION) {
+        return Layout_Engine_reject(engine, "not a version 1 layout pack", "");
+    }
+    const uint8_t screenCount = file[5];
+    const uint8_t widgetCount = file[6];
+    const uint8_t segmentCount = file[7];
+    const uint8_t stringCount = file[8];
+    const uint16_t stringBytes = Layout_Engine_read16(file + 10);
+    if (screenCount == 0 || screenCount > LAYOUT_MAX_SCREENS || widgetCount > LAYOUT_MAX_WIDGETS ||
+        segmentCount > LAYOUT_MAX_SEGMENTS || stringCount > LAYOUT_MAX_STRINGS) {
+        return Layout_Engine_reject(engine, "too many screens, widgets, segments or strings", "");
+    }
+    const uint8_t* strings = file + LAYOUT_HEADER_SIZE;
+    const uint8_t* screens = strings + stringBytes;
+    const uint8_t* widgets = screens + screenCount * LAYOUT_SCREEN_SIZE;
+    const uint8_t* segments = widgets + widgetCount * LAYOUT_WIDGET_SIZE;
+    if (segments + segmentCount * LAYOUT_SEGMENT_SIZE != file + engine->fileSize) {
+        return Layout_Engine_reject(engine, "size does not match the header", "");
+    }
+
+    // Strings back to back, each NUL-terminated
+    const char* names[LAYOUT_MAX_STRINGS];
+    uint8_t nameCount = 0;
+    for (const uint8_t* p = strings; p < screens; nameCount++) {
+        const uint8_t* end = (const uint8_t*)memchr(p, '\0', (size_t)(screens - p));
+        if (end == nullptr || nameCount >= stringCount) {
+            return Layout_Engine_reject(engine, "malformed strings", "");
+        }
+        names[nameCount] = (const char*)p;
+        p = end + 1;
+    }
+    if (nameCount != stringCount) {
+        return Layout_Engine_reject(engine, "malformed strings", "");
+    }
+
+    uint8_t firstWidget = 0;
+    for (uint8_t s = 0; s < screenCount; s++) {
+        Layout_Screen_t* screen = &engine->screens[s];
+        screen->name = Layout_Engine_string(names, stringCount, screens[s * LAYOUT_SCREEN_SIZE]);
+        screen->firstWidget = firstWidget;
+        screen->widgetCount = screens[s * LAYOUT_SCREEN_SIZE + 1];
+        screen->signals = 0;
+        if (screen->name == nullptr || screen->widgetCount > LAYOUT_MAX_SCREEN_WIDGETS ||
+            firstWidget + screen->widgetCount > widgetCount) {
+            return Layout_Engine_reject(engine, "malformed screen table", "");
+        }
+        engine->screenNames[s] = screen->name;
+        firstWidget += screen->widgetCount;
+    }
+    if (firstWidget != widgetCount) {
+        return Layout_Engine_reject(engine, "widgets outside the screens", "");
+    }
+
+    for (uint8_t i = 0; i < segmentCount; i++) {
+        engine->segments[i].threshold = (int16_t)Layout_Engine_read16(segments + i * LAYOUT_SEGMENT_SIZE);
+        engine->segments[i].height = segments[i * LAYOUT_SEGMENT_SIZE + 2];
+    }
+    for (uint8_t i = 0; i < widgetCount; i++) {
+        if (!Layout_Engine_parseWidget(engine, &engine->widgets[i], widgets + i * LAYOUT_WIDGET_SIZE,
+                                       names, stringCount, segmentCount)) {
+            return false;
+        }
+    }
+    engine->widgetCount = widgetCount;
+    engine->segmentCount = segmentCount;
+
+    // Glyph bounds come from the atlas, so the boxes follow it
+    Layout_Engine_buildAtlas(engine);
+    for (uint8_t s = 0; s < screenCount; s++) {
+        Layout_Screen_t* screen = &engine->screens[s];
+        Layout_Widget_t* first = &engine->widgets[screen->firstWidget];
+        for (uint8_t i = 0; i < screen->widgetCount; i++) {
+            Layout_Widget_t* widget = &first[i];
+            widget->box = Layout_Engine_widgetBox(engine, widget);
+            for (uint8_t f = 0; f < widget->fieldCount; f++) {
+                screen->signals |= 1u << widget->fields[f];
+            }
+            if (widget->type == LAYOUT_WIDGET_BAR || widget->type == LAYOUT_WIDGET_METER || widget->type == LAYOUT_WIDGET_SPARK) {
+                screen->signals |= 1u << widget->signal;
+            }
+        }
+        for (uint8_t i = 0; i < screen->widgetCount; i++) {
+            for (uint8_t j = 0; j < screen->widgetCount; j++) {
+                if (i != j && Layout_Engine_overlap(&first[i].box, &first[j].box)) {
+                    first[i].overlaps |= 1u << j;
+                }
+            }
+        }
+    }
+    engine->screenCount = screenCount;
+    return true;
+}
+
+bool Layout_Engine_load(Layout_Engine_t* engine, File file) {
+    // Replaces the screens with a compiled pack, false (and no screens) when it is rejected
+    engine->screenCount = 0;
+    engine->drawnScreen = -1;
+    if (!file) {
+        return false;
+    }
+    strncpy(engine->source, file.path(), sizeof(engine->source) - 1);
+    engine->source[sizeof(engine->source) - 1] = '\0';
+    size_t size = file.size();
+    if (size > LAYOUT_MAX_FILE_SIZE) {
+        file.close();
+        return Layout_Engine_reject(engine, "larger than the file buffer", "");
+    }
+    engine->fileSize = file.read(engine->file, size);
+    file.close();
+    return Layout_Engine_parse(engine);
+}
+
+void Layout_Engine_loadDefaults(Layout_Engine_t* engine) {
+    // The pack compiled from assets/screens.layout
+    engine->screenCount = 0;
+    engine->drawnScreen = -1;
+    strcpy(engine->source, "built-in");
+    memcpy(engine->file, LAYOUT_DEFAULT_PACK, sizeof(LAYOUT_DEFAULT_PACK));
+    engine->fileSize = sizeof(LAYOUT_DEFAULT_PACK);
+    Layout_Engine_parse(engine);
+}
+
+void Layout_Engine_invalidate(Layout_Engine_t* engine) {
+    // Someone else drew into the frame buffer, the next draw is a full one
+    engine->drawnScreen = -1;
+}
+
+uint32_t Layout_Engine_screenSignals(const Layout_Engine_t* engine, int screen) {
+    return (screen >= 0 && screen < engine->screenCount) ? engine->screens[screen].signals : 0;
+}
+
+// === STATE ===
+static uint8_t Layout_Engine_visibility(const Layout_Engine_t* engine, const Layout_Widget_t* widget, bool blinking) {
+    // Blink phases come from the clock, so an unchanged screen keeps blinking without bookkeeping
+    if (widget->show != ALERT_INDICATOR_NONE && !Alert_Engine_indicator(engine->alerts, widget->show)) {
+        return LAYOUT_HIDDEN;
+    }
+    if (blinking && ((engine->nowMs / widget->periodMs) & 1) == 0) {
+        return LAYOUT_BLINK_OFF;
+    }
+    return LAYOUT_SHOWN;
+}
+
+uint32_t Layout_Engine_prepare(Layout_Engine_t* engine, int screen, uint32_t nowMs) {
+    // Works out what every widget of screen shows at nowMs, returns a key of the whole screen state
+    engine->screen = screen;
+    engine->nowMs = nowMs;
+    uint32_t frameKey = DISPLAY_RENDERER_KEY_SEED;
+    if (screen < 0 || screen >= engine->screenCount) {
+        return frameKey;
+    }
+    const Vehicle_State_t* state = engine->state;
+    const Layout_Screen_t* entry = &engine->screens[screen];
+    for (uint8_t i = 0; i < entry->widgetCount; i++) {
+        Layout_Widget_t* widget = &engine->widgets[entry->firstWidget + i];
+        bool blinking = widget->blink != ALERT_INDICATOR_NONE && Alert_Engine_indicator(engine->alerts, widget->blink);
+        uint32_t key = DISPLAY_RENDERER_KEY_SEED;
+        widget->level = 0;
+        switch (widget->type) {
+            case LAYOUT_WIDGET_VALUE:
+                for (uint8_t f = 0; f < widget->fieldCount; f++) {
+                    Vehicle_ValueStatus_t status = Vehicle_State_status(state, widget->fields[f], nowMs);
+                    key = Display_Renderer_hash(key, status);
+                    if (status != VEHICLE_VALUE_MISSING) {
+                        key = Display_Renderer_hash(key, state->value[widget->fields[f]]);
+                    }
+                }
+                break;
+            case LAYOUT_WIDGET_BAR: {
+                int reading = Vehicle_State_reading(state, widget->signal, nowMs, 0);
+                widget->level = (int16_t)map(constrain(reading, widget->min, widget->max), widget->min, widget->max, 0, widget->w);
+                break;
+            }
+            case LAYOUT_WIDGET_METER: {
+                // A predicted reading moves between decoded frames, so the lit segments are the state
+                int reading = Vehicle_State_reading(state, widget->signal, nowMs, 0);
+                if ((widget->flags & LAYOUT_FLAG_PREDICT) && engine->predict != nullptr) {
+                    reading = engine->predict(widget->signal, reading);
+                }
+                const Layout_Segment_t* segments = &engine->segments[widget->firstSegment];
+                while (widget->level < widget->segmentCount && reading >= segments[widget->level].threshold) {
+                    widget->level++;
+                }
+                blinking = blinking || ((widget->flags & LAYOUT_FLAG_BLINK_FULL) && widget->level == widget->segmentCount);
+                break;
+            }
+            case LAYOUT_WIDGET_SPARK:
+                key = Display_Renderer_hash(key, (int32_t)engine->history->sampleCount);
+                break;
+            default:
+                break;
+        }
+        widget->visibility = Layout_Engine_visibility(engine, widget, blinking);
+        key = Display_Renderer_hash(key, widget->level);
+        widget->pendingKey = Display_Renderer_hash(key, widget->visibility);
+        frameKey = Display_Renderer_hash(frameKey, (int32_t)widget->pendingKey);
+    }
+    return frameKey;
+}
+
+// === DRAWING ===
+static void Layout_Engine_formatValue(const Layout_Engine_t* engine, const Layout_Widget_t* widget, char* out) {
+    // Fills in the template without printf: "87", "87?" when stale, "--" when missing,
+    // right-aligned in the field width
+    uint8_t field = 0;
+    for (const char* c = widget->text; *c != '\0'; c++) {
+        if (*c != LAYOUT_FIELD_MARK) {
+            *out++ = *c;
+            continue;
+        }
+        uint8_t signal = widget->fields[field++];
+        uint8_t width = (uint8_t)c[2] - 1;
+        c += 2;
+
+        char digits[LAYOUT_VALUE_CHARS + 1];
+        char* d = digits + sizeof(digits) - 1;
+        *d = '\0';
+        Vehicle_ValueStatus_t status = Vehicle_State_status(engine->state, signal, engine->nowMs);
+        if (status == VEHICLE_VALUE_MISSING) {
+            *--d = '-';
+            *--d = '-';
+        } else {
+            if (status == VEHICLE_VALUE_STALE) {
+                *--d = '?';
+            }
+            int16_t value = engine->state->value[signal];
+            uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+            do {
+                *--d = (char)('0' + magnitude % 10);
+                magnitude /= 10;
+            } while (magnitude != 0);
+            if (value < 0) {
+                *--d = '-';
+            }
+        }
+        for (size_t length = (size_t)(digits + sizeof(digits) - 1 - d); length < width; length++) {
+            *out++ = ' ';
+        }
+        while (*d != '\0') {
+            *out++ = *d++;
+        }
+    }
+    *out = '\0';
+}
+
+static void Layout_Engine_drawSpark(Layout_Engine_t* engine, const Layout_Widget_t* widget) {
+    // Framed min/max envelope of the last spanMs, newest on the right. Cost depends on the span, not on how long we ran.
+    U8G2* display = engine->display;
+    const int x = widget->x, y = widget->y, width = widget->w, height = widget->h;
+    const int minValue = widget->min, maxValue = widget->max;
+    display->drawFrame(x, y, width, height);
+    int tier = Signal_History_tierFor(widget->spanMs);
+    uint32_t points = widget->spanMs / Signal_History_tierPeriodMs(tier);
+    points = constrain(points, 1, SIGNAL_HISTORY_LENGTH);
+
+    int lastY = -1;
+    for (int column = 0; column < width; column++) {
+        uint16_t newest = (uint16_t)((width - 1 - column) * points / width);
+        uint16_t oldest = (uint16_t)((width - column) * points / width);
+        Signal_History_Point_t point = Signal_History_range(engine->history, widget->history, tier, newest,
+                                                            oldest > newest ? oldest - newest : 1);
+        if (point.mean == SIGNAL_HISTORY_NO_DATA) {
+            lastY = -1;
+            continue;
+        }
+        int yMin = y + height - 1 - map(constrain(point.min, minValue, maxValue), minValue, maxValue, 0, height - 1);
+        int yMax = y + height - 1 - map(constrain(point.max, minValue, maxValue), minValue, maxValue, 0, height - 1);
+        // Reach back to the previous column so a steady signal still draws a connected line
+        int top = lastY >= 0 && lastY < yMax ? lastY : yMax;
+        int bottom = lastY > yMin ? lastY : yMin;
+        display->drawVLine(x + column, top, bottom - top + 1);
+        lastY = y + height - 1 - map(constrain(point.mean, minValue, maxValue), minValue, maxValue, 0, height - 1);
+    }
+}
+
+static void Layout_Engine_drawWidget(Layout_Engine_t* engine, const Layout_Widget_t* widget) {
+    // A blinking bar or meter keeps its frame in the off phase, anything else disappears
+    U8G2* display = engine->display;
+    const bool on = widget->visibility == LAYOUT_SHOWN;
+    if (widget->visibility == LAYOUT_HIDDEN ||
+        (!on && widget->type != LAYOUT_WIDGET_BAR && widget->type != LAYOUT_WIDGET_METER)) {
+        return;
+    }
+    switch (widget->type) {
+        case LAYOUT_WIDGET_LABEL:
+            display->setFont(engine->fonts[widget->font].font);
+            display->drawStr(widget->x, widget->y, widget->text);
+            break;
+        case LAYOUT_WIDGET_VALUE: {
+            char text[LAYOUT_TEXT_SIZE];
+            Layout_Engine_formatValue(engine, widget, text);
+            const Layout_Font_t* font = &engine->fonts[widget->font];
+            if (font->atlasFont >= 0) {
+                Glyph_Atlas_drawStr(engine->atlas, (uint8_t)font->atlasFont, widget->x, widget->y, text);
+            } else {
+                display->setFont(font->font);
+                display->drawStr(widget->x, widget->y, text);
+            }
+            break;
+        }
+        case LAYOUT_WIDGET_BAR:
+            display->drawFrame(widget->x, widget->y, widget->w, widget->h);
+            if (on) {
+                display->drawBox(widget->x, widget->y, widget->level, widget->h);
+            }
+            break;
+        case LAYOUT_WIDGET_METER:
+            // Segments aligned to the bottom, each lit once the reading reaches its threshold
+            for (uint8_t i = 0; i < widget->segmentCount; i++) {
+                const Layout_Segment_t* segment = &engine->segments[widget->firstSegment + i];
+                int x = widget->x + i * (widget->w + widget->h);
+                int y = widget->y - segment->height;
+                display->drawFrame(x, y, widget->w, segment->height);
+                if (on && i < widget->level) {
+                    display->drawBox(x, y, widget->w, segment->height);
+                }
+            }
+            break;
+        case LAYOUT_WIDGET_SPARK:
+            Layout_Engine_drawSpark(engine, widget);
+            break;
+        case LAYOUT_WIDGET_ICON: {
+            const Layout_Icon_t* icon = &engine->icons[widget->icon];
+            if (icon->sprite >= 0) {
+                Glyph_Atlas_drawSprite(engine->atlas, (uint8_t)icon->sprite, widget->x, widget->y);
+            } else {
+                icon->draw(widget->x, widget->y);
+            }
+            break;
+        }
+        case LAYOUT_WIDGET_LINE:
+            display->drawBox(widget->x, widget->y, widget->w, widget->h);
+            break;
+        default:
+            break;
+    }
+}
+
+void Layout_Engine_draw(Layout_Engine_t* engine, bool full) {
+    // Brings the frame buffer to the prepared state. A partial draw clears and redraws the widgets
+    // whose state changed and, transitively, every widget whose box meets one of them, in screen order.
+    U8G2* display = engine->display;
+    if (engine->screen < 0 || engine->screen >= engine->screenCount) {
+        display->clearBuffer();
+        engine->drawnScreen = -1;
+        return;
+    }
+    const Layout_Screen_t* screen = &engine->screens[engine->screen];
+    Layout_Widget_t* widgets = &engine->widgets[screen->firstWidget];
+    const uint32_t all = screen->widgetCount >= 32 ? ~0u : (1u << screen->widgetCount) - 1;
+    uint32_t dirty = 0;
+    if (full || engine->drawnScreen != engine->screen) {
+        dirty = all;
+        display->clearBuffer();
+        engine->fullDraws++;
+    } else {
+        for (uint8_t i = 0; i < screen->widgetCount; i++) {
+            if (widgets[i].pendingKey != widgets[i].key) {
+                dirty |= 1u << i;
+            }
+        }
+        // A cleared box takes the pixels of every widget that meets it
+        uint32_t closure = dirty;
+        do {
+            dirty = closure;
+            for (uint8_t i = 0; i < screen->widgetCount; i++) {
+                if (dirty & (1u << i)) {
+                    closure |= widgets[i].overlaps;
+                }
+            }
+        } while (closure != dirty);
+        display->setDrawColor(0);
+        for (uint8_t i = 0; i < screen->widgetCount; i++) {
+            const Layout_Box_t* box = &widgets[i].box;
+            if ((dirty & (1u << i)) && box->x1 > box->x0) {
+                display->drawBox(box->x0, box->y0, box->x1 - box->x0, box->y1 - box->y0);
+            }
+        }
+        display->setDrawColor(1);
+        engine->partialDraws++;
+        engine->widgetsKept += screen->widgetCount - (uint32_t)__builtin_popcount(dirty);
+    }
+    for (uint8_t i = 0; i < screen->widgetCount; i++) {
+        if (dirty & (1u << i)) {
+            Layout_Engine_drawWidget(engine, &widgets[i]);
+            engine->widgetsDrawn++;
+        }
+        widgets[i].key = widgets[i].pendingKey;
+    }
+    engine->drawnScreen = engine->screen;
+}
+
+// === VERIFICATION ===
+uint32_t Layout_Engine_verify(Layout_Engine_t* engine, int screen, uint32_t nowMs) {
+    // Draws screen in full at nowMs, then steps the clock (blink phases, values going stale) and
+    // compares each partial draw with a full one. Returns the differing pixels; the buffer is left
+    // with the last full draw and the draw counters are untouched.
+    uint8_t* buffer = engine->display->getBufferPtr();
+    const size_t size = (size_t)engine->display->getBufferTileWidth() * 8 * engine->display->getBufferTileHeight();
+    static uint8_t partial[DISPLAY_RENDERER_BUFFER_SIZE];
+    if (size > sizeof(partial)) {
+        return 0;
+    }
+    const uint32_t fullDraws = engine->fullDraws, partialDraws = engine->partialDraws;
+    const uint32_t widgetsDrawn = engine->widgetsDrawn, widgetsKept = engine->widgetsKept;
+
+    Layout_Engine_prepare(engine, screen, nowMs);
+    Layout_Engine_draw(engine, true);
+    uint32_t differing = 0;
+    for (uint32_t step = 1; step <= LAYOUT_VERIFY_STEPS; step++) {
+        Layout_Engine_prepare(engine, screen, nowMs + step * LAYOUT_VERIFY_STEP_MS);
+        Layout_Engine_draw(engine, false);
+        memcpy(partial, buffer, size);
+        Layout_Engine_draw(engine, true);
+        for (size_t i = 0; i < size; i++) {
+            differing += (uint32_t)__builtin_popcount((unsigned)(partial[i] ^ buffer[i]));
+        }
+    }
+
+    engine->fullDraws = fullDraws;
+    engine->partialDraws = partialDraws;
+    engine->widgetsDrawn = widgetsDrawn;
+    engine->widgetsKept = widgetsKept;
+    return differing;
+}
+
+void Layout_Engine_printStatus(const Layout_Engine_t* engine) {
+    Serial.printf("Layout: %s, %u screens, %u widgets, %u bytes\n", engine->source, (unsigned)engine->screenCount,
+                  (unsigned)engine->widgetCount, (unsigned)engine->fileSize);
+    for (uint8_t s = 0; s < engine->screenCount; s++) {
+        const Layout_Screen_t* screen = &engine->screens[s];
+        unsigned overlaps = 0;
+        for (uint8_t i = 0; i < screen->widgetCount; i++) {
+            overlaps += (unsigned)__builtin_popcount(engine->widgets[screen->firstWidget + i].overlaps);
+        }
+        Serial.printf("  %-22s %2u widgets, %2u overlapping pairs\n", screen->name, (unsigned)screen->widgetCount, overlaps / 2);
+    }
+    Serial.print("Fonts:");
+    for (uint8_t f = 0; f < engine->fontCount; f++) {
+        Serial.printf(" %s%s", engine->fonts[f].name, engine->fonts[f].atlasFont >= 0 ? " (atlas)" : "");
+    }
+    Serial.println();
+    Serial.printf("Draws: %lu full, %lu partial, %lu widgets drawn, %lu kept\n", (unsigned long)engine->fullDraws,
+                  (unsigned long)engine->partialDraws, (unsigned long)engine->widgetsDrawn, (unsigned long)engine->widgetsKept);
+}
@@ -0,0 +1,210 @@
+#include "Perf_Trace.h"
+#include <Arduino.h>
+#include <string.h>
+#ifndef ARDUINO_ARCH_ESP32
+#include <chrono>
+#endif
+
+// A PERF_TRACE=0 build keeps the prototypes but none of the code
+#if PERF_TRACE
+
+static const char* const PERF_STAGE_NAMES[PERF_STAGE_COUNT] = {
+    "rx -> decode", "decode -> commit", "commit -> draw", "draw -> flush", "rx -> pixel"
+};
+static const char* const PERF_TASK_NAMES[PERF_TASK_COUNT] = {"CAN task", "UI task"};
+static const char* const PERF_SECTION_NAMES[PERF_SECTION_COUNT] = {
+    "decode", "diag", "log", "publish", "input", "view", "render"
+};
+static const Perf_Task_t PERF_SECTION_TASK[PERF_SECTION_COUNT] = {
+    PERF_TASK_CAN, PERF_TASK_CAN, PERF_TASK_CAN, PERF_TASK_CAN, PERF_TASK_UI, PERF_TASK_UI, PERF_TASK_UI
+};
+// Task that records each stage, the only one allowed to clear it
+static const Perf_Task_t PERF_STAGE_TASK[PERF_STAGE_COUNT] = {
+    PERF_TASK_CAN, PERF_TASK_CAN, PERF_TASK_UI, PERF_TASK_UI, PERF_TASK_UI
+};
+
+void Perf_Trace_init(Perf_Trace_t* perf) {
+    memset(perf, 0, sizeof(*perf));
+#ifdef ARDUINO_ARCH_ESP32
+    perf->cyclesPerUs = ESP.getCpuFreqMHz();
+#else
+    perf->cyclesPerUs = 1000;   // Host "cycles" are nanoseconds
+#endif
+}
+
+void Perf_Trace_reset(Perf_Trace_t* perf) {
+    // Cleared by each task at its next iteration, never under a writer's feet
+    perf->resetRequested = (1u << PERF_TASK_COUNT) - 1;
+}
+
+uint32_t Perf_Trace_cycles(void) {
+#ifdef ARDUINO_ARCH_ESP32
+    return ESP.getCycleCount();
+#else
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+#endif
+}
+
+// === HISTOGRAMS ===
+static uint8_t Perf_Hist_bucket(uint32_t us) {
+    if (us < (1u << PERF_HIST_SUB_BITS)) {
+        return (uint8_t)us;
+    }
+    uint8_t msb = (uint8_t)(31 - __builtin_clz(us));
+    uint32_t sub = (us >> (msb - PERF_HIST_SUB_BITS)) & ((1u << PERF_HIST_SUB_BITS) - 1);
+    uint32_t bucket = ((uint32_t)(msb - PERF_HIST_SUB_BITS + 1) << PERF_HIST_SUB_BITS) + sub;
+    return (uint8_t)(bucket < PERF_HIST_BUCKETS ? bucket : PERF_HIST_BUCKETS - 1);
+}
+
+static uint32_t Perf_Hist_upperBound(uint8_t bucket) {
+    if (bucket < (1u << PERF_HIST_SUB_BITS)) {
+        return bucket;
+    }
+    uint8_t shift = (uint8_t)((bucket >> PERF_HIST_SUB_BITS) - 1);
+    uint32_t sub = bucket & ((1u << PERF_HIST_SUB_BITS) - 1);
+    return (((1u << PERF_HIST_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+static void Perf_Hist_add(Perf_Hist_t* hist, uint32_t us) {
+    hist->buckets[Perf_Hist_bucket(us)]++;
+    hist->count++;
+    hist->sumUs += us;
+    if (us > hist->maxUs) {
+        hist->maxUs = us;
+    }
+}
+
+uint32_t Perf_Hist_percentile(const Perf_Hist_t* hist, uint8_t percent) {
+    // Upper edge of the bucket holding the percentile, never above the largest value seen
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < PERF_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank && seen > 0) {
+            uint32_t bound = Perf_Hist_upperBound(i);
+            return bound < hist->maxUs ? bound : hist->maxUs;
+        }
+    }
+    return hist->maxUs;
+}
+
+// === LOOP PROFILER ===
+void Perf_Trace_loopBegin(Perf_Trace_t* perf, Perf_Task_t task) {
+    uint8_t bit = (uint8_t)(1u << task);
+    if (perf->resetRequested & bit) {
+        memset(&perf->loops[task], 0, sizeof(perf->loops[task]));
+        for (uint8_t s = 0; s < PERF_SECTION_COUNT; s++) {
+            if (PERF_SECTION_TASK[s] == task) {
+                memset(&perf->sections[s], 0, sizeof(perf->sections[s]));
+            }
+        }
+        for (uint8_t s = 0; s < PERF_STAGE_COUNT; s++) {
+            if (PERF_STAGE_TASK[s] == task) {
+                memset(&perf->stages[s], 0, sizeof(perf->stages[s]));
+            }
+        }
+        perf->resetRequested &= (uint8_t)~bit;
+    }
+    perf->loopStart[task] = Perf_Trace_cycles();
+    perf->mark[task] = perf->loopStart[task];
+}
+
+void Perf_Trace_mark(Perf_Trace_t* perf, Perf_Section_t section) {
+    // Charges the time since the previous mark of the same task to this section
+    Perf_Task_t task = PERF_SECTION_TASK[section];
+    uint32_t now = Perf_Trace_cycles();
+    uint32_t elapsed = now - perf->mark[task];
+    perf->mark[task] = now;
+    perf->sections[section].cycles += elapsed;
+    if (elapsed > perf->sections[section].maxCycles) {
+        perf->sections[section].maxCycles = elapsed;
+    }
+}
+
+void Perf_Trace_loopEnd(Perf_Trace_t* perf, Perf_Task_t task) {
+    Perf_Hist_add(&perf->loops[task], (Perf_Trace_cycles() - perf->loopStart[task]) / perf->cyclesPerUs);
+}
+
+// === FRAME PIPELINE ===
+void Perf_Trace_decoded(Perf_Trace_t* perf, const CAN_Frame_t* frames, size_t count, uint64_t nowUs) {
+    // CAN task, after a batch went through the decoders
+    for (size_t i = 0; i < count; i++) {
+        Perf_Hist_add(&perf->stages[PERF_STAGE_DECODE], (uint32_t)(nowUs - frames[i].timestamp));
+        if (perf->pending.receivedUs == 0 || frames[i].timestamp < perf->pending.receivedUs) {
+            perf->pending.receivedUs = frames[i].timestamp;
+        }
+    }
+    if (count > 0) {
+        perf->pending.decodedUs = nowUs;
+    }
+}
+
+void Perf_Trace_commit(Perf_Trace_t* perf, Perf_Trace_Stamp_t* stamp, uint64_t nowUs) {
+    // CAN task, right before the snapshot carrying stamp is published
+    if (perf->pending.decodedUs == 0) {
+        return;
+    }
+    Perf_Hist_add(&perf->stages[PERF_STAGE_COMMIT], (uint32_t)(nowUs - perf->pending.decodedUs));
+    *stamp = perf->pending;
+    stamp->committedUs = nowUs;
+    memset(&perf->pending, 0, sizeof(perf->pending));
+}
+
+void Perf_Trace_viewed(Perf_Trace_t* perf, const Perf_Trace_Stamp_t* stamp) {
+    // UI task, after reading a snapshot. A snapshot replaced before it was drawn never reached the panel.
+    if (stamp->committedUs != 0 && stamp->committedUs != perf->shown.committedUs) {
+        perf->shown = *stamp;
+    }
+}
+
+void Perf_Trace_rendered(Perf_Trace_t* perf, uint64_t drawStartUs, uint64_t flushEndUs) {
+    // UI task, after a frame was drawn and flushed. Only the first frame showing a snapshot counts for the pipeline.
+    Perf_Hist_add(&perf->stages[PERF_STAGE_DRAW], (uint32_t)(flushEndUs - drawStartUs));
+    if (perf->shown.committedUs == 0 || perf->shown.committedUs > drawStartUs) {
+        return;
+    }
+    Perf_Hist_add(&perf->stages[PERF_STAGE_PICKUP], (uint32_t)(drawStartUs - perf->shown.committedUs));
+    Perf_Hist_add(&perf->stages[PERF_STAGE_TOTAL], (uint32_t)(flushEndUs - perf->shown.receivedUs));
+    memset(&perf->shown, 0, sizeof(perf->shown));
+}
+
+// === REPORT ===
+static void Perf_Trace_printHist(const char* name, const Perf_Hist_t* hist) {
+    Serial.printf("%-18s %8lu %8lu %8lu %8lu %8lu %8lu\n", name, (unsigned long)hist->count,
+                  (unsigned long)(hist->count ? hist->sumUs / hist->count : 0),
+                  (unsigned long)Perf_Hist_percentile(hist, 50), (unsigned long)Perf_Hist_percentile(hist, 90),
+                  (unsigned long)Perf_Hist_percentile(hist, 99), (unsigned long)hist->maxUs);
+}
+
+void Perf_Trace_print(const Perf_Trace_t* perf) {
+    Serial.println("Latency (us)          count     mean      p50      p90      p99      max");
+    for (uint8_t s = 0; s < PERF_STAGE_COUNT; s++) {
+        Perf_Trace_printHist(PERF_STAGE_NAMES[s], &perf->stages[s]);
+    }
+    for (uint8_t t = 0; t < PERF_TASK_COUNT; t++) {
+        Perf_Trace_printHist(PERF_TASK_NAMES[t], &perf->loops[t]);
+    }
+
+    Serial.println("Section           task      share  mean us   max us");
+    for (uint8_t s = 0; s < PERF_SECTION_COUNT; s++) {
+        Perf_Task_t task = PERF_SECTION_TASK[s];
+        uint64_t taskCycles = 0;
+        for (uint8_t other = 0; other < PERF_SECTION_COUNT; other++) {
+            if (PERF_SECTION_TASK[other] == task) {
+                taskCycles += perf->sections[other].cycles;
+            }
+        }
+        uint32_t loops = perf->loops[task].count;
+        uint32_t share = taskCycles ? (uint32_t)(perf->sections[s].cycles * 1000 / taskCycles) : 0;   // Permille
+        Serial.printf("%-17s %-8s %4lu.%lu%% %8lu %8lu\n", PERF_SECTION_NAMES[s], PERF_TASK_NAMES[task],
+                      (unsigned long)(share / 10), (unsigned long)(share % 10),
+                      (unsigned long)(loops ? perf->sections[s].cycles / perf->cyclesPerUs / loops : 0),
+                      (unsigned long)(perf->sections[s].maxCycles / perf->cyclesPerUs));
+    }
+}
+
+#endif // PERF_TRACE
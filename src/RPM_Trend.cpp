@@ -0,0 +1,77 @@
+#include "RPM_Trend.h"
+#include <string.h>
+
+void RPM_Trend_reset(RPM_Trend_t* trend) {
+    memset(trend, 0, sizeof(*trend));
+}
+
+static void RPM_Trend_fit(RPM_Trend_t* trend) {
+    // Least squares over the samples, times relative to the newest one so the sums stay small
+    uint8_t newest = (uint8_t)((trend->head + RPM_TREND_FIT_SAMPLES - 1) % RPM_TREND_FIT_SAMPLES);
+    uint64_t newestUs = trend->timeUs[newest];
+    int64_t n = trend->count;
+    int64_t sumT = 0;
+    int64_t sumR = 0;
+    int64_t sumTT = 0;
+    int64_t sumTR = 0;
+    for (uint8_t i = 0; i < trend->count; i++) {
+        int64_t t = -(int64_t)(newestUs - trend->timeUs[i]);
+        int64_t r = trend->rpm[i];
+        sumT += t;
+        sumR += r;
+        sumTT += t * t;
+        sumTR += t * r;
+    }
+
+    int64_t den = n * sumTT - sumT * sumT;
+    int64_t slope = den > 0 ? (n * sumTR - sumT * sumR) * 1000000 / den : 0;
+    if (slope > RPM_TREND_MAX_SLOPE) {
+        slope = RPM_TREND_MAX_SLOPE;
+    } else if (slope < -RPM_TREND_MAX_SLOPE) {
+        slope = -RPM_TREND_MAX_SLOPE;
+    }
+    // The fitted line at the newest sample, smoother than the raw value
+    trend->slope = (int32_t)slope;
+    trend->anchorUs = newestUs;
+    trend->anchorRpm = (int32_t)((sumR * 1000000 - slope * sumT) / (n * 1000000));
+}
+
+void RPM_Trend_sample(RPM_Trend_t* trend, uint64_t timeUs, int16_t rpm) {
+    uint8_t newest = (uint8_t)((trend->head + RPM_TREND_FIT_SAMPLES - 1) % RPM_TREND_FIT_SAMPLES);
+    if (trend->count > 0) {
+        // A gap or a clock jump says nothing about the slope, and a line fitted across a step
+        // (a gear change) would extrapolate the step: start a new fit from here
+        bool gap = timeUs <= trend->timeUs[newest] || timeUs - trend->timeUs[newest] > RPM_TREND_MAX_GAP_US;
+        int step = gap ? 0 : rpm - RPM_Trend_predict(trend, timeUs);
+        if (gap || step > RPM_TREND_MAX_STEP || step < -RPM_TREND_MAX_STEP) {
+            trend->count = 0;
+            trend->head = 0;
+            trend->restarts++;
+        }
+    }
+
+    trend->timeUs[trend->head] = timeUs;
+    trend->rpm[trend->head] = rpm < 0 ? 0 : rpm;
+    trend->head = (uint8_t)((trend->head + 1) % RPM_TREND_FIT_SAMPLES);
+    if (trend->count < RPM_TREND_FIT_SAMPLES) {
+        trend->count++;
+    }
+    trend->samples++;
+    RPM_Trend_fit(trend);
+}
+
+int RPM_Trend_predict(const RPM_Trend_t* trend, uint64_t atUs) {
+    // Engine speed expected at atUs, on the sample clock. Holds the fit once the lead runs out.
+    if (trend->count == 0) {
+        return 0;
+    }
+    uint64_t lead = atUs > trend->anchorUs ? atUs - trend->anchorUs : 0;
+    if (lead > RPM_TREND_MAX_LEAD_US) {
+        lead = RPM_TREND_MAX_LEAD_US;
+    }
+    int64_t rpm = trend->anchorRpm + (int64_t)trend->slope * (int64_t)lead / 1000000;
+    if (rpm < 0) {
+        return 0;
+    }
+    return rpm > INT16_MAX ? INT16_MAX : (int)rpm;
+}
@@ -6,7 +6,7 @@ void Serial_Handler_init(Serial_Handler_Context_t* ctx,
                         bool* devMode, 
                         VehicleType_t* vehicleType,
                         CAN_Reader_Context_t* canReaderCtx,
-                        MCP_CAN* canInterface,
+                        CAN_Interface_t* canInterface,
                         bool* displayUpdated,
                         ScreenChangeCallback_t screenChangeCallback,
                         ModeChangeCallback_t modeChangeCallback,
@@ -34,6 +34,127 @@ void Serial_Handler_init(Serial_Handler_Context_t* ctx,
     ctx->vinRequestCallback = vinRequestCallback;
     ctx->vehicleTypeChangeCallback = vehicleTypeChangeCallback;
     ctx->vehicleStatusCallback = vehicleStatusCallback;
+    ctx->displayStatsCallback = nullptr;
+    ctx->taskStatsCallback = nullptr;
+    ctx->replayStartCallback = nullptr;
+    ctx->replayStopCallback = nullptr;
+    ctx->replayStatusCallback = nullptr;
+    ctx->logCommandCallback = nullptr;
+    ctx->diagCommandCallback = nullptr;
+    ctx->simCommandCallback = nullptr;
+    ctx->alertCommandCallback = nullptr;
+    ctx->shiftCommandCallback = nullptr;
+    ctx->perfCommandCallback = nullptr;
+    ctx->atlasCommandCallback = nullptr;
+    ctx->layoutCommandCallback = nullptr;
+}
+
+static void Serial_Handler_handleReplay(Serial_Handler_Context_t* ctx, const char* args) {
+    // replay [status] | replay stop | replay <file> [speed|max]
+    if (*args == '\0' || strcmp(args, "status") == 0) {
+        if (ctx->replayStatusCallback) {
+            ctx->replayStatusCallback();
+        } else {
+            Serial.println("Replay not available");
+        }
+        return;
+    }
+    if (strcmp(args, "stop") == 0) {
+        if (ctx->replayStopCallback) {
+            ctx->replayStopCallback();
+        }
+        return;
+    }
+
+    char path[SERIAL_BUFFER_SIZE];
+    strncpy(path, args, sizeof(path) - 1);
+    path[sizeof(path) - 1] = '\0';
+    float speed = 1.0f;
+    char* space = strchr(path, ' ');
+    if (space != nullptr) {
+        *space = '\0';
+        const char* speedArg = space + 1;
+        speed = (strcmp(speedArg, "max") == 0) ? 0.0f : (float)atof(speedArg);
+        if (speed < 0.0f) {
+            Serial.println("Speed must be positive or 'max'");
+            return;
+        }
+    }
+    if (ctx->replayStartCallback) {
+        ctx->replayStartCallback(path, speed);
+    } else {
+        Serial.println("Replay not available");
+    }
+}
+
+static void Serial_Handler_handleTrace(Serial_Handler_Context_t* ctx, const char* args) {
+    // trace [status] | off | full | sample <n> | id <hex> [<hex>...] | id clear
+    CAN_Trace_t* trace = ctx->canReaderCtx->trace;
+    if (trace == nullptr) {
+        Serial.println("Trace not available");
+        return;
+    }
+
+    if (strcmp(args, "status") == 0) {
+        CAN_Trace_printStatus(trace);
+    } else if (strcmp(args, "off") == 0) {
+        CAN_Trace_setLevel(trace, CAN_TRACE_OFF);
+        Serial.println("Frame trace off");
+    } else if (strcmp(args, "full") == 0) {
+        CAN_Trace_setLevel(trace, CAN_TRACE_FULL);
+        Serial.println("Tracing every frame");
+    } else if (strncmp(args, "sample ", 7) == 0) {
+        CAN_Trace_setSample(trace, (uint16_t)atoi(args + 7));
+        CAN_Trace_setLevel(trace, CAN_TRACE_SAMPLED);
+        Serial.printf("Tracing every %u frames\n", (unsigned)trace->sampleEvery);
+    } else if (strcmp(args, "id clear") == 0) {
+        CAN_Trace_clearIds(trace);
+        Serial.println("Trace ID filter cleared");
+    } else if (strncmp(args, "id ", 3) == 0) {
+        const char* p = args + 3;
+        char* end;
+        int added = 0;
+        for (unsigned long id = strtoul(p, &end, 16); end != p; id = strtoul(p, &end, 16)) {
+            CAN_Trace_addId(trace, (uint32_t)id);
+            added++;
+            p = end;
+        }
+        if (added == 0) {
+            Serial.println("Usage: trace id <hex> [<hex>...]");
+            return;
+        }
+        CAN_Trace_setLevel(trace, CAN_TRACE_FILTERED);
+        Serial.printf("Tracing %d more ID(s)\n", added);
+    } else {
+        Serial.println("Usage: trace [status]|off|full|sample <n>|id <hex>...|id clear");
+    }
+}
+
+static void Serial_Handler_handleStats(Serial_Handler_Context_t* ctx, const char* args) {
+    // stats | stats reset | stats top <n> | stats <hex id>
+    CAN_Stats_t* stats = ctx->canReaderCtx->stats;
+    if (stats == nullptr) {
+        Serial.println("Bus statistics not available");
+        return;
+    }
+
+    if (args[0] == '\0') {
+        CAN_Stats_print(stats, CAN_Reader_timestampUs(), CAN_STATS_TOP_N);
+    } else if (strcmp(args, "reset") == 0) {
+        CAN_Reader_resetStats(ctx->canReaderCtx);
+        Serial.println("Bus statistics reset");
+    } else if (strncmp(args, "top ", 4) == 0) {
+        int top = atoi(args + 4);
+        CAN_Stats_print(stats, CAN_Reader_timestampUs(), (uint8_t)(top > 0 && top < CAN_STATS_MAX_IDS ? top : CAN_STATS_MAX_IDS));
+    } else {
+        char* end;
+        unsigned long id = strtoul(args, &end, 16);
+        if (end == args || *end != '\0') {
+            Serial.println("Usage: stats [reset|top <n>|<hex id>]");
+        } else if (!CAN_Stats_printId(stats, (uint32_t)id, CAN_Reader_timestampUs())) {
+            Serial.printf("ID 0x%03lX not seen\n", id);
+        }
+    }
 }
 
 void Serial_Handler_processInput(Serial_Handler_Context_t* ctx) {
@@ -55,21 +176,15 @@ void Serial_Handler_processInput(Serial_Handler_Context_t* ctx) {
                 ctx->serialBuffer[ctx->serialBufferIndex] = '\0'; // Null terminate the string
                 
                 // Process the command
-                if (strcmp(ctx->serialBuffer, "screen1") == 0) {
-                    *ctx->currentScreen = 0;
-                    Serial.println("Switched to RPM Screen");
-                }
-                else if (strcmp(ctx->serialBuffer, "screen2") == 0) {
-                    *ctx->currentScreen = 1;
-                    Serial.println("Switched to Temperature Screen");
-                }
-                else if (strcmp(ctx->serialBuffer, "screen3") == 0) {
-                    *ctx->currentScreen = 2;
-                    Serial.println("Switched to RPM Meter Screen");
-                }
-                else if (strcmp(ctx->serialBuffer, "screen4") == 0) {
-                    *ctx->currentScreen = 3;
-                    Serial.println("Switched to Detailed Temperature Screen");
+                if (strncmp(ctx->serialBuffer, "screen", 6) == 0 && ctx->serialBuffer[6] >= '1' && ctx->serialBuffer[6] <= '9') {
+                    // Screens come from the layout, the callback knows how many there are
+                    int screen = atoi(ctx->serialBuffer + 6) - 1;
+                    if (ctx->screenChangeCallback) {
+                        ctx->screenChangeCallback(screen);
+                    } else {
+                        *ctx->currentScreen = screen;
+                        Serial.printf("Switched to screen %d\n", screen + 1);
+                    }
                 }
                 else if (strcmp(ctx->serialBuffer, "demo") == 0) {
                     *ctx->devMode = true;
@@ -99,14 +214,13 @@ void Serial_Handler_processInput(Serial_Handler_Context_t* ctx) {
                         if (ctx->vinRequestCallback) {
                             ctx->vinRequestCallback();
                         }
-                        Serial.println("Requesting VIN from instrument cluster...");
                     } else {
                         Serial.println("VIN request only works in real mode");
                     }
                 }
                 else if (strcmp(ctx->serialBuffer, "vehicle bmw") == 0) {
                     *ctx->vehicleType = VEHICLE_BMW;
-                    CAN_Reader_init(ctx->canReaderCtx, *ctx->vehicleType, ctx->canInterface, ctx->displayUpdated);
+                    CAN_Reader_requestVehicle(ctx->canReaderCtx, *ctx->vehicleType);
                     if (ctx->vehicleTypeChangeCallback) {
                         ctx->vehicleTypeChangeCallback(VEHICLE_BMW);
                     }
@@ -114,19 +228,19 @@ void Serial_Handler_processInput(Serial_Handler_Context_t* ctx) {
                 }
                 else if (strcmp(ctx->serialBuffer, "vehicle kawasaki") == 0) {
                     *ctx->vehicleType = VEHICLE_KAWASAKI;
-                    CAN_Reader_init(ctx->canReaderCtx, *ctx->vehicleType, ctx->canInterface, ctx->displayUpdated);
+                    CAN_Reader_requestVehicle(ctx->canReaderCtx, *ctx->vehicleType);
                     if (ctx->vehicleTypeChangeCallback) {
                         ctx->vehicleTypeChangeCallback(VEHICLE_KAWASAKI);
                     }
                     Serial.println("Switched to Kawasaki vehicle mode");
                 }
-                else if (strcmp(ctx->serialBuffer, "vehicle unknown") == 0) {
+                else if (strcmp(ctx->serialBuffer, "vehicle auto") == 0 || strcmp(ctx->serialBuffer, "vehicle unknown") == 0) {
                     *ctx->vehicleType = VEHICLE_UNKNOWN;
-                    CAN_Reader_init(ctx->canReaderCtx, *ctx->vehicleType, ctx->canInterface, ctx->displayUpdated);
+                    CAN_Reader_requestVehicle(ctx->canReaderCtx, *ctx->vehicleType);
                     if (ctx->vehicleTypeChangeCallback) {
                         ctx->vehicleTypeChangeCallback(VEHICLE_UNKNOWN);
                     }
-                    Serial.println("Switched to Unknown vehicle mode (tries both parsers)");
+                    Serial.println("Switched to auto-detect vehicle mode (decoding starts once the bus is recognised)");
                 }
                 else if (strcmp(ctx->serialBuffer, "vehicle status") == 0) {
                     if (ctx->vehicleStatusCallback) {
@@ -141,11 +255,90 @@ void Serial_Handler_processInput(Serial_Handler_Context_t* ctx) {
                                 Serial.println("Kawasaki");
                                 break;
                             case VEHICLE_UNKNOWN:
-                                Serial.println("Unknown (tries both parsers)");
+                                Serial.println("Auto-detect");
                                 break;
                         }
                     }
                 }
+                else if (strcmp(ctx->serialBuffer, "display stats") == 0) {
+                    if (ctx->displayStatsCallback) {
+                        ctx->displayStatsCallback();
+                    } else {
+                        Serial.println("Display statistics not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "tasks") == 0) {
+                    if (ctx->taskStatsCallback) {
+                        ctx->taskStatsCallback();
+                    } else {
+                        Serial.println("Task statistics not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "replay") == 0 || strncmp(ctx->serialBuffer, "replay ", 7) == 0) {
+                    Serial_Handler_handleReplay(ctx, ctx->serialBuffer[6] == ' ' ? ctx->serialBuffer + 7 : "");
+                }
+                else if (strcmp(ctx->serialBuffer, "log") == 0 || strncmp(ctx->serialBuffer, "log ", 4) == 0) {
+                    if (ctx->logCommandCallback) {
+                        ctx->logCommandCallback(ctx->serialBuffer[3] == ' ' ? ctx->serialBuffer + 4 : "status");
+                    } else {
+                        Serial.println("Logger not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "diag") == 0 || strncmp(ctx->serialBuffer, "diag ", 5) == 0) {
+                    if (ctx->diagCommandCallback) {
+                        ctx->diagCommandCallback(ctx->serialBuffer[4] == ' ' ? ctx->serialBuffer + 5 : "status");
+                    } else {
+                        Serial.println("Diagnostic polling not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "sim") == 0 || strncmp(ctx->serialBuffer, "sim ", 4) == 0) {
+                    if (ctx->simCommandCallback) {
+                        ctx->simCommandCallback(ctx->serialBuffer[3] == ' ' ? ctx->serialBuffer + 4 : "status");
+                    } else {
+                        Serial.println("Engine simulator not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "alerts") == 0 || strncmp(ctx->serialBuffer, "alerts ", 7) == 0) {
+                    if (ctx->alertCommandCallback) {
+                        ctx->alertCommandCallback(ctx->serialBuffer[6] == ' ' ? ctx->serialBuffer + 7 : "status");
+                    } else {
+                        Serial.println("Alert engine not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "shift") == 0 || strncmp(ctx->serialBuffer, "shift ", 6) == 0) {
+                    if (ctx->shiftCommandCallback) {
+                        ctx->shiftCommandCallback(ctx->serialBuffer[5] == ' ' ? ctx->serialBuffer + 6 : "status");
+                    } else {
+                        Serial.println("Shift light not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "perf") == 0 || strncmp(ctx->serialBuffer, "perf ", 5) == 0) {
+                    if (ctx->perfCommandCallback) {
+                        ctx->perfCommandCallback(ctx->serialBuffer[4] == ' ' ? ctx->serialBuffer + 5 : "");
+                    } else {
+                        Serial.println("Profiler not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "atlas") == 0 || strncmp(ctx->serialBuffer, "atlas ", 6) == 0) {
+                    if (ctx->atlasCommandCallback) {
+                        ctx->atlasCommandCallback(ctx->serialBuffer[5] == ' ' ? ctx->serialBuffer + 6 : "status");
+                    } else {
+                        Serial.println("Glyph atlas not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "layout") == 0 || strncmp(ctx->serialBuffer, "layout ", 7) == 0) {
+                    if (ctx->layoutCommandCallback) {
+                        ctx->layoutCommandCallback(ctx->serialBuffer[6] == ' ' ? ctx->serialBuffer + 7 : "status");
+                    } else {
+                        Serial.println("Screen layout not available");
+                    }
+                }
+                else if (strcmp(ctx->serialBuffer, "stats") == 0 || strncmp(ctx->serialBuffer, "stats ", 6) == 0) {
+                    Serial_Handler_handleStats(ctx, ctx->serialBuffer[5] == ' ' ? ctx->serialBuffer + 6 : "");
+                }
+                else if (strcmp(ctx->serialBuffer, "trace") == 0 || strncmp(ctx->serialBuffer, "trace ", 6) == 0) {
+                    Serial_Handler_handleTrace(ctx, ctx->serialBuffer[5] == ' ' ? ctx->serialBuffer + 6 : "status");
+                }
                 else {
                     Serial.println("Unknown command. Type 'help' for available commands.");
                 }
@@ -165,18 +358,52 @@ void Serial_Handler_processInput(Serial_Handler_Context_t* ctx) {
 
 void Serial_Handler_printHelp(void) {
     Serial.println("\nAvailable commands:");
-    Serial.println("screen1 - RPM Screen");
-    Serial.println("screen2 - Temperature Screen");
-    Serial.println("screen3 - RPM Meter Screen");
-    Serial.println("screen4 - Detailed Temperature Screen");
-    Serial.println("demo - Switch to Development/Demo Mode");
+    Serial.println("screen<n> - Show screen n of the layout (built-in: 1 RPM, 2 Temperature, 3 RPM Meter, 4 Detailed Temperature)");
+    Serial.println("demo - Switch to Development/Demo Mode (simulated engine on the CAN reader)");
     Serial.println("real - Switch to Real Mode (CAN data)");
     Serial.println("showintro - Show Intro");
     Serial.println("getvin - Request VIN from instrument cluster");
     Serial.println("vehicle bmw - Switch to BMW vehicle mode");
     Serial.println("vehicle kawasaki - Switch to Kawasaki vehicle mode");
-    Serial.println("vehicle unknown - Switch to Unknown vehicle mode (tries both parsers)");
-    Serial.println("vehicle status - Show current vehicle type");
+    Serial.println("vehicle auto - Detect the vehicle from the IDs and rates on the bus (also 'vehicle unknown')");
+    Serial.println("vehicle status - Show current vehicle type and the auto-detect decision");
+    Serial.println("display stats - Show per-screen render statistics");
+    Serial.println("tasks - Show task priorities and stack high-water marks");
+    Serial.println("replay <file> [speed|max] - Replay a candump/ASC/binary log from SPIFFS (1 = real time)");
+    Serial.println("replay stop - Stop the replay and return to the CAN controller");
+    Serial.println("replay status - Show replay progress");
+    Serial.println("trace off/full - Disable or enable the received frame dump");
+    Serial.println("trace sample <n> - Dump every nth received frame");
+    Serial.println("trace id <hex>... - Dump only these IDs (trace id clear resets)");
+    Serial.println("trace status - Show trace level and dropped lines");
+    Serial.println("stats - Show busiest IDs: rate, inter-arrival gaps, jitter, late frames, DLC changes, bus load");
+    Serial.println("stats top <n> - Show the n busiest IDs");
+    Serial.println("stats <hex> - Show the statistics of one ID");
+    Serial.println("stats reset - Clear the bus statistics");
+    Serial.println("log start/stop - Record received frames to flash");
+    Serial.println("log status - Show logger statistics");
+    Serial.println("log list - List recorded logs");
+    Serial.println("log dump <n> - Print log n as hex for tools/canlog_decode.py");
+    Serial.println("log clear - Delete all recorded logs");
+    Serial.println("diag [status] - Show DME polling rates, latency and errors");
+    Serial.println("diag on/off - Enable or disable DME diagnostic polling");
+    Serial.println("sim [status] - Show the demo mode engine simulator");
+    Serial.println("sim seed <n> - Restart the simulated drive with a seed");
+    Serial.println("sim load <percent> [unfiltered] - Fill the simulated bus, optionally past the acceptance filter");
+    Serial.println("alerts [status] - Show the alert rules and which are raised");
+    Serial.println("alerts rule <name> <signal> <op> <value> [hyst=] [debounce=] [prio=] [show=] [screen=] - Add or replace a rule");
+    Serial.println("alerts remove <name> - Delete a rule");
+    Serial.println("alerts save/reload/defaults - Write the rules to flash, read them back or restore the built-in set");
+    Serial.println("shift [status] - Show the RPM trend and panel latency behind the RPM meter bars");
+    Serial.println("shift on/off - Light the RPM meter bars from the predicted or the last decoded RPM");
+    Serial.println("perf - Show frame-to-pixel latency and task loop profile");
+    Serial.println("perf reset - Clear the latency histograms and loop profile");
+    Serial.println("atlas [status] - Show the pre-rasterised glyphs and icons the screens are drawn from");
+    Serial.println("atlas on/off - Draw numbers and icons from the atlas or through U8g2");
+    Serial.println("atlas check - Compare atlas and U8g2 output pixel by pixel for every glyph, icon and screen");
+    Serial.println("layout [status] - Show the loaded screen layout, its fonts and partial redraw counts");
+    Serial.println("layout reload/defaults - Read the layout from flash again or use the built-in one");
+    Serial.println("layout check - Compare partial redraws with full ones pixel by pixel for every screen");
 }
 
 void Serial_Handler_printPrompt(void) {
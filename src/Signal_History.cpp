@@ -0,0 +1,177 @@
+#include "Signal_History.h"
+#include <string.h>
+
+static const Signal_History_Point_t SIGNAL_HISTORY_GAP = {SIGNAL_HISTORY_NO_DATA, SIGNAL_HISTORY_NO_DATA, SIGNAL_HISTORY_NO_DATA};
+
+void Signal_History_init(Signal_History_t* history, const Vehicle_State_t* state) {
+    memset(history, 0, sizeof(*history));
+    history->state = state;
+}
+
+static void Signal_History_resetAccumulator(Signal_History_Accumulator_t* acc) {
+    acc->sum = 0;
+    acc->min = INT16_MAX;
+    acc->max = INT16_MIN;
+    acc->valid = 0;
+}
+
+int Signal_History_register(Signal_History_t* history, const char* name, uint8_t signal) {
+    if (history->count >= SIGNAL_HISTORY_MAX_SIGNALS) {
+        return -1;
+    }
+    Signal_History_Series_t* series = &history->series[history->count];
+    series->name = name;
+    series->signal = signal;
+    for (int i = 0; i < SIGNAL_HISTORY_LENGTH; i++) {
+        series->samples[i] = SIGNAL_HISTORY_NO_DATA;
+        for (int tier = 0; tier < SIGNAL_HISTORY_TIER_COUNT - 1; tier++) {
+            series->points[tier][i] = SIGNAL_HISTORY_GAP;
+        }
+    }
+    for (int tier = 0; tier < SIGNAL_HISTORY_TIER_COUNT - 1; tier++) {
+        Signal_History_resetAccumulator(&series->pending[tier]);
+    }
+    return history->count++;
+}
+
+int Signal_History_find(const Signal_History_t* history, uint8_t signal) {
+    // Series recording a vehicle state slot, -1 when none does
+    for (int i = 0; i < history->count; i++) {
+        if (history->series[i].signal == signal) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int16_t Signal_History_quantize(const Signal_History_t* history, const Signal_History_Series_t* series, unsigned long nowMs) {
+    // A frozen value would draw as a flat line, record a gap instead
+    if (Vehicle_State_status(history->state, series->signal, (uint32_t)nowMs) != VEHICLE_VALUE_FRESH) {
+        return SIGNAL_HISTORY_NO_DATA;
+    }
+    return history->state->value[series->signal];
+}
+
+static void Signal_History_accumulate(Signal_History_Accumulator_t* acc, const Signal_History_Point_t* point) {
+    if (point->mean == SIGNAL_HISTORY_NO_DATA) {
+        return;
+    }
+    acc->sum += point->mean;
+    acc->min = point->min < acc->min ? point->min : acc->min;
+    acc->max = point->max > acc->max ? point->max : acc->max;
+    acc->valid++;
+}
+
+static Signal_History_Point_t Signal_History_finish(Signal_History_Accumulator_t* acc) {
+    Signal_History_Point_t point = SIGNAL_HISTORY_GAP;
+    if (acc->valid > 0) {
+        point.min = acc->min;
+        point.max = acc->max;
+        point.mean = (int16_t)(acc->sum / acc->valid);
+    }
+    Signal_History_resetAccumulator(acc);
+    return point;
+}
+
+static void Signal_History_advance(Signal_History_t* history, int tier) {
+    history->head[tier] = (uint16_t)((history->head[tier] + 1) % SIGNAL_HISTORY_LENGTH);
+    if (history->filled[tier] < SIGNAL_HISTORY_LENGTH) {
+        history->filled[tier]++;
+    }
+}
+
+static void Signal_History_record(Signal_History_t* history, unsigned long nowMs) {
+    // Tier 0 sample, folded into the first accumulator
+    for (int s = 0; s < history->count; s++) {
+        Signal_History_Series_t* series = &history->series[s];
+        int16_t value = Signal_History_quantize(history, series, nowMs);
+        Signal_History_Point_t point = {value, value, value};
+        series->samples[history->head[0]] = value;
+        Signal_History_accumulate(&series->pending[0], &point);
+    }
+    Signal_History_advance(history, 0);
+    history->sampleCount++;
+
+    // Every DECIMATION points of a tier complete one point of the next
+    for (int tier = 1; tier < SIGNAL_HISTORY_TIER_COUNT; tier++) {
+        if (++history->phase[tier - 1] < SIGNAL_HISTORY_DECIMATION) {
+            break;
+        }
+        history->phase[tier - 1] = 0;
+        for (int s = 0; s < history->count; s++) {
+            Signal_History_Series_t* series = &history->series[s];
+            Signal_History_Point_t point = Signal_History_finish(&series->pending[tier - 1]);
+            series->points[tier - 1][history->head[tier]] = point;
+            if (tier < SIGNAL_HISTORY_TIER_COUNT - 1) {
+                Signal_History_accumulate(&series->pending[tier], &point);
+            }
+        }
+        Signal_History_advance(history, tier);
+    }
+}
+
+bool Signal_History_sample(Signal_History_t* history, unsigned long nowMs) {
+    // Driven by the clock, not by redraws: a late call records the ticks it missed
+    if (!history->started) {
+        history->started = true;
+        history->nextSampleMs = nowMs;
+    }
+    int recorded = 0;
+    while ((long)(nowMs - history->nextSampleMs) >= 0 && recorded < SIGNAL_HISTORY_MAX_CATCH_UP) {
+        Signal_History_record(history, nowMs);
+        history->nextSampleMs += SIGNAL_HISTORY_BASE_PERIOD_MS;
+        recorded++;
+    }
+    if ((long)(nowMs - history->nextSampleMs) >= 0) {
+        history->nextSampleMs = nowMs + SIGNAL_HISTORY_BASE_PERIOD_MS;
+    }
+    return recorded > 0;
+}
+
+uint32_t Signal_History_tierPeriodMs(int tier) {
+    uint32_t period = SIGNAL_HISTORY_BASE_PERIOD_MS;
+    for (int i = 0; i < tier; i++) {
+        period *= SIGNAL_HISTORY_DECIMATION;
+    }
+    return period;
+}
+
+int Signal_History_tierFor(uint32_t spanMs) {
+    // Finest tier that covers the span
+    for (int tier = 0; tier < SIGNAL_HISTORY_TIER_COUNT - 1; tier++) {
+        if (Signal_History_tierPeriodMs(tier) * SIGNAL_HISTORY_LENGTH >= spanMs) {
+            return tier;
+        }
+    }
+    return SIGNAL_HISTORY_TIER_COUNT - 1;
+}
+
+uint16_t Signal_History_available(const Signal_History_t* history, int tier) {
+    return history->filled[tier];
+}
+
+Signal_History_Point_t Signal_History_get(const Signal_History_t* history, int signal, int tier, uint16_t age) {
+    // age 0 is the newest point
+    if (signal < 0 || signal >= history->count || age >= history->filled[tier]) {
+        return SIGNAL_HISTORY_GAP;
+    }
+    uint16_t index = (uint16_t)((history->head[tier] + SIGNAL_HISTORY_LENGTH - 1 - age) % SIGNAL_HISTORY_LENGTH);
+    const Signal_History_Series_t* series = &history->series[signal];
+    if (tier == 0) {
+        int16_t value = series->samples[index];
+        Signal_History_Point_t point = {value, value, value};
+        return point;
+    }
+    return series->points[tier - 1][index];
+}
+
+Signal_History_Point_t Signal_History_range(const Signal_History_t* history, int signal, int tier, uint16_t age, uint16_t count) {
+    // Points [age, age + count) folded into one, e.g. one graph column
+    Signal_History_Accumulator_t acc;
+    Signal_History_resetAccumulator(&acc);
+    for (uint16_t i = 0; i < count; i++) {
+        Signal_History_Point_t point = Signal_History_get(history, signal, tier, (uint16_t)(age + i));
+        Signal_History_accumulate(&acc, &point);
+    }
+    return Signal_History_finish(&acc);
+}
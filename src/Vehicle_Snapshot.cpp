@@ -0,0 +1,40 @@
+#include "Vehicle_Snapshot.h"
+#include <string.h>
+
+void Vehicle_Snapshot_init(Vehicle_Snapshot_t* snapshot) {
+    memset(&snapshot->data, 0, sizeof(snapshot->data));
+    snapshot->sequence.store(0, std::memory_order_relaxed);
+}
+
+void Vehicle_Snapshot_publish(Vehicle_Snapshot_t* snapshot, const Vehicle_Data_t* data) {
+    // Odd sequence marks a write in progress
+    uint32_t sequence = snapshot->sequence.load(std::memory_order_relaxed);
+    snapshot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy(&snapshot->data, data, sizeof(*data));
+
+    snapshot->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+uint32_t Vehicle_Snapshot_read(const Vehicle_Snapshot_t* snapshot, Vehicle_Data_t* data) {
+    uint32_t before;
+    uint32_t after;
+    do {
+        before = snapshot->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        memcpy(data, &snapshot->data, sizeof(*data));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = snapshot->sequence.load(std::memory_order_relaxed);
+        if (before == after) {
+            break;
+        }
+    } while (true);
+    return before;
+}
+
+uint32_t Vehicle_Snapshot_sequence(const Vehicle_Snapshot_t* snapshot) {
+    return snapshot->sequence.load(std::memory_order_acquire);
+}
@@ -0,0 +1,158 @@
+#include "Vehicle_State.h"
+#include <stdio.h>
+#include <string.h>
+
+// === STALE THRESHOLDS ===
+// A few missed periods of the slowest source of each signal, 0 = never stale
+static constexpr uint16_t VEHICLE_STATE_STALE_MS[VEHICLE_STATE_SIGNAL_COUNT] = {
+    // DME1, DME2 and DME4 are broadcast every 10-20 ms
+    500, 500, 500, 500, 500, 500,                   // Ignition .. torque loss
+    500, 500,                                       // Coolant, manifold pressure
+    500, 500, 500, 500,                             // MIL, cruise, EML, oil temperature
+    // MS42 blocks polled by Diag_Poller, every 2 s while not on screen
+    6000, 6000, 6000, 6000, 6000,                   // Intake, outlet, fuel pressure, lambda, MAF
+    VEHICLE_STATE_NEVER_STALE,                      // VIN, read once on request
+    // Kawasaki calibration tool frame
+    1000, 1000, 1000, 1000, 1000,
+};
+static_assert(VEHICLE_STATE_SIGNAL_COUNT == 23, "Stale thresholds must list every signal");
+
+// === SIGNAL NAMES ===
+// Used by the console and the alert rules file, lower case without spaces
+static const char* const VEHICLE_STATE_NAMES[VEHICLE_STATE_SIGNAL_COUNT] = {
+    "ignition", "cranking", "tcs", "torque", "rpm", "torque_loss",
+    "coolant", "map",
+    "mil", "cruise", "eml", "oil",
+    "intake", "outlet", "fuel_pressure", "lambda", "maf",
+    "vin",
+    "kw_rpm", "kw_tps", "kw_iap", "kw_ect", "kw_coolant",
+};
+
+void Vehicle_State_clear(Vehicle_State_t* state) {
+    // Everything becomes missing, and drawn as such
+    uint32_t generation = state->generation + 1;
+    uint32_t nowMs = state->nowMs;
+    memset(state, 0, sizeof(*state));
+    state->generation = generation;
+    state->nowMs = nowMs;
+    for (int i = 0; i < VEHICLE_STATE_SIGNAL_COUNT; i++) {
+        state->changedGeneration[i] = generation;
+    }
+}
+
+void Vehicle_State_begin(Vehicle_State_t* state, uint32_t nowMs) {
+    // Once per CAN task step, before anything is decoded
+    state->generation++;
+    state->nowMs = nowMs;
+}
+
+void Vehicle_State_touch(Vehicle_State_t* state, uint32_t updated, uint32_t changed) {
+    // A first reading changes what is drawn even when it equals the cleared value
+    changed |= updated & ~state->received;
+    state->received |= updated;
+    for (uint8_t i = 0; updated != 0; i++, updated >>= 1, changed >>= 1) {
+        if (updated & 1) {
+            state->updatedMs[i] = state->nowMs;
+            state->updates[i]++;
+        }
+        if (changed & 1) {
+            state->changedGeneration[i] = state->generation;
+        }
+    }
+}
+
+uint32_t Vehicle_State_set(Vehicle_State_t* state, uint8_t signal, int32_t value) {
+    // For values that do not come from a signal table (simulated data, the VIN flag)
+    if (signal >= VEHICLE_STATE_SIGNAL_COUNT) {
+        return 0;
+    }
+    // Out of range is not available, as for decoded signals
+    int16_t stored = (int16_t)(value > INT16_MAX || value < INT16_MIN ? SIGNAL_NO_VALUE : value);
+    uint32_t bit = 1u << signal;
+    uint32_t changed = state->value[signal] != stored ? bit : 0;
+    state->value[signal] = stored;
+    Vehicle_State_touch(state, bit, changed);
+    return changed;
+}
+
+uint32_t Vehicle_State_staleAfterMs(uint8_t signal) {
+    return signal < VEHICLE_STATE_SIGNAL_COUNT ? VEHICLE_STATE_STALE_MS[signal] : VEHICLE_STATE_NEVER_STALE;
+}
+
+const char* Vehicle_State_signalName(uint8_t signal) {
+    return signal < VEHICLE_STATE_SIGNAL_COUNT ? VEHICLE_STATE_NAMES[signal] : "?";
+}
+
+int Vehicle_State_findSignal(const char* name) {
+    for (int i = 0; i < VEHICLE_STATE_SIGNAL_COUNT; i++) {
+        if (strcmp(VEHICLE_STATE_NAMES[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+Vehicle_ValueStatus_t Vehicle_State_status(const Vehicle_State_t* state, uint8_t signal, uint32_t nowMs) {
+    if (signal >= VEHICLE_STATE_SIGNAL_COUNT || !(state->received & (1u << signal)) ||
+        state->value[signal] == SIGNAL_NO_VALUE) {
+        return VEHICLE_VALUE_MISSING;
+    }
+    uint32_t staleMs = VEHICLE_STATE_STALE_MS[signal];
+    // Signed age: the reader's clock may lag the writer's by a tick
+    if (staleMs != VEHICLE_STATE_NEVER_STALE && (int32_t)(nowMs - state->updatedMs[signal]) > (int32_t)staleMs) {
+        return VEHICLE_VALUE_STALE;
+    }
+    return VEHICLE_VALUE_FRESH;
+}
+
+uint32_t Vehicle_State_staleMask(const Vehicle_State_t* state, uint32_t signals, uint32_t nowMs) {
+    // Signals of the mask without a fresh value, e.g. hashed into a screen key
+    uint32_t mask = 0;
+    for (uint8_t i = 0; signals != 0; i++, signals >>= 1) {
+        if ((signals & 1) && Vehicle_State_status(state, i, nowMs) != VEHICLE_VALUE_FRESH) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+bool Vehicle_State_changedSince(const Vehicle_State_t* state, uint32_t signals, uint32_t generation) {
+    for (uint8_t i = 0; signals != 0; i++, signals >>= 1) {
+        if ((signals & 1) && (int32_t)(state->changedGeneration[i] - generation) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t Vehicle_State_lastChange(const Vehicle_State_t* state, uint32_t signals) {
+    // Generation of the newest change in the mask, equal as long as none of its values changed
+    uint32_t last = 0;
+    bool any = false;
+    for (uint8_t i = 0; signals != 0; i++, signals >>= 1) {
+        if ((signals & 1) && (!any || (int32_t)(state->changedGeneration[i] - last) > 0)) {
+            last = state->changedGeneration[i];
+            any = true;
+        }
+    }
+    return last;
+}
+
+int Vehicle_State_reading(const Vehicle_State_t* state, uint8_t signal, uint32_t nowMs, int fallback) {
+    // Value for bars and warnings, which must not act on a missing or stale reading
+    return Vehicle_State_status(state, signal, nowMs) == VEHICLE_VALUE_FRESH ? state->value[signal] : fallback;
+}
+
+void Vehicle_State_format(const Vehicle_State_t* state, uint8_t signal, uint32_t nowMs, char* buf, size_t size) {
+    switch (Vehicle_State_status(state, signal, nowMs)) {
+        case VEHICLE_VALUE_MISSING:
+            snprintf(buf, size, "--");
+            break;
+        case VEHICLE_VALUE_STALE:
+            snprintf(buf, size, "%d?", state->value[signal]);
+            break;
+        default:
+            snprintf(buf, size, "%d", state->value[signal]);
+            break;
+    }
+}
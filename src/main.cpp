@@ -1,17 +1,39 @@
 // TODO: (DME4) from instrument cluster https://forums.bimmerforums.com/forum/showthread.php?1887229-E46-Can-bus-project
-// - add a way to request vin from the instrument cluster
 // - add a way to request cluster data from the instrument cluster
 // - add a way to request cluster data from the instrument cluster
+#ifdef ARDUINO_ARCH_ESP32
 #include <SPI.h>
 #include <mcp_can.h>
 #include <Wire.h>
+#include "CAN_MCP2515.h"
+#else
+#include "CAN_Mock.h"
+#include "Display_Headless.h"
+#endif
 #include <U8g2lib.h>
 #include "SPIFFS.h"
 #include "BMW_CAN.h"
 #include "Kawasaki_CAN.h"
 #include "CAN_Reader.h"
+#include "CAN_Replay.h"
+#include "CAN_Logger.h"
+#include "CAN_Trace.h"
+#include "CAN_Stats.h"
+#include "Alert_Engine.h"
+#include "Perf_Trace.h"
 #include "Serial_Handler.h"
-#include "FakeDataGenerator.h"
+#include "Engine_Sim.h"
+#include "Display_Renderer.h"
+#include "Anim_Player.h"
+#include "Glyph_Atlas.h"
+#include "Layout_Engine.h"
+#include "ISOTP.h"
+#include "Diag_Poller.h"
+#include "Kombi_VIN.h"
+#include "Vehicle_State.h"
+#include "Vehicle_Snapshot.h"
+#include "Signal_History.h"
+#include "Task_Config.h"
 
 // === PIN DEFINITIONS ===
 #define CAN_CS_PIN 5
@@ -20,122 +42,601 @@
 #define CAN_MISO 19
 #define CAN_MOSI 23
 
-// === DISPLAY CONFIGURATION ===
-const int FRAME_WIDTH = 128;
-const int FRAME_HEIGHT = 64;
-const int FRAME_SIZE = FRAME_WIDTH * FRAME_HEIGHT / 8;
-const int NUM_SCREENS = 4;
-
 // === DEVELOPMENT CONFIGURATION ===
 bool dev_mode = true;      // Development mode flag
 bool show_intro = false;   // Show intro animation flag
-int currentScreen = 3;     // Current display screen (0=RPM, 1=Temp, 2=RPM Meter, 3=Detailed Temp)
+int currentScreen = 3;     // Current layout screen (built-in: 0=RPM, 1=Temp, 2=RPM Meter, 3=Detailed Temp)
+uint32_t sim_seed = ENGINE_SIM_DEFAULT_SEED;  // Demo mode engine simulator, see the "sim" command
+uint8_t sim_bus_load = 0;                     // Percent of the bus, filler frames make up the difference
+bool sim_unfiltered = false;                  // Filler frames bypass the acceptance filter
 
 // === VEHICLE CONFIGURATION ===
 VehicleType_t vehicleType = VEHICLE_BMW;  // Set to BMW by default
 
-// === BMW CAN DATA ===
-BMW_DME1_t dme1 = {0};
-BMW_DME2_t dme2 = {0};
-BMW_DME4_t dme4 = {0};
-BMW_MS42_Temp_t ms42_temp = {0};
-BMW_MS42_Status_t ms42_status = {0};
-BMW_Kombi_t kombi = {0};
+// === VEHICLE DATA ===
+// Decoded on the CAN task, published through the seqlock snapshot, copied into the view by the UI task
+Vehicle_Data_t rx_data = {};
+Vehicle_Snapshot_t vehicle_snapshot;
+Vehicle_Data_t view_data = {};
+bool rxDataUpdated = false;              // Set by the parsers on the CAN task
+volatile bool resetDataRequested = false; // Set by the UI task, handled by the CAN task
+
+// === VEHICLE STATE (render view) ===
+// Every signal with its timestamp, BMW_Signal_t slots from 0, Kawasaki_Signal_t slots after them
+Vehicle_State_t& view_state = view_data.state;
+BMW_Kombi_t& kombi = view_data.kombi;
 
-BMW_CAN_Context_t bmw_ctx = {&dme1, &dme2, &dme4, &ms42_temp, &ms42_status, &kombi};
+BMW_CAN_Context_t bmw_ctx = {&rx_data.state, &rx_data.kombi};
 
-// === KAWASAKI CAN DATA ===
-Kawasaki_CAN_Data_t kawasaki_data = {0};
+// === TASKS ===
+#ifdef ARDUINO_ARCH_ESP32
+TaskHandle_t canTaskHandle = nullptr;
+TaskHandle_t uiTaskHandle = nullptr;
+#endif
 
 // === CAN READER CONTEXT ===
 CAN_Reader_Context_t can_reader_ctx;
 
+// === LOG REPLAY ===
+CAN_Replay_t can_replay;
+CAN_Interface_t replay_interface;   // Swapped in for can_interface while a log plays
+
+// === ENGINE SIMULATOR ===
+Engine_Sim_t engine_sim;
+CAN_Interface_t sim_interface;      // Swapped in for can_interface in demo mode
+
+// === FLASH LOGGER ===
+CAN_Logger_t can_logger;
+
+// === DIAGNOSTICS ===
+// ISO-TP sessions on the diagnostic CAN IDs, all driven by the CAN task
+ISOTP_t diag_isotp;
+// MS42 values that are not broadcast, requested from the DME
+Diag_Poller_t diag_poller;
+// VIN from the instrument cluster, requested with "getvin"
+Kombi_VIN_t kombi_vin;
+
+// === FRAME TRACE ===
+CAN_Trace_t can_trace;
+
+// === BUS STATISTICS ===
+CAN_Stats_t can_stats;
+
+// === ALERTS ===
+// Threshold rules from ALERT_RULES_PATH on flash, evaluated by the UI task for every screen
+Alert_Engine_t alert_engine;
+
+// === PROFILER ===
+// Frame-to-pixel latency and task loop profile, compiled out with -DPERF_TRACE=0
+#if PERF_TRACE
+Perf_Trace_t perf_trace;
+#endif
+
+// === SHIFT LIGHT ===
+// RPM meter bars and blink follow the RPM trend extrapolated to when the frame reaches the panel
+bool shift_light_predict = true;
+
+// === GLYPH ATLAS ===
+// Readout glyphs and warning icons of the layout, rasterised by U8g2 whenever a layout is loaded
+Glyph_Atlas_t glyph_atlas;
+
+// === SCREEN LAYOUT ===
+// Screens built from widgets, read from LAYOUT_PATH on flash or the built-in layout. Fonts and
+// icons are compiled in and registered by name in setup().
+Layout_Engine_t layout_engine;
+
 // === SERIAL HANDLER CONTEXT ===
 Serial_Handler_Context_t serial_handler_ctx;
 
-// === DISPLAY STATE ===
-char displayBuffer[32];
-bool displayUpdated = false;
-uint8_t bmw_animation[FRAME_SIZE];
+// === INTRO ANIMATION ===
+#define INTRO_ANIMATION_PATH "/bmw_animation.anim"
+Anim_Player_t intro_player;
+uint32_t introRxCount = 0;          // Frames received when the intro started
 
-// === RPM METER CONFIGURATION ===
-const int NUM_BARS = 6;
-const int RPM_THRESHOLDS[NUM_BARS] = {5250, 5500, 5750, 6000, 6250, 6500};
-const int BLINK_THRESHOLD = 6500;
+// === SIGNAL HISTORY ===
+// Render view values sampled on a fixed clock by the UI task, for the layout's graphs
+Signal_History_t signal_history;
 
-// === TEMPERATURE CONFIGURATION ===
-const int TEMP_HISTORY_SIZE = 32;
-int tempHistory[TEMP_HISTORY_SIZE];
-int tempHistoryIndex = 0;
-
-const int HIGH_TEMP_THRESHOLD = 100;  // Temperature threshold for warning icons
-const int MIN_INTAKE_TEMP = 20;       // Minimum intake temperature
-const int MAX_INTAKE_TEMP = 60;       // Maximum intake temperature
+// === RENDER CONFIGURATION ===
+Display_Renderer_Context_t display_renderer_ctx;
 
 // === HARDWARE OBJECTS ===
+#ifdef ARDUINO_ARCH_ESP32
 MCP_CAN CAN(CAN_CS_PIN);
 U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, U8X8_PIN_NONE);
+#else
+CAN_Mock_t CAN;   // Fed from a frame file by native_main.cpp
+U8G2_SH1106_128X64_HEADLESS_F u8g2(U8G2_R0);
+#endif
+CAN_Interface_t can_interface;
 
 // Function prototypes
 void drawIntro();
-void drawTemperatureScreen();
-void drawRPMScreen();
-void drawRPMMeterScreen();
-void drawDetailedTemperatureScreen();
-void updateFakeData();
-void emptyAllData();
+void drawLayoutScreen(bool full);
+void drawShiftWarningIcon(int centerX, int topY);
+void drawCoolantWarningIcon(int tempX, int tempY);
+void drawOverheatIcon(int iconX, int iconY);
+void attachSimulator();
+bool detachSimulator();
+void emptyAllData(Vehicle_Data_t* data);
+void canTaskStep();
+void uiTaskStep();
+#ifdef ARDUINO_ARCH_ESP32
+void canTask(void* arg);
+void uiTask(void* arg);
+#endif
+int signalReading(uint8_t signal);
+int shiftLightRpm();
+int layoutPredict(uint8_t signal, int reading);
 
 // Serial Handler callback functions
+void handleScreenChange(int screen);
 void handleModeChange(bool devMode);
 void handleIntroShow();
 void handleVINRequest();
 void handleVehicleTypeChange(VehicleType_t vehicleType);
 void handleVehicleStatus(VehicleType_t vehicleType);
+void handleDisplayStats();
+void handleTaskStats();
+void handleReplayStart(const char* path, float speed);
+void handleReplayStop();
+void handleReplayStatus();
+void handleLogCommand(const char* args);
+void handleDiagCommand(const char* args);
+void handleSimCommand(const char* args);
+void handleAlertCommand(const char* args);
+void loadAlertRules();
+void canFrameTap(void* ctx, const CAN_Frame_t* frame);
+void handleShiftCommand(const char* args);
+void handlePerfCommand(const char* args);
+void handleAtlasCommand(const char* args);
+void handleLayoutCommand(const char* args);
+void loadLayout();
+bool diagSendFrame(void* ctx, uint32_t id, uint8_t len, const uint8_t* buf);
+uint32_t diagReceiveFrame(void* ctx, uint32_t id, uint8_t len, const uint8_t* buf);
 
 // Callback function implementations
+void handleScreenChange(int screen) {
+    if (screen < 0 || screen >= layout_engine.screenCount) {
+        Serial.printf("No screen %d, the layout has %u\n", screen + 1, (unsigned)layout_engine.screenCount);
+        return;
+    }
+    currentScreen = screen;
+    Serial.printf("Switched to %s Screen\n", layout_engine.screenNames[screen]);
+}
+
 void handleModeChange(bool devMode) {
+    // Vehicle data belongs to the CAN task, it is cleared on its next step
+    resetDataRequested = true;
     if (devMode) {
-        updateFakeData();
-    } else {
-        emptyAllData();
+        if (can_reader_ctx.canInterface == &replay_interface) {
+            CAN_Reader_setInterface(&can_reader_ctx, &can_interface);
+            CAN_Replay_close(&can_replay);
+        }
+        attachSimulator();
+        // 350 frames/s would bury the console
+        CAN_Trace_setLevel(&can_trace, CAN_TRACE_OFF);
+    } else if (detachSimulator()) {
+        CAN_Trace_setLevel(&can_trace, CAN_TRACE_DEFAULT_LEVEL);
+    }
+}
+
+void attachSimulator() {
+    // Demo frames take the same path as a car's: reader, filters, decoders and DME polling
+    detachSimulator();
+    Engine_Sim_setVehicles(&engine_sim, vehicleType != VEHICLE_KAWASAKI, vehicleType != VEHICLE_BMW);
+    Engine_Sim_setBusLoad(&engine_sim, sim_bus_load, sim_unfiltered);
+    Engine_Sim_initInterface(&sim_interface, &engine_sim);
+    CAN_Reader_setInterface(&can_reader_ctx, &sim_interface);
+}
+
+bool detachSimulator() {
+    // Once swapped out under the reader's lock the receive task no longer touches the simulator
+    if (can_reader_ctx.canInterface != &sim_interface) {
+        return false;
     }
+    CAN_Reader_setInterface(&can_reader_ctx, &can_interface);
+    return true;
 }
 
 void handleIntroShow() {
     drawIntro();
 }
 
+void handleDisplayStats() {
+    Display_Renderer_printStats(&display_renderer_ctx, layout_engine.screenNames, layout_engine.screenCount);
+}
+
+void handleTaskStats() {
+#ifdef ARDUINO_ARCH_ESP32
+    // ESP32 FreeRTOS reports stack high-water marks in bytes
+    TaskHandle_t tasks[] = {(TaskHandle_t)can_reader_ctx.rxTask, canTaskHandle, uiTaskHandle};
+    Serial.println("Task       prio  min free stack (bytes)");
+    for (size_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+        if (tasks[i] == nullptr) {
+            continue;
+        }
+        Serial.printf("%-10s %4u  %u\n", pcTaskGetName(tasks[i]),
+                      (unsigned)uxTaskPriorityGet(tasks[i]),
+                      (unsigned)uxTaskGetStackHighWaterMark(tasks[i]));
+    }
+#else
+    Serial.println("Native build: CAN and UI steps run sequentially from loop()");
+#endif
+}
+
+void handleReplayStart(const char* path, float speed) {
+    char spiffsPath[SERIAL_BUFFER_SIZE + 1];
+    snprintf(spiffsPath, sizeof(spiffsPath), "%s%s", path[0] == '/' ? "" : "/", path);
+    File file = SPIFFS.open(spiffsPath);
+    if (!file) {
+        Serial.printf("Cannot open %s\n", spiffsPath);
+        return;
+    }
+
+    // Detach a running replay before its file is replaced
+    CAN_Reader_setInterface(&can_reader_ctx, &can_interface);
+    if (!CAN_Replay_open(&can_replay, file, speed)) {
+        Serial.println("Unsupported log file");
+        return;
+    }
+    CAN_Replay_initInterface(&replay_interface, &can_replay);
+    CAN_Reader_setInterface(&can_reader_ctx, &replay_interface);
+
+    if (dev_mode) {
+        dev_mode = false;
+        handleModeChange(false);
+    }
+    if (speed > 0.0f) {
+        Serial.printf("Replaying %s at %.2fx\n", spiffsPath, speed);
+    } else {
+        Serial.printf("Replaying %s at max speed\n", spiffsPath);
+    }
+}
+
+void handleReplayStop() {
+    if (can_reader_ctx.canInterface != &replay_interface) {
+        Serial.println("No replay running");
+        return;
+    }
+    CAN_Reader_setInterface(&can_reader_ctx, &can_interface);
+    CAN_Replay_close(&can_replay);
+    Serial.println("Replay stopped, reading from the CAN controller");
+}
+
+void handleReplayStatus() {
+    if (can_reader_ctx.canInterface != &replay_interface) {
+        Serial.println("No replay running");
+        return;
+    }
+    char speedText[16];
+    if (can_replay.speed > 0.0f) {
+        snprintf(speedText, sizeof(speedText), "%.2fx", can_replay.speed);
+    } else {
+        snprintf(speedText, sizeof(speedText), "max");
+    }
+    Serial.printf("Replay %s (%s), log time %.1f s, speed %s\n",
+                  can_replay.finished ? "finished" : "running",
+                  CAN_Replay_formatName(can_replay.format),
+                  CAN_Replay_positionMs(&can_replay) / 1000.0f, speedText);
+    Serial.printf("Frames read: %lu  rejected by filter: %lu  parse errors: %lu\n",
+                  (unsigned long)can_replay.framesRead,
+                  (unsigned long)can_replay.framesRejected,
+                  (unsigned long)can_replay.parseErrors);
+}
+
+void handleLogCommand(const char* args) {
+    if (strcmp(args, "start") == 0) {
+        CAN_Logger_start(&can_logger);
+        Serial.println("Logging received frames to flash");
+    } else if (strcmp(args, "stop") == 0) {
+        CAN_Logger_stop(&can_logger);
+        Serial.println("Logging stopped");
+    } else if (strcmp(args, "status") == 0) {
+        CAN_Logger_printStatus(&can_logger);
+    } else if (strcmp(args, "list") == 0) {
+        CAN_Logger_list();
+    } else if (strncmp(args, "dump ", 5) == 0) {
+        if (!CAN_Logger_dump((uint16_t)atoi(args + 5))) {
+            Serial.println("No such log");
+        }
+    } else if (strcmp(args, "clear") == 0) {
+        if (CAN_Logger_isRecording(&can_logger)) {
+            Serial.println("Stop logging first");
+        } else if (!CAN_Logger_isIdle(&can_logger)) {
+            Serial.println("Logger still writing the last blocks, try again");
+        } else {
+            CAN_Logger_clear(&can_logger);
+            Serial.println("Logs deleted");
+        }
+    } else {
+        Serial.println("Usage: log start|stop|status|list|dump <n>|clear");
+    }
+}
+
+void handleDiagCommand(const char* args) {
+    if (strcmp(args, "status") == 0) {
+        Diag_Poller_printStatus(&diag_poller);
+    } else if (strcmp(args, "on") == 0 || strcmp(args, "off") == 0) {
+        Diag_Poller_setEnabled(&diag_poller, args[1] == 'n');
+        Serial.printf("Diagnostic polling %s\n", args);
+    } else {
+        Serial.println("Usage: diag status|on|off");
+    }
+}
+
+void handleSimCommand(const char* args) {
+    if (strcmp(args, "status") == 0) {
+        Engine_Sim_printStatus(&engine_sim);
+        return;
+    }
+    if (strncmp(args, "seed ", 5) == 0) {
+        // Restarts the drive, the same seed gives the same frames
+        sim_seed = (uint32_t)strtoul(args + 5, nullptr, 0);
+        bool attached = detachSimulator();
+        Engine_Sim_init(&engine_sim, sim_seed);
+        if (attached) {
+            attachSimulator();
+            resetDataRequested = true;
+        }
+        Serial.printf("Engine simulator restarted with seed %lu\n", (unsigned long)sim_seed);
+    } else if (strncmp(args, "load ", 5) == 0) {
+        char* end;
+        long percent = strtol(args + 5, &end, 10);
+        if (end == args + 5 || percent < 0 || percent > 100) {
+            Serial.println("Bus load is 0-100 percent");
+            return;
+        }
+        sim_bus_load = (uint8_t)percent;
+        sim_unfiltered = strcmp(end, " unfiltered") == 0;
+        if (detachSimulator()) {
+            attachSimulator();
+        } else {
+            Engine_Sim_setBusLoad(&engine_sim, sim_bus_load, sim_unfiltered);
+        }
+        Serial.printf("Simulated bus load %u%%%s\n", sim_bus_load, sim_unfiltered ? ", filler unfiltered" : "");
+    } else {
+        Serial.println("Usage: sim status|seed <n>|load <percent> [unfiltered]");
+    }
+}
+
+void loadAlertRules() {
+    // Per-car thresholds live on flash, the built-in rules match the original gauge
+    if (SPIFFS.exists(ALERT_RULES_PATH)) {
+        int rules = Alert_Engine_load(&alert_engine, SPIFFS.open(ALERT_RULES_PATH));
+        Serial.printf("Loaded %d alert rules from %s\n", rules, ALERT_RULES_PATH);
+    } else {
+        Alert_Engine_loadDefaults(&alert_engine);
+        Serial.println("No alert rules on flash, using the defaults");
+    }
+}
+
+void handleAlertCommand(const char* args) {
+    if (strcmp(args, "status") == 0) {
+        Alert_Engine_printStatus(&alert_engine, millis());
+    } else if (strcmp(args, "reload") == 0) {
+        loadAlertRules();
+    } else if (strcmp(args, "defaults") == 0) {
+        Alert_Engine_loadDefaults(&alert_engine);
+        Serial.println("Default alert rules restored, 'alerts save' keeps them");
+    } else if (strcmp(args, "save") == 0) {
+        if (Alert_Engine_save(&alert_engine, SPIFFS.open(ALERT_RULES_PATH, FILE_WRITE))) {
+            Serial.printf("Saved %u alert rules to %s\n", (unsigned)alert_engine.ruleCount, ALERT_RULES_PATH);
+        } else {
+            Serial.printf("Cannot write %s\n", ALERT_RULES_PATH);
+        }
+    } else if (strncmp(args, "rule ", 5) == 0) {
+        Alert_Rule_t rule;
+        if (!Alert_Engine_parseRule(args + 5, &rule)) {
+            Serial.println("Usage: alerts rule <name> <signal> <op> <threshold> [hyst=] [debounce=] [prio=] [show=] [screen=]");
+        } else if (!Alert_Engine_setRule(&alert_engine, &rule)) {
+            Serial.println("Alert rule table full");
+        } else {
+            Serial.printf("Alert rule %s set, 'alerts save' keeps it\n", rule.name);
+        }
+    } else if (strncmp(args, "remove ", 7) == 0) {
+        Serial.println(Alert_Engine_removeRule(&alert_engine, args + 7) ? "Alert rule removed" : "No such alert rule");
+    } else {
+        Serial.println("Usage: alerts status|reload|defaults|save|rule <line>|remove <name>");
+    }
+}
+
+void canFrameTap(void* ctx, const CAN_Frame_t* frame) {
+    CAN_Logger_record((CAN_Logger_t*)ctx, frame);
+    // Every DME1 frame with its receive time, the decoders only see the newest one of a batch
+    int16_t rpm;
+    if (BMW_decodeRPM(frame, &rpm)) {
+        RPM_Trend_sample(&rx_data.rpmTrend, frame->timestamp, rpm);
+    }
+}
+
+void handlePerfCommand(const char* args) {
+#if PERF_TRACE
+    if (strcmp(args, "reset") == 0) {
+        Perf_Trace_reset(&perf_trace);
+        Serial.println("Profile cleared");
+    } else if (*args == '\0') {
+        Perf_Trace_print(&perf_trace);
+    } else {
+        Serial.println("Usage: perf [reset]");
+    }
+#else
+    Serial.println("Profiler compiled out, build with -DPERF_TRACE=1");
+#endif
+}
+
+void handleAtlasCommand(const char* args) {
+    if (strcmp(args, "on") == 0 || strcmp(args, "off") == 0) {
+        glyph_atlas.enabled = strcmp(args, "on") == 0;
+    } else if (strcmp(args, "check") == 0) {
+        // Runs on the UI task like rendering, the next frame is sent in full
+        Serial.printf("Glyphs and icons: %lu pixels differ\n", (unsigned long)Glyph_Atlas_verify(&glyph_atlas));
+        static uint8_t reference[DISPLAY_RENDERER_BUFFER_SIZE];
+        bool enabled = glyph_atlas.enabled;
+        for (int screen = 0; screen < layout_engine.screenCount; screen++) {
+            Layout_Engine_prepare(&layout_engine, screen, millis());
+            glyph_atlas.enabled = false;
+            Layout_Engine_draw(&layout_engine, true);
+            memcpy(reference, u8g2.getBufferPtr(), sizeof(reference));
+            glyph_atlas.enabled = true;
+            Layout_Engine_draw(&layout_engine, true);
+            uint32_t differing = 0;
+            for (size_t i = 0; i < sizeof(reference); i++) {
+                differing += (uint32_t)__builtin_popcount((unsigned)(reference[i] ^ u8g2.getBufferPtr()[i]));
+            }
+            Serial.printf("%s screen: %lu pixels differ\n", layout_engine.screenNames[screen], (unsigned long)differing);
+        }
+        glyph_atlas.enabled = enabled;
+        Layout_Engine_invalidate(&layout_engine);
+        Display_Renderer_invalidate(&display_renderer_ctx);
+        return;
+    } else if (strcmp(args, "status") != 0) {
+        Serial.println("Usage: atlas [status|on|off|check]");
+        return;
+    }
+    Glyph_Atlas_printStatus(&glyph_atlas);
+}
+
+void loadLayout() {
+    // Screens live on flash, the built-in layout is the four original screens
+    if (SPIFFS.exists(LAYOUT_PATH) && Layout_Engine_load(&layout_engine, SPIFFS.open(LAYOUT_PATH))) {
+        Serial.printf("Loaded %u screens from %s\n", (unsigned)layout_engine.screenCount, LAYOUT_PATH);
+    } else {
+        Layout_Engine_loadDefaults(&layout_engine);
+        Serial.println("Using the built-in screen layout");
+    }
+    // Loading rasterises into the frame buffer, so the panel is sent in full
+    Display_Renderer_invalidate(&display_renderer_ctx);
+}
+
+void handleLayoutCommand(const char* args) {
+    if (strcmp(args, "status") == 0) {
+        Layout_Engine_printStatus(&layout_engine);
+    } else if (strcmp(args, "reload") == 0) {
+        loadLayout();
+    } else if (strcmp(args, "defaults") == 0) {
+        Layout_Engine_loadDefaults(&layout_engine);
+        Display_Renderer_invalidate(&display_renderer_ctx);
+        Serial.println("Built-in screen layout loaded");
+    } else if (strcmp(args, "check") == 0) {
+        // Runs on the UI task like rendering, the next frame is sent in full
+        for (int screen = 0; screen < layout_engine.screenCount; screen++) {
+            Serial.printf("%s screen: %lu pixels differ\n", layout_engine.screenNames[screen],
+                          (unsigned long)Layout_Engine_verify(&layout_engine, screen, millis()));
+        }
+        Layout_Engine_invalidate(&layout_engine);
+        Display_Renderer_invalidate(&display_renderer_ctx);
+    } else {
+        Serial.println("Usage: layout [status]|reload|defaults|check");
+    }
+}
+
+void handleShiftCommand(const char* args) {
+    if (strcmp(args, "on") == 0 || strcmp(args, "off") == 0) {
+        shift_light_predict = strcmp(args, "on") == 0;
+    } else if (strcmp(args, "status") != 0) {
+        Serial.println("Usage: shift [status|on|off]");
+        return;
+    }
+    const RPM_Trend_t* trend = &view_data.rpmTrend;
+    Serial.printf("Shift light: %s, panel latency %lu us\n",
+                  shift_light_predict ? "predicted RPM" : "last decoded RPM",
+                  (unsigned long)display_renderer_ctx.latencyUs);
+    Serial.printf("RPM %d, slope %ld rpm/s, shown as %d\n", signalReading(BMW_SIGNAL_RPM),
+                  (long)trend->slope, shiftLightRpm());
+    Serial.printf("Trend samples: %lu, restarts: %lu\n", (unsigned long)trend->samples, (unsigned long)trend->restarts);
+}
+
+bool diagSendFrame(void* ctx, uint32_t id, uint8_t len, const uint8_t* buf) {
+    return CAN_Reader_send((CAN_Reader_Context_t*)ctx, id, len, buf);
+}
+
+uint32_t diagReceiveFrame(void* ctx, uint32_t id, uint8_t len, const uint8_t* buf) {
+    return ISOTP_onFrame((ISOTP_t*)ctx, id, len, buf);
+}
+
 void handleVINRequest() {
-    // TODO: Implement VIN request functionality
-    // This would typically send a CAN message to request VIN from instrument cluster
+    // Sent by the CAN task, the answer is printed by uiTaskStep once it arrived
+    if (CAN_Reader_activeVehicle(&can_reader_ctx) != VEHICLE_BMW) {
+        Serial.println("VIN request needs a BMW bus");
+    } else if (can_reader_ctx.canInterface != &can_interface) {
+        Serial.println("VIN request not available during replay");
+    } else {
+        Kombi_VIN_request(&kombi_vin);
+        Serial.println("Requesting VIN from instrument cluster...");
+    }
 }
 
 void handleVehicleTypeChange(VehicleType_t vehicleType) {
-    // Vehicle type change is handled in the Serial_Handler
-    // This callback can be used for additional actions when vehicle type changes
+    // The Serial_Handler asked the CAN task to switch the reader, the simulator follows with its frames
+    if (dev_mode) {
+        attachSimulator();
+    }
 }
 
 void handleVehicleStatus(VehicleType_t vehicleType) {
-    // Vehicle status is handled in the Serial_Handler
-    // This callback can be used for additional status reporting
+    Serial.print("Current vehicle type: ");
+    switch (vehicleType) {
+        case VEHICLE_BMW:
+            Serial.println("BMW");
+            break;
+        case VEHICLE_KAWASAKI:
+            Serial.println("Kawasaki");
+            break;
+        case VEHICLE_UNKNOWN:
+            Serial.println("Auto-detect");
+            Bus_Fingerprint_printStatus(&can_reader_ctx.fingerprint);
+            break;
+    }
+    Serial.printf("CAN frames received: %lu  ring overflows: %lu\n",
+                  (unsigned long)can_reader_ctx.rxCount,
+                  (unsigned long)CAN_Reader_getOverflowCount(&can_reader_ctx));
+
+    // Frames rejected by the MCP2515 never reach us, only mask leakage can be counted
+    const CAN_Filter_Config_t* filters = &can_reader_ctx.filterConfig;
+    Serial.printf("HW filter: %s, %lu IDs admitted, masks 0x%03X/0x%03X, filters",
+                  filters->acceptAll ? "open" : (filters->exact ? "exact" : "masked"),
+                  (unsigned long)CAN_Filter_acceptedIdCount(filters), filters->masks[0], filters->masks[1]);
+    for (int i = 0; i < CAN_FILTER_SLOT_COUNT; i++) {
+        Serial.printf(" 0x%03X", filters->filters[i]);
+    }
+    Serial.println();
+    Serial.printf("Accepted by HW filter: %lu  decoded: %lu  without decoder: %lu\n",
+                  (unsigned long)can_reader_ctx.rxCount,
+                  (unsigned long)(can_reader_ctx.rxCount - can_reader_ctx.rxUnmatched),
+                  (unsigned long)can_reader_ctx.rxUnmatched);
 }
 
 void setup() {
   Serial.begin(115200);
+#ifdef ARDUINO_ARCH_ESP32
   SPI.begin(CAN_SCK, CAN_MISO, CAN_MOSI, CAN_CS_PIN);
   pinMode(CAN_INT_PIN, INPUT);
 
-  // Initialize CAN
-  if (CAN.begin(MCP_ANY, CAN_500KBPS, MCP_8MHZ) == CAN_OK) {
+  // Initialize CAN (standard frames only, filters are set up by CAN_Reader_init)
+  if (CAN.begin(MCP_STD, CAN_500KBPS, MCP_8MHZ) == CAN_OK) {
     Serial.println("MCP2515 initialized.");
   } else {
     Serial.println("MCP2515 init failed. Check wiring.");
     while (1);
   }
   CAN.setMode(MCP_NORMAL);
+  CAN_MCP2515_init(&can_interface, &CAN);
+#else
+  // The frame file (if any) was opened by native_main.cpp before setup()
+  CAN_Mock_initInterface(&can_interface, &CAN);
+#endif
 
   // Initialize CAN Reader
-  CAN_Reader_init(&can_reader_ctx, vehicleType, &CAN, &displayUpdated);
+  CAN_Reader_init(&can_reader_ctx, vehicleType, &can_interface, &rxDataUpdated);
+  ISOTP_init(&diag_isotp, diagSendFrame, &can_reader_ctx);
+  bmw_ctx.diagFrame = diagReceiveFrame;
+  bmw_ctx.diagCtx = &diag_isotp;
+  Diag_Poller_init(&diag_poller, &diag_isotp, &bmw_ctx);
+  Kombi_VIN_init(&kombi_vin, &diag_isotp, &bmw_ctx);
+  if (!CAN_Reader_start(&can_reader_ctx, CAN_INT_PIN)) {
+    Serial.println("CAN receive task not started, falling back to polling.");
+  }
 
   // Initialize Serial Handler
   Serial_Handler_init(&serial_handler_ctx, 
@@ -143,19 +644,50 @@ void setup() {
                      &dev_mode, 
                      &vehicleType,
                      &can_reader_ctx,
-                     &CAN,
-                     &displayUpdated,
-                     nullptr,  // screenChangeCallback (not needed as we handle it directly)
+                     &can_interface,
+                     &rxDataUpdated,
+                     handleScreenChange,
                      handleModeChange,
                      handleIntroShow,
                      handleVINRequest,
                      handleVehicleTypeChange,
                      handleVehicleStatus);
+  serial_handler_ctx.displayStatsCallback = handleDisplayStats;
+  serial_handler_ctx.taskStatsCallback = handleTaskStats;
+  serial_handler_ctx.replayStartCallback = handleReplayStart;
+  serial_handler_ctx.replayStopCallback = handleReplayStop;
+  serial_handler_ctx.replayStatusCallback = handleReplayStatus;
+  serial_handler_ctx.logCommandCallback = handleLogCommand;
+  serial_handler_ctx.diagCommandCallback = handleDiagCommand;
+  serial_handler_ctx.simCommandCallback = handleSimCommand;
+  serial_handler_ctx.alertCommandCallback = handleAlertCommand;
+  serial_handler_ctx.shiftCommandCallback = handleShiftCommand;
+  serial_handler_ctx.perfCommandCallback = handlePerfCommand;
+  serial_handler_ctx.atlasCommandCallback = handleAtlasCommand;
+  serial_handler_ctx.layoutCommandCallback = handleLayoutCommand;
+  CAN_Replay_init(&can_replay);
 
   // OLED setup
   u8g2.begin();
+
+  // Fonts and icons layouts can name, the atlas is filled from them when a layout is loaded
+  Glyph_Atlas_init(&glyph_atlas, &u8g2);
+  Layout_Engine_init(&layout_engine, &u8g2, &glyph_atlas, &view_state, &alert_engine, &signal_history);
+  layout_engine.predict = layoutPredict;
+  Layout_Engine_addFont(&layout_engine, "6x12_tr", u8g2_font_6x12_tr);
+  Layout_Engine_addFont(&layout_engine, "5x8_tr", u8g2_font_5x8_tr);
+  Layout_Engine_addFont(&layout_engine, "7x13B_tf", u8g2_font_7x13B_tf);
+  Layout_Engine_addFont(&layout_engine, "tenthinnerguys_tf", u8g2_font_tenthinnerguys_tf);
+  Layout_Engine_addFont(&layout_engine, "tenfatguys_tu", u8g2_font_tenfatguys_tu);
+  Layout_Engine_addFont(&layout_engine, "logisoso22_tn", u8g2_font_logisoso22_tn);
+  Layout_Engine_addFont(&layout_engine, "lucasfont_alternate_tf", u8g2_font_lucasfont_alternate_tf);
+  Layout_Engine_addIcon(&layout_engine, "shift", drawShiftWarningIcon);
+  Layout_Engine_addIcon(&layout_engine, "coolant", drawCoolantWarningIcon);
+  Layout_Engine_addIcon(&layout_engine, "overheat", drawOverheatIcon);
+
   u8g2.setFont(u8g2_font_6x12_tr);
   u8g2.clearBuffer();
+  Display_Renderer_init(&display_renderer_ctx, &u8g2, DISPLAY_RENDERER_MIN_FRAME_MS);
   
   if(!SPIFFS.begin()){
 	Serial.println("SPIFFS Mount Failed");
@@ -164,402 +696,309 @@ void setup() {
 	Serial.println("SPIFFS Mount Success");
   }
 
+  // Alert rules: from flash when present, the UI task evaluates them for every screen
+  Alert_Engine_init(&alert_engine);
+  loadAlertRules();
+
+  // Frame logger: encoding runs on the CAN task, flash writes on their own task
+  CAN_Logger_init(&can_logger);
+  CAN_Logger_startWriter(&can_logger);
+  can_reader_ctx.frameTap = canFrameTap;
+  can_reader_ctx.frameTapCtx = &can_logger;
+
+  // Frame dump to the console, queued by the CAN task and written by the UI task
+  CAN_Trace_init(&can_trace);
+  can_reader_ctx.trace = &can_trace;
+
+  // Per-ID rates and gaps, updated by the receive task for every frame read from the controller
+  CAN_Stats_reset(&can_stats);
+  can_reader_ctx.stats = &can_stats;
+
+#if PERF_TRACE
+  // Stamps every decoded frame on its way to the panel
+  Perf_Trace_init(&perf_trace);
+  can_reader_ctx.perf = &perf_trace;
+#endif
+
+  Signal_History_init(&signal_history, &view_state);
+  Signal_History_register(&signal_history, "coolant", BMW_SIGNAL_COOLANT_TEMP);
+  Signal_History_register(&signal_history, "oil", BMW_SIGNAL_OIL_TEMP);
+  Signal_History_register(&signal_history, "intake", BMW_SIGNAL_INTAKE_TEMP);
+  Signal_History_register(&signal_history, "rpm", BMW_SIGNAL_RPM);
+
+  // Screens: from flash when present, graphs use the series above
+  loadLayout();
+
+  Anim_Player_init(&intro_player);
   if(show_intro)
   {
     drawIntro();
   }
 
-  // Initialize values based on mode
+  // Demo mode drives the engine simulator through the CAN reader
+  emptyAllData(&rx_data);
+  Engine_Sim_init(&engine_sim, sim_seed);
   if (dev_mode) {
-    updateFakeData();
-  } else {
-    emptyAllData();
+    attachSimulator();
+    CAN_Trace_setLevel(&can_trace, CAN_TRACE_OFF);
   }
+  Vehicle_Snapshot_init(&vehicle_snapshot);
+  Vehicle_Snapshot_publish(&vehicle_snapshot, &rx_data);
 
   // Print initial help message
   Serial.println("\nBMW Screen Simulator");
   Serial.println("Type 'help' for available commands");
   Serial.print("> "); // Show initial prompt
+
+#ifdef ARDUINO_ARCH_ESP32
+  // CAN decode next to the receive task on core 0, rendering and console on core 1
+  xTaskCreatePinnedToCore(canTask, "can", CAN_TASK_STACK_SIZE, nullptr, CAN_TASK_PRIORITY, &canTaskHandle, CAN_TASK_CORE);
+  can_reader_ctx.consumerTask = canTaskHandle;
+  xTaskCreatePinnedToCore(uiTask, "ui", UI_TASK_STACK_SIZE, nullptr, UI_TASK_PRIORITY, &uiTaskHandle, UI_TASK_CORE);
+#endif
 }
 
 void drawIntro() {
-    u8g2.clearBuffer();
-    File animFile = SPIFFS.open("/bmw_animation.bin");
-    if(!animFile){
-    Serial.println("Failed to open file");
-    }
-    else{
-    Serial.println("File opened successfully");
-    }
-  	for (int i = 0; i < 171; i++) {
-		if(animFile.read(bmw_animation, FRAME_SIZE) != FRAME_SIZE){
-			Serial.println("Failed to read frame");
-			break;
-		}
-		u8g2.clearBuffer();
-		u8g2.drawXBMP(0, 0, FRAME_WIDTH, FRAME_HEIGHT, bmw_animation);
-		u8g2.sendBuffer();
-		delay(20);
+    // Played frame by frame from uiTaskStep, CAN ingestion keeps running meanwhile
+    if (!Anim_Player_start(&intro_player, SPIFFS.open(INTRO_ANIMATION_PATH), &u8g2)) {
+        Serial.println("Failed to open intro animation");
+        return;
     }
+    introRxCount = can_reader_ctx.rxCount;
 }
-void drawTemperatureScreen() {
-  u8g2.clearBuffer();
-  
-  // Coolant Temperature
-  u8g2.setFont(u8g2_font_tenthinnerguys_tf);  // Smaller font for labels
-  u8g2.drawStr(0, 15, "COOLANT");
-  u8g2.setFont(u8g2_font_tenfatguys_tu);  // Bold font that supports numbers and letters
-  snprintf(displayBuffer, sizeof(displayBuffer), "%d C", dme2.coolantTemp);
-  u8g2.drawStr(80, 18, displayBuffer);
-  
-  // Coolant Temperature Bar
-  const int barY = 23;
-  const int barHeight = 8;
-  const int barWidth = 120;
-  const int barX = 4;
-  const int minTemp = 80;
-  const int maxTemp = 110;
-  
-  // Draw bar background
-  u8g2.drawFrame(barX, barY, barWidth, barHeight);
-  
-  // Calculate fill width based on temperature
-  int coolantFill = map(constrain(dme2.coolantTemp, minTemp, maxTemp), minTemp, maxTemp, 0, barWidth);
-  u8g2.drawBox(barX, barY, coolantFill, barHeight);
-  
-  // Oil Temperature
-  u8g2.setFont(u8g2_font_tenthinnerguys_tf);  // Smaller font for labels
-  u8g2.drawStr(0, 51, "OIL");
-  u8g2.setFont(u8g2_font_tenfatguys_tu);  // Bold font that supports numbers and letters
-  snprintf(displayBuffer, sizeof(displayBuffer), "%d C", ms42_temp.oilTemp);
-  u8g2.drawStr(80, 51, displayBuffer);
-  
-  // Oil Temperature Bar
-  const int oilBarY = 56;
-  u8g2.drawFrame(barX, oilBarY, barWidth, barHeight);
-  int oilFill = map(constrain(ms42_temp.oilTemp, minTemp, maxTemp), minTemp, maxTemp, 0, barWidth);
-  u8g2.drawBox(barX, oilBarY, oilFill, barHeight);
-  
-  u8g2.sendBuffer();
+void drawShiftWarningIcon(int centerX, int topY) {
+  // Warning triangle with an exclamation mark, hanging from its top point
+  int symbolSize = 22;  // Made smaller
+  int width = 12;  // Reduced width of triangle base
+  
+  // Triangle points
+  int x1 = centerX;                // Top point
+  int y1 = topY;
+  int x2 = centerX - width;        // Bottom left
+  int y2 = topY + symbolSize;
+  int x3 = centerX + width;        // Bottom right
+  int y3 = topY + symbolSize;
+  
+  // Draw triangle
+  u8g2.drawLine(x1, y1, x2, y2);      // Left side
+  u8g2.drawLine(x2, y2, x3, y3);      // Bottom
+  u8g2.drawLine(x3, y3, x1, y1);      // Right side
+  
+  // Exclamation mark centered inside
+  u8g2.setFont(u8g2_font_7x13B_tf);   // Bold and readable
+  u8g2.drawStr(centerX - 3, topY + 17, "!");
 }
 
-void drawRPMScreen() {
-  u8g2.clearBuffer();
+void drawCoolantWarningIcon(int tempX, int tempY) {
+  // Engine Temp Warning Icon with Waves, from the top of the thermometer
+  int waveWidth = 16;
   
-  // === RPM Display ===
-  u8g2.setFont(u8g2_font_logisoso22_tn);
-  snprintf(displayBuffer, sizeof(displayBuffer), "%4drpm", dme1.rpm);
-  u8g2.drawStr(0, 22, displayBuffer);
+  // Shortened thermometer stem
+  u8g2.drawLine(tempX, tempY, tempX, tempY + 9);
+  u8g2.drawLine(tempX + 1, tempY, tempX + 1, tempY + 9);
   
-  // === RPM Bar ===
-  int rpmBarX = 0;
-  int rpmBarY = 27;
-  int rpmBarW = 128;
-  int rpmBarH = 3;
-  int rpmMax = 8500;
-  int rpmBlinkThreshold = 6000;
-  int rpmFill = map(dme1.rpm, 0, rpmMax, 0, rpmBarW);
+  // Smaller bulb
+  u8g2.drawCircle(tempX, tempY + 12, 3, U8G2_DRAW_ALL);
+  u8g2.drawDisc(tempX, tempY + 12, 1);
   
-  static bool blinkState = false;
-  static unsigned long lastBlink = 0;
-  unsigned long now = millis();
+  // Side ticks
+  u8g2.drawPixel(tempX - 3, tempY + 2);
+  u8g2.drawPixel(tempX - 3, tempY + 5);
+  u8g2.drawPixel(tempX - 3, tempY + 7);
   
-  bool showBar = true;
-  
-  if (dme1.rpm >= rpmBlinkThreshold) {
-    if (now - lastBlink > 150) {
-      blinkState = !blinkState;
-      lastBlink = now;
-    }
-    showBar = blinkState;
+  // Compact waves (tighter and lower)
+  for (int x = 0; x < waveWidth; x += 4) {
+    u8g2.drawLine(tempX + x - 8, tempY + 17, tempX + x - 6, tempY + 16);
+    u8g2.drawLine(tempX + x - 6, tempY + 16, tempX + x - 4, tempY + 17);
   }
-  u8g2.drawFrame(rpmBarX, rpmBarY, rpmBarW, rpmBarH);
-  if (showBar) {
-    u8g2.drawBox(rpmBarX, rpmBarY, rpmFill, rpmBarH);
-    
-    if (dme1.rpm >= rpmBlinkThreshold) {
-      // Draw warning triangle
-      int centerX = 108;
-      int topY = 2;  // Moved down slightly
-      int symbolSize = 22;  // Made smaller
-      int width = 12;  // Reduced width of triangle base
-      
-      // Triangle points
-      int x1 = centerX;                // Top point
-      int y1 = topY;
-      int x2 = centerX - width;        // Bottom left
-      int y2 = topY + symbolSize;
-      int x3 = centerX + width;        // Bottom right
-      int y3 = topY + symbolSize;
-      
-      // Draw triangle
-      u8g2.drawLine(x1, y1, x2, y2);      // Left side
-      u8g2.drawLine(x2, y2, x3, y3);      // Bottom
-      u8g2.drawLine(x3, y3, x1, y1);      // Right side
-      
-      // Exclamation mark centered inside
-      u8g2.setFont(u8g2_font_7x13B_tf);   // Bold and readable
-      u8g2.drawStr(centerX - 3, topY + 17, "!");
-    }
-    
-    // Draw temperature warning if over 90°C
-    if (dme2.coolantTemp > 90) {
-      // Engine Temp Warning Icon with Waves
-      int tempX = 78;   // X position of thermometer
-      int tempY = 2;    // Start near the top
-      int waveWidth = 16;
-      
-      // Shortened thermometer stem
-      u8g2.drawLine(tempX, tempY, tempX, tempY + 9);
-      u8g2.drawLine(tempX + 1, tempY, tempX + 1, tempY + 9);
-      
-      // Smaller bulb
-      u8g2.drawCircle(tempX, tempY + 12, 3, U8G2_DRAW_ALL);
-      u8g2.drawDisc(tempX, tempY + 12, 1);
-      
-      // Side ticks
-      u8g2.drawPixel(tempX - 3, tempY + 2);
-      u8g2.drawPixel(tempX - 3, tempY + 5);
-      u8g2.drawPixel(tempX - 3, tempY + 7);
-      
-      // Compact waves (tighter and lower)
-      for (int x = 0; x < waveWidth; x += 4) {
-        u8g2.drawLine(tempX + x - 8, tempY + 17, tempX + x - 6, tempY + 16);
-        u8g2.drawLine(tempX + x - 6, tempY + 16, tempX + x - 4, tempY + 17);
-      }
-      for (int x = 0; x < waveWidth; x += 4) {
-        u8g2.drawLine(tempX + x - 8, tempY + 19, tempX + x - 6, tempY + 18);
-        u8g2.drawLine(tempX + x - 6, tempY + 18, tempX + x - 4, tempY + 19);
-      }
-    }
+  for (int x = 0; x < waveWidth; x += 4) {
+    u8g2.drawLine(tempX + x - 8, tempY + 19, tempX + x - 6, tempY + 18);
+    u8g2.drawLine(tempX + x - 6, tempY + 18, tempX + x - 4, tempY + 19);
   }
-  
-  // === Engine Temp & Intake Temp ===
-  u8g2.setFont(u8g2_font_6x12_tr);
-  int intakeTemp = 32; // placeholder
-  snprintf(displayBuffer, sizeof(displayBuffer), "TMP:%dC  IAT:%dC", dme2.coolantTemp, ms42_temp.intakeTemp);
-  u8g2.drawStr(0, 40, displayBuffer);
-  
-  // === Torque Info ===
-  snprintf(displayBuffer, sizeof(displayBuffer), "TQ:%d%%  Loss:%d%%", dme1.torque, dme1.torqueLoss);
-  u8g2.drawStr(0, 52, displayBuffer);
-  
-  // === Footer ===
-  u8g2.setFont(u8g2_font_5x8_tr);
-  u8g2.drawStr(0, 63, "TEST TEST RPMLINK");
-  u8g2.drawStr(100, 63, "12.8V");
-  
-  u8g2.sendBuffer();
 }
 
-void drawRPMMeterScreen() {
-  u8g2.clearBuffer();
-  
-  // RPM Display in top left
-  u8g2.setFont(u8g2_font_tenfatguys_tu);
-  snprintf(displayBuffer, sizeof(displayBuffer), "%d", dme1.rpm);
-  u8g2.drawStr(0, 15, displayBuffer);
-  
-  // Small RPM text under the number
-  u8g2.setFont(u8g2_font_lucasfont_alternate_tf);  // Very small font
-  u8g2.drawStr(24, 24, "RPM");
-  
-  // Bar parameters
-  const int startX = 4;
-  const int startY = 20;
-  const int barSpacing = 4;
-  const int maxBarHeight = 54;
-  const int barWidth = 16;
-  const int baseHeight = 24;  // Starting height for first bar
-  const int heightStep = 6;   // How much taller each bar gets
-  const int bigStep = 12;     // Bigger step for bars 5 and 6
-  
-  // Calculate if we should blink (above 6500 RPM)
-  static bool blinkState = false;
-  static unsigned long lastBlink = 0;
-  unsigned long now = millis();
-  bool shouldBlink = dme1.rpm >= BLINK_THRESHOLD;
-  
-  if (shouldBlink && (now - lastBlink > 100)) {
-    blinkState = !blinkState;
-    lastBlink = now;
+void drawOverheatIcon(int iconX, int iconY) {
+  // Draw larger, more detailed temperature warning icon, from the top of the thermometer
+  // Thermometer stem (thicker)
+  u8g2.drawLine(iconX, iconY, iconX, iconY + 16);
+  u8g2.drawLine(iconX + 1, iconY, iconX + 1, iconY + 16);
+  u8g2.drawLine(iconX + 2, iconY, iconX + 2, iconY + 16);
+  
+  // Thermometer bulb (larger)
+  u8g2.drawCircle(iconX + 1, iconY + 20, 5, U8G2_DRAW_ALL);
+  u8g2.drawDisc(iconX + 1, iconY + 20, 2);
+  
+  // Temperature waves (more visible)
+  for (int i = 0; i < 3; i++) {
+    int waveY = iconY + 26 + (i * 4);
+    u8g2.drawLine(iconX - 4, waveY, iconX + 6, waveY);
+    u8g2.drawLine(iconX - 2, waveY - 1, iconX + 4, waveY - 1);
   }
   
-  // Draw bars
-  for (int i = 0; i < NUM_BARS; i++) {
-    int barHeight;
-    if (i < 4) {
-      // Bars 1-4: gradual increase
-      barHeight = baseHeight + (i * heightStep);
-    } else {
-      // Bars 5-6: bigger step
-      barHeight = baseHeight + (3 * heightStep) + ((i - 3) * bigStep);
-    }
-    int x = startX + (i * (barWidth + barSpacing));
-    int y = startY + (maxBarHeight - barHeight);  // Align to bottom
-    
-    // Draw bar background
-    u8g2.drawFrame(x, y, barWidth, barHeight);
-    
-    // Fill bar if RPM is above threshold
-    if (dme1.rpm >= RPM_THRESHOLDS[i]) {
-      if (!shouldBlink || blinkState) {
-        u8g2.drawBox(x, y, barWidth, barHeight);
-      }
-    }
+  // Exclamation mark
+  u8g2.setFont(u8g2_font_7x13B_tf);
+  u8g2.drawStr(iconX - 2, iconY + 12, "!");
+}
+
+void drawLayoutScreen(bool full) {
+  Layout_Engine_draw(&layout_engine, full);
+}
+
+int signalReading(uint8_t signal) {
+  // Fresh value of a render view signal, 0 while it is missing or stale so bars stay empty and warnings off
+  return Vehicle_State_reading(&view_state, signal, millis(), 0);
+}
+
+int shiftLightRpm() {
+  // Engine speed for the RPM meter bars: in shift-light mode the trend extrapolated to when the
+  // frame being drawn reaches the panel, on the same clock as the frame timestamps
+  int rpm = signalReading(BMW_SIGNAL_RPM);
+  if (!shift_light_predict || rpm == 0 || view_data.rpmTrend.count == 0) {
+    return rpm;
   }
-  
-  
-  u8g2.sendBuffer();
+  return RPM_Trend_predict(&view_data.rpmTrend, CAN_Reader_timestampUs() + display_renderer_ctx.latencyUs);
 }
 
-void drawDetailedTemperatureScreen() {
-  u8g2.clearBuffer();
-  
-  // === Temperature Warning Icon (if either IN or OUT is too high) ===
-  static bool blinkState = false;
-  static unsigned long lastBlink = 0;
-  unsigned long now = millis();
-  
-  bool tempWarning = (dme2.coolantTemp >= HIGH_TEMP_THRESHOLD) || (ms42_temp.outletTemp >= HIGH_TEMP_THRESHOLD);
-  
-  if (tempWarning) {
-    if (now - lastBlink > 500) {
-      blinkState = !blinkState;
-      lastBlink = now;
-    }
-    if (blinkState) {
-      // Draw larger, more detailed temperature warning icon
-      int iconX = 95;  // Position on the right side
-      int iconY = 2;   // Start from top
-      
-      // Thermometer stem (thicker)
-      u8g2.drawLine(iconX, iconY, iconX, iconY + 16);
-      u8g2.drawLine(iconX + 1, iconY, iconX + 1, iconY + 16);
-      u8g2.drawLine(iconX + 2, iconY, iconX + 2, iconY + 16);
-      
-      // Thermometer bulb (larger)
-      u8g2.drawCircle(iconX + 1, iconY + 20, 5, U8G2_DRAW_ALL);
-      u8g2.drawDisc(iconX + 1, iconY + 20, 2);
-      
-      // Temperature waves (more visible)
-      for (int i = 0; i < 3; i++) {
-        int waveY = iconY + 26 + (i * 4);
-        u8g2.drawLine(iconX - 4, waveY, iconX + 6, waveY);
-        u8g2.drawLine(iconX - 2, waveY - 1, iconX + 4, waveY - 1);
-      }
-      
-      // Exclamation mark
-      u8g2.setFont(u8g2_font_7x13B_tf);
-      u8g2.drawStr(iconX - 2, iconY + 12, "!");
-    }
+int layoutPredict(uint8_t signal, int reading) {
+  // Meters marked predict=1 in the layout show the shift-light RPM
+  return signal == BMW_SIGNAL_RPM ? shiftLightRpm() : reading;
+}
+
+void emptyAllData(Vehicle_Data_t* data) {
+    // Every signal becomes missing until its next frame
+    Vehicle_State_clear(&data->state);
+    RPM_Trend_reset(&data->rpmTrend);
+
+    // Reset VIN data
+    memset(data->kombi.vin, 0, sizeof(data->kombi.vin));
+    data->kombi.vinReceived = false;
+}
+
+void canTaskStep() {
+#ifdef ARDUINO_ARCH_ESP32
+  // Wait for the receive task to queue frames, or time out to keep diagnostics and the logger going
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_TASK_TIMEOUT_MS));
+#endif
+  PERF_LOOP_BEGIN(&perf_trace, PERF_TASK_CAN);
+  // Everything decoded in this step shares one timestamp and generation
+  Vehicle_State_begin(&rx_data.state, millis());
+
+  if (resetDataRequested) {
+    resetDataRequested = false;
+    emptyAllData(&rx_data);
+    rxDataUpdated = true;
   }
-  
-  // === IN/OUT Temperatures Section ===
-  // IN Temperature
-  u8g2.setFont(u8g2_font_tenthinnerguys_tf);
-  u8g2.drawStr(0, 15, "IN");
-  u8g2.setFont(u8g2_font_tenfatguys_tu);
-  snprintf(displayBuffer, sizeof(displayBuffer), "%d C", dme2.coolantTemp);
-  u8g2.drawStr(40, 15, displayBuffer);
-  
-  // OUT Temperature
-  u8g2.setFont(u8g2_font_tenthinnerguys_tf);
-  u8g2.drawStr(0, 30, "OUT");
-  u8g2.setFont(u8g2_font_tenfatguys_tu);
-  snprintf(displayBuffer, sizeof(displayBuffer), "%d C", ms42_temp.outletTemp);
-  u8g2.drawStr(40, 30, displayBuffer);
-  
-  // Draw separator line
-  u8g2.drawHLine(0, 34, 128);
-  
-  // === INTAKE Temperature Section ===
-  u8g2.setFont(u8g2_font_tenthinnerguys_tf);
-  u8g2.drawStr(0, 46, "INTAKE");
-  u8g2.setFont(u8g2_font_tenfatguys_tu);
-  
-  snprintf(displayBuffer, sizeof(displayBuffer), "%d C", ms42_temp.intakeTemp);
-  u8g2.drawStr(60, 46, displayBuffer);
-  
-  // Update temperature history
-  tempHistory[tempHistoryIndex] = ms42_temp.intakeTemp;
-  tempHistoryIndex = (tempHistoryIndex + 1) % TEMP_HISTORY_SIZE;
-  
-  // Draw temperature history graph
-  const int graphX = 0;
-  const int graphY = 50;
-  const int graphWidth = 128;
-  const int graphHeight = 14;
-  
-  // Draw graph background
-  u8g2.drawFrame(graphX, graphY, graphWidth, graphHeight);
-  
-  // Draw temperature history with lines instead of pixels
-  for (int i = 1; i < TEMP_HISTORY_SIZE; i++) {
-    int x1 = graphX + ((i-1) * graphWidth / TEMP_HISTORY_SIZE);
-    int x2 = graphX + (i * graphWidth / TEMP_HISTORY_SIZE);
-    int y1 = graphY + graphHeight - map(tempHistory[i-1], MIN_INTAKE_TEMP, MAX_INTAKE_TEMP, 0, graphHeight);
-    int y2 = graphY + graphHeight - map(tempHistory[i], MIN_INTAKE_TEMP, MAX_INTAKE_TEMP, 0, graphHeight);
-    
-    // Draw a line between points
-    u8g2.drawLine(x1, y1, x2, y2);
+
+  CAN_Reader_readMessages(&can_reader_ctx, &bmw_ctx, &rx_data.state);
+  PERF_MARK(&perf_trace, PERF_SECTION_CAN_DECODE);
+
+  // A live BMW bus or the simulator has a DME to ask, a replayed log cannot answer
+  bool bmwBus = CAN_Reader_activeVehicle(&can_reader_ctx) == VEHICLE_BMW;
+  if (bmwBus && can_reader_ctx.canInterface != &replay_interface) {
+    ISOTP_step(&diag_isotp);
+    Diag_Poller_step(&diag_poller);
+    Kombi_VIN_step(&kombi_vin);
   }
-  
-  u8g2.sendBuffer();
-}
-
-
-void emptyAllData() {
-    // Reset DME1 values
-    dme1.ignition = false;
-    dme1.cranking = false;
-    dme1.tcs = false;
-    dme1.torque = -1;
-    dme1.rpm = -1;
-    dme1.torqueLoss = -1;
-    
-    // Reset DME2 values
-    dme2.coolantTemp = -999;
-    dme2.manifoldPressure = -999;
-    
-    // Reset DME4 values
-    dme4.mil = false;
-    dme4.cruise = false;
-    dme4.eml = false;
-    
-    // Reset MS42 values
-    ms42_temp.intakeTemp = -999;
-    ms42_temp.oilTemp = -999;
-    ms42_temp.outletTemp = -999;
-    ms42_status.fuelPressure = -999;
-    ms42_status.lambda = -999;
-    ms42_status.maf = -999;
+  PERF_MARK(&perf_trace, PERF_SECTION_CAN_DIAG);
 
-    // Reset VIN data
-    memset(kombi.vin, 0, sizeof(kombi.vin));
-    kombi.vinReceived = false;
+  CAN_Logger_service(&can_logger);
+  PERF_MARK(&perf_trace, PERF_SECTION_CAN_LOG);
+
+  // Publish once per batch, the renderer never sees a half-written struct
+  if (rxDataUpdated) {
+    rxDataUpdated = false;
+    PERF_COMMIT(&perf_trace, &rx_data.perf, CAN_Reader_timestampUs());
+    Vehicle_Snapshot_publish(&vehicle_snapshot, &rx_data);
+  }
+  PERF_MARK(&perf_trace, PERF_SECTION_CAN_PUBLISH);
+  PERF_LOOP_END(&perf_trace, PERF_TASK_CAN);
 }
 
-void loop() {
-  // Handle any serial input
+void uiTaskStep() {
+  static uint32_t viewSequence = 0;
+  static uint32_t visibleSignals = 0;
+  PERF_LOOP_BEGIN(&perf_trace, PERF_TASK_UI);
+
+  // Handle any serial input, then send queued frame trace lines the UART can take
   Serial_Handler_processInput(&serial_handler_ctx);
-  
-  // Draw appropriate screen
-  if (currentScreen == 1) {
-    drawTemperatureScreen();
-  } else if (currentScreen == 2) {
-    drawRPMMeterScreen();
-  } else if (currentScreen == 3) {
-    drawDetailedTemperatureScreen();
-  } else {
-    drawRPMScreen();
+  CAN_Trace_drain(&can_trace);
+  Kombi_VIN_report(&kombi_vin);
+  PERF_MARK(&perf_trace, PERF_SECTION_UI_INPUT);
+
+  // Take a consistent copy of the latest vehicle data
+  if (Vehicle_Snapshot_sequence(&vehicle_snapshot) != viewSequence) {
+    viewSequence = Vehicle_Snapshot_read(&vehicle_snapshot, &view_data);
+    PERF_VIEWED(&perf_trace, &view_data.perf);
   }
-  
-  if (dev_mode) {
-    FakeDataGenerator_updateBMW(&bmw_ctx);
-    // FakeDataGenerator_updateKawasaki(&kawasaki_data);
-  } else {
-    CAN_Reader_readMessages(&can_reader_ctx, &bmw_ctx, &kawasaki_data);
-    delay(100);
+
+  // Alerts are evaluated whatever screen is shown, the most urgent one may replace it
+  Alert_Engine_update(&alert_engine, &view_state, millis());
+  int screen = Alert_Engine_overrideScreen(&alert_engine);
+  if (screen < 0 || screen >= layout_engine.screenCount) {
+    screen = (currentScreen >= 0 && currentScreen < layout_engine.screenCount) ? currentScreen : 0;
   }
+
+  // Sampled on a fixed clock whatever screen is shown, so graphs have no gaps
+  Signal_History_sample(&signal_history, millis());
+  PERF_MARK(&perf_trace, PERF_SECTION_UI_VIEW);
+
+  // Intro runs until it ends or real vehicle data arrives, then the screen is redrawn in full
+  if (Anim_Player_isPlaying(&intro_player)) {
+    if (!dev_mode && can_reader_ctx.rxCount != introRxCount) {
+      Anim_Player_stop(&intro_player);
+    } else {
+      Anim_Player_step(&intro_player, &display_renderer_ctx);
+      PERF_MARK(&perf_trace, PERF_SECTION_UI_RENDER);
+      PERF_LOOP_END(&perf_trace, PERF_TASK_UI);
+      return;
+    }
+  }
+
+  // The DME polls what the screen shows at the fast rate
+  uint32_t signals = Layout_Engine_screenSignals(&layout_engine, screen);
+  if (signals != visibleSignals) {
+    Diag_Poller_setVisibleSignals(&diag_poller, signals);
+    visibleSignals = signals;
+  }
+
+  // Every widget keys what it shows: bound values, staleness, alerts and blink phases.
+  // Redraw only when the screen state changed, only the changed widgets, and push only the changed tiles.
+  uint32_t frameKey = Layout_Engine_prepare(&layout_engine, screen, millis());
+#if PERF_TRACE
+  // Draw start and flush end close the frame-to-pixel pipeline of the snapshot on screen
+  uint64_t drawStartUs = CAN_Reader_timestampUs();
+  if (Display_Renderer_update(&display_renderer_ctx, screen, frameKey, drawLayoutScreen)) {
+    PERF_RENDERED(&perf_trace, drawStartUs, CAN_Reader_timestampUs());
+  }
+#else
+  Display_Renderer_update(&display_renderer_ctx, screen, frameKey, drawLayoutScreen);
+#endif
+  PERF_MARK(&perf_trace, PERF_SECTION_UI_RENDER);
+  PERF_LOOP_END(&perf_trace, PERF_TASK_UI);
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+void canTask(void* arg) {
+  for (;;) {
+    canTaskStep();
+  }
+}
+
+void uiTask(void* arg) {
+  for (;;) {
+    uiTaskStep();
+    vTaskDelay(pdMS_TO_TICKS(UI_TASK_PERIOD_MS));
+  }
+}
+
+void loop() {
+  // All work happens in canTask and uiTask
+  vTaskDelete(nullptr);
+}
+#else
+void loop() {
+  // No scheduler on the host, run both steps in turn
+  canTaskStep();
+  uiTaskStep();
 }
+#endif
\ No newline at end of file
@@ -0,0 +1,355 @@
+// Host benchmark suite for the hot paths of the firmware: the vehicle decoders, the CAN reader
+// fed by an in-memory controller, rasterisation of every screen into the headless frame buffer
+// and the serial console. Runs inside the native program after setup() and a short demo drive.
+// Every result is a "name ns/op ops/s" line; given a baseline in the same format, a benchmark
+// slower than the baseline plus the tolerance, or missing from it, fails the run. Baselines are
+// per host, tools/bench_baseline.py measures them and gates a change against its base commit.
+//   pio run -e bench && .pio/build/bench/program --benchmark --baseline bench/baseline.txt
+#ifndef ARDUINO_ARCH_ESP32
+
+#include "Native_Bench.h"
+#include <Arduino.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include "BMW_CAN.h"
+#include "Kawasaki_CAN.h"
+#include "CAN_Reader.h"
+#include "Engine_Sim.h"
+#include "Serial_Handler.h"
+#include "Display_Headless.h"
+#include "Layout_Engine.h"
+#include "Glyph_Atlas.h"
+#include "Task_Config.h"
+
+#define NATIVE_BENCH_FRAMES 4096
+#define NATIVE_BENCH_DECODE_ROUNDS 500
+#define NATIVE_BENCH_STEP_FRAMES 64     // Frames the controller holds per reader call, like CAN_MOCK_FRAMES_PER_STEP
+#define NATIVE_BENCH_DRAWS 2000
+#define NATIVE_BENCH_CONSOLE_ROUNDS 1000
+#define NATIVE_BENCH_MAX_RESULTS (8 + 2 * LAYOUT_MAX_SCREENS)  // Every screen with the atlas on and off
+
+// === FIRMWARE STATE (main.cpp) ===
+extern U8G2_SH1106_128X64_HEADLESS_F u8g2;
+extern Serial_Handler_Context_t serial_handler_ctx;
+extern int currentScreen;
+extern Layout_Engine_t layout_engine;
+extern Glyph_Atlas_t glyph_atlas;
+
+void loop();
+
+typedef struct {
+    char name[NATIVE_BENCH_NAME_SIZE];
+    double nsPerOp;
+} Native_Bench_Result_t;
+
+// Runs one round of a benchmark and returns the operations it did
+typedef uint32_t (*Native_Bench_Round_t)(void* ctx);
+
+static Native_Bench_Result_t results[NATIVE_BENCH_MAX_RESULTS];
+static size_t resultCount = 0;
+
+// === TIMING ===
+static void Native_Bench_measure(const char* name, Native_Bench_Round_t round, void* ctx, void (*prepare)(void)) {
+    double best = 0;
+    for (int repeat = 0; repeat < NATIVE_BENCH_REPEATS; repeat++) {
+        if (prepare != nullptr) {
+            prepare();
+        }
+        auto start = std::chrono::steady_clock::now();
+        uint32_t ops = round(ctx);
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / (ops > 0 ? ops : 1);
+        if (repeat == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    if (resultCount < NATIVE_BENCH_MAX_RESULTS) {
+        Native_Bench_Result_t* result = &results[resultCount++];
+        snprintf(result->name, sizeof(result->name), "%s", name);
+        result->nsPerOp = best;
+    }
+}
+
+// === DECODERS ===
+static CAN_Frame_t bmwFrames[NATIVE_BENCH_FRAMES];
+static CAN_Frame_t kawasakiFrames[NATIVE_BENCH_FRAMES];
+
+static void Native_Bench_simulate(CAN_Frame_t* frames, bool bmw, bool kawasaki) {
+    // A seeded demo drive, the same traffic mix the CAN reader sees in demo mode
+    Engine_Sim_t sim;
+    Engine_Sim_init(&sim, ENGINE_SIM_DEFAULT_SEED);
+    Engine_Sim_setVehicles(&sim, bmw, kawasaki);
+    for (size_t i = 0; i < NATIVE_BENCH_FRAMES; i++) {
+        Engine_Sim_next(&sim, &frames[i]);
+    }
+}
+
+static uint32_t Native_Bench_decodeBMW(void* ctx) {
+    for (int r = 0; r < NATIVE_BENCH_DECODE_ROUNDS; r++) {
+        for (size_t i = 0; i < NATIVE_BENCH_FRAMES; i += CAN_READER_BATCH_SIZE) {
+            BMW_decodeBatch(&bmwFrames[i], CAN_READER_BATCH_SIZE, (BMW_CAN_Context_t*)ctx);
+        }
+    }
+    return NATIVE_BENCH_FRAMES * NATIVE_BENCH_DECODE_ROUNDS;
+}
+
+static uint32_t Native_Bench_decodeKawasaki(void* ctx) {
+    for (int r = 0; r < NATIVE_BENCH_DECODE_ROUNDS; r++) {
+        for (size_t i = 0; i < NATIVE_BENCH_FRAMES; i += CAN_READER_BATCH_SIZE) {
+            Kawasaki_decodeBatch(&kawasakiFrames[i], CAN_READER_BATCH_SIZE, (Vehicle_State_t*)ctx);
+        }
+    }
+    return NATIVE_BENCH_FRAMES * NATIVE_BENCH_DECODE_ROUNDS;
+}
+
+// === CAN READER ===
+// Controller serving a frame array, a step at a time like the mock between two loop() calls
+typedef struct {
+    const CAN_Frame_t* frames;
+    size_t next;
+    size_t stepEnd;
+} Native_Bench_Controller_t;
+
+typedef struct {
+    CAN_Reader_Context_t reader;
+    CAN_Interface_t iface;
+    Native_Bench_Controller_t controller;
+    Vehicle_State_t state;
+    BMW_Kombi_t kombi;
+    BMW_CAN_Context_t bmw;
+    bool updated;
+} Native_Bench_Reader_t;
+
+static bool Native_Bench_available(void* impl) {
+    Native_Bench_Controller_t* controller = (Native_Bench_Controller_t*)impl;
+    return controller->next < controller->stepEnd;
+}
+
+static bool Native_Bench_read(void* impl, uint32_t* id, uint8_t* len, uint8_t* buf) {
+    Native_Bench_Controller_t* controller = (Native_Bench_Controller_t*)impl;
+    if (controller->next >= controller->stepEnd) {
+        return false;
+    }
+    const CAN_Frame_t* frame = &controller->frames[controller->next++];
+    *id = frame->id;
+    *len = frame->len;
+    memcpy(buf, frame->buf, frame->len);
+    return true;
+}
+
+static bool Native_Bench_send(void* impl, uint32_t id, uint8_t len, const uint8_t* buf) {
+    (void)impl;
+    (void)id;
+    (void)len;
+    (void)buf;
+    return false;
+}
+
+static bool Native_Bench_setAcceptance(void* impl, const CAN_Filter_Config_t* config) {
+    // Accept everything, the reader still counts frames without a decoder
+    (void)impl;
+    (void)config;
+    return true;
+}
+
+static void Native_Bench_initReader(Native_Bench_Reader_t* bench, VehicleType_t vehicle, const CAN_Frame_t* frames) {
+    // Static storage, zeroed like the firmware's reader context
+    bench->iface.impl = &bench->controller;
+    bench->iface.available = Native_Bench_available;
+    bench->iface.read = Native_Bench_read;
+    bench->iface.send = Native_Bench_send;
+    bench->iface.setAcceptance = Native_Bench_setAcceptance;
+    bench->controller.frames = frames;
+    bench->bmw.state = &bench->state;
+    bench->bmw.kombi = &bench->kombi;
+    CAN_Reader_start(&bench->reader, 0);
+    CAN_Reader_init(&bench->reader, vehicle, &bench->iface, &bench->updated);
+}
+
+static uint32_t Native_Bench_readMessages(void* ctx) {
+    // Poll, ring, batch, dispatch of the newest copy per ID: everything canTaskStep pays per frame
+    Native_Bench_Reader_t* bench = (Native_Bench_Reader_t*)ctx;
+    Native_Bench_Controller_t* controller = &bench->controller;
+    controller->next = 0;
+    while (controller->next < NATIVE_BENCH_FRAMES) {
+        controller->stepEnd = controller->next + NATIVE_BENCH_STEP_FRAMES;
+        if (controller->stepEnd > NATIVE_BENCH_FRAMES) {
+            controller->stepEnd = NATIVE_BENCH_FRAMES;
+        }
+        Vehicle_State_begin(&bench->state, millis());
+        CAN_Reader_readMessages(&bench->reader, &bench->bmw, &bench->state);
+    }
+    return NATIVE_BENCH_FRAMES;
+}
+
+// === SCREENS ===
+static uint32_t Native_Bench_draw(void* ctx) {
+    // Full rasterisation of a layout screen, the headless panel has no bus to flush to
+    int screen = (int)(intptr_t)ctx;
+    for (int i = 0; i < NATIVE_BENCH_DRAWS; i++) {
+        Layout_Engine_prepare(&layout_engine, screen, millis());
+        Layout_Engine_draw(&layout_engine, true);
+    }
+    return NATIVE_BENCH_DRAWS;
+}
+
+static void Native_Bench_refresh(void) {
+    // Fresh frames before each repeat, signals must not go stale while the screens are timed
+    loop();
+}
+
+// === CONSOLE ===
+static const char* const CONSOLE_COMMANDS[] = {
+    "screen2", "screen1", "vehicle status", "trace status", "shift status", "alerts status", "perf", "bogus"
+};
+static const size_t CONSOLE_COMMAND_COUNT = sizeof(CONSOLE_COMMANDS) / sizeof(CONSOLE_COMMANDS[0]);
+
+static uint32_t Native_Bench_console(void* ctx) {
+    // Typed a command at a time, echo and replies go to the muted Serial
+    (void)ctx;
+    uint32_t commands = 0;
+    for (int r = 0; r < NATIVE_BENCH_CONSOLE_ROUNDS; r++) {
+        for (size_t i = 0; i < CONSOLE_COMMAND_COUNT; i++) {
+            ArduinoHost_injectSerial(CONSOLE_COMMANDS[i]);
+            ArduinoHost_injectSerial("\n");
+            Serial_Handler_processInput(&serial_handler_ctx);
+            commands++;
+        }
+    }
+    return commands;
+}
+
+// === BASELINE ===
+static bool Native_Bench_write(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+    // Timings only compare on the machine that took them, so the file says which one that was
+    char host[64] = "unknown host";
+    gethostname(host, sizeof(host) - 1);
+    fprintf(file, "# %s, name ns/op ops/s\n", host);
+    for (size_t i = 0; i < resultCount; i++) {
+        fprintf(file, "%s %.1f %.0f\n", results[i].name, results[i].nsPerOp, 1e9 / results[i].nsPerOp);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool Native_Bench_lookup(FILE* file, const char* name, double* nsPerOp) {
+    char line[128];
+    rewind(file);
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        char lineName[NATIVE_BENCH_NAME_SIZE];
+        double value;
+        if (line[0] != '#' && sscanf(line, "%31s %lf", lineName, &value) == 2 && strcmp(lineName, name) == 0) {
+            *nsPerOp = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t Native_Bench_compare(FILE* baseline, uint8_t tolerancePercent) {
+    printf("\n%-32s %12s %12s %12s %8s\n", "benchmark", "ns/op", "ops/s", "baseline", "change");
+    uint32_t regressions = 0;
+    for (size_t i = 0; i < resultCount; i++) {
+        const Native_Bench_Result_t* result = &results[i];
+        printf("%-32s %12.1f %12.0f", result->name, result->nsPerOp, 1e9 / result->nsPerOp);
+        double reference;
+        if (baseline == nullptr) {
+            printf("\n");
+            continue;
+        }
+        if (!Native_Bench_lookup(baseline, result->name, &reference) || reference <= 0) {
+            // Not gated is not passed, a baseline from another build must be regenerated
+            printf(" %12s %8s  MISSING\n", "-", "-");
+            regressions++;
+            continue;
+        }
+        double change = (result->nsPerOp / reference - 1.0) * 100.0;
+        bool regressed = change > tolerancePercent;
+        printf(" %12.1f %+7.1f%%%s\n", reference, change, regressed ? "  REGRESSION" : "");
+        if (regressed) {
+            regressions++;
+        }
+    }
+    return regressions;
+}
+
+int Native_Bench_run(const Native_Bench_Options_t* opts) {
+    FILE* baseline = nullptr;
+    if (opts->baselinePath != nullptr) {
+        baseline = fopen(opts->baselinePath, "r");
+        if (baseline == nullptr) {
+            fprintf(stderr, "Cannot read baseline: %s\n", opts->baselinePath);
+            return 1;
+        }
+    }
+
+    // Demo drive so the view holds live values, then keep firmware chatter out of the results
+    unsigned long start = millis();
+    while (millis() - start < NATIVE_BENCH_WARMUP_MS) {
+        loop();
+        delay(UI_TASK_PERIOD_MS);
+    }
+    ArduinoHost_setStdinEnabled(false);
+    ArduinoHost_setStdoutEnabled(false);
+
+    Native_Bench_simulate(bmwFrames, true, false);
+    Native_Bench_simulate(kawasakiFrames, false, true);
+
+    static Vehicle_State_t state;
+    static BMW_Kombi_t kombi;
+    BMW_CAN_Context_t bmw = {};
+    bmw.state = &state;
+    bmw.kombi = &kombi;
+    Native_Bench_measure("decode.bmw", Native_Bench_decodeBMW, &bmw, nullptr);
+    Native_Bench_measure("decode.kawasaki", Native_Bench_decodeKawasaki, &state, nullptr);
+
+    static Native_Bench_Reader_t bmwReader;
+    static Native_Bench_Reader_t kawasakiReader;
+    Native_Bench_initReader(&bmwReader, VEHICLE_BMW, bmwFrames);
+    Native_Bench_measure("reader.bmw", Native_Bench_readMessages, &bmwReader, nullptr);
+    Native_Bench_initReader(&kawasakiReader, VEHICLE_KAWASAKI, kawasakiFrames);
+    Native_Bench_measure("reader.kawasaki", Native_Bench_readMessages, &kawasakiReader, nullptr);
+
+    // "draw." and the screen name, lower case with underscores: draw.rpm_meter, then the same
+    // screen with the glyph atlas off, everything through U8g2: draw.rpm_meter.u8g2
+    bool atlasEnabled = glyph_atlas.enabled;
+    for (int atlas = 1; atlas >= 0; atlas--) {
+        glyph_atlas.enabled = atlas != 0;
+        for (int screen = 0; screen < layout_engine.screenCount; screen++) {
+            char name[NATIVE_BENCH_NAME_SIZE];
+            snprintf(name, NATIVE_BENCH_NAME_SIZE, "draw.%s%s", layout_engine.screenNames[screen], atlas ? "" : ".u8g2");
+            for (char* c = name; *c != '\0'; c++) {
+                *c = *c == ' ' ? '_' : (char)tolower((unsigned char)*c);
+            }
+            Native_Bench_measure(name, Native_Bench_draw, (void*)(intptr_t)screen, Native_Bench_refresh);
+        }
+    }
+    glyph_atlas.enabled = atlasEnabled;
+    Layout_Engine_invalidate(&layout_engine);
+
+    int screen = currentScreen;
+    Native_Bench_measure("console.command", Native_Bench_console, nullptr, nullptr);
+    currentScreen = screen;
+
+    ArduinoHost_setStdoutEnabled(true);
+    uint32_t regressions = Native_Bench_compare(baseline, opts->tolerancePercent);
+    if (baseline != nullptr) {
+        fclose(baseline);
+        printf("%lu of %lu benchmarks more than %u%% slower than %s or missing there\n", (unsigned long)regressions,
+               (unsigned long)resultCount, (unsigned)opts->tolerancePercent, opts->baselinePath);
+    }
+    if (opts->resultsPath != nullptr && !Native_Bench_write(opts->resultsPath)) {
+        fprintf(stderr, "Cannot write results: %s\n", opts->resultsPath);
+        return 1;
+    }
+    return regressions > 0 ? 1 : 0;
+}
+
+#endif // ARDUINO_ARCH_ESP32
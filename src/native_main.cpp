@@ -0,0 +1,391 @@
+// Host entry point for the native environment: runs setup()/loop() against the
+// mock CAN controller and the headless display.
+//   .pio/build/native/program --frames data/drive.log --screen 0 --snapshot rpm.pbm
+// Left out of 'pio test -e native', where each test under test/ brings its own main().
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(PIO_UNIT_TESTING)
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <string>
+#include "CAN_Reader.h"
+#include "CAN_Mock.h"
+#include "CAN_Replay.h"
+#include "CAN_Logger.h"
+#include "Display_Renderer.h"
+#include "Anim_Player.h"
+#include "Diag_Poller.h"
+#include "DME_Sim.h"
+#include "Engine_Sim.h"
+#include "Kombi_VIN.h"
+#include "Kombi_Sim.h"
+#include "Display_Headless.h"
+#include "Task_Config.h"
+#include "Perf_Trace.h"
+#include "Native_Bench.h"
+
+// === FIRMWARE STATE (main.cpp) ===
+extern bool dev_mode;
+extern uint32_t sim_seed;
+extern uint8_t sim_bus_load;
+extern bool sim_unfiltered;
+extern Engine_Sim_t engine_sim;
+extern int currentScreen;
+extern VehicleType_t vehicleType;
+extern CAN_Mock_t CAN;
+extern U8G2_SH1106_128X64_HEADLESS_F u8g2;
+extern CAN_Reader_Context_t can_reader_ctx;
+extern CAN_Replay_t can_replay;
+extern CAN_Interface_t replay_interface;
+extern CAN_Logger_t can_logger;
+extern CAN_Trace_t can_trace;
+extern CAN_Stats_t can_stats;
+#if PERF_TRACE
+extern Perf_Trace_t perf_trace;
+#endif
+extern Display_Renderer_Context_t display_renderer_ctx;
+extern Anim_Player_t intro_player;
+extern Diag_Poller_t diag_poller;
+extern Kombi_VIN_t kombi_vin;
+
+void setup();
+void loop();
+
+// === OPTIONS ===
+typedef struct {
+    const char* framesPath;
+    bool loop;
+    bool realTime;
+    bool demo;
+    long simSeed;
+    int simLoad;
+    bool simUnfiltered;
+    const char* replayPath;
+    float speed;
+    bool bench;
+    bool stats;
+    bool perf;
+    bool benchmark;
+    const char* baselinePath;
+    const char* resultsPath;
+    int tolerance;
+    int screen;
+    VehicleType_t vehicle;
+    unsigned long durationMs;
+    const char* snapshotPath;
+    const char* snapshotDir;
+    const char* dataDir;
+    bool dmeSim;
+    int dmeLatencyMs;
+    int dmeJitterMs;
+    int dmeDropPercent;
+    bool kombiSim;
+    const char* vin;
+    int kombiLatencyMs;
+    int blockSize;
+    int stMin;
+    std::string commands;
+} Native_Options_t;
+
+static void printUsage(const char* program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --frames FILE        Replay a candump style frame file through the mock MCP2515\n");
+    printf("  --loop               Restart the frame file when it ends\n");
+    printf("  --realtime           Deliver frames at their recorded timestamps\n");
+    printf("  --replay FILE        Stream a candump, ASC or binary log through CAN_Replay\n");
+    printf("  --speed X            Replay speed: 1 real time, N accelerated, max (default)\n");
+    printf("  --bench              Disable the frame trace and report decoded frames/s\n");
+    printf("  --stats              Print the per-ID bus statistics at the end\n");
+    printf("  --perf               Print the frame-to-pixel latency and loop profile at the end\n");
+    printf("  --benchmark          Time decoders, CAN reader, screens and console, then exit\n");
+    printf("  --baseline FILE      Fail the benchmark run when slower than these results\n");
+    printf("  --results FILE       Write the benchmark results for a later --baseline\n");
+    printf("  --tolerance P        Percent slower than the baseline allowed (default %d)\n", NATIVE_BENCH_DEFAULT_TOLERANCE);
+    printf("  --demo               Drive the engine simulator through the CAN reader (default without a source)\n");
+    printf("  --sim-seed N         Seed of the simulated drive (default %d)\n", ENGINE_SIM_DEFAULT_SEED);
+    printf("  --sim-load P         Fill the simulated bus to P percent with filler frames\n");
+    printf("  --sim-unfiltered     Filler frames bypass the acceptance filter\n");
+    printf("  --dme-sim            Answer diagnostic requests with a simulated MS42 DME\n");
+    printf("  --dme-latency-ms N   Simulated DME response time (default 20)\n");
+    printf("  --dme-jitter-ms N    Random +-N ms on every response (default 5)\n");
+    printf("  --dme-drop P         Ignore P percent of the requests (default 0)\n");
+    printf("  --kombi-sim          Answer VIN requests with a simulated instrument cluster\n");
+    printf("  --vin TEXT           VIN reported by the simulated cluster\n");
+    printf("  --kombi-latency-ms N Simulated cluster response time (default 30)\n");
+    printf("  --isotp-bs N         Block size the tester asks the cluster for (default %d)\n", ISOTP_DEFAULT_BLOCK_SIZE);
+    printf("  --isotp-stmin N      STmin the tester asks the cluster for (default %d)\n", ISOTP_DEFAULT_ST_MIN);
+    printf("  --screen N           Start on screen N (0-%d)\n", DISPLAY_RENDERER_MAX_SCREENS - 1);
+    printf("  --vehicle TYPE       bmw, kawasaki or auto (unknown)\n");
+    printf("  --cmd \"TEXT\"         Queue a console command (repeatable)\n");
+    printf("  --duration-ms N      Stop after N ms (default: when the frame file is drained)\n");
+    printf("  --snapshot FILE      Write the final frame buffer as a PBM image\n");
+    printf("  --snapshot-dir DIR   Write every rendered frame as DIR/frame_NNNNN.pbm\n");
+    printf("  --data-dir DIR       Host directory mounted as SPIFFS (default: data)\n");
+}
+
+static bool parseOptions(int argc, char** argv, Native_Options_t* opts) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) {
+            opts->framesPath = argv[++i];
+        } else if (arg == "--loop") {
+            opts->loop = true;
+        } else if (arg == "--realtime") {
+            opts->realTime = true;
+        } else if (arg == "--replay" && hasValue) {
+            opts->replayPath = argv[++i];
+        } else if (arg == "--speed" && hasValue) {
+            std::string speed = argv[++i];
+            opts->speed = (speed == "max") ? CAN_REPLAY_SPEED_MAX : (float)atof(speed.c_str());
+        } else if (arg == "--bench") {
+            opts->bench = true;
+        } else if (arg == "--stats") {
+            opts->stats = true;
+        } else if (arg == "--perf") {
+            opts->perf = true;
+        } else if (arg == "--benchmark") {
+            opts->benchmark = true;
+        } else if (arg == "--baseline" && hasValue) {
+            opts->baselinePath = argv[++i];
+        } else if (arg == "--results" && hasValue) {
+            opts->resultsPath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            opts->tolerance = atoi(argv[++i]);
+        } else if (arg == "--demo") {
+            opts->demo = true;
+        } else if (arg == "--sim-seed" && hasValue) {
+            opts->simSeed = strtol(argv[++i], nullptr, 0);
+        } else if (arg == "--sim-load" && hasValue) {
+            opts->simLoad = atoi(argv[++i]);
+        } else if (arg == "--sim-unfiltered") {
+            opts->simUnfiltered = true;
+        } else if (arg == "--dme-sim") {
+            opts->dmeSim = true;
+        } else if (arg == "--dme-latency-ms" && hasValue) {
+            opts->dmeLatencyMs = atoi(argv[++i]);
+        } else if (arg == "--dme-jitter-ms" && hasValue) {
+            opts->dmeJitterMs = atoi(argv[++i]);
+        } else if (arg == "--dme-drop" && hasValue) {
+            opts->dmeDropPercent = atoi(argv[++i]);
+        } else if (arg == "--kombi-sim") {
+            opts->kombiSim = true;
+        } else if (arg == "--vin" && hasValue) {
+            opts->vin = argv[++i];
+        } else if (arg == "--kombi-latency-ms" && hasValue) {
+            opts->kombiLatencyMs = atoi(argv[++i]);
+        } else if (arg == "--isotp-bs" && hasValue) {
+            opts->blockSize = atoi(argv[++i]);
+        } else if (arg == "--isotp-stmin" && hasValue) {
+            opts->stMin = (int)strtol(argv[++i], nullptr, 0);
+        } else if (arg == "--screen" && hasValue) {
+            opts->screen = atoi(argv[++i]);
+        } else if (arg == "--vehicle" && hasValue) {
+            std::string type = argv[++i];
+            if (type == "bmw") {
+                opts->vehicle = VEHICLE_BMW;
+            } else if (type == "kawasaki") {
+                opts->vehicle = VEHICLE_KAWASAKI;
+            } else if (type == "auto" || type == "unknown") {
+                opts->vehicle = VEHICLE_UNKNOWN;
+            } else {
+                fprintf(stderr, "Unknown vehicle type: %s\n", type.c_str());
+                return false;
+            }
+        } else if (arg == "--cmd" && hasValue) {
+            opts->commands += argv[++i];
+            opts->commands += "\n";
+        } else if (arg == "--duration-ms" && hasValue) {
+            opts->durationMs = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--snapshot" && hasValue) {
+            opts->snapshotPath = argv[++i];
+        } else if (arg == "--snapshot-dir" && hasValue) {
+            opts->snapshotDir = argv[++i];
+        } else if (arg == "--data-dir" && hasValue) {
+            opts->dataDir = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t renderedFrames(void) {
+    uint32_t total = 0;
+    for (int i = 0; i < DISPLAY_RENDERER_MAX_SCREENS; i++) {
+        total += display_renderer_ctx.stats[i].framesRendered;
+    }
+    return total + intro_player.framesShown;
+}
+
+int main(int argc, char** argv) {
+    Native_Options_t opts = {};
+    opts.screen = -1;
+    opts.simSeed = ENGINE_SIM_DEFAULT_SEED;
+    opts.speed = CAN_REPLAY_SPEED_MAX;
+    opts.vehicle = vehicleType;
+    opts.dmeLatencyMs = 20;
+    opts.dmeJitterMs = 5;
+    opts.vin = KOMBI_SIM_DEFAULT_VIN;
+    opts.kombiLatencyMs = 30;
+    opts.blockSize = ISOTP_DEFAULT_BLOCK_SIZE;
+    opts.stMin = ISOTP_DEFAULT_ST_MIN;
+    opts.tolerance = NATIVE_BENCH_DEFAULT_TOLERANCE;
+    if (!parseOptions(argc, argv, &opts)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (opts.dataDir != nullptr) {
+        SPIFFS.setRoot(opts.dataDir);
+    }
+    CAN_Mock_init(&CAN);
+    if (opts.framesPath != nullptr && !CAN_Mock_open(&CAN, opts.framesPath, opts.loop, opts.realTime)) {
+        fprintf(stderr, "Cannot open frame file: %s\n", opts.framesPath);
+        return 1;
+    }
+
+    DME_Sim_t dmeSim;
+    if (opts.dmeSim) {
+        DME_Sim_init(&dmeSim, &CAN, (uint16_t)opts.dmeLatencyMs, (uint16_t)opts.dmeJitterMs, (uint8_t)opts.dmeDropPercent);
+    }
+    Kombi_Sim_t kombiSim;
+    if (opts.kombiSim) {
+        Kombi_Sim_init(&kombiSim, &CAN, opts.vin, (uint16_t)opts.kombiLatencyMs);
+    }
+    bool simulated = opts.dmeSim || opts.kombiSim;
+    if (simulated && opts.durationMs == 0 && opts.framesPath == nullptr && opts.replayPath == nullptr) {
+        opts.durationMs = 5000;
+    }
+
+    // Replaying frames implies real mode unless demo data was asked for
+    bool haveSource = opts.framesPath != nullptr || opts.replayPath != nullptr || simulated;
+    dev_mode = opts.demo || !haveSource;
+    vehicleType = opts.vehicle;
+    sim_seed = (uint32_t)opts.simSeed;
+    sim_bus_load = (uint8_t)(opts.simLoad < 0 ? 0 : (opts.simLoad > 100 ? 100 : opts.simLoad));
+    sim_unfiltered = opts.simUnfiltered;
+    if (opts.screen >= 0) {
+        currentScreen = opts.screen;
+    }
+    if (!opts.commands.empty()) {
+        ArduinoHost_injectSerial(opts.commands.c_str());
+    }
+
+    setup();
+    ISOTP_setFlowControl(kombi_vin.session, (uint8_t)opts.blockSize, (uint8_t)opts.stMin);
+
+    if (opts.benchmark) {
+        // Replaces the main loop, the demo drive inside keeps the firmware state realistic
+        Native_Bench_Options_t benchOpts;
+        benchOpts.resultsPath = opts.resultsPath;
+        benchOpts.baselinePath = opts.baselinePath;
+        benchOpts.tolerancePercent = (uint8_t)(opts.tolerance < 0 ? 0 : (opts.tolerance > 255 ? 255 : opts.tolerance));
+        return Native_Bench_run(&benchOpts);
+    }
+
+    if (opts.replayPath != nullptr) {
+        if (!CAN_Replay_open(&can_replay, File(fopen(opts.replayPath, "rb"), opts.replayPath), opts.speed)) {
+            fprintf(stderr, "Cannot open log: %s\n", opts.replayPath);
+            return 1;
+        }
+        CAN_Replay_initInterface(&replay_interface, &can_replay);
+        CAN_Reader_setInterface(&can_reader_ctx, &replay_interface);
+    }
+    if (opts.bench) {
+        CAN_Trace_setLevel(&can_trace, CAN_TRACE_OFF);
+    }
+    bool throttled = opts.realTime || (opts.replayPath != nullptr && opts.speed > CAN_REPLAY_SPEED_MAX) || !haveSource || simulated;
+    unsigned long benchStart = micros();
+
+    uint32_t snapshotCount = 0;
+    uint32_t lastRendered = renderedFrames();
+    unsigned long start = millis();
+    for (;;) {
+        CAN_Mock_beginStep(&CAN);
+        if (opts.dmeSim) {
+            DME_Sim_step(&dmeSim);
+        }
+        if (opts.kombiSim) {
+            Kombi_Sim_step(&kombiSim);
+        }
+        loop();
+
+        if (opts.snapshotDir != nullptr && renderedFrames() != lastRendered) {
+            lastRendered = renderedFrames();
+            char path[512];
+            snprintf(path, sizeof(path), "%s/frame_%05lu.pbm", opts.snapshotDir, (unsigned long)snapshotCount++);
+            Display_Headless_writePNM(&u8g2, path);
+        }
+
+        if (opts.durationMs > 0 && millis() - start >= opts.durationMs) {
+            break;
+        }
+        bool sourceDone = opts.replayPath != nullptr ? can_replay.finished
+                                                     : (opts.framesPath != nullptr && !opts.loop && CAN_Mock_isDrained(&CAN));
+        if (opts.durationMs == 0 && sourceDone && CAN_RingBuffer_count(&can_reader_ctx.rxRing) == 0) {
+            break;
+        }
+        if (throttled) {
+            delay(UI_TASK_PERIOD_MS);
+        }
+    }
+
+    unsigned long benchUs = micros() - benchStart;
+
+    // Flush a running flash log like "log stop" would
+    if (CAN_Logger_isRecording(&can_logger)) {
+        CAN_Logger_stop(&can_logger);
+        CAN_Logger_service(&can_logger);
+    }
+
+    // One more render past the frame cap so the final snapshot shows the last decoded values
+    delay(DISPLAY_RENDERER_MIN_FRAME_MS);
+    loop();
+    if (opts.snapshotPath != nullptr && !Display_Headless_writePNM(&u8g2, opts.snapshotPath)) {
+        fprintf(stderr, "Cannot write snapshot: %s\n", opts.snapshotPath);
+    }
+
+    printf("\nMock frames read: %lu  rejected by filter: %lu  received: %lu  without decoder: %lu  ring overflows: %lu\n",
+           (unsigned long)CAN.framesRead, (unsigned long)CAN.framesRejected,
+           (unsigned long)can_reader_ctx.rxCount, (unsigned long)can_reader_ctx.rxUnmatched,
+           (unsigned long)CAN_Reader_getOverflowCount(&can_reader_ctx));
+    if (opts.replayPath != nullptr) {
+        uint32_t decoded = can_reader_ctx.rxCount - can_reader_ctx.rxUnmatched;
+        printf("Replay (%s): %lu frames read, %lu parse errors, log time %.3f s\n",
+               CAN_Replay_formatName(can_replay.format), (unsigned long)can_replay.framesRead,
+               (unsigned long)can_replay.parseErrors, CAN_Replay_positionMs(&can_replay) / 1000.0);
+        printf("Decoded %lu frames in %.3f s: %.0f frames/s\n", (unsigned long)decoded, benchUs / 1e6,
+               benchUs > 0 ? decoded * 1e6 / benchUs : 0.0);
+    }
+    if (opts.dmeSim) {
+        printf("DME simulator: %lu requests, %lu responses, %lu dropped\n",
+               (unsigned long)dmeSim.requests, (unsigned long)dmeSim.responses, (unsigned long)dmeSim.dropped);
+        Diag_Poller_printStatus(&diag_poller);
+    }
+    if (opts.kombiSim) {
+        printf("Cluster simulator: %lu requests, %lu flow controls, %lu frames sent\n",
+               (unsigned long)kombiSim.requests, (unsigned long)kombiSim.flowControls, (unsigned long)kombiSim.framesSent);
+        printf("VIN in vehicle data: %s\n", kombi_vin.bmw->kombi->vinReceived ? kombi_vin.bmw->kombi->vin : "(none)");
+    }
+    if (vehicleType == VEHICLE_UNKNOWN) {
+        Bus_Fingerprint_printStatus(&can_reader_ctx.fingerprint);
+    }
+    if (dev_mode) {
+        Engine_Sim_printStatus(&engine_sim);
+    }
+    if (opts.stats) {
+        CAN_Stats_print(&can_stats, CAN_Reader_timestampUs(), CAN_STATS_MAX_IDS);
+    }
+    if (opts.perf) {
+#if PERF_TRACE
+        // Same report as the 'perf' command, from the mock controller and the headless panel
+        Perf_Trace_print(&perf_trace);
+#else
+        printf("Profiler compiled out, build with -DPERF_TRACE=1\n");
+#endif
+    }
+    printf("Frames rendered: %lu  snapshots written: %lu\n", (unsigned long)renderedFrames(), (unsigned long)snapshotCount);
+    return 0;
+}
+
+#endif // !ARDUINO_ARCH_ESP32 && !PIO_UNIT_TESTING
@@ -0,0 +1,184 @@
+// CAN_RingBuffer on the host: wrap-around, overflow accounting and a producer thread
+// standing in for the MCP2515 drain task.
+//   pio test -e native -f test_can_ring
+#include <unity.h>
+#include <string.h>
+#include <thread>
+#include "CAN_RingBuffer.h"
+
+#define TEST_THREAD_FRAMES 200000
+
+static CAN_RingBuffer_t ring;
+
+// Frame n carries n in its ID, its timestamp and its first four data bytes
+static CAN_Frame_t fakeFrame(uint32_t n) {
+    CAN_Frame_t frame = {};
+    frame.timestamp = n;
+    frame.id = n & CAN_ID_MASK;
+    frame.len = 8;
+    memcpy(frame.buf, &n, sizeof(n));
+    return frame;
+}
+
+static uint32_t frameNumber(const CAN_Frame_t* frame) {
+    uint32_t n;
+    memcpy(&n, frame->buf, sizeof(n));
+    return n;
+}
+
+void setUp(void) {
+    CAN_RingBuffer_init(&ring);
+}
+
+void tearDown(void) {
+}
+
+// === SINGLE THREAD ===
+static void test_pop_empty(void) {
+    CAN_Frame_t frame;
+    TEST_ASSERT_FALSE(CAN_RingBuffer_pop(&ring, &frame));
+    TEST_ASSERT_EQUAL_UINT32(0, CAN_RingBuffer_count(&ring));
+}
+
+static void test_wraps_around(void) {
+    // Move the indices close to the end of the array, then run several laps across it
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    CAN_Frame_t frame;
+    for (int i = 0; i < CAN_RING_BUFFER_SIZE - 3; i++) {
+        frame = fakeFrame(next++);
+        TEST_ASSERT_TRUE(CAN_RingBuffer_push(&ring, &frame));
+        TEST_ASSERT_TRUE(CAN_RingBuffer_pop(&ring, &frame));
+        TEST_ASSERT_EQUAL_UINT32(expected++, frameNumber(&frame));
+    }
+    for (int lap = 0; lap < 3 * CAN_RING_BUFFER_SIZE; lap += 7) {
+        for (int i = 0; i < 7; i++) {
+            frame = fakeFrame(next++);
+            TEST_ASSERT_TRUE(CAN_RingBuffer_push(&ring, &frame));
+        }
+        TEST_ASSERT_EQUAL_UINT32(7, CAN_RingBuffer_count(&ring));
+        for (int i = 0; i < 7; i++) {
+            TEST_ASSERT_TRUE(CAN_RingBuffer_pop(&ring, &frame));
+            TEST_ASSERT_EQUAL_UINT32(expected, frameNumber(&frame));
+            TEST_ASSERT_EQUAL_UINT32(expected, (uint32_t)frame.timestamp);
+            expected++;
+        }
+    }
+    TEST_ASSERT_FALSE(CAN_RingBuffer_pop(&ring, &frame));
+    TEST_ASSERT_EQUAL_UINT32(0, ring.overflowCount);
+}
+
+static void test_overflow_drops_newest(void) {
+    CAN_Frame_t frame;
+    for (uint32_t n = 0; n < CAN_RING_BUFFER_SIZE; n++) {
+        frame = fakeFrame(n);
+        TEST_ASSERT_TRUE(CAN_RingBuffer_push(&ring, &frame));
+    }
+    TEST_ASSERT_EQUAL_UINT32(CAN_RING_BUFFER_SIZE, CAN_RingBuffer_count(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, ring.overflowCount);
+
+    // Full: every further frame is refused and counted, the queued ones stay intact
+    for (uint32_t n = 0; n < 3; n++) {
+        frame = fakeFrame(CAN_RING_BUFFER_SIZE + n);
+        TEST_ASSERT_FALSE(CAN_RingBuffer_push(&ring, &frame));
+        TEST_ASSERT_EQUAL_UINT32(n + 1, ring.overflowCount);
+    }
+    TEST_ASSERT_EQUAL_UINT32(CAN_RING_BUFFER_SIZE, CAN_RingBuffer_count(&ring));
+
+    // One slot freed takes exactly one more frame
+    TEST_ASSERT_TRUE(CAN_RingBuffer_pop(&ring, &frame));
+    TEST_ASSERT_EQUAL_UINT32(0, frameNumber(&frame));
+    frame = fakeFrame(1000);
+    TEST_ASSERT_TRUE(CAN_RingBuffer_push(&ring, &frame));
+    TEST_ASSERT_FALSE(CAN_RingBuffer_push(&ring, &frame));
+    TEST_ASSERT_EQUAL_UINT32(4, ring.overflowCount);
+
+    for (uint32_t n = 1; n < CAN_RING_BUFFER_SIZE; n++) {
+        TEST_ASSERT_TRUE(CAN_RingBuffer_pop(&ring, &frame));
+        TEST_ASSERT_EQUAL_UINT32(n, frameNumber(&frame));
+    }
+    TEST_ASSERT_TRUE(CAN_RingBuffer_pop(&ring, &frame));
+    TEST_ASSERT_EQUAL_UINT32(1000, frameNumber(&frame));
+    TEST_ASSERT_FALSE(CAN_RingBuffer_pop(&ring, &frame));
+}
+
+// === PRODUCER THREAD ===
+static void test_threaded_order_and_count(void) {
+    // The producer retries a refused frame, so the consumer must see every frame exactly once
+    // and in order, while overflowCount records how often the ring was full
+    std::thread producer([] {
+        for (uint32_t n = 0; n < TEST_THREAD_FRAMES; n++) {
+            CAN_Frame_t frame = fakeFrame(n);
+            while (!CAN_RingBuffer_push(&ring, &frame)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    bool inOrder = true;
+    CAN_Frame_t frame;
+    while (expected < TEST_THREAD_FRAMES) {
+        if (!CAN_RingBuffer_pop(&ring, &frame)) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint32_t n = frameNumber(&frame);
+        if (n != expected || frame.id != (n & CAN_ID_MASK) || frame.timestamp != n || frame.len != 8) {
+            inOrder = false;
+            break;
+        }
+        expected++;
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(inOrder);
+    TEST_ASSERT_EQUAL_UINT32(TEST_THREAD_FRAMES, expected);
+    TEST_ASSERT_FALSE(CAN_RingBuffer_pop(&ring, &frame));
+    TEST_ASSERT_EQUAL_UINT32(0, CAN_RingBuffer_count(&ring));
+}
+
+static void test_threaded_overflow_accounting(void) {
+    // A producer that never retries, like the drain task: frames delivered plus frames
+    // dropped add up to frames offered, and the delivered ones keep their order
+    std::thread producer([] {
+        for (uint32_t n = 0; n < TEST_THREAD_FRAMES; n++) {
+            CAN_Frame_t frame = fakeFrame(n);
+            CAN_RingBuffer_push(&ring, &frame);
+        }
+    });
+
+    uint32_t delivered = 0;
+    uint32_t last = 0;
+    bool increasing = true;
+    CAN_Frame_t frame;
+    auto drain = [&] {
+        while (CAN_RingBuffer_pop(&ring, &frame)) {
+            uint32_t n = frameNumber(&frame);
+            if (delivered > 0 && n <= last) {
+                increasing = false;
+            }
+            last = n;
+            delivered++;
+        }
+    };
+    for (int i = 0; i < 2000; i++) {
+        drain();
+        std::this_thread::yield();
+    }
+    producer.join();
+    drain();
+
+    TEST_ASSERT_TRUE(increasing);
+    TEST_ASSERT_EQUAL_UINT32(TEST_THREAD_FRAMES, delivered + ring.overflowCount);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pop_empty);
+    RUN_TEST(test_wraps_around);
+    RUN_TEST(test_overflow_drops_newest);
+    RUN_TEST(test_threaded_order_and_count);
+    RUN_TEST(test_threaded_overflow_accounting);
+    return UNITY_END();
+}
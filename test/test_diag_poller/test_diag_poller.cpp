@@ -0,0 +1,217 @@
+// Diag_Poller against the simulated MS42 DME on the host: poll periods, the in-flight limit,
+// latency adaption, timeout backoff and negative responses. Runs in real time, a few seconds.
+//   pio test -e native -f test_diag_poller
+#include <unity.h>
+#include <Arduino.h>
+#include <string.h>
+#include "BMW_CAN.h"
+#include "CAN_Mock.h"
+#include "DME_Sim.h"
+#include "Diag_Poller.h"
+#include "ISOTP.h"
+#include "Vehicle_State.h"
+
+#define TEMP_BLOCK 0    // Diag_Poller item of BMW_MS42_BLOCK_TEMP
+#define FUEL_BLOCK 1
+#define AIR_BLOCK 2
+
+static CAN_Mock_t mock;
+static CAN_Interface_t mockInterface;
+static DME_Sim_t dmeSim;
+static ISOTP_t isotp;
+static Vehicle_State_t state;
+static BMW_Kombi_t kombi;
+static BMW_CAN_Context_t bmw_ctx = {&state, &kombi, nullptr, nullptr};
+static Diag_Poller_t poller;
+static uint8_t maxInFlight;
+static uint8_t maxQueued;
+
+static bool mockSend(void* sendCtx, uint32_t id, uint8_t len, const uint8_t* buf) {
+    CAN_Interface_t* iface = (CAN_Interface_t*)sendCtx;
+    return iface->send(iface->impl, id, len, buf);
+}
+
+static void startPoller(uint16_t latencyMs, uint8_t dropPercent, uint32_t visibleSignals) {
+    CAN_Mock_init(&mock);
+    CAN_Mock_initInterface(&mockInterface, &mock);
+    Vehicle_State_clear(&state);
+    memset(&kombi, 0, sizeof(kombi));
+    DME_Sim_init(&dmeSim, &mock, latencyMs, 0, dropPercent);
+    ISOTP_init(&isotp, mockSend, &mockInterface);
+    TEST_ASSERT_TRUE(Diag_Poller_init(&poller, &isotp, &bmw_ctx));
+    Diag_Poller_setVisibleSignals(&poller, visibleSignals);
+    maxInFlight = 0;
+    maxQueued = 0;
+}
+
+// What the CAN task does every millisecond or so, with the simulated DME in front of the controller
+static void runStep(void) {
+    CAN_Mock_beginStep(&mock);
+    DME_Sim_step(&dmeSim);
+    uint32_t id;
+    uint8_t len;
+    uint8_t buf[8];
+    Vehicle_State_begin(&state, millis());
+    while (mockInterface.available(mockInterface.impl) && mockInterface.read(mockInterface.impl, &id, &len, buf)) {
+        ISOTP_onFrame(&isotp, id & CAN_ID_MASK, len, buf);
+    }
+    ISOTP_step(&isotp);
+    Diag_Poller_step(&poller);
+    maxInFlight = poller.inFlight > maxInFlight ? poller.inFlight : maxInFlight;
+    maxQueued = dmeSim.queueCount > maxQueued ? dmeSim.queueCount : maxQueued;
+    delay(1);
+}
+
+static void runFor(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        runStep();
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// === SCHEDULING ===
+static void test_visible_and_background_periods(void) {
+    // Intake temperature on screen: its block every 100 ms, the others every 2 s
+    startPoller(20, 0, 1u << BMW_SIGNAL_INTAKE_TEMP);
+    runFor(1050);
+
+    TEST_ASSERT_EQUAL_UINT16(DIAG_POLLER_VISIBLE_PERIOD_MS, poller.items[TEMP_BLOCK].periodMs);
+    TEST_ASSERT_EQUAL_UINT16(DIAG_POLLER_BACKGROUND_PERIOD_MS, poller.items[FUEL_BLOCK].periodMs);
+    TEST_ASSERT_EQUAL_UINT16(DIAG_POLLER_BACKGROUND_PERIOD_MS, poller.items[AIR_BLOCK].periodMs);
+    TEST_ASSERT_UINT32_WITHIN(1, 11, poller.items[TEMP_BLOCK].requests);
+    TEST_ASSERT_EQUAL_UINT32(1, poller.items[FUEL_BLOCK].requests);
+    TEST_ASSERT_EQUAL_UINT32(1, poller.items[AIR_BLOCK].requests);
+    TEST_ASSERT_EQUAL_UINT32(0, poller.items[TEMP_BLOCK].timeouts);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(poller.items[TEMP_BLOCK].requests - 1, poller.items[TEMP_BLOCK].responses);
+
+    // The answers reached the vehicle state
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_FRESH, Vehicle_State_status(&state, VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_INTAKE_TEMP, millis()));
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_FRESH, Vehicle_State_status(&state, VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_MAF, millis()));
+
+    // Switching screens moves the fast poll to the fuel block
+    Diag_Poller_setVisibleSignals(&poller, 1u << BMW_SIGNAL_LAMBDA);
+    runFor(50);
+    TEST_ASSERT_EQUAL_UINT16(DIAG_POLLER_BACKGROUND_PERIOD_MS, poller.items[TEMP_BLOCK].periodMs);
+    TEST_ASSERT_EQUAL_UINT16(DIAG_POLLER_VISIBLE_PERIOD_MS, poller.items[FUEL_BLOCK].periodMs);
+}
+
+static void test_in_flight_limit(void) {
+    // Every block on screen and a slow DME: requests queue up unless the poller holds back
+    startPoller(150, 0, (1u << BMW_SIGNAL_INTAKE_TEMP) | (1u << BMW_SIGNAL_LAMBDA) | (1u << BMW_SIGNAL_MAF));
+    runFor(1000);
+
+    TEST_ASSERT_EQUAL_UINT8(DIAG_POLLER_MAX_IN_FLIGHT, maxInFlight);
+    TEST_ASSERT_LESS_OR_EQUAL(DIAG_POLLER_MAX_IN_FLIGHT, maxQueued);     // Outstanding at the DME
+    TEST_ASSERT_EQUAL_UINT32(0, dmeSim.dropped);
+    uint32_t requests = 0;
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        requests += poller.items[i].requests;
+    }
+    TEST_ASSERT_EQUAL_UINT32(requests, dmeSim.requests);
+}
+
+static void test_period_floor_follows_latency(void) {
+    // 400 ms per answer: the visible block cannot be polled every 100 ms, its period stretches
+    // to at least the latency shared between the requests allowed in flight
+    startPoller(400, 0, 1u << BMW_SIGNAL_INTAKE_TEMP);
+    runFor(3000);
+
+    const Diag_Poller_Item_t* temp = &poller.items[TEMP_BLOCK];
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, temp->responses);
+    // Measured from the requests, so a little below the DME's when answers come late
+    uint32_t floorMs = temp->latencyAvgUs / (DIAG_POLLER_MAX_IN_FLIGHT * 1000u);
+    TEST_ASSERT_GREATER_THAN_UINT32(DIAG_POLLER_VISIBLE_PERIOD_MS, floorMs);
+    TEST_ASSERT_GREATER_THAN_UINT32(DIAG_POLLER_VISIBLE_PERIOD_MS, temp->periodMs);
+    // 30 requests at the nominal period, far fewer at the stretched one
+    TEST_ASSERT_LESS_OR_EQUAL(3000 / 200 + 1, temp->requests);
+
+    // The same screen against a quick DME stays at the nominal period
+    startPoller(20, 0, 1u << BMW_SIGNAL_INTAKE_TEMP);
+    runFor(300);
+    TEST_ASSERT_EQUAL_UINT16(DIAG_POLLER_VISIBLE_PERIOD_MS, poller.items[TEMP_BLOCK].periodMs);
+}
+
+// === FAILURES ===
+static void test_timeout_backoff_and_reset(void) {
+    // A DME that ignores every request: each timeout doubles the block's period
+    startPoller(20, 100, 1u << BMW_SIGNAL_INTAKE_TEMP);
+    runFor(1300);
+
+    const Diag_Poller_Item_t* temp = &poller.items[TEMP_BLOCK];
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, temp->timeouts);
+    TEST_ASSERT_EQUAL_UINT32(0, temp->responses);
+    TEST_ASSERT_EQUAL_UINT8(temp->timeouts < DIAG_POLLER_MAX_BACKOFF ? temp->timeouts : DIAG_POLLER_MAX_BACKOFF, temp->backoff);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(DIAG_POLLER_VISIBLE_PERIOD_MS << 1, temp->periodMs);
+    TEST_ASSERT_LESS_OR_EQUAL(DIAG_POLLER_MAX_IN_FLIGHT, maxInFlight);
+
+    // The DME comes back: the first answer clears the backoff
+    dmeSim.dropPercent = 0;
+    unsigned long start = millis();
+    while (temp->responses == 0) {
+        TEST_ASSERT_TRUE(millis() - start < 3000);
+        runStep();
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, temp->backoff);
+    runFor(150);
+    TEST_ASSERT_EQUAL_UINT16(DIAG_POLLER_VISIBLE_PERIOD_MS, temp->periodMs);
+}
+
+static void test_negative_response_blames_oldest(void) {
+    // Two requests the DME never answers, then a negative response naming only the service
+    startPoller(20, 100, 1u << BMW_SIGNAL_INTAKE_TEMP);
+    unsigned long start = millis();
+    while (poller.inFlight < DIAG_POLLER_MAX_IN_FLIGHT) {
+        TEST_ASSERT_TRUE(millis() - start < 200);
+        runStep();
+    }
+    Diag_Poller_Item_t* oldest = nullptr;
+    Diag_Poller_Item_t* newer = nullptr;
+    unsigned long nowUs = micros();
+    for (int i = 0; i < DIAG_POLLER_ITEM_COUNT; i++) {
+        Diag_Poller_Item_t* item = &poller.items[i];
+        if (!item->inFlight) {
+            continue;
+        }
+        if (oldest == nullptr || nowUs - item->sentUs > nowUs - oldest->sentUs) {
+            newer = oldest;
+            oldest = item;
+        } else {
+            newer = item;
+        }
+    }
+    TEST_ASSERT_NOT_NULL(oldest);
+    TEST_ASSERT_NOT_NULL(newer);
+
+    const uint8_t negative[8] = {BMW_DIAG_TESTER_ADDRESS, 0x03, DIAG_KWP_NEGATIVE_RESPONSE, DIAG_KWP_READ_LOCAL_ID, 0x31, 0, 0, 0};
+    ISOTP_onFrame(&isotp, BMW_DIAG_DME_RESPONSE_ID, sizeof(negative), negative);
+
+    TEST_ASSERT_EQUAL_UINT32(1, oldest->negatives);
+    TEST_ASSERT_FALSE(oldest->inFlight);
+    TEST_ASSERT_EQUAL_UINT8(1, oldest->backoff);
+    TEST_ASSERT_EQUAL_UINT32(0, newer->negatives);
+    TEST_ASSERT_TRUE(newer->inFlight);
+    TEST_ASSERT_EQUAL_UINT8(1, poller.inFlight);
+
+    // The next one goes to the remaining request, a third finds nobody to blame
+    ISOTP_onFrame(&isotp, BMW_DIAG_DME_RESPONSE_ID, sizeof(negative), negative);
+    TEST_ASSERT_EQUAL_UINT32(1, newer->negatives);
+    TEST_ASSERT_EQUAL_UINT8(0, poller.inFlight);
+    ISOTP_onFrame(&isotp, BMW_DIAG_DME_RESPONSE_ID, sizeof(negative), negative);
+    TEST_ASSERT_EQUAL_UINT32(1, poller.unexpected);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_visible_and_background_periods);
+    RUN_TEST(test_in_flight_limit);
+    RUN_TEST(test_period_floor_follows_latency);
+    RUN_TEST(test_timeout_backoff_and_reset);
+    RUN_TEST(test_negative_response_blames_oldest);
+    return UNITY_END();
+}
@@ -0,0 +1,386 @@
+// ISO-TP transport on the host: frames fed in by hand against a recording sender, then a
+// VIN read from the simulated instrument cluster through the mock controller.
+//   pio test -e native -f test_isotp
+#include <unity.h>
+#include <Arduino.h>
+#include <string.h>
+#include "ISOTP.h"
+#include "BMW_CAN.h"
+#include "CAN_Mock.h"
+#include "Kombi_Sim.h"
+#include "Kombi_VIN.h"
+#include "Vehicle_State.h"
+
+#define TEST_MAX_FRAMES 64
+#define TEST_MAX_RESULTS 8
+#define TEST_RX_SIZE 64
+
+// === RECORDING SENDER ===
+typedef struct {
+    uint32_t id;
+    uint8_t len;
+    uint8_t buf[8];
+    unsigned long us;
+} Test_Frame_t;
+
+static Test_Frame_t sent[TEST_MAX_FRAMES];
+static int sentCount;
+
+static bool recordFrame(void* sendCtx, uint32_t id, uint8_t len, const uint8_t* buf) {
+    if (sentCount >= TEST_MAX_FRAMES) {
+        return false;
+    }
+    Test_Frame_t* frame = &sent[sentCount++];
+    frame->id = id;
+    frame->len = len;
+    memcpy(frame->buf, buf, len);
+    frame->us = micros();
+    return true;
+}
+
+// === RESULTS ===
+typedef struct {
+    ISOTP_Result_t result;
+    uint8_t data[TEST_RX_SIZE];
+    uint16_t len;
+} Test_Result_t;
+
+typedef struct {
+    Test_Result_t results[TEST_MAX_RESULTS];
+    int count;
+} Test_Results_t;
+
+static uint32_t recordResult(void* userCtx, ISOTP_Result_t result, const uint8_t* data, uint16_t len) {
+    Test_Results_t* results = (Test_Results_t*)userCtx;
+    if (results->count < TEST_MAX_RESULTS) {
+        Test_Result_t* r = &results->results[results->count++];
+        r->result = result;
+        r->len = len;
+        if (data != nullptr) {
+            memcpy(r->data, data, len < TEST_RX_SIZE ? len : TEST_RX_SIZE);
+        }
+    }
+    return 0;
+}
+
+static ISOTP_t isotp;
+static uint8_t dmeBuf[TEST_RX_SIZE];
+static uint8_t kombiBuf[TEST_RX_SIZE];
+static Test_Results_t dmeResults;
+static Test_Results_t kombiResults;
+static ISOTP_Session_t* dme;
+static ISOTP_Session_t* kombi;
+
+// Frame from an ECU to the tester, extended addressing like every BMW diagnostic frame
+static void ecuFrame(uint32_t id, const uint8_t* payload, uint8_t len) {
+    uint8_t buf[8] = {};
+    buf[0] = BMW_DIAG_TESTER_ADDRESS;
+    memcpy(&buf[1], payload, len);
+    ISOTP_onFrame(&isotp, id, 8, buf);
+}
+
+// First frame plus consecutive frames of a message of len bytes, numbered from seq 1
+static void ecuFirstFrame(uint32_t id, const uint8_t* data, uint16_t len) {
+    uint8_t payload[7] = {(uint8_t)(ISOTP_PCI_FIRST | (len >> 8)), (uint8_t)len};
+    memcpy(&payload[2], data, 5);
+    ecuFrame(id, payload, 7);
+}
+
+static void ecuConsecutiveFrame(uint32_t id, uint8_t seq, const uint8_t* data, uint16_t len, uint16_t pos) {
+    uint8_t payload[7] = {(uint8_t)(ISOTP_PCI_CONSECUTIVE | (seq & 0x0F))};
+    uint16_t n = len - pos < 6 ? len - pos : 6;
+    memcpy(&payload[1], &data[pos], n);
+    ecuFrame(id, payload, (uint8_t)(n + 1));
+}
+
+static void fillPattern(uint8_t* data, uint16_t len, uint8_t seed) {
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)(seed + i * 7);
+    }
+}
+
+void setUp(void) {
+    sentCount = 0;
+    memset(&dmeResults, 0, sizeof(dmeResults));
+    memset(&kombiResults, 0, sizeof(kombiResults));
+    ISOTP_init(&isotp, recordFrame, nullptr);
+    dme = ISOTP_open(&isotp, BMW_DIAG_REQUEST_ID, BMW_DIAG_DME_ADDRESS, BMW_DIAG_DME_RESPONSE_ID, BMW_DIAG_TESTER_ADDRESS,
+                     dmeBuf, sizeof(dmeBuf), recordResult, &dmeResults);
+    kombi = ISOTP_open(&isotp, BMW_DIAG_REQUEST_ID, BMW_DIAG_KOMBI_ADDRESS, BMW_DIAG_KOMBI_RESPONSE_ID, BMW_DIAG_TESTER_ADDRESS,
+                       kombiBuf, sizeof(kombiBuf), recordResult, &kombiResults);
+}
+
+void tearDown(void) {
+}
+
+// === SINGLE FRAMES ===
+static void test_single_frame_send(void) {
+    const uint8_t request[2] = {DIAG_KWP_READ_ECU_ID, DIAG_KWP_ECU_ID_VIN};
+    TEST_ASSERT_TRUE(ISOTP_send(&isotp, kombi, request, sizeof(request)));
+    TEST_ASSERT_FALSE(ISOTP_isBusy(kombi));
+    TEST_ASSERT_EQUAL_INT(1, sentCount);
+    TEST_ASSERT_EQUAL_HEX32(BMW_DIAG_REQUEST_ID, sent[0].id);
+    TEST_ASSERT_EQUAL_UINT8(8, sent[0].len);
+    const uint8_t expected[8] = {BMW_DIAG_KOMBI_ADDRESS, 0x02, DIAG_KWP_READ_ECU_ID, DIAG_KWP_ECU_ID_VIN, 0, 0, 0, 0};
+    TEST_ASSERT_EQUAL_MEMORY(expected, sent[0].buf, 8);
+}
+
+static void test_single_frame_receive(void) {
+    const uint8_t payload[4] = {0x03, 0x61, 0x0B, 0x42};
+    ecuFrame(BMW_DIAG_DME_RESPONSE_ID, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL_INT(1, dmeResults.count);
+    TEST_ASSERT_EQUAL(ISOTP_RESULT_RECEIVED, dmeResults.results[0].result);
+    TEST_ASSERT_EQUAL_UINT16(3, dmeResults.results[0].len);
+    TEST_ASSERT_EQUAL_MEMORY(&payload[1], dmeResults.results[0].data, 3);
+    TEST_ASSERT_EQUAL_INT(0, kombiResults.count);
+    TEST_ASSERT_EQUAL_INT(0, sentCount);
+
+    // Addressed to another tester: not ours
+    uint8_t other[8] = {0xF2, 0x02, 0x61, 0x0B};
+    ISOTP_onFrame(&isotp, BMW_DIAG_DME_RESPONSE_ID, 8, other);
+    TEST_ASSERT_EQUAL_INT(1, dmeResults.count);
+}
+
+// === SEGMENTED RECEIVE ===
+static void test_receive_with_block_size(void) {
+    // 20 bytes: first frame with 5, then 6 + 6 + 3, a flow control every 2 consecutive frames
+    uint8_t data[20];
+    fillPattern(data, sizeof(data), 1);
+    ISOTP_setFlowControl(kombi, 2, 5);
+
+    ecuFirstFrame(BMW_DIAG_KOMBI_RESPONSE_ID, data, sizeof(data));
+    TEST_ASSERT_EQUAL_INT(1, sentCount);
+    const uint8_t fc[8] = {BMW_DIAG_KOMBI_ADDRESS, ISOTP_PCI_FLOW_CONTROL | ISOTP_FC_CONTINUE, 2, 5, 0, 0, 0, 0};
+    TEST_ASSERT_EQUAL_HEX32(BMW_DIAG_REQUEST_ID, sent[0].id);
+    TEST_ASSERT_EQUAL_MEMORY(fc, sent[0].buf, 8);
+
+    ecuConsecutiveFrame(BMW_DIAG_KOMBI_RESPONSE_ID, 1, data, sizeof(data), 5);
+    TEST_ASSERT_EQUAL_INT(1, sentCount);
+    ecuConsecutiveFrame(BMW_DIAG_KOMBI_RESPONSE_ID, 2, data, sizeof(data), 11);
+    TEST_ASSERT_EQUAL_INT(2, sentCount);
+    TEST_ASSERT_EQUAL_MEMORY(fc, sent[1].buf, 8);
+    TEST_ASSERT_EQUAL_INT(0, kombiResults.count);
+
+    ecuConsecutiveFrame(BMW_DIAG_KOMBI_RESPONSE_ID, 3, data, sizeof(data), 17);
+    TEST_ASSERT_EQUAL_INT(2, sentCount);
+    TEST_ASSERT_EQUAL_INT(1, kombiResults.count);
+    TEST_ASSERT_EQUAL(ISOTP_RESULT_RECEIVED, kombiResults.results[0].result);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(data), kombiResults.results[0].len);
+    TEST_ASSERT_EQUAL_MEMORY(data, kombiResults.results[0].data, sizeof(data));
+    TEST_ASSERT_EQUAL_UINT32(1, kombi->messagesReceived);
+}
+
+static void test_sequence_error(void) {
+    uint8_t data[20];
+    fillPattern(data, sizeof(data), 9);
+    ecuFirstFrame(BMW_DIAG_KOMBI_RESPONSE_ID, data, sizeof(data));
+    ecuConsecutiveFrame(BMW_DIAG_KOMBI_RESPONSE_ID, 1, data, sizeof(data), 5);
+    ecuConsecutiveFrame(BMW_DIAG_KOMBI_RESPONSE_ID, 3, data, sizeof(data), 11);
+    TEST_ASSERT_EQUAL_INT(1, kombiResults.count);
+    TEST_ASSERT_EQUAL(ISOTP_RESULT_SEQUENCE, kombiResults.results[0].result);
+    TEST_ASSERT_EQUAL_UINT32(1, kombi->errors);
+
+    // The message is dropped, late frames of it are ignored
+    ecuConsecutiveFrame(BMW_DIAG_KOMBI_RESPONSE_ID, 2, data, sizeof(data), 11);
+    TEST_ASSERT_EQUAL_INT(1, kombiResults.count);
+    TEST_ASSERT_EQUAL_UINT32(0, kombi->messagesReceived);
+}
+
+static void test_first_frame_overflow(void) {
+    // Longer than the receive buffer: flow control "overflow" and no reassembly
+    uint8_t data[TEST_RX_SIZE + 1];
+    fillPattern(data, sizeof(data), 3);
+    ecuFirstFrame(BMW_DIAG_KOMBI_RESPONSE_ID, data, sizeof(data));
+
+    TEST_ASSERT_EQUAL_INT(1, sentCount);
+    TEST_ASSERT_EQUAL_HEX32(BMW_DIAG_REQUEST_ID, sent[0].id);
+    TEST_ASSERT_EQUAL_HEX8(BMW_DIAG_KOMBI_ADDRESS, sent[0].buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(ISOTP_PCI_FLOW_CONTROL | ISOTP_FC_OVERFLOW, sent[0].buf[1]);
+    TEST_ASSERT_EQUAL_INT(1, kombiResults.count);
+    TEST_ASSERT_EQUAL(ISOTP_RESULT_OVERFLOW, kombiResults.results[0].result);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(data), kombiResults.results[0].len);
+
+    ecuConsecutiveFrame(BMW_DIAG_KOMBI_RESPONSE_ID, 1, data, sizeof(data), 5);
+    TEST_ASSERT_EQUAL_INT(1, kombiResults.count);
+}
+
+static void test_concurrent_sessions(void) {
+    // DME and cluster answer at the same time, interleaved frame by frame
+    uint8_t dmeData[17];
+    uint8_t kombiData[23];
+    fillPattern(dmeData, sizeof(dmeData), 0x10);
+    fillPattern(kombiData, sizeof(kombiData), 0x80);
+
+    ecuFirstFrame(BMW_DIAG_DME_RESPONSE_ID, dmeData, sizeof(dmeData));
+    ecuFirstFrame(BMW_DIAG_KOMBI_RESPONSE_ID, kombiData, sizeof(kombiData));
+    TEST_ASSERT_EQUAL_INT(2, sentCount);
+    TEST_ASSERT_EQUAL_HEX8(BMW_DIAG_DME_ADDRESS, sent[0].buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(BMW_DIAG_KOMBI_ADDRESS, sent[1].buf[0]);
+
+    uint16_t dmePos = 5;
+    uint16_t kombiPos = 5;
+    uint8_t seq = 1;
+    while (dmePos < sizeof(dmeData) || kombiPos < sizeof(kombiData)) {
+        if (kombiPos < sizeof(kombiData)) {
+            ecuConsecutiveFrame(BMW_DIAG_KOMBI_RESPONSE_ID, seq, kombiData, sizeof(kombiData), kombiPos);
+            kombiPos += 6;
+        }
+        if (dmePos < sizeof(dmeData)) {
+            ecuConsecutiveFrame(BMW_DIAG_DME_RESPONSE_ID, seq, dmeData, sizeof(dmeData), dmePos);
+            dmePos += 6;
+        }
+        seq++;
+    }
+
+    TEST_ASSERT_EQUAL_INT(1, dmeResults.count);
+    TEST_ASSERT_EQUAL(ISOTP_RESULT_RECEIVED, dmeResults.results[0].result);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(dmeData), dmeResults.results[0].len);
+    TEST_ASSERT_EQUAL_MEMORY(dmeData, dmeResults.results[0].data, sizeof(dmeData));
+    TEST_ASSERT_EQUAL_INT(1, kombiResults.count);
+    TEST_ASSERT_EQUAL(ISOTP_RESULT_RECEIVED, kombiResults.results[0].result);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(kombiData), kombiResults.results[0].len);
+    TEST_ASSERT_EQUAL_MEMORY(kombiData, kombiResults.results[0].data, sizeof(kombiData));
+}
+
+// === SEGMENTED SEND ===
+static void stepUntil(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        ISOTP_step(&isotp);
+        delayMicroseconds(200);
+    }
+}
+
+static void test_send_honours_flow_control(void) {
+    // 30 bytes: first frame with 5, then 6 + 6 + 6 + 6 + 1
+    uint8_t data[30];
+    fillPattern(data, sizeof(data), 0x40);
+    TEST_ASSERT_TRUE(ISOTP_send(&isotp, dme, data, sizeof(data)));
+    TEST_ASSERT_TRUE(ISOTP_isBusy(dme));
+    TEST_ASSERT_EQUAL_INT(1, sentCount);
+    TEST_ASSERT_EQUAL_HEX8(ISOTP_PCI_FIRST, sent[0].buf[1]);
+    TEST_ASSERT_EQUAL_UINT8(sizeof(data), sent[0].buf[2]);
+    TEST_ASSERT_EQUAL_MEMORY(data, &sent[0].buf[3], 5);
+
+    // Nothing before the receiver's flow control
+    stepUntil(20);
+    TEST_ASSERT_EQUAL_INT(1, sentCount);
+
+    // Block size 2, STmin 10 ms
+    const uint8_t fc[3] = {ISOTP_PCI_FLOW_CONTROL | ISOTP_FC_CONTINUE, 2, 10};
+    ecuFrame(BMW_DIAG_DME_RESPONSE_ID, fc, sizeof(fc));
+    stepUntil(60);
+    TEST_ASSERT_EQUAL_INT(3, sentCount);
+    TEST_ASSERT_EQUAL_HEX8(ISOTP_PCI_CONSECUTIVE | 1, sent[1].buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(ISOTP_PCI_CONSECUTIVE | 2, sent[2].buf[1]);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(10000, sent[2].us - sent[1].us);
+
+    // Second block, no separation time, then the last frame completes the message
+    const uint8_t fcRest[3] = {ISOTP_PCI_FLOW_CONTROL | ISOTP_FC_CONTINUE, 0, 0};
+    ecuFrame(BMW_DIAG_DME_RESPONSE_ID, fcRest, sizeof(fcRest));
+    stepUntil(5);
+    TEST_ASSERT_EQUAL_INT(6, sentCount);
+    TEST_ASSERT_EQUAL_HEX8(ISOTP_PCI_CONSECUTIVE | 5, sent[5].buf[1]);
+    TEST_ASSERT_FALSE(ISOTP_isBusy(dme));
+    TEST_ASSERT_EQUAL_INT(1, dmeResults.count);
+    TEST_ASSERT_EQUAL(ISOTP_RESULT_SENT, dmeResults.results[0].result);
+
+    // Reassemble what went out
+    uint8_t out[30];
+    memcpy(out, &sent[0].buf[3], 5);
+    for (int i = 1; i < 6; i++) {
+        uint16_t pos = (uint16_t)(5 + (i - 1) * 6);
+        memcpy(&out[pos], &sent[i].buf[2], sizeof(out) - pos < 6 ? sizeof(out) - pos : 6);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, out, sizeof(data));
+}
+
+static void test_send_overflow_from_receiver(void) {
+    uint8_t data[30] = {};
+    TEST_ASSERT_TRUE(ISOTP_send(&isotp, dme, data, sizeof(data)));
+    const uint8_t fc[3] = {ISOTP_PCI_FLOW_CONTROL | ISOTP_FC_OVERFLOW, 0, 0};
+    ecuFrame(BMW_DIAG_DME_RESPONSE_ID, fc, sizeof(fc));
+    TEST_ASSERT_FALSE(ISOTP_isBusy(dme));
+    TEST_ASSERT_EQUAL_INT(1, dmeResults.count);
+    TEST_ASSERT_EQUAL(ISOTP_RESULT_OVERFLOW, dmeResults.results[0].result);
+}
+
+// === VIN FROM THE SIMULATED CLUSTER ===
+static CAN_Mock_t mock;
+static CAN_Interface_t mockInterface;
+static Vehicle_State_t state;
+static BMW_Kombi_t kombiData;
+static BMW_CAN_Context_t bmw_ctx = {&state, &kombiData, nullptr, nullptr};
+static Kombi_Sim_t kombiSim;
+static Kombi_VIN_t vinReader;
+
+static bool mockSend(void* sendCtx, uint32_t id, uint8_t len, const uint8_t* buf) {
+    CAN_Interface_t* iface = (CAN_Interface_t*)sendCtx;
+    return iface->send(iface->impl, id, len, buf);
+}
+
+static void runVinRequest(const char* vin, uint8_t blockSize, uint8_t stMin) {
+    CAN_Mock_init(&mock);
+    CAN_Mock_initInterface(&mockInterface, &mock);
+    Vehicle_State_clear(&state);
+    memset(&kombiData, 0, sizeof(kombiData));
+    Kombi_Sim_init(&kombiSim, &mock, vin, 5);
+    ISOTP_init(&isotp, mockSend, &mockInterface);
+    TEST_ASSERT_TRUE(Kombi_VIN_init(&vinReader, &isotp, &bmw_ctx));
+    ISOTP_setFlowControl(vinReader.session, blockSize, stMin);
+
+    // One CAN task step: simulated ECU, controller, transport, request
+    Kombi_VIN_request(&vinReader);
+    unsigned long start = millis();
+    while (vinReader.status.load() == KOMBI_VIN_IDLE || vinReader.status.load() == KOMBI_VIN_PENDING) {
+        TEST_ASSERT_TRUE(millis() - start < 2000);
+        CAN_Mock_beginStep(&mock);
+        Kombi_Sim_step(&kombiSim);
+        uint32_t id;
+        uint8_t len;
+        uint8_t buf[8];
+        while (mockInterface.available(mockInterface.impl) && mockInterface.read(mockInterface.impl, &id, &len, buf)) {
+            ISOTP_onFrame(&isotp, id & CAN_ID_MASK, len, buf);
+        }
+        ISOTP_step(&isotp);
+        Kombi_VIN_step(&vinReader);
+        delay(1);
+    }
+}
+
+static void test_getvin_round_trip(void) {
+    runVinRequest("WBAAM31040FJ12345", 0, 0);
+    TEST_ASSERT_EQUAL(KOMBI_VIN_DONE, vinReader.status.load());
+    TEST_ASSERT_EQUAL_STRING("WBAAM31040FJ12345", vinReader.vin);
+    TEST_ASSERT_TRUE(kombiData.vinReceived);
+    TEST_ASSERT_EQUAL_STRING("WBAAM31040FJ12345", kombiData.vin);
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_FRESH, Vehicle_State_status(&state, VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_VIN, state.nowMs));
+    TEST_ASSERT_EQUAL_UINT32(1, kombiSim.requests);
+    TEST_ASSERT_EQUAL_UINT32(1, kombiSim.flowControls);
+    TEST_ASSERT_EQUAL_UINT32(0, vinReader.failures);
+}
+
+static void test_getvin_with_block_size_and_stmin(void) {
+    // 19 byte answer: first frame plus 3 consecutive frames, one flow control per frame
+    runVinRequest("WDB2030461A123456", 1, 3);
+    TEST_ASSERT_EQUAL(KOMBI_VIN_DONE, vinReader.status.load());
+    TEST_ASSERT_EQUAL_STRING("WDB2030461A123456", vinReader.vin);
+    TEST_ASSERT_EQUAL_UINT32(3, kombiSim.flowControls);
+    TEST_ASSERT_EQUAL_UINT32(4, kombiSim.framesSent);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(6, vinReader.elapsedMs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_frame_send);
+    RUN_TEST(test_single_frame_receive);
+    RUN_TEST(test_receive_with_block_size);
+    RUN_TEST(test_sequence_error);
+    RUN_TEST(test_first_frame_overflow);
+    RUN_TEST(test_concurrent_sessions);
+    RUN_TEST(test_send_honours_flow_control);
+    RUN_TEST(test_send_overflow_from_receiver);
+    RUN_TEST(test_getvin_round_trip);
+    RUN_TEST(test_getvin_with_block_size_and_stmin);
+    return UNITY_END();
+}
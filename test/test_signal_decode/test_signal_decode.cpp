@@ -0,0 +1,162 @@
+// Generated signal decoders on the host: engine speed through the dispatch table into the
+// vehicle state store, including raw values that do not fit its int16_t slots, and refused
+// dispatch registrations.
+//   pio test -e native -f test_signal_decode
+#include <unity.h>
+#include <string.h>
+#include "BMW_CAN.h"
+#include "Kawasaki_CAN.h"
+#include "CAN_Dispatch.h"
+#include "Vehicle_State.h"
+
+#define TEST_NOW_MS 1000
+
+static Vehicle_State_t state;
+static BMW_Kombi_t kombi;
+static BMW_CAN_Context_t bmw_ctx = {&state, &kombi, nullptr, nullptr};
+static CAN_Dispatch_Table_t dispatch;
+
+// DME1 with engine speed in bytes 2 (low) and 3 (high)
+static uint32_t sendDME1(uint16_t raw) {
+    uint8_t buf[8] = {0x01, 0x40, (uint8_t)raw, (uint8_t)(raw >> 8), 0, 0x05, 0, 0};
+    uint32_t changed = 0;
+    Vehicle_State_begin(&state, TEST_NOW_MS);
+    TEST_ASSERT_TRUE(CAN_Dispatch_process(&dispatch, 0x316, 8, buf, &changed));
+    return changed;
+}
+
+static const uint8_t RPM = VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_RPM;
+
+void setUp(void) {
+    memset(&kombi, 0, sizeof(kombi));
+    Vehicle_State_clear(&state);
+    CAN_Dispatch_clear(&dispatch);
+    BMW_registerDecoders(&dispatch, &bmw_ctx, VEHICLE_STATE_BMW_BASE);
+    Kawasaki_registerDecoders(&dispatch, &state, VEHICLE_STATE_KAWASAKI_BASE);
+}
+
+void tearDown(void) {
+}
+
+// === BMW DME1 ===
+static void test_rpm_in_range(void) {
+    sendDME1(0x1F40);
+    TEST_ASSERT_EQUAL_INT16(8000, state.value[RPM]);
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_FRESH, Vehicle_State_status(&state, RPM, TEST_NOW_MS));
+    TEST_ASSERT_EQUAL_INT16(64, state.value[VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_TORQUE]);
+
+    sendDME1(0x7FFF);
+    TEST_ASSERT_EQUAL_INT16(32767, state.value[RPM]);
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_FRESH, Vehicle_State_status(&state, RPM, TEST_NOW_MS));
+}
+
+static void test_rpm_above_int16_is_missing(void) {
+    // Raw values above 0x7FFF do not fit the slot: missing, never a plausible 32767
+    static const uint16_t raws[] = {0x8000, 0x8AE2, 0xFFFF};
+    for (size_t i = 0; i < sizeof(raws) / sizeof(raws[0]); i++) {
+        sendDME1(0x0BB8);
+        TEST_ASSERT_EQUAL_INT16(3000, state.value[RPM]);
+
+        uint32_t changed = sendDME1(raws[i]);
+        TEST_ASSERT_TRUE(changed & (1u << BMW_SIGNAL_RPM));
+        TEST_ASSERT_EQUAL_INT16(SIGNAL_NO_VALUE, state.value[RPM]);
+        TEST_ASSERT_EQUAL(VEHICLE_VALUE_MISSING, Vehicle_State_status(&state, RPM, TEST_NOW_MS));
+        TEST_ASSERT_EQUAL_INT(-1, Vehicle_State_reading(&state, RPM, TEST_NOW_MS, -1));
+
+        char text[8];
+        Vehicle_State_format(&state, RPM, TEST_NOW_MS, text, sizeof(text));
+        TEST_ASSERT_EQUAL_STRING("--", text);
+    }
+    // The other DME1 signals of the frame still decode
+    TEST_ASSERT_EQUAL_INT16(64, state.value[VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_TORQUE]);
+    TEST_ASSERT_EQUAL_INT16(5, state.value[VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_TORQUE_LOSS]);
+}
+
+static void test_single_frame_rpm(void) {
+    // The shift light's per-frame path skips frames without a usable engine speed
+    CAN_Frame_t frame = {};
+    frame.id = 0x316;
+    frame.len = 8;
+    frame.buf[2] = 0x70;
+    frame.buf[3] = 0x17;
+    int16_t rpm = 0;
+    TEST_ASSERT_TRUE(BMW_decodeRPM(&frame, &rpm));
+    TEST_ASSERT_EQUAL_INT16(6000, rpm);
+
+    frame.buf[3] = 0x80;
+    TEST_ASSERT_FALSE(BMW_decodeRPM(&frame, &rpm));
+}
+
+// === KAWASAKI ===
+static void test_kawasaki_rpm_above_int16_is_missing(void) {
+    // Big-endian engine speed in bytes 0 and 1
+    uint8_t buf[8] = {0x2E, 0xE0, 10, 20, 90, 0, 0, 0};
+    uint32_t changed = 0;
+    const uint8_t slot = VEHICLE_STATE_KAWASAKI_BASE + KAWASAKI_SIGNAL_RPM;
+    Vehicle_State_begin(&state, TEST_NOW_MS);
+    TEST_ASSERT_TRUE(CAN_Dispatch_process(&dispatch, 0x620, 8, buf, &changed));
+    TEST_ASSERT_EQUAL_INT16(12000, state.value[slot]);
+
+    buf[0] = 0x90;
+    TEST_ASSERT_TRUE(CAN_Dispatch_process(&dispatch, 0x620, 8, buf, &changed));
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_MISSING, Vehicle_State_status(&state, slot, TEST_NOW_MS));
+}
+
+// === STORE ===
+static void test_set_out_of_range_is_missing(void) {
+    const uint8_t slot = VEHICLE_STATE_BMW_BASE + BMW_SIGNAL_OIL_TEMP;
+    Vehicle_State_set(&state, slot, 95);
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_FRESH, Vehicle_State_status(&state, slot, state.nowMs));
+    Vehicle_State_set(&state, slot, 40000);
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_MISSING, Vehicle_State_status(&state, slot, state.nowMs));
+    Vehicle_State_set(&state, slot, -40000);
+    TEST_ASSERT_EQUAL(VEHICLE_VALUE_MISSING, Vehicle_State_status(&state, slot, state.nowMs));
+}
+
+// === DISPATCH TABLE ===
+static uint32_t decodeNothing(uint8_t len, const uint8_t* buf, void* target) {
+    return 0;
+}
+
+static void test_failed_registration_changes_nothing(void) {
+    // 0x316 is taken by the BMW decoders: none of the other entries may be registered either
+    static const CAN_Dispatch_Entry_t clashing[] = {{0x100, 8, decodeNothing, 0}, {0x316, 8, decodeNothing, 0}};
+    static const CAN_Dispatch_Entry_t invalid[] = {{0x101, 8, decodeNothing, 0}, {0x800, 8, decodeNothing, 0}};
+    static const CAN_Dispatch_Entry_t repeated[] = {{0x102, 8, decodeNothing, 0}, {0x102, 8, decodeNothing, 0}};
+    const uint8_t before = dispatch.count;
+    uint8_t buf[8] = {};
+    uint32_t changed = 0;
+
+    TEST_ASSERT_FALSE(CAN_Dispatch_register(&dispatch, clashing, 2, nullptr, 0));
+    TEST_ASSERT_FALSE(CAN_Dispatch_register(&dispatch, invalid, 2, nullptr, 0));
+    TEST_ASSERT_FALSE(CAN_Dispatch_register(&dispatch, repeated, 2, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT8(before, dispatch.count);
+    TEST_ASSERT_FALSE(CAN_Dispatch_process(&dispatch, 0x100, 8, buf, &changed));
+    TEST_ASSERT_FALSE(CAN_Dispatch_process(&dispatch, 0x101, 8, buf, &changed));
+    TEST_ASSERT_FALSE(CAN_Dispatch_process(&dispatch, 0x102, 8, buf, &changed));
+
+    // More entries than free slots: refused as a whole
+    static CAN_Dispatch_Entry_t many[CAN_DISPATCH_MAX_ENTRIES];
+    for (int i = 0; i < CAN_DISPATCH_MAX_ENTRIES; i++) {
+        many[i] = {(uint32_t)(0x200 + i), 8, decodeNothing, 0};
+    }
+    TEST_ASSERT_FALSE(CAN_Dispatch_register(&dispatch, many, CAN_DISPATCH_MAX_ENTRIES, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT8(before, dispatch.count);
+    TEST_ASSERT_FALSE(CAN_Dispatch_process(&dispatch, 0x200, 8, buf, &changed));
+
+    // The free slots themselves still take a fitting registration
+    TEST_ASSERT_TRUE(CAN_Dispatch_register(&dispatch, many, CAN_DISPATCH_MAX_ENTRIES - before, nullptr, 0));
+    TEST_ASSERT_EQUAL_UINT8(CAN_DISPATCH_MAX_ENTRIES, dispatch.count);
+    TEST_ASSERT_TRUE(CAN_Dispatch_process(&dispatch, 0x200, 8, buf, &changed));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rpm_in_range);
+    RUN_TEST(test_rpm_above_int16_is_missing);
+    RUN_TEST(test_single_frame_rpm);
+    RUN_TEST(test_kawasaki_rpm_above_int16_is_missing);
+    RUN_TEST(test_set_out_of_range_is_missing);
+    RUN_TEST(test_failed_registration_changes_nothing);
+    return UNITY_END();
+}
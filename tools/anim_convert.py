@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""Convert raw XBM animation frames into the compressed .anim format played by Anim_Player.
+
+    python3 tools/anim_convert.py assets/bmw_animation.bin data/bmw_animation.anim
+
+Frames are converted from XBM (row major, LSB first) to the U8g2 page layout
+(one byte per column of 8 pixels), so the player can copy them straight into
+the frame buffer. Each frame is stored either as a key frame or as the XOR
+against the previous frame, whichever is smaller, and then run-length encoded.
+
+Format (all integers little endian):
+  header  "ANIM", uint8 version, uint8 flags, uint16 width, uint16 height,
+          uint16 frameCount, uint16 frameMs
+  frame   uint8 type (0 key, 1 xor delta), uint16 payloadLen, payload
+  payload control byte c < 0x80: c + 1 literal bytes follow
+          control byte c >= 0x80: the next byte repeats c - 0x80 + 3 times
+"""
+import argparse
+import struct
+import sys
+
+MAGIC = b"ANIM"
+VERSION = 1
+FRAME_KEY = 0
+FRAME_DELTA = 1
+MIN_RUN = 3
+MAX_RUN = 0x7F + MIN_RUN
+MAX_LITERAL = 0x80
+
+
+def xbm_to_pages(frame, width, height):
+    row_bytes = (width + 7) // 8
+    out = bytearray(width * height // 8)
+    for y in range(height):
+        for x in range(width):
+            if frame[y * row_bytes + x // 8] & (1 << (x % 8)):
+                out[(y // 8) * width + x] |= 1 << (y % 8)
+    return bytes(out)
+
+
+def rle_encode(data):
+    out = bytearray()
+    literal = bytearray()
+    i = 0
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:MAX_LITERAL]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+            del literal[:MAX_LITERAL]
+
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < MAX_RUN:
+            run += 1
+        if run >= MIN_RUN:
+            flush_literal()
+            out.append(0x80 + run - MIN_RUN)
+            out.append(data[i])
+            i += run
+        else:
+            literal.append(data[i])
+            i += 1
+    flush_literal()
+    return bytes(out)
+
+
+def rle_decode(data, size):
+    out = bytearray()
+    i = 0
+    while len(out) < size:
+        c = data[i]
+        if c < 0x80:
+            out.extend(data[i + 1:i + 2 + c])
+            i += 2 + c
+        else:
+            out.extend(bytes([data[i + 1]]) * (c - 0x80 + MIN_RUN))
+            i += 2
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert raw XBM frames to .anim")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--width", type=int, default=128)
+    parser.add_argument("--height", type=int, default=64)
+    parser.add_argument("--frame-ms", type=int, default=20)
+    args = parser.parse_args()
+
+    frame_size = args.width * args.height // 8
+    with open(args.input, "rb") as f:
+        raw = f.read()
+    if len(raw) % frame_size:
+        print(f"{args.input}: size is not a multiple of {frame_size}", file=sys.stderr)
+        return 1
+
+    frames = [xbm_to_pages(raw[i:i + frame_size], args.width, args.height)
+              for i in range(0, len(raw), frame_size)]
+    out = bytearray(MAGIC + struct.pack("<BBHHHH", VERSION, 0, args.width, args.height, len(frames), args.frame_ms))
+    previous = bytes(frame_size)
+    keys = 0
+    for frame in frames:
+        key = rle_encode(frame)
+        delta = rle_encode(bytes(a ^ b for a, b in zip(frame, previous)))
+        frame_type, payload = (FRAME_DELTA, delta) if len(delta) < len(key) else (FRAME_KEY, key)
+        keys += frame_type == FRAME_KEY
+
+        # Round trip check, the player has no way to recover from a bad frame
+        decoded = rle_decode(payload, frame_size)
+        if frame_type == FRAME_DELTA:
+            decoded = bytes(a ^ b for a, b in zip(decoded, previous))
+        assert decoded == frame
+
+        out += struct.pack("<BH", frame_type, len(payload)) + payload
+        previous = frame
+
+    with open(args.output, "wb") as f:
+        f.write(out)
+    print(f"{len(frames)} frames ({keys} key frames): {len(raw)} -> {len(out)} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""Measure the host benchmark suite on this machine and write or gate against a baseline.
+
+    python3 tools/bench_baseline.py                      # write bench/baseline.txt for this host
+    python3 tools/bench_baseline.py --against origin/main  # CI: this tree against REF, same host
+
+Timings only compare on the machine that took them, so bench/baseline.txt stays out of git and
+CI never gates against a stored file: --against builds REF in a temporary git worktree, measures
+it on the runner, then measures this tree the same way and compares. Both builds are [env:bench],
+which links the U8g2 release pinned there, so every draw.* screen is measured.
+A measurement is the per-benchmark median of --runs program runs, each the best of 9 repeats.
+Benchmarks missing from REF are new and pass, unlike with the program's own --baseline.
+
+Before measuring, the tree's "atlas check" and "layout check" console commands must report no
+differing pixels on any screen: the glyph atlas and partial redraws against full U8g2 output.
+The draw.* screens are timed with the atlas on and, as draw.*.u8g2, off.
+"""
+import argparse
+import os
+import re
+import socket
+import statistics
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PROGRAM = os.path.join(".pio", "build", "bench", "program")
+
+
+def build(tree):
+    subprocess.run(["pio", "run", "-e", "bench", "-d", tree], check=True)
+
+
+def check(tree):
+    """Pixel checks of the atlas and the partial redraws, against the U8g2 the build linked."""
+    cmd = [PROGRAM, "--cmd", "atlas check", "--cmd", "layout check", "--duration-ms", "1000"]
+    output = subprocess.run(cmd, cwd=tree, check=True, capture_output=True, text=True).stdout
+    reports = re.findall(r"^(?:> )?(?:atlas check|layout check)?(.+): (\d+) pixels differ$", output, re.MULTILINE)
+    for what, pixels in reports:
+        print(f"{what}: {pixels} pixels differ")
+    if not reports or any(int(pixels) != 0 for _, pixels in reports):
+        raise SystemExit(f"Pixel checks failed in {tree}")
+
+
+def read_results(path):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) >= 2 and not line.startswith("#"):
+                results[fields[0]] = float(fields[1])
+    return results
+
+
+def measure(tree, runs):
+    """Median ns/op per benchmark over several runs, in the order the suite runs them."""
+    samples = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "results.txt")
+        for _ in range(runs):
+            subprocess.run([PROGRAM, "--benchmark", "--results", path], cwd=tree, check=True)
+            for name, ns in read_results(path).items():
+                samples.setdefault(name, []).append(ns)
+    if not any(name.startswith("draw.") for name in samples):
+        raise SystemExit("No draw.* results, the bench build did not render any screen")
+    return {name: statistics.median(values) for name, values in samples.items()}
+
+
+def write_baseline(path, results, runs, source):
+    with open(path, "w") as f:
+        f.write('# Host benchmark baseline for native_program --benchmark --baseline, "name ns/op ops/s" per line.\n')
+        f.write(f"# Median of {runs} runs of the bench environment (-O2, pinned U8g2) of {source} on {socket.gethostname()}.\n")
+        f.write("# Only comparable on that machine, rewrite with tools/bench_baseline.py after changing hosts.\n")
+        for name, ns in results.items():
+            f.write(f"{name} {ns:.1f} {1e9 / ns:.0f}\n")
+
+
+def gate(ref, runs, tolerance):
+    with tempfile.TemporaryDirectory() as tmp:
+        base = os.path.join(tmp, "base")
+        subprocess.run(["git", "-C", ROOT, "worktree", "add", "--detach", base, ref], check=True)
+        try:
+            build(base)
+            reference = measure(base, runs)
+        finally:
+            subprocess.run(["git", "-C", ROOT, "worktree", "remove", "--force", base], check=False)
+    build(ROOT)
+    check(ROOT)
+    results = measure(ROOT, runs)
+
+    # Benchmarks this tree adds have nothing to compare against yet and pass as new
+    regressions = 0
+    print(f"\n{'benchmark':<32} {'ns/op':>10} {ref:>10} {'change':>8}")
+    for name, ns in results.items():
+        if name not in reference:
+            print(f"{name:<32} {ns:10.1f} {'-':>10} {'-':>8}  new")
+            continue
+        change = (ns / reference[name] - 1.0) * 100.0
+        regressed = change > tolerance
+        regressions += regressed
+        print(f"{name:<32} {ns:10.1f} {reference[name]:10.1f} {change:+7.1f}%{'  REGRESSION' if regressed else ''}")
+    print(f"{regressions} of {len(results)} benchmarks more than {tolerance}% slower than {ref}")
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--against", metavar="REF", help="gate this tree against REF measured on this host")
+    parser.add_argument("--runs", type=int, default=3, help="program runs per measurement (default 3)")
+    parser.add_argument("--tolerance", type=int, default=25, help="percent slower allowed with --against (default 25)")
+    parser.add_argument("--output", default=os.path.join(ROOT, "bench", "baseline.txt"), help="baseline to write")
+    args = parser.parse_args()
+
+    if args.against:
+        return gate(args.against, args.runs, args.tolerance)
+    build(ROOT)
+    check(ROOT)
+    results = measure(ROOT, args.runs)
+    write_baseline(args.output, results, args.runs, "this tree")
+    print(f"{len(results)} benchmarks written to {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
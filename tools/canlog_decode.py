@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Decode flash logs written by CAN_Logger into candump or Vector ASC text.
+
+    python3 tools/canlog_decode.py canlog_003.bin > drive.log
+    python3 tools/canlog_decode.py --format asc serial_capture.txt > drive.asc
+
+Input is either the raw log file or a serial capture of "log dump <n>"
+(lines starting with ':'). The candump output can be replayed with
+"replay" on the device or "--replay" in the native build.
+"""
+import argparse
+import struct
+import sys
+import zlib
+
+FILE_MAGIC = b"CANL"
+FILE_VERSION = 1
+FILE_HEADER_SIZE = 8
+BLOCK_MAGIC = b"BK"
+BLOCK_HEADER = struct.Struct("<2sHHHII")
+NEW_ENTRY = 0xFF
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data.startswith(FILE_MAGIC):
+        return data
+    # Serial capture: concatenate the hex lines between LOG BEGIN and LOG END
+    out = bytearray()
+    for line in data.decode("ascii", errors="replace").splitlines():
+        line = line.strip()
+        if line.startswith(":"):
+            out += bytes.fromhex(line[1:])
+    return bytes(out)
+
+
+def read_varint(payload, pos):
+    value = shift = 0
+    while True:
+        byte = payload[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def decode_block(payload, base_us, frame_count):
+    ids, lens = [], []
+    pos, time_us = 0, base_us
+    for _ in range(frame_count):
+        delta, pos = read_varint(payload, pos)
+        time_us += delta
+        tag = payload[pos]
+        pos += 1
+        if tag == NEW_ENTRY:
+            can_id, length = struct.unpack_from("<HB", payload, pos)
+            pos += 3
+            ids.append(can_id)
+            lens.append(length)
+            index = len(ids) - 1
+        else:
+            index = tag
+        length = lens[index]
+        yield time_us, ids[index], payload[pos:pos + length]
+        pos += length
+
+
+def decode(data, stats):
+    if not data.startswith(FILE_MAGIC) or data[4] != FILE_VERSION:
+        raise ValueError("not a CAN_Logger file (or unsupported version)")
+
+    pos = FILE_HEADER_SIZE
+    epoch = 0          # 64-bit time base, device timestamps are 32-bit micros()
+    last_base = None
+    while pos + BLOCK_HEADER.size <= len(data):
+        magic, payload_len, frame_count, sequence, base_us, crc = BLOCK_HEADER.unpack_from(data, pos)
+        payload = data[pos + BLOCK_HEADER.size:pos + BLOCK_HEADER.size + payload_len]
+        if magic != BLOCK_MAGIC or len(payload) != payload_len or zlib.crc32(payload) != crc:
+            # Skip to the next block header, a torn write only loses one block
+            stats["bad_blocks"] += 1
+            next_pos = data.find(BLOCK_MAGIC, pos + 1)
+            if next_pos < 0:
+                break
+            pos = next_pos
+            continue
+
+        if last_base is not None and base_us < last_base:
+            epoch += 1 << 32
+        last_base = base_us
+        stats["blocks"] += 1
+        for time_us, can_id, frame in decode_block(payload, base_us, frame_count):
+            stats["frames"] += 1
+            yield epoch + time_us, can_id, frame
+        pos += BLOCK_HEADER.size + payload_len
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("input")
+    parser.add_argument("--format", choices=("candump", "asc"), default="candump")
+    parser.add_argument("--interface", default="can0", help="candump interface name")
+    args = parser.parse_args()
+
+    stats = {"blocks": 0, "bad_blocks": 0, "frames": 0}
+    out = sys.stdout
+    first = None
+    if args.format == "asc":
+        out.write("base hex  timestamps absolute\nBegin Triggerblock\n")
+    for time_us, can_id, frame in decode(load(args.input), stats):
+        if args.format == "candump":
+            out.write(f"({time_us // 1000000}.{time_us % 1000000:06d}) {args.interface} {can_id:03X}#{frame.hex().upper()}\n")
+        else:
+            first = time_us if first is None else first
+            rel = (time_us - first) / 1e6
+            data = " ".join(f"{b:02X}" for b in frame)
+            out.write(f"   {rel:.6f} 1  {can_id:X}             Rx   d {len(frame)} {data}\n")
+    if args.format == "asc":
+        out.write("End TriggerBlock\n")
+
+    print(f"{stats['frames']} frames in {stats['blocks']} blocks, {stats['bad_blocks']} damaged blocks skipped",
+          file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
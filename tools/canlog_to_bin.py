@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Convert a candump or Vector ASC log into the compact binary format read by CAN_Replay.
+
+    python3 tools/canlog_to_bin.py drive.log data/drive.bin
+
+Layout (see CAN_Replay.h): "CANB", version 1, 3 reserved bytes, then per frame
+uint32 timeUs (relative to the first frame), uint16 id, uint8 len, data.
+
+timeUs wraps every 2^32 us (71.6 min) and the replay unwraps it from one record to the next,
+so times are written never decreasing, and a gap of 2^32 us or more between frames is an error.
+"""
+import re
+import struct
+import sys
+
+CANDUMP_RE = re.compile(r"^\s*(?:\((\d+)\.(\d+)\)\s+\S+\s+)?([0-9A-Fa-f]+)#([0-9A-Fa-f]*)")
+ASC_RE = re.compile(r"^\s*(\d+\.\d+)\s+\d+\s+([0-9A-Fa-f]+)x?\s+(?:Rx|Tx)\s+[dD]\s+([0-9A-Fa-f])((?:\s+[0-9A-Fa-f]{2})*)")
+MAGIC = b"CANB"
+VERSION = 1
+
+
+def parse_frames(lines):
+    decimal_ids = False
+    for line in lines:
+        m = CANDUMP_RE.match(line)
+        if m:
+            seconds, frac, can_id, data = m.groups()
+            time_us = int(seconds) * 1000000 + int(frac.ljust(6, "0")[:6]) if seconds else 0
+            yield time_us, int(can_id, 16), bytes.fromhex(data)[:8]
+            continue
+        m = ASC_RE.match(line)
+        if m:
+            seconds, can_id, dlc, data = m.groups()
+            payload = bytes.fromhex("".join(data.split()))[: int(dlc, 16)]
+            yield round(float(seconds) * 1e6), int(can_id, 10 if decimal_ids else 16), payload
+            continue
+        if line.strip().startswith("base "):
+            decimal_ids = line.split()[1] == "dec"
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+
+    count = 0
+    first = None
+    last = 0
+    with open(sys.argv[1], "r", errors="replace") as src, open(sys.argv[2], "wb") as dst:
+        dst.write(MAGIC + bytes([VERSION, 0, 0, 0]))
+        for time_us, can_id, data in parse_frames(src):
+            if can_id > 0xFFFF:
+                continue  # Extended IDs are not replayed
+            if first is None:
+                first = time_us
+            rel = max(last, time_us - first)
+            if rel - last >= 1 << 32:
+                print(f"Gap of {(rel - last) / 1e6:.0f} s before frame {count + 1}, too long for the format", file=sys.stderr)
+                return 1
+            last = rel
+            dst.write(struct.pack("<IHB", rel & 0xFFFFFFFF, can_id, len(data)) + data)
+            count += 1
+    print(f"{count} frames written to {sys.argv[2]}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""Compile a text screen layout into the binary .lay pack loaded by Layout_Engine.
+
+    python3 tools/layout_compile.py assets/screens.layout data/screens.lay --header include/Layout_Default.h
+
+The firmware reads /screens.lay from SPIFFS at boot ('layout reload' re-reads it) and
+falls back to the pack compiled into Layout_Default.h, which this tool also writes.
+
+Layout description, one item per line, '#' starts a comment, quotes group words:
+  screen "<name>"                                  starts a screen, its widgets are drawn in order
+  label <font> <x> <y> "<text>"
+  value <font> <x> <y> "<template>"                {signal} or {signal:width} is the reading,
+                                                   right-aligned in width characters
+  bar <signal> <x> <y> <w> <h> min=<n> max=<n>
+  meter <signal> <x> <bottom> <width> <gap> <threshold>:<height>... [predict=1] [blinkfull=1]
+  spark <signal> <x> <y> <w> <h> min=<n> max=<n> span=<ms>
+  icon <name> <x> <y>
+  line <x> <y> <w> <h>
+Every widget also takes show=<indicator> (drawn only while the alert indicator is raised) and
+blink=<indicator> period=<ms> (hidden every other period while raised; a bar or meter keeps its
+frame). Signals are the Vehicle_State names, fonts the U8g2 names without "u8g2_font_", icons
+and fonts must be registered by the firmware. Names are checked when the firmware loads the pack.
+
+Format (all integers little endian):
+  header   "LAYT", uint8 version, uint8 screenCount, uint8 widgetCount, uint8 segmentCount,
+           uint8 stringCount, uint8 reserved, uint16 stringBytes
+  strings  stringBytes of NUL-terminated strings, referred to by their position (255 = none)
+  screens  uint8 name, uint8 widgetCount; the widgets follow in screen order
+  widgets  uint8 type, uint8 flags, int16 x, int16 y, int16 w, int16 h,
+           uint8 ref, uint8 text, uint8 show, uint8 blink, uint16 periodMs,
+           int16 min, int16 max, uint32 spanMs
+             label, value  ref font, text label or template
+             bar, spark    ref signal, min and max of the range
+             meter         ref signal, y bottom, w segment width, h gap, min first segment,
+                           max segment count, flags 1 predict, 2 blink when all segments are lit
+             icon          ref icon
+  segments int16 threshold, uint8 height, uint8 reserved
+  template fields are 0x01, signal string + 1, width + 1
+"""
+import argparse
+import re
+import shlex
+import struct
+import sys
+
+MAGIC = b"LAYT"
+VERSION = 1
+NO_STRING = 0xFF
+FIELD_MARK = 0x01
+MAX_SCREENS = 8
+MAX_WIDGETS = 64
+MAX_SCREEN_WIDGETS = 32
+MAX_SEGMENTS = 32
+MAX_STRINGS = 128
+MAX_FIELDS = 4
+MAX_FILE_SIZE = 4096
+
+WIDGET_TYPES = ["label", "value", "bar", "meter", "spark", "icon", "line"]
+FLAG_PREDICT = 0x01
+FLAG_BLINK_FULL = 0x02
+FIELD = re.compile(r"\{([a-z0-9_]+)(?::(\d+))?\}")
+
+
+class LayoutError(Exception):
+    pass
+
+
+class Pack:
+    def __init__(self):
+        self.strings = []
+        self.screens = []       # [name index, widget records]
+        self.segments = []
+
+    def string(self, text):
+        data = text.encode("ascii")
+        if b"\0" in data:
+            raise LayoutError("NUL in a string")
+        if data not in self.strings:
+            if len(self.strings) >= MAX_STRINGS:
+                raise LayoutError(f"more than {MAX_STRINGS} strings")
+            self.strings.append(data)
+        return self.strings.index(data)
+
+    def template(self, text):
+        out = bytearray()
+        fields = 0
+        pos = 0
+        for match in FIELD.finditer(text):
+            out += self.literal(text[pos:match.start()])
+            width = int(match.group(2) or 0)
+            if width > 32:
+                raise LayoutError(f"field width {width} is over 32")
+            out += bytes([FIELD_MARK, self.string(match.group(1)) + 1, width + 1])
+            fields += 1
+            pos = match.end()
+        out += self.literal(text[pos:])
+        if fields > MAX_FIELDS:
+            raise LayoutError(f"more than {MAX_FIELDS} fields in a template")
+        data = bytes(out)
+        if data not in self.strings:
+            if len(self.strings) >= MAX_STRINGS:
+                raise LayoutError(f"more than {MAX_STRINGS} strings")
+            self.strings.append(data)
+        return self.strings.index(data)
+
+    @staticmethod
+    def literal(text):
+        if any(c in "{}" for c in text):
+            raise LayoutError(f"malformed field in {text!r}")
+        if any(not " " <= c <= "~" for c in text):
+            raise LayoutError(f"only printable ASCII is drawn: {text!r}")
+        return text.encode("ascii")
+
+
+def number(text, low=-32768, high=32767):
+    try:
+        value = int(text, 0)
+    except ValueError:
+        raise LayoutError(f"not a number: {text}")
+    if not low <= value <= high:
+        raise LayoutError(f"{value} is outside {low}..{high}")
+    return value
+
+
+def split_options(words):
+    args = []
+    options = {}
+    for word in words:
+        if "=" in word:
+            key, value = word.split("=", 1)
+            options[key] = value
+        else:
+            args.append(word)
+    return args, options
+
+
+def compile_widget(pack, kind, args, options):
+    counts = {"label": 4, "value": 4, "bar": 5, "spark": 5, "icon": 3, "line": 4}
+    if kind == "meter":
+        if len(args) < 6:
+            raise LayoutError("meter needs a signal, x, bottom, width, gap and at least one threshold:height")
+    elif len(args) != counts[kind]:
+        raise LayoutError(f"{kind} takes {counts[kind]} arguments, got {len(args)}")
+
+    w = {"type": WIDGET_TYPES.index(kind), "flags": 0, "x": 0, "y": 0, "w": 0, "h": 0,
+         "ref": NO_STRING, "text": NO_STRING, "min": 0, "max": 0, "span": 0}
+    if kind in ("label", "value"):
+        w["ref"] = pack.string(args[0])
+        w["x"], w["y"] = number(args[1]), number(args[2])
+        w["text"] = pack.template(args[3]) if kind == "value" else pack.string(Pack.literal(args[3]).decode())
+    elif kind in ("bar", "spark"):
+        w["ref"] = pack.string(args[0])
+        w["x"], w["y"], w["w"], w["h"] = (number(a) for a in args[1:5])
+        if "min" not in options or "max" not in options:
+            raise LayoutError(f"{kind} needs min= and max=")
+        w["min"], w["max"] = number(options.pop("min")), number(options.pop("max"))
+        if w["min"] >= w["max"]:
+            raise LayoutError("min must be below max")
+        if kind == "spark":
+            if "span" not in options:
+                raise LayoutError("spark needs span=")
+            w["span"] = number(options.pop("span"), 1, 0xFFFFFFFF)
+    elif kind == "meter":
+        w["ref"] = pack.string(args[0])
+        w["x"], w["y"], w["w"], w["h"] = (number(a) for a in args[1:5])
+        w["min"] = len(pack.segments)
+        for segment in args[5:]:
+            threshold, _, height = segment.partition(":")
+            pack.segments.append((number(threshold), number(height or "x", 1, 255)))
+        w["max"] = len(args) - 5
+        if len(pack.segments) > MAX_SEGMENTS:
+            raise LayoutError(f"more than {MAX_SEGMENTS} meter segments")
+        if number(options.pop("predict", "0"), 0, 1):
+            w["flags"] |= FLAG_PREDICT
+        if number(options.pop("blinkfull", "0"), 0, 1):
+            w["flags"] |= FLAG_BLINK_FULL
+    elif kind == "icon":
+        w["ref"] = pack.string(args[0])
+        w["x"], w["y"] = number(args[1]), number(args[2])
+    elif kind == "line":
+        w["x"], w["y"], w["w"], w["h"] = (number(a) for a in args)
+
+    w["show"] = pack.string(options.pop("show")) if "show" in options else NO_STRING
+    w["blink"] = pack.string(options.pop("blink")) if "blink" in options else NO_STRING
+    w["period"] = number(options.pop("period", "0"), 0, 65535)
+    if (w["blink"] != NO_STRING or w["flags"] & FLAG_BLINK_FULL) and w["period"] == 0:
+        raise LayoutError("blinking needs period=")
+    if options:
+        raise LayoutError(f"unknown options for {kind}: {', '.join(sorted(options))}")
+    return struct.pack("<BBhhhhBBBBHhhI", w["type"], w["flags"], w["x"], w["y"], w["w"], w["h"],
+                       w["ref"], w["text"], w["show"], w["blink"], w["period"], w["min"], w["max"], w["span"])
+
+
+def compile_layout(lines):
+    pack = Pack()
+    for number_, line in enumerate(lines, 1):
+        try:
+            words = shlex.split(line, comments=True)
+            if not words:
+                continue
+            kind, rest = words[0], words[1:]
+            if kind == "screen":
+                if len(rest) != 1:
+                    raise LayoutError('screen takes a quoted name: screen "<name>"')
+                if len(pack.screens) >= MAX_SCREENS:
+                    raise LayoutError(f"more than {MAX_SCREENS} screens")
+                pack.screens.append([pack.string(rest[0]), []])
+            elif kind in WIDGET_TYPES:
+                if not pack.screens:
+                    raise LayoutError("widget before the first screen")
+                if len(pack.screens[-1][1]) >= MAX_SCREEN_WIDGETS:
+                    raise LayoutError(f"more than {MAX_SCREEN_WIDGETS} widgets on a screen")
+                args, options = split_options(rest)
+                pack.screens[-1][1].append(compile_widget(pack, kind, args, options))
+            else:
+                raise LayoutError(f"unknown item: {kind}")
+        except (LayoutError, ValueError) as e:
+            raise LayoutError(f"line {number_}: {e}")
+
+    widgets = [record for _, records in pack.screens for record in records]
+    if not pack.screens:
+        raise LayoutError("no screens")
+    if len(widgets) > MAX_WIDGETS:
+        raise LayoutError(f"more than {MAX_WIDGETS} widgets")
+    strings = b"".join(s + b"\0" for s in pack.strings)
+    out = bytearray(MAGIC + struct.pack("<BBBBBBH", VERSION, len(pack.screens), len(widgets),
+                                        len(pack.segments), len(pack.strings), 0, len(strings)))
+    out += strings
+    for name, records in pack.screens:
+        out += struct.pack("<BB", name, len(records))
+    out += b"".join(widgets)
+    for threshold, height in pack.segments:
+        out += struct.pack("<hBB", threshold, height, 0)
+    if len(out) > MAX_FILE_SIZE:
+        raise LayoutError(f"{len(out)} bytes, the firmware reads at most {MAX_FILE_SIZE}")
+    return bytes(out), len(pack.screens), len(widgets)
+
+
+def write_header(path, source, data):
+    rows = [", ".join(f"0x{b:02x}" for b in data[i:i + 16]) for i in range(0, len(data), 16)]
+    with open(path, "w") as f:
+        f.write(f"// Generated by tools/layout_compile.py from {source}, do not edit\n")
+        f.write("#ifndef LAYOUT_DEFAULT_H\n#define LAYOUT_DEFAULT_H\n\n#include <stdint.h>\n\n")
+        f.write("// Built-in layout pack, used when no layout file is on flash\n")
+        f.write("static const uint8_t LAYOUT_DEFAULT_PACK[] = {\n")
+        f.write("".join(f"    {row},\n" for row in rows))
+        f.write("};\n\n#endif // LAYOUT_DEFAULT_H\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile a text screen layout to .lay")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--header", help="also write the pack as the firmware's built-in C array")
+    args = parser.parse_args()
+
+    with open(args.input) as f:
+        try:
+            data, screens, widgets = compile_layout(f.readlines())
+        except LayoutError as e:
+            print(f"{args.input}: {e}", file=sys.stderr)
+            return 1
+    with open(args.output, "wb") as f:
+        f.write(data)
+    if args.header:
+        write_header(args.header, args.input, data)
+    print(f"{screens} screens, {widgets} widgets: {len(data)} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())